@@ -6,7 +6,9 @@
 
 aimanager::aimanager(QObject *parent)
     : QObject{parent}
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_networkManager(nullptr)
+    , m_pendingReplies(0)
+    , m_nextRequestId(1)
     , m_modelLoaded(false)
     , m_ollamaUrl("http://localhost:11434")
 {
@@ -39,7 +41,8 @@ bool aimanager::loadModel(const QString &modelName)
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
     // 发送GET请求获取模型标签信息
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = networkManager()->get(request);
+    ++m_pendingReplies;
 
     // 当网络请求完成时，连接到槽函数处理响应
     connect(reply, &QNetworkReply::finished, this, [this, reply]() {
@@ -101,6 +104,7 @@ void aimanager::onModelLoadFinished(QNetworkReply *reply)
     }
 
     // 清理网络回复对象，防止内存泄漏
+    --m_pendingReplies;
     reply->deleteLater();
 }
 
@@ -153,7 +157,7 @@ QString aimanager::generateResponse(const QString &prompt)
                              .arg(systemPrompt, prompt);
 
     json["prompt"] = fullPrompt;// 设置完整的提示词
-    json["stream"] = false;// 关闭流示输出，等待恢复完成
+    json["stream"] = true;// 流式输出：每生成一小段就返回一行JSON，界面边收边显示
 
     // 添加生成参数控制回复风格
     json["temperature"] = 0.8;      // 增加随机性（0-1），让回复更生动有趣
@@ -165,9 +169,14 @@ QString aimanager::generateResponse(const QString &prompt)
     QByteArray data = doc.toJson();
 
     // 发送POST请求到Ollama API
-    QNetworkReply *reply = m_networkManager->post(request, data);
+    QNetworkReply *reply = networkManager()->post(request, data);
+    ++m_pendingReplies;
+    m_streams.insert(reply, StreamState());
 
-    // 连接完成信号到处理槽函数
+    // 数据到达时立即解析，完成时再做收尾
+    connect(reply, &QNetworkReply::readyRead, this, [this, reply]() {
+        readStream(reply);
+    });
     connect(reply, &QNetworkReply::finished, this, [this, reply]() {
         onGenerateFinished(reply);
     });
@@ -176,11 +185,44 @@ QString aimanager::generateResponse(const QString &prompt)
     return "正在思考中喵～";
 }
 
+/*
+ * @brief 解析流式回复中已到达的数据
+ *
+ * Ollama 的流式输出是NDJSON：每行一个JSON对象，"response"字段是新生成的文本片段。
+ * 网络数据可能在行中间断开，不完整的行留在缓冲区等下一次数据。
+ *
+ * @param reply 对应的网络回复
+ */
+void aimanager::readStream(QNetworkReply *reply)
+{
+    auto it = m_streams.find(reply);
+    if (it == m_streams.end()) {
+        return;
+    }
+    StreamState &state = it.value();
+    state.buffer += reply->readAll();
+
+    int newline;
+    while ((newline = state.buffer.indexOf('\n')) >= 0) {
+        const QByteArray line = state.buffer.left(newline);
+        state.buffer.remove(0, newline + 1);
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+        const QJsonObject obj = QJsonDocument::fromJson(line).object();
+        const QString delta = obj["response"].toString();
+        if (!delta.isEmpty()) {
+            state.text += delta;
+            emit responseChunk(delta);
+        }
+    }
+}
+
 /*
  * @brief 处理AI生成回复完成的网络响应
  *
- * 该槽函数在向Ollama API发送生成请求完成后被调用，用于解析AI返回的回复内容。
- * 成功时提取回复文本并发射信号，失败时处理错误信息。
+ * 流式数据已在 readStream 中逐段发出，这里解析最后剩余的数据，
+ * 成功时发出完整的回复文本，失败时发出错误信息。
  *
  * @param reply 包含API响应的QNetworkReply对象
  */
@@ -188,21 +230,20 @@ void aimanager::onGenerateFinished(QNetworkReply *reply)
 {
     // 检查网络请求是否成功完成
     if (reply->error() == QNetworkReply::NoError) {
-        // 读取完整的API响应数据
-        QByteArray response = reply->readAll();
-        // 将JSON响应解析为文档对象
-        QJsonDocument doc = QJsonDocument::fromJson(response);
-        // 转换JSON对象以便访问具体字段
-        QJsonObject obj = doc.object();
+        readStream(reply);
+        StreamState state = m_streams.take(reply);
+        // 最后一行可能没有换行符
+        const QString delta = QJsonDocument::fromJson(state.buffer).object()["response"].toString();
+        if (!delta.isEmpty()) {
+            state.text += delta;
+            emit responseChunk(delta);
+        }
 
-        // 检查响应中是否包含"response"字段（AI生成的回复）
-        if (obj.contains("response")) {
-            // 提取AI生成的回复文本
-            QString aiResponse = obj["response"].toString();
+        if (!state.text.isEmpty()) {
             // 输出调试信息，便于开发时查看回复内容
-            qDebug() << "AI Response:" << aiResponse;
-            // 发射信号，将AI回复传递给连接的槽函数
-            emit responseGenerated(aiResponse);
+            qDebug() << "AI Response:" << state.text;
+            // 发射信号，将完整的AI回复传递给连接的槽函数
+            emit responseGenerated(state.text);
         } else {
             // 处理API返回数据中缺少回复字段的情况
             QString error = "Error: No response from AI";
@@ -210,6 +251,7 @@ void aimanager::onGenerateFinished(QNetworkReply *reply)
             emit responseGenerated(error);
         }
     } else {
+        m_streams.remove(reply);
         // 处理网络请求失败的情况（如连接错误、超时等）
         qWarning() << "API request failed:" << reply->errorString();
         // 构造包含具体错误信息的错误消息
@@ -219,6 +261,7 @@ void aimanager::onGenerateFinished(QNetworkReply *reply)
 
     // 清理网络回复对象，防止内存泄漏
     // 使用deleteLater()确保在事件循环安全时删除对象
+    --m_pendingReplies;
     reply->deleteLater();
 }
 /*
@@ -235,3 +278,74 @@ bool aimanager::isModelLoaded() const
 {
     return m_modelLoaded;
 }
+
+/*
+ * @brief 发送原始提示词（不附加猫娘角色设定）
+ *
+ * 供文件摘要等内部任务使用。与generateResponse不同，每个请求都有独立编号，
+ * 调用方可以同时发起多个请求，并根据promptFinished信号中的编号区分结果。
+ *
+ * @param prompt 完整的提示词
+ * @return int 请求编号；模型未加载时返回-1，不分配编号，也不发出promptFinished
+ */
+int aimanager::submitPrompt(const QString &prompt)
+{
+    if (!m_modelLoaded) {
+        qWarning() << "Model not loaded, please call loadModel() first";
+        return -1;
+    }
+    const int requestId = m_nextRequestId++;
+
+    QNetworkRequest request(QUrl(m_ollamaUrl + "/api/generate"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    QJsonObject json;
+    json["model"] = m_modelName;
+    json["prompt"] = prompt;
+    json["stream"] = false;
+
+    QNetworkReply *reply = networkManager()->post(request, QJsonDocument(json).toJson());
+    ++m_pendingReplies;
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, requestId]() {
+        if (reply->error() == QNetworkReply::NoError) {
+            QJsonObject obj = QJsonDocument::fromJson(reply->readAll()).object();
+            if (obj.contains("response")) {
+                emit promptFinished(requestId, true, obj["response"].toString());
+            } else {
+                emit promptFinished(requestId, false, "Error: No response from AI");
+            }
+        } else {
+            qWarning() << "API request failed:" << reply->errorString();
+            emit promptFinished(requestId, false, "Error: " + reply->errorString());
+        }
+        --m_pendingReplies;
+        reply->deleteLater();
+    });
+
+    return requestId;
+}
+
+QNetworkAccessManager *aimanager::networkManager()
+{
+    if (!m_networkManager) {
+        m_networkManager = new QNetworkAccessManager(this);
+    }
+    return m_networkManager;
+}
+
+/*
+ * @brief 释放与Ollama之间的网络连接
+ *
+ * 聊天窗口长时间隐藏时由会话管理器调用。QNetworkAccessManager 会缓存长连接并占用后台线程，
+ * 这里直接销毁它，下次请求时再重新创建；模型名称和加载状态属于轻量状态，予以保留。
+ * 有请求仍在进行时不做处理，避免打断正在生成的回复。
+ */
+void aimanager::releaseConnections()
+{
+    if (!m_networkManager || m_pendingReplies > 0) {
+        return;
+    }
+    m_networkManager->deleteLater();
+    m_networkManager = nullptr;
+}
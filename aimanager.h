@@ -5,6 +5,7 @@
 #include <QString>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QHash>
 
 class aimanager : public QObject
 {
@@ -16,17 +17,32 @@ public:
     Q_INVOKABLE bool loadModel(const QString &modelName = "qwen2.5:latest"); // 改为模型名
     Q_INVOKABLE QString generateResponse(const QString &prompt);
     Q_INVOKABLE bool isModelLoaded() const;
+    int submitPrompt(const QString &prompt);//发送不带猫娘设定的原始提示词，结果通过promptFinished返回，返回请求编号
+    void releaseConnections();//释放网络连接（空闲时调用），模型状态保留
 
 signals:
     void modelLoaded(bool success);
+    void responseChunk(const QString &delta);//流式输出的一小段新文本，结束后仍会发出 responseGenerated
     void responseGenerated(const QString &response);
+    void promptFinished(int requestId, bool success, const QString &text);
 
 private slots:
     void onModelLoadFinished(QNetworkReply *reply);
     void onGenerateFinished(QNetworkReply *reply);
 
 private:
+    struct StreamState
+    {
+        QByteArray buffer;//尚未凑成完整一行的NDJSON数据
+        QString text;//已收到的完整回复
+    };
+
+    void readStream(QNetworkReply *reply);//解析已到达的完整行并发出 responseChunk
+    QNetworkAccessManager *networkManager();//按需创建网络管理器
     QNetworkAccessManager *m_networkManager;
+    int m_pendingReplies;//进行中的请求数
+    int m_nextRequestId;//submitPrompt 的请求编号
+    QHash<QNetworkReply*, StreamState> m_streams;//进行中的流式回复
     bool m_modelLoaded;
     QString m_modelName;
     QString m_ollamaUrl; // Ollama 服务地址，默认 http://localhost:11434
@@ -0,0 +1,313 @@
+#include "animationcache.h"
+#include "animationscheduler.h"
+#include "assetpack.h"
+#include <QImageReader>
+#include <QBuffer>
+#include <QSettings>
+#include <QDebug>
+
+AnimationDecoder::AnimationDecoder(QObject *parent)
+    : QObject{parent}
+    , m_scheduled(false)
+{
+}
+
+void AnimationDecoder::enqueue(const QString &path, bool urgent)
+{
+    if (urgent) {
+        m_background.removeAll(path);
+        if (!m_urgent.contains(path)) {
+            m_urgent.enqueue(path);
+        }
+    } else if (!m_urgent.contains(path) && !m_background.contains(path)) {
+        m_background.enqueue(path);
+    }
+
+    // 通过事件循环逐个处理，期间到达的紧急任务可以插到前面
+    if (!m_scheduled) {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(this, &AnimationDecoder::processNext, Qt::QueuedConnection);
+    }
+}
+
+void AnimationDecoder::processNext()
+{
+    m_scheduled = false;
+    if (!m_urgent.isEmpty()) {
+        decode(m_urgent.dequeue());
+    } else if (!m_background.isEmpty()) {
+        decode(m_background.dequeue());
+    }
+    if (!m_urgent.isEmpty() || !m_background.isEmpty()) {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(this, &AnimationDecoder::processNext, Qt::QueuedConnection);
+    }
+}
+
+/*
+ * 解码一个动画的全部帧
+ *
+ * @param path：资源名称（见 AssetLibrary），数据直接取自映射的资源包或qrc，不复制文件内容
+ */
+void AnimationDecoder::decode(const QString &path)
+{
+    const QByteArray data = AssetLibrary::instance().data(path);
+    if (data.isEmpty()) {
+        emit failed(path, "找不到动画资源");
+        return;
+    }
+    if (SpritePack::isSpritePack(data)) {
+        decodeSprite(path, data);
+        return;
+    }
+
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    if (!reader.canRead()) {
+        emit failed(path, reader.errorString());
+        return;
+    }
+
+    // 完整的各帧只在解码期间存在，放进缓存的是增量索引帧
+    QVector<AnimationFrame> frames;
+    QImage image;
+    while (reader.read(&image)) {
+        if (!frames.isEmpty() && image.size() != frames.first().image.size()) {
+            emit failed(path, "各帧尺寸不一致");
+            return;
+        }
+        // 读完一帧后 nextImageDelay 是这一帧的显示时长；部分GIF写的是0，按浏览器的做法当作100ms
+        frames.append(AnimationFrame{image, reader.nextImageDelay() > 0 ? reader.nextImageDelay() : 100, QRect()});
+        if (!reader.supportsAnimation()) {
+            break;
+        }
+    }
+    if (frames.isEmpty()) {
+        emit failed(path, reader.errorString());
+        return;
+    }
+
+    auto animation = QSharedPointer<Animation>::create();
+    animation->path = path;
+    animation->size = frames.first().image.size();
+    animation->frames = SpritePack::index(frames);
+    finish(animation);
+}
+
+/*
+ * 解码构建时打包好的 .sprite 动画：只解压，各帧保持索引形式
+ */
+void AnimationDecoder::decodeSprite(const QString &path, const QByteArray &data)
+{
+    auto animation = QSharedPointer<Animation>::create();
+    animation->path = path;
+    QString error;
+    if (!SpritePack::decodeIndexed(data, &animation->size, &animation->frames, &error)) {
+        emit failed(path, error);
+        return;
+    }
+    finish(animation);
+}
+
+void AnimationDecoder::finish(QSharedPointer<Animation> animation)
+{
+    animation->bytes = 0;
+    const QVector<IndexedFrame> &frames = animation->frames;
+    for (const IndexedFrame &frame : frames) {
+        animation->bytes += frame.bytes();
+    }
+    emit decoded(animation->path, animation);
+}
+
+/*
+ * AnimationCache 构造函数
+ *
+ * 解码线程以低优先级运行，避免和界面抢CPU
+ */
+AnimationCache::AnimationCache(QObject *parent)
+    : QObject{parent}
+    , m_decoder(new AnimationDecoder)
+    , m_used(0)
+{
+    qRegisterMetaType<AnimationPtr>();
+    QSettings settings;
+    m_budget = settings.value("animation/cacheBudgetMB", 64).toLongLong() * 1024 * 1024;
+
+    m_decoder->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_decoder, &QObject::deleteLater);
+    connect(this, &AnimationCache::requestDecode, m_decoder, &AnimationDecoder::enqueue);
+    connect(m_decoder, &AnimationDecoder::decoded, this, &AnimationCache::onDecoded);
+    connect(m_decoder, &AnimationDecoder::failed, this, &AnimationCache::onFailed);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+AnimationCache::~AnimationCache()
+{
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+AnimationPtr AnimationCache::get(const QString &path)
+{
+    auto it = m_animations.constFind(path);
+    if (it == m_animations.constEnd()) {
+        return AnimationPtr();
+    }
+    m_lru.removeOne(path);
+    m_lru.append(path);
+    return it.value();
+}
+
+bool AnimationCache::isPending(const QString &path) const
+{
+    return m_pending.contains(path);
+}
+
+void AnimationCache::prefetch(const QString &path, bool urgent)
+{
+    if (m_animations.contains(path) || (m_pending.contains(path) && !urgent)) {
+        return;
+    }
+    // 已在排队的预取任务再次以 urgent 提交时，解码线程会把它提到前面
+    m_pending.insert(path);
+    emit requestDecode(path, urgent);
+}
+
+void AnimationCache::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    evict();
+}
+
+qint64 AnimationCache::budget() const
+{
+    return m_budget;
+}
+
+qint64 AnimationCache::usedBytes() const
+{
+    return m_used;
+}
+
+void AnimationCache::onDecoded(const QString &path, AnimationPtr animation)
+{
+    m_pending.remove(path);
+    if (m_animations.contains(path)) {
+        return;//正在解码时又被插队提交过一次，后到的结果丢弃
+    }
+    m_animations.insert(path, animation);
+    m_lru.append(path);
+    m_used += animation->bytes;
+    evict();
+    emit animationReady(path, animation);
+}
+
+void AnimationCache::onFailed(const QString &path, const QString &error)
+{
+    m_pending.remove(path);
+    qWarning() << "动画解码失败:" << path << error;
+    emit animationFailed(path, error);
+}
+
+/*
+ * 超出预算时按最近最少使用淘汰，至少保留刚放进来的那一个
+ */
+void AnimationCache::evict()
+{
+    while (m_used > m_budget && m_lru.size() > 1) {
+        const QString path = m_lru.takeFirst();
+        m_used -= m_animations.take(path)->bytes;
+    }
+}
+
+AnimationPlayer::AnimationPlayer(AnimationScheduler *scheduler, QObject *parent)
+    : QObject{parent}
+    , m_frame(0)
+    , m_elapsed(0)
+{
+    scheduler->addPlayer(this);
+}
+
+void AnimationPlayer::setAnimation(AnimationPtr animation)
+{
+    m_animation = animation;
+    m_frame = 0;
+    m_elapsed = 0;
+    emit animationChanged();
+    if (m_animation && !m_animation->frames.isEmpty()) {
+        // 尺寸相同时沿用画布，第一帧是完整画面，会覆盖上一段动画留下的内容
+        if (m_canvas.size() != m_animation->size) {
+            m_canvas = QImage(m_animation->size, QImage::Format_ARGB32_Premultiplied);
+        }
+        m_animation->frames.first().apply(&m_canvas);
+        emit frameChanged(m_canvas, m_canvas.rect());
+    }
+}
+
+AnimationPtr AnimationPlayer::animation() const
+{
+    return m_animation;
+}
+
+QImage AnimationPlayer::currentFrame() const
+{
+    return m_animation ? m_canvas : QImage();
+}
+
+void AnimationPlayer::refresh()
+{
+    if (m_animation && !m_canvas.isNull()) {
+        emit frameChanged(m_canvas, m_canvas.rect());
+    }
+}
+
+/*
+ * 推进动画时间
+ *
+ * 帧率上限或空闲低帧率下，一拍可能跨过好几帧：各帧是增量的，跨过的帧都要依次画到画布上，
+ * 但只发出一次 frameChanged，变化区域是跨过的各帧变化区域的并集
+ */
+void AnimationPlayer::tick(int elapsedMs)
+{
+    if (!m_animation || m_animation->frames.size() < 2) {
+        return;
+    }
+    const QVector<IndexedFrame> &frames = m_animation->frames;
+    m_elapsed += elapsedMs;
+    int steps = 0;
+    QRect dirty;
+    while (m_elapsed >= frames.at(m_frame).delay && steps < frames.size()) {
+        m_elapsed -= frames.at(m_frame).delay;
+        m_frame = (m_frame + 1) % frames.size();
+        frames.at(m_frame).apply(&m_canvas);
+        dirty |= frames.at(m_frame).dirty;
+        ++steps;
+    }
+    if (steps == frames.size()) {
+        // 跨过了整整一轮（例如系统休眠后），剩余的时间直接丢弃
+        m_elapsed = 0;
+    }
+    if (steps > 0) {
+        emit frameChanged(m_canvas, dirty);
+    }
+}
+
+/*
+ * 换帧对齐到节拍：当前帧已经显示了一半以上时立即换下一帧，刚换过的不再连跳
+ */
+void AnimationPlayer::beat()
+{
+    if (!m_animation || m_animation->frames.size() < 2) {
+        return;
+    }
+    const QVector<IndexedFrame> &frames = m_animation->frames;
+    if (m_elapsed * 2 < frames.at(m_frame).delay) {
+        return;
+    }
+    m_elapsed = 0;
+    m_frame = (m_frame + 1) % frames.size();
+    frames.at(m_frame).apply(&m_canvas);
+    emit frameChanged(m_canvas, frames.at(m_frame).dirty);
+}
@@ -0,0 +1,141 @@
+#ifndef ANIMATIONCACHE_H
+#define ANIMATIONCACHE_H
+
+#include <QObject>
+#include <QImage>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
+#include <QQueue>
+#include "spritepack.h"
+
+class AnimationScheduler;
+
+/*
+ * Animation：解码好的一段动画
+ *
+ * 各帧以增量调色板索引的形式保存（见 IndexedFrame），播放时由 AnimationPlayer 展开到画布上。
+ * 解码完成后不再修改，可以在线程之间、多个播放器之间共享。
+ */
+struct Animation
+{
+    QString path;
+    QSize size;
+    QVector<IndexedFrame> frames;
+    qint64 bytes;//所有帧占用的内存
+};
+
+typedef QSharedPointer<const Animation> AnimationPtr;
+Q_DECLARE_METATYPE(AnimationPtr)
+
+/*
+ * AnimationDecoder：运行在工作线程中的动画解码器
+ *
+ * 内置动画是构建时生成的 .sprite 包（见 SpritePack），只需解压；其他格式用 QImageReader
+ * 逐帧解码后再转换成增量索引帧。每次事件循环只解码一个动画，紧急任务（情绪反应）
+ * 最多等待正在解码的那一个预取任务。
+ */
+class AnimationDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnimationDecoder(QObject *parent = nullptr);
+
+public slots:
+    void enqueue(const QString &path, bool urgent);//urgent 的任务排在所有预取任务之前
+
+signals:
+    void decoded(const QString &path, AnimationPtr animation);
+    void failed(const QString &path, const QString &error);
+
+private:
+    void processNext();
+    void decode(const QString &path);
+    void decodeSprite(const QString &path, const QByteArray &data);
+    void finish(QSharedPointer<Animation> animation);
+
+    QQueue<QString> m_urgent;
+    QQueue<QString> m_background;
+    bool m_scheduled;
+};
+
+/*
+ * AnimationCache：预解码动画的LRU缓存
+ *
+ * prefetch() 把解码交给后台线程，完成后发出 animationReady；get() 只查缓存，不会阻塞。
+ * 缓存按最近使用顺序淘汰，总内存不超过预算（配置项 animation/cacheBudgetMB，默认64MB）。
+ * 正在播放的动画由播放器持有引用，即使被淘汰也不会提前释放。
+ */
+class AnimationCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnimationCache(QObject *parent = nullptr);
+    ~AnimationCache();
+
+    AnimationPtr get(const QString &path);//命中时返回动画并刷新使用顺序，未命中返回空
+    bool isPending(const QString &path) const;
+    void prefetch(const QString &path, bool urgent = false);//urgent：马上就要显示，插队解码
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 usedBytes() const;
+
+signals:
+    void animationReady(const QString &path, AnimationPtr animation);
+    void animationFailed(const QString &path, const QString &error);
+
+    void requestDecode(const QString &path, bool urgent);
+
+private slots:
+    void onDecoded(const QString &path, AnimationPtr animation);
+    void onFailed(const QString &path, const QString &error);
+
+private:
+    void evict();
+
+    QThread m_workerThread;
+    AnimationDecoder *m_decoder;
+    QHash<QString, AnimationPtr> m_animations;
+    QStringList m_lru;//最近使用的在末尾
+    QSet<QString> m_pending;//已提交、尚未解码完成
+    qint64 m_budget;
+    qint64 m_used;
+};
+
+/*
+ * AnimationPlayer：按帧延迟播放一段预解码动画
+ *
+ * 自己不带定时器，由 AnimationScheduler 统一驱动；切换动画只是替换共享指针，不做任何解码。
+ * 播放器持有一张可复用的画布，每到一帧只把这一帧变化的区域展开上去，不为每帧保留整幅图像。
+ */
+class AnimationPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AnimationPlayer(AnimationScheduler *scheduler, QObject *parent = nullptr);
+
+    void setAnimation(AnimationPtr animation);
+    AnimationPtr animation() const;
+    QImage currentFrame() const;
+    void tick(int elapsedMs);//由调度器调用，推进经过的时间
+    void beat();//由调度器在节拍上调用：立即换到下一帧
+
+public slots:
+    void refresh();//重新发出当前整帧（显示控件丢弃了缓存时）
+
+signals:
+    void animationChanged();
+    void frameChanged(const QImage &frame, const QRect &dirty);//frame 是播放器的画布，接收方不要保留引用；dirty：与上一次发出的帧相比变化的区域
+
+private:
+    AnimationPtr m_animation;
+    QImage m_canvas;//当前帧的完整画面
+    int m_frame;
+    int m_elapsed;//当前帧已经显示的毫秒数
+};
+
+#endif // ANIMATIONCACHE_H
@@ -0,0 +1,270 @@
+#include "animationscheduler.h"
+#include "animationcache.h"
+#include "beatdetector.h"
+#include <QApplication>
+#include <QWidget>
+#include <QWindow>
+#include <QCursor>
+#include <QEvent>
+#include <QSettings>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+/*
+ * AnimationScheduler 构造函数
+ *
+ * 帧率上限默认30，空闲时4帧，用户2分钟没有操作视为空闲
+ */
+AnimationScheduler::AnimationScheduler(QObject *parent)
+    : QObject{parent}
+    , m_state(Paused)
+    , m_nextBeat(0)
+    , m_lastBeat(0)
+    , m_beatPeriod(0)
+    , m_carry(0)
+{
+    QSettings settings;
+    m_maxFps = qBound(1, settings.value("animation/maxFps", 30).toInt(), 120);
+    m_idleFps = qBound(1, settings.value("animation/idleFps", 4).toInt(), m_maxFps);
+    m_idleTimeout = settings.value("animation/idleTimeoutSec", 120).toInt() * 1000;
+
+    connect(&m_frameTimer, &QTimer::timeout, this, &AnimationScheduler::tick);
+    m_idleTimer.setInterval(2000);
+    m_idleTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&m_idleTimer, &QTimer::timeout, this, &AnimationScheduler::checkIdle);
+    m_beatTimer.setSingleShot(true);
+    m_beatTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_beatTimer, &QTimer::timeout, this, &AnimationScheduler::onBeatTimer);
+
+    // 本程序窗口内的输入直接记录，其他程序中的操作靠定期检查得到
+    m_lastInput.start();
+    m_lastCursor = QCursor::pos();
+    qApp->installEventFilter(this);
+}
+
+void AnimationScheduler::addPlayer(AnimationPlayer *player)
+{
+    if (m_players.contains(player)) {
+        return;
+    }
+    m_players.append(player);
+    connect(player, &QObject::destroyed, this, [this, player]() {
+        m_players.removeOne(player);
+    });
+}
+
+void AnimationScheduler::removePlayer(AnimationPlayer *player)
+{
+    m_players.removeOne(player);
+    disconnect(player, &QObject::destroyed, this, nullptr);
+}
+
+void AnimationScheduler::watchWindow(QWidget *window)
+{
+    // 窗口及其原生窗口的事件都经过构造函数中安装的应用级事件过滤器
+    m_windows.append(window);
+    updateState();
+}
+
+void AnimationScheduler::setMaxFps(int fps)
+{
+    m_maxFps = qBound(1, fps, 120);
+    m_idleFps = qMin(m_idleFps, m_maxFps);
+    applyState();
+}
+
+int AnimationScheduler::maxFps() const
+{
+    return m_maxFps;
+}
+
+void AnimationScheduler::setIdleFps(int fps)
+{
+    m_idleFps = qBound(1, fps, m_maxFps);
+    applyState();
+}
+
+int AnimationScheduler::idleFps() const
+{
+    return m_idleFps;
+}
+
+void AnimationScheduler::setIdleTimeout(int msec)
+{
+    m_idleTimeout = msec;
+    updateState();
+}
+
+AnimationScheduler::State AnimationScheduler::state() const
+{
+    return m_state;
+}
+
+bool AnimationScheduler::isBeatSynced() const
+{
+    return m_beatPeriod > 0 && BeatDetector::now() - m_lastBeat < m_beatPeriod * 2;
+}
+
+/*
+ * 收到一拍：定时到它被听到的时刻。节拍检测会提前几十毫秒发出，晚到的也立即执行
+ */
+void AnimationScheduler::beat(qint64 timeMs, int periodMs)
+{
+    if (periodMs <= 0 || timeMs <= m_nextBeat) {
+        return;
+    }
+    m_beatPeriod = periodMs;
+    if (m_nextBeat > 0 && m_beatTimer.isActive()) {
+        return;//上一拍还没到，到了之后再定下一拍
+    }
+    m_nextBeat = timeMs;
+    if (m_state == Running) {
+        m_beatTimer.start(int(qMax<qint64>(0, timeMs - BeatDetector::now())));
+    }
+}
+
+void AnimationScheduler::onBeatTimer()
+{
+    m_lastBeat = m_nextBeat;
+    m_nextBeat = 0;
+    for (AnimationPlayer *player : m_players) {
+        player->beat();
+    }
+    emit beatReached();
+}
+
+/*
+ * 每一帧：把上一帧以来经过的时间交给各播放器，由播放器决定是否换帧。
+ * 跟着节拍时按速度缩放（以每分钟120拍为原速，最慢0.75倍、最快1.5倍）
+ */
+void AnimationScheduler::tick()
+{
+    double elapsed = double(m_clock.restart());
+    if (isBeatSynced()) {
+        elapsed = elapsed * qBound(0.75, 500.0 / m_beatPeriod, 1.5) + m_carry;
+    } else {
+        elapsed += m_carry;
+    }
+    const int step = int(elapsed);
+    m_carry = elapsed - step;
+    for (AnimationPlayer *player : m_players) {
+        player->tick(step);
+    }
+}
+
+void AnimationScheduler::checkIdle()
+{
+    const QPoint cursor = QCursor::pos();
+    if (cursor != m_lastCursor) {
+        m_lastCursor = cursor;
+        m_lastInput.restart();
+    }
+    updateState();
+}
+
+void AnimationScheduler::updateState()
+{
+    State state;
+    if (!anyWindowVisible()) {
+        state = Paused;
+    } else if (m_idleTimeout > 0 && idleMsec() >= m_idleTimeout) {
+        state = Idle;
+    } else {
+        state = Running;
+    }
+
+    if (state != m_state) {
+        m_state = state;
+        applyState();
+        emit stateChanged(m_state);
+    }
+}
+
+/*
+ * 按当前状态设置定时器：暂停时两个定时器都停掉，恢复时重置时钟，避免把暂停的时间一次性补上
+ */
+void AnimationScheduler::applyState()
+{
+    if (m_state == Paused) {
+        m_frameTimer.stop();
+        m_idleTimer.stop();
+        m_beatTimer.stop();
+        m_nextBeat = 0;
+        return;
+    }
+
+    const int fps = m_state == Idle ? m_idleFps : m_maxFps;
+    m_frameTimer.setTimerType(m_state == Idle ? Qt::CoarseTimer : Qt::PreciseTimer);
+    m_frameTimer.setInterval(1000 / fps);
+    if (!m_frameTimer.isActive()) {
+        m_clock.restart();
+        m_frameTimer.start();
+    }
+    if (!m_idleTimer.isActive()) {
+        m_idleTimer.start();
+    }
+}
+
+bool AnimationScheduler::anyWindowVisible() const
+{
+    for (const QPointer<QWidget> &window : m_windows) {
+        if (!window || !window->isVisible() || window->isMinimized()) {
+            continue;
+        }
+        // 被完全遮挡时，支持的平台（macOS、Wayland等）会把窗口标记为未暴露
+        if (window->windowHandle() && !window->windowHandle()->isExposed()) {
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+qint64 AnimationScheduler::idleMsec() const
+{
+#ifdef Q_OS_WIN
+    LASTINPUTINFO info;
+    info.cbSize = sizeof(info);
+    if (GetLastInputInfo(&info)) {
+        return qint64(GetTickCount() - info.dwTime);
+    }
+#endif
+    return m_lastInput.elapsed();
+}
+
+/*
+ * 事件过滤
+ *
+ * 被监视窗口的显示、隐藏、最小化、暴露变化都会重新计算状态；
+ * 程序内的键盘鼠标输入会立即把空闲状态唤醒。
+ */
+bool AnimationScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::KeyPress:
+    case QEvent::Wheel:
+        m_lastInput.restart();
+        if (m_state == Idle) {
+            updateState();
+        }
+        break;
+    case QEvent::Show:
+    case QEvent::Hide:
+    case QEvent::WindowStateChange:
+    case QEvent::Expose:
+        for (const QPointer<QWidget> &window : m_windows) {
+            if (window && (window.data() == watched || window->windowHandle() == watched)) {
+                // 状态在事件处理完后才更新，稍后再计算
+                QTimer::singleShot(0, this, &AnimationScheduler::updateState);
+                break;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
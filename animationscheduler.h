@@ -0,0 +1,85 @@
+#ifndef ANIMATIONSCHEDULER_H
+#define ANIMATIONSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QPoint>
+#include <QList>
+
+class QWidget;
+class AnimationPlayer;
+
+/*
+ * AnimationScheduler：所有桌宠动画共用的时钟
+ *
+ * 只有一个帧定时器，每一拍把经过的时间分发给所有播放器，帧率有上限（配置项 animation/maxFps）。
+ * 根据窗口和用户状态切换三种状态：
+ *  - Running：正常帧率；
+ *  - Idle：用户一段时间没有操作（animation/idleTimeoutSec），降到低帧率（animation/idleFps）；
+ *  - Paused：被监视的窗口全部隐藏、最小化或不可见（被遮挡），定时器全部停止，不占CPU。
+ *
+ * 播放音乐时由 beat() 送入节拍：动画速度随节拍快慢调整，每一拍准时让各播放器换帧，
+ * 节拍停止送入两拍之后恢复原速。
+ */
+class AnimationScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum State { Running, Idle, Paused };
+
+    explicit AnimationScheduler(QObject *parent = nullptr);
+
+    void addPlayer(AnimationPlayer *player);
+    void removePlayer(AnimationPlayer *player);
+    void watchWindow(QWidget *window);//所有被监视的窗口都不可见时暂停
+
+    void setMaxFps(int fps);
+    int maxFps() const;
+    void setIdleFps(int fps);
+    int idleFps() const;
+    void setIdleTimeout(int msec);
+    State state() const;
+    bool isBeatSynced() const;//最近还在收到节拍
+
+public slots:
+    void beat(qint64 timeMs, int periodMs);//timeMs：BeatDetector::now() 时间
+
+signals:
+    void stateChanged(AnimationScheduler::State state);
+    void beatReached();//节拍到达，各播放器刚换过帧
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void tick();
+    void checkIdle();
+    void updateState();
+    void onBeatTimer();
+
+private:
+    bool anyWindowVisible() const;
+    qint64 idleMsec() const;//距离用户最后一次输入的毫秒数
+    void applyState();
+
+    QList<AnimationPlayer*> m_players;
+    QList<QPointer<QWidget>> m_windows;
+    QTimer m_frameTimer;
+    QTimer m_idleTimer;//低频检查用户是否离开
+    QTimer m_beatTimer;//定到下一拍被听到的时刻
+    QElapsedTimer m_clock;//两拍之间经过的时间
+    QElapsedTimer m_lastInput;
+    QPoint m_lastCursor;
+    State m_state;
+    int m_maxFps;
+    int m_idleFps;
+    int m_idleTimeout;
+    qint64 m_nextBeat;//下一拍的时刻，0 表示没有
+    qint64 m_lastBeat;//最近一拍的时刻
+    int m_beatPeriod;//最近的节拍周期（毫秒）
+    double m_carry;//按节拍调速后不足1毫秒的部分
+};
+
+#endif // ANIMATIONSCHEDULER_H
@@ -0,0 +1,319 @@
+#include "assetpack.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSet>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const char Magic[4] = {'P', 'P', 'A', 'K'};
+const int HeaderSize = 16;
+const qint64 Alignment = 16;
+
+qint64 aligned(qint64 offset)
+{
+    return (offset + Alignment - 1) / Alignment * Alignment;
+}
+
+void appendU16(QByteArray &out, quint16 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendU32(QByteArray &out, quint32 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendU64(QByteArray &out, quint64 value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+bool fail(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+} // namespace
+
+AssetPack::AssetPack()
+    : m_map(nullptr)
+    , m_size(0)
+{
+}
+
+/*
+ * 打开资源包：映射整个文件，只解析目录
+ *
+ * 映射不会立即读入文件内容，各条目的页面在第一次访问时才换入
+ */
+bool AssetPack::open(const QString &path, QString *error)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(error, m_file.errorString());
+    }
+    m_size = m_file.size();
+    if (m_size < HeaderSize) {
+        return fail(error, "资源包文件过小");
+    }
+    m_map = m_file.map(0, m_size);
+    if (!m_map) {
+        return fail(error, m_file.errorString());
+    }
+    if (memcmp(m_map, Magic, sizeof(Magic)) != 0) {
+        return fail(error, "不是资源包文件");
+    }
+    const quint32 version = qFromLittleEndian<quint32>(m_map + 4);
+    if (version != Version) {
+        return fail(error, QString("不支持的资源包版本 %1").arg(version));
+    }
+    const quint32 count = qFromLittleEndian<quint32>(m_map + 8);
+    const quint32 tocSize = qFromLittleEndian<quint32>(m_map + 12);
+    if (HeaderSize + qint64(tocSize) > m_size) {
+        return fail(error, "资源包目录不完整");
+    }
+
+    const uchar *p = m_map + HeaderSize;
+    const uchar *end = p + tocSize;
+    m_entries.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        if (end - p < 2) {
+            return fail(error, "资源包目录不完整");
+        }
+        const quint16 nameLength = qFromLittleEndian<quint16>(p);
+        p += 2;
+        if (end - p < nameLength + 16) {
+            return fail(error, "资源包目录不完整");
+        }
+        const QString name = QString::fromUtf8(reinterpret_cast<const char *>(p), nameLength);
+        p += nameLength;
+        Entry entry;
+        entry.offset = qint64(qFromLittleEndian<quint64>(p));
+        entry.size = qint64(qFromLittleEndian<quint64>(p + 8));
+        p += 16;
+        if (entry.offset < 0 || entry.size < 0 || entry.offset + entry.size > m_size) {
+            return fail(error, QString("资源包条目越界：%1").arg(name));
+        }
+        m_entries.insert(name, entry);
+    }
+    return true;
+}
+
+QString AssetPack::path() const
+{
+    return m_file.fileName();
+}
+
+bool AssetPack::contains(const QString &name) const
+{
+    return m_entries.contains(name);
+}
+
+QByteArray AssetPack::data(const QString &name) const
+{
+    auto it = m_entries.constFind(name);
+    if (it == m_entries.constEnd()) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(m_map + it->offset), it->size);
+}
+
+QStringList AssetPack::names() const
+{
+    return m_entries.keys();
+}
+
+/*
+ * 写出资源包
+ *
+ * 先根据文件大小排好目录和偏移，再逐个复制文件内容，不需要把所有文件同时读入内存
+ */
+bool AssetPack::write(const QString &packPath, const QList<QPair<QString, QString>> &files, QString *error)
+{
+    QList<qint64> sizes;
+    qint64 tocSize = 0;
+    for (const auto &file : files) {
+        const QFileInfo info(file.second);
+        if (!info.isFile()) {
+            return fail(error, QString("找不到文件：%1").arg(file.second));
+        }
+        const QByteArray name = file.first.toUtf8();
+        if (name.size() > 0xFFFF) {
+            return fail(error, QString("条目名称过长：%1").arg(file.first));
+        }
+        sizes.append(info.size());
+        tocSize += 2 + name.size() + 16;
+    }
+
+    QByteArray head(Magic, sizeof(Magic));
+    appendU32(head, Version);
+    appendU32(head, quint32(files.size()));
+    appendU32(head, quint32(tocSize));
+    qint64 offset = aligned(HeaderSize + tocSize);
+    QList<qint64> offsets;
+    for (int i = 0; i < files.size(); ++i) {
+        const QByteArray name = files.at(i).first.toUtf8();
+        appendU16(head, quint16(name.size()));
+        head.append(name);
+        appendU64(head, quint64(offset));
+        appendU64(head, quint64(sizes.at(i)));
+        offsets.append(offset);
+        offset = aligned(offset + sizes.at(i));
+    }
+
+    QSaveFile out(packPath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return fail(error, out.errorString());
+    }
+    out.write(head);
+    for (int i = 0; i < files.size(); ++i) {
+        out.write(QByteArray(offsets.at(i) - out.pos(), '\0'));
+        QFile in(files.at(i).second);
+        if (!in.open(QIODevice::ReadOnly)) {
+            out.cancelWriting();
+            return fail(error, in.errorString());
+        }
+        while (!in.atEnd()) {
+            out.write(in.read(1024 * 1024));
+        }
+    }
+    if (!out.commit()) {
+        return fail(error, out.errorString());
+    }
+    return true;
+}
+
+/*
+ * 第一次调用时挂载资源包，C++11起局部静态变量的初始化是线程安全的
+ */
+AssetLibrary &AssetLibrary::instance()
+{
+    static AssetLibrary library;
+    return library;
+}
+
+QString AssetLibrary::userPackDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/packs";
+}
+
+AssetLibrary::AssetLibrary()
+{
+    // 内置资源包：程序所在目录，macOS 包内放在 Resources
+    const QString appDir = QCoreApplication::applicationDirPath();
+    for (const QString &path : {appDir + "/petmiao.pak", appDir + "/../Resources/petmiao.pak"}) {
+        if (QFile::exists(path)) {
+            mount(path);
+            break;
+        }
+    }
+    // 用户资源包按文件名顺序挂载
+    QDir userDir(userPackDir());
+    const QStringList packs = userDir.entryList({"*.pak"}, QDir::Files, QDir::Name);
+    for (const QString &pack : packs) {
+        mount(userDir.filePath(pack));
+    }
+}
+
+AssetLibrary::~AssetLibrary()
+{
+    qDeleteAll(m_packs);
+}
+
+void AssetLibrary::mount(const QString &path)
+{
+    auto pack = new AssetPack;
+    QString error;
+    if (!pack->open(path, &error)) {
+        qWarning() << "无法加载资源包" << path << ":" << error;
+        delete pack;
+        return;
+    }
+    m_packs.prepend(pack);
+}
+
+bool AssetLibrary::contains(const QString &name) const
+{
+    for (const AssetPack *pack : m_packs) {
+        if (pack->contains(name)) {
+            return true;
+        }
+    }
+    return QFile::exists(":/" + name);
+}
+
+/*
+ * 取一个资源的内容
+ *
+ * @param name：条目名称，如 "image/animation1.sprite"，与qrc中去掉 ":/" 的路径一致
+ * @return 资源包中的条目直接指向映射内存；qrc资源未压缩时同样映射，否则读出一份
+ */
+QByteArray AssetLibrary::data(const QString &name) const
+{
+    for (const AssetPack *pack : m_packs) {
+        if (pack->contains(name)) {
+            return pack->data(name);
+        }
+    }
+    QFile file(":/" + name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    // qrc资源属于程序本身，映射在程序退出前一直有效
+    if (const uchar *mapped = file.map(0, file.size())) {
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), file.size());
+    }
+    return file.readAll();
+}
+
+QIODevice *AssetLibrary::open(const QString &name, QObject *parent) const
+{
+    const QByteArray bytes = data(name);
+    if (bytes.isNull()) {
+        return nullptr;
+    }
+    auto buffer = new QBuffer(parent);
+    buffer->setData(bytes);
+    buffer->open(QIODevice::ReadOnly);
+    return buffer;
+}
+
+QStringList AssetLibrary::list(const QString &prefix) const
+{
+    QSet<QString> names;
+    for (const AssetPack *pack : m_packs) {
+        const QStringList packNames = pack->names();
+        for (const QString &name : packNames) {
+            if (name.startsWith(prefix)) {
+                names.insert(name);
+            }
+        }
+    }
+    // qrc中的必需品
+    const int slash = prefix.lastIndexOf('/');
+    QDirIterator it(":/" + prefix.left(slash + 1), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString name = it.next().mid(2);
+        if (name.startsWith(prefix)) {
+            names.insert(name);
+        }
+    }
+    QStringList sorted(names.begin(), names.end());
+    sorted.sort();
+    return sorted;
+}
@@ -0,0 +1,82 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QStringList>
+#include <QByteArray>
+
+class QIODevice;
+class QObject;
+
+/*
+ * AssetPack：外置资源包（.pak）
+ *
+ * 启动时整个文件只做内存映射，并读取开头的目录；条目内容直到第一次使用时才会被操作系统换入内存。
+ * 取出的数据直接指向映射区域，不复制。
+ *
+ * 文件格式（小端）：
+ *   "PPAK" | u32 版本 | u32 条目数 | u32 目录字节数
+ *   目录：条目数 × { u16 名称长度 | UTF-8名称 | u64 数据偏移 | u64 数据长度 }
+ *   数据：各条目原样存放，起始位置按16字节对齐
+ */
+class AssetPack
+{
+public:
+    static const quint32 Version = 1;
+
+    AssetPack();
+
+    bool open(const QString &path, QString *error = nullptr);
+    QString path() const;
+    bool contains(const QString &name) const;
+    QByteArray data(const QString &name) const;//指向映射内存，资源包存在期间有效
+    QStringList names() const;
+
+    // 打包：files 为 (条目名称, 源文件路径)
+    static bool write(const QString &packPath, const QList<QPair<QString, QString>> &files, QString *error = nullptr);
+
+private:
+    struct Entry
+    {
+        qint64 offset;
+        qint64 size;
+    };
+
+    QFile m_file;
+    const uchar *m_map;
+    qint64 m_size;
+    QHash<QString, Entry> m_entries;
+};
+
+/*
+ * AssetLibrary：桌宠的资源查找入口
+ *
+ * 依次挂载程序目录下的内置资源包 petmiao.pak 和用户目录（AppDataLocation/packs）中的 .pak，
+ * 后挂载的同名条目覆盖先挂载的，用户不用重新编译就能添加或替换动画和音乐。
+ * 资源包中找不到时回退到编译进程序的qrc资源（只保留图标、一个日常动画等必需品）。
+ *
+ * 第一次调用 instance() 时挂载，之后只读，可以在任意线程中使用。
+ */
+class AssetLibrary
+{
+public:
+    static AssetLibrary &instance();
+    static QString userPackDir();
+
+    bool contains(const QString &name) const;
+    QByteArray data(const QString &name) const;
+    QIODevice *open(const QString &name, QObject *parent = nullptr) const;//只读设备，数据不复制
+    QStringList list(const QString &prefix) const;//名称以 prefix 开头的所有条目（去重、排序）
+
+private:
+    AssetLibrary();
+    ~AssetLibrary();
+    void mount(const QString &path);
+
+    QList<AssetPack*> m_packs;//后挂载的在前面，查找时优先
+};
+
+#endif // ASSETPACK_H
@@ -0,0 +1,88 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+/*
+ * AudioRingBuffer：单生产者/单消费者无锁环形缓冲区
+ *
+ * 音频回调线程只调用 write()，工作线程只调用 read()/available()，两边都不加锁、不分配内存。
+ * 容量会向上取整为2的幂，读写位置单调递增，用掩码取下标。
+ * 缓冲区满时 write() 只写入能放下的部分并返回实际写入数量（丢弃最新数据，不阻塞音频线程）。
+ */
+template <typename T>
+class AudioRingBuffer
+{
+public:
+    explicit AudioRingBuffer(std::size_t capacity = 1 << 16)
+    {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_buffer.resize(size);
+        m_mask = size - 1;
+    }
+
+    AudioRingBuffer(const AudioRingBuffer &) = delete;
+    AudioRingBuffer &operator=(const AudioRingBuffer &) = delete;
+
+    std::size_t capacity() const { return m_buffer.size(); }
+
+    // 可读取的元素数量（消费者线程调用）
+    std::size_t available() const
+    {
+        return m_writePos.load(std::memory_order_acquire) - m_readPos.load(std::memory_order_relaxed);
+    }
+
+    // 可写入的元素数量（生产者线程调用）
+    std::size_t freeSpace() const
+    {
+        return m_buffer.size() - (m_writePos.load(std::memory_order_relaxed) - m_readPos.load(std::memory_order_acquire));
+    }
+
+    std::size_t write(const T *data, std::size_t count)
+    {
+        const std::size_t writePos = m_writePos.load(std::memory_order_relaxed);
+        count = std::min(count, m_buffer.size() - (writePos - m_readPos.load(std::memory_order_acquire)));
+        const std::size_t start = writePos & m_mask;
+        const std::size_t first = std::min(count, m_buffer.size() - start);
+        std::copy(data, data + first, m_buffer.begin() + start);
+        std::copy(data + first, data + count, m_buffer.begin());
+        m_writePos.store(writePos + count, std::memory_order_release);
+        return count;
+    }
+
+    std::size_t read(T *data, std::size_t count)
+    {
+        const std::size_t readPos = m_readPos.load(std::memory_order_relaxed);
+        count = std::min(count, m_writePos.load(std::memory_order_acquire) - readPos);
+        const std::size_t start = readPos & m_mask;
+        const std::size_t first = std::min(count, m_buffer.size() - start);
+        std::copy(m_buffer.begin() + start, m_buffer.begin() + start + first, data);
+        std::copy(m_buffer.begin(), m_buffer.begin() + (count - first), data + first);
+        m_readPos.store(readPos + count, std::memory_order_release);
+        return count;
+    }
+
+    // 丢弃所有未读数据（消费者线程调用）
+    void clear()
+    {
+        m_readPos.store(m_writePos.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<T> m_buffer;
+    std::size_t m_mask = 0;
+    alignas(64) std::atomic<std::size_t> m_writePos{0};//生产者和消费者的位置分开放在不同缓存行，避免伪共享
+    alignas(64) std::atomic<std::size_t> m_readPos{0};
+};
+
+// 从播放的音频线程分出一路浮点PCM给分析线程，两边共同持有，谁最后释放都安全
+typedef std::shared_ptr<AudioRingBuffer<float>> AudioTap;
+
+#endif // AUDIORINGBUFFER_H
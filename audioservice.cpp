@@ -0,0 +1,454 @@
+#include "audioservice.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QDebug>
+#include "assetpack.h"
+#include "musiclibrary.h"
+#include "playbackengine.h"
+#include "playlistmodel.h"
+#include "spectrumanalyzer.h"
+#include "beatdetector.h"
+#include "waveformcache.h"
+
+/*
+ * AudioService 构造函数
+ *
+ * 读入资源包中的歌，用户音乐目录在后台扫描，扫到的歌逐步追加到列表
+ */
+AudioService::AudioService(QObject *parent)
+    : QObject{parent}
+    , m_library(nullptr)
+    , m_builtinCount(0)
+    , m_placeholder(false)
+    , m_currentIndex(0)
+    , m_status(Idle)
+    , m_normalize(true)
+    , m_volume(60)// 默认音量设置60%
+    , m_ducked(false)
+    , m_spectrumVisible(false)
+{
+    // 播放引擎：下一首预先解码，切歌无间隙，可设置淡入淡出
+    m_engine = new PlaybackEngine(this);
+    m_spectrum = new SpectrumAnalyzer(m_engine->sampleRate(), this);
+    m_waveform = new WaveformCache(this);
+    m_beats = new BeatDetector(m_engine->sampleRate(), this);
+    m_model = new PlaylistModel(this);
+    applyVolume();
+
+    connect(m_engine, &PlaybackEngine::advanced, this, &AudioService::onTrackAdvanced);
+    connect(m_engine, &PlaybackEngine::stateChanged, this, [this]() {
+        // 列表播完或下一首打不开时引擎自己停下
+        updateSpectrum();
+        updateBeats();
+    });
+    connect(m_model, &QAbstractItemModel::modelReset, this, [this]() {
+        // 筛选或排序的结果出来后，下一首按新的顺序预先打开
+        if (isPlaying()) {
+            queueNext();
+        }
+    });
+
+    loadSongs();
+    setupLibrary();
+}
+
+AudioService::~AudioService()
+{
+    // 引擎、曲库和分析线程都是子对象，引擎析构时停止音频输出，曲库析构时保存索引
+}
+
+PlaybackEngine *AudioService::engine() const
+{
+    return m_engine;
+}
+
+MusicLibrary *AudioService::library() const
+{
+    return m_library;
+}
+
+PlaylistModel *AudioService::model() const
+{
+    return m_model;
+}
+
+SpectrumAnalyzer *AudioService::spectrum() const
+{
+    return m_spectrum;
+}
+
+WaveformCache *AudioService::waveform() const
+{
+    return m_waveform;
+}
+
+BeatDetector *AudioService::beatDetector() const
+{
+    return m_beats;
+}
+
+int AudioService::currentIndex() const
+{
+    return m_currentIndex;
+}
+
+QString AudioService::currentTitle() const
+{
+    return m_model->title(m_currentIndex);
+}
+
+AudioService::Status AudioService::status() const
+{
+    return m_status;
+}
+
+bool AudioService::isPlaying() const
+{
+    return m_engine->state() == PlaybackEngine::PlayingState;
+}
+
+bool AudioService::isNormalized() const
+{
+    return m_normalize;
+}
+
+void AudioService::setNormalized(bool normalize)
+{
+    m_normalize = normalize;
+    QSettings settings;
+    settings.setValue("music/normalize", normalize);
+    m_engine->setGain(trackGain(m_engine->source()));
+    if (isPlaying()) {
+        queueNext();
+    }
+}
+
+int AudioService::volume() const
+{
+    return m_volume;
+}
+
+void AudioService::setVolume(int volume)
+{
+    m_volume = qBound(0, volume, 100);
+    applyVolume();
+}
+
+void AudioService::setDucked(bool ducked)
+{
+    if (m_ducked != ducked) {
+        m_ducked = ducked;
+        applyVolume();
+    }
+}
+
+void AudioService::applyVolume()
+{
+    // 压低时保留30%音量，说完立即恢复设定的音量
+    const float volume = m_volume / 100.0f;
+    m_engine->setVolume(m_ducked ? volume * 0.3f : volume);
+}
+
+/*
+ * 释放重量级资源
+ * 由会话管理器在播放器窗口隐藏一段时间后调用：引擎关闭音频输出、卸载两个解码器和缓冲区，
+ * 记住当前进度，下次播放时重新打开文件并跳转回原位置
+ */
+void AudioService::releaseResources()
+{
+    if (isPlaying()) {
+        return;
+    }
+    m_engine->release();
+}
+
+void AudioService::setSpectrumVisible(bool visible)
+{
+    m_spectrumVisible = visible;
+    updateSpectrum();
+}
+
+/*
+ * 只在看得见频谱的时候分析：窗口隐藏或暂停时引擎不再分出数据，分析线程随之停下
+ */
+void AudioService::updateSpectrum()
+{
+    if (m_spectrumVisible && isPlaying()) {
+        m_spectrum->setActive(true);
+        m_engine->addTap(m_spectrum->tap());
+    } else {
+        m_engine->removeTap(m_spectrum->tap());
+        m_spectrum->setActive(false);
+    }
+}
+
+/*
+ * 节拍检测只要在播放就运行（没有窗口时桌宠也跟着节拍动）
+ */
+void AudioService::updateBeats()
+{
+    if (isPlaying()) {
+        m_beats->setLatency(m_engine->outputLatency());
+        m_beats->setActive(true);
+        m_engine->addTap(m_beats->tap());
+    } else {
+        m_engine->removeTap(m_beats->tap());
+        m_beats->setActive(false);
+    }
+}
+
+/*
+ * 打开一首歌：资源包中的歌直接从映射的内存解码，不解压、不复制到临时文件
+ *
+ * @return 资源不存在时返回false
+ */
+bool AudioService::openSong(int index)
+{
+    const QString name = m_model->path(index);
+    const bool exists = QDir::isAbsolutePath(name) ? QFileInfo::exists(name) : AssetLibrary::instance().contains(name);
+    return exists && m_engine->load(name, 0, trackGain(name));
+}
+
+/*
+ * 响度均衡：按曲库中记录的响度换算的增益，关闭或还没分析过时为1
+ */
+float AudioService::trackGain(const QString &name) const
+{
+    return m_normalize && m_library ? m_library->playbackGain(name) : 1.0f;
+}
+
+/*
+ * 把列表中的下一首交给引擎预先打开，当前歌曲播完时直接接上
+ */
+void AudioService::queueNext()
+{
+    if (m_placeholder || m_model->trackCount() == 0) {
+        return;
+    }
+    const QString next = m_model->path(m_model->neighbour(m_currentIndex, 1));
+    m_engine->setNext(next, trackGain(next));
+}
+
+void AudioService::setStatus(Status status)
+{
+    m_status = status;
+    emit currentChanged();
+}
+
+void AudioService::loadSongs()
+{
+    //清空现有歌曲
+    m_model->clear();
+    QVector<PlaylistEntry> entries;
+    //扫描资源包中的音乐，用户资源包里的歌也会出现在列表中
+    const QStringList names = AssetLibrary::instance().list("music/");
+    for (const QString &name : names)
+    {
+        if (!name.endsWith(".mp3") && !name.endsWith(".wav") && !name.endsWith(".flac")) {
+            continue;
+        }
+        QString baseName = QFileInfo(name).baseName(); // 不带扩展名的文件名
+        // 添加到歌曲列表
+        PlaylistEntry entry;
+        entry.title = baseName;
+        entry.path = name;
+        entries.append(entry);
+
+        qDebug() << "找到音乐文件:" << name;
+    }
+    m_builtinCount = entries.size();
+    // 如果没有找到音乐文件，添加默认提示（曲库扫到歌后移除）
+    m_placeholder = entries.isEmpty();
+    if (m_placeholder) {
+        PlaylistEntry entry;
+        entry.title = "未找到音乐文件";
+        entry.path = "请将音乐打包到资源包中";
+        entries.append(entry);
+        qDebug() << "未找到音乐文件，请检查资源包 petmiao.pak";
+    }
+    m_model->appendTracks(entries);
+
+    // 设置第一首歌为当前歌曲
+    m_currentIndex = 0;
+    setStatus(Idle);
+}
+
+void AudioService::setupLibrary()
+{
+    m_library = new MusicLibrary(this);
+    connect(m_library, &MusicLibrary::tracksAdded, this, &AudioService::onLibraryTracksAdded);
+    connect(m_library, &MusicLibrary::trackChanged, this, [this](int row) {
+        const int index = m_builtinCount + row;
+        if (!m_placeholder && index < m_model->trackCount()) {
+            const LibraryTrack &track = m_library->tracks().at(row);
+            m_model->setTrackText(index, track.title, track.artist, track.album);
+        }
+    });
+    connect(m_library, &MusicLibrary::tracksRemoved, this, &AudioService::rebuildLibrarySongs);
+
+    // 内置歌曲也在后台分析响度，结果保存在配置中
+    QSettings settings;
+    m_normalize = settings.value("music/normalize", true).toBool();
+    QStringList builtins;
+    for (int i = 0; !m_placeholder && i < m_builtinCount; ++i) {
+        builtins.append(m_model->path(i));
+    }
+    m_library->analyzeBuiltins(builtins);
+}
+
+/*
+ * 曲库新扫到的歌追加在内置歌曲之后，一批只更新一次列表
+ */
+void AudioService::onLibraryTracksAdded(int first, int count)
+{
+    const bool wasPlaceholder = m_placeholder;
+    if (m_placeholder) {
+        m_model->clear();
+        m_placeholder = false;
+        m_currentIndex = 0;
+    }
+    const QVector<LibraryTrack> &tracks = m_library->tracks();
+    QVector<PlaylistEntry> entries;
+    entries.reserve(count);
+    for (int row = first; row < first + count; ++row) {
+        const LibraryTrack &track = tracks.at(row);
+        PlaylistEntry entry;
+        entry.title = track.title;
+        entry.artist = track.artist;
+        entry.album = track.album;
+        entry.path = track.path;
+        entries.append(entry);
+    }
+    m_model->appendTracks(entries);
+    if (wasPlaceholder) {
+        emit currentChanged();
+    }
+}
+
+/*
+ * 曲库有歌被移除时按当前曲库重建列表中曲库的部分，当前歌曲尽量保持不变
+ */
+void AudioService::rebuildLibrarySongs()
+{
+    const QString current = m_model->path(m_currentIndex);
+    if (!m_placeholder) {
+        m_model->truncate(m_builtinCount);
+    }
+    if (!m_library->tracks().isEmpty()) {
+        onLibraryTracksAdded(0, m_library->tracks().size());
+    }
+    m_currentIndex = qMax(0, m_model->findPath(current));
+    if (m_model->trackCount() == 0) {
+        m_placeholder = true;
+        PlaylistEntry entry;
+        entry.title = "未找到音乐文件";
+        entry.path = "请将音乐打包到资源包中";
+        m_model->appendTracks({entry});
+    }
+    emit currentChanged();
+}
+
+//播放逻辑
+void AudioService::play()
+{
+    if (!isPlaying()) {
+        playPause();
+    }
+}
+
+void AudioService::pause()
+{
+    if (isPlaying()) {
+        m_engine->pause();
+    }
+}
+
+void AudioService::playPause()
+{
+    if (m_model->trackCount() == 0)
+    {
+        qDebug() << "没有可播放的音乐文件";
+        return;
+    }
+    if (isPlaying())
+    {
+        m_engine->pause();
+        return;
+    }
+    QString filePath = m_model->path(m_currentIndex);
+
+    // 暂停后继续播放时不重新打开，否则会从头开始
+    if (m_engine->source() != filePath && !openSong(m_currentIndex)) {
+        setStatus(Missing);
+        return;
+    }
+
+    m_engine->play();
+    queueNext();
+    setStatus(Playing);
+
+    qDebug() << "正在播放:" << filePath;
+}
+
+/*
+ * 换到 index
+ *
+ * @param keepPlaying：正在播放时直接播放新的歌曲（下一首已经预先打开时没有停顿）
+ */
+void AudioService::setCurrent(int index, bool keepPlaying)
+{
+    if (index < 0 || index >= m_model->trackCount()) {
+        return;
+    }
+    m_currentIndex = index;
+
+    const bool playing = keepPlaying && isPlaying();
+    if (!playing) {
+        m_engine->pause();
+    }
+
+    // 如果是真实音乐文件，准备播放
+    if (!openSong(m_currentIndex)) {
+        m_engine->stop();
+        setStatus(Missing);
+    } else if (playing) {
+        queueNext();
+        setStatus(Playing);
+    } else {
+        setStatus(Ready);
+    }
+}
+
+void AudioService::next()
+{
+    if (m_model->trackCount() == 0) return;
+
+    setCurrent(m_model->neighbour(m_currentIndex, 1), true);// 如果正在播放，自动播放下一首
+}
+
+void AudioService::previous()
+{
+    if (m_model->trackCount() == 0) return;
+
+    setCurrent(m_model->neighbour(m_currentIndex, -1), false);
+}
+
+void AudioService::selectTrack(int index)
+{
+    setCurrent(index, false);
+}
+
+/*
+ * 引擎已经接上了预先打开的下一首：只更新当前歌曲
+ */
+void AudioService::onTrackAdvanced(const QString &name)
+{
+    int index = m_model->neighbour(m_currentIndex, 1);
+    if (m_model->path(index) != name) {
+        index = qMax(0, m_model->findPath(name));// 预先打开之后列表有变化
+    }
+    m_currentIndex = index;
+    queueNext();
+    setStatus(Playing);
+}
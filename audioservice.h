@@ -0,0 +1,107 @@
+#ifndef AUDIOSERVICE_H
+#define AUDIOSERVICE_H
+
+#include <QObject>
+#include <QString>
+
+class MusicLibrary;
+class PlaybackEngine;
+class PlaylistModel;
+class SpectrumAnalyzer;
+class WaveformCache;
+class BeatDetector;
+
+/*
+ * AudioService：没有界面的音乐播放服务
+ *
+ * 播放引擎、曲库、歌曲列表、当前歌曲、音量和节拍检测都在这里，由会话管理器持有，
+ * 第一次用到音乐时创建，之后一直存在。播放器窗口只是它的视图：按钮调用这里的槽，
+ * 标签和列表跟着这里的信号更新。窗口长时间隐藏后整个销毁，音乐照常播放，
+ * 远程命令也直接控制服务，不需要创建窗口。
+ *
+ * 频谱和波形只给窗口用：窗口可见时 setSpectrumVisible(true)，波形由窗口按需向 waveform() 请求。
+ */
+class AudioService : public QObject
+{
+    Q_OBJECT
+public:
+    // 当前歌曲的状态，播放器窗口显示为歌手一栏的提示
+    enum Status {
+        Idle,//还没有选过歌
+        Ready,//已经打开，等待播放
+        Playing,
+        Missing//文件不存在或无法打开
+    };
+    Q_ENUM(Status)
+
+    explicit AudioService(QObject *parent = nullptr);
+    ~AudioService();
+
+    PlaybackEngine *engine() const;
+    MusicLibrary *library() const;
+    PlaylistModel *model() const;
+    SpectrumAnalyzer *spectrum() const;
+    WaveformCache *waveform() const;
+    BeatDetector *beatDetector() const;//播放时发出节拍，桌宠动画跟着节拍
+
+    int currentIndex() const;//当前歌曲在 model() 中的编号（不是显示的行）
+    QString currentTitle() const;
+    Status status() const;
+    bool isPlaying() const;
+
+    bool isNormalized() const;
+    void setNormalized(bool normalize);//响度均衡，配置项 music/normalize，切换后当前歌曲立即生效
+    int volume() const;//0~100
+
+    void setSpectrumVisible(bool visible);//有看得见的频谱时才分析混音输出
+    void releaseResources();//长时间没有播放时释放已解码的媒体，保留歌曲和进度
+
+public slots:
+    void play();
+    void pause();
+    void playPause();
+    void next();
+    void previous();
+    void selectTrack(int index);//换到这首歌，不自动播放
+    void setVolume(int volume);
+    void setDucked(bool ducked);//猫猫说话时临时压低音乐音量
+
+signals:
+    void currentChanged();//当前歌曲或它的状态变了
+
+private slots:
+    void onLibraryTracksAdded(int first, int count);
+    void rebuildLibrarySongs();
+    void onTrackAdvanced(const QString &name);
+
+private:
+    void loadSongs();
+    void setupLibrary();
+    void setCurrent(int index, bool keepPlaying);
+    void setStatus(Status status);
+    bool openSong(int index);
+    void queueNext();
+    float trackGain(const QString &name) const;
+    void updateSpectrum();
+    void updateBeats();
+    void applyVolume();
+
+    PlaybackEngine *m_engine;//两个解码器：当前歌曲和预先打开的下一首
+    SpectrumAnalyzer *m_spectrum;
+    WaveformCache *m_waveform;//当前歌曲的波形概览，在后台解码
+    BeatDetector *m_beats;//正在播放时检测节拍
+
+    // 歌曲列表：先是资源包中的内置歌曲，之后是曲库中的歌
+    MusicLibrary *m_library;
+    PlaylistModel *m_model;
+    int m_builtinCount;
+    bool m_placeholder;//列表中只有"未找到音乐文件"提示
+    int m_currentIndex;
+    Status m_status;
+    bool m_normalize;
+    int m_volume;
+    bool m_ducked;
+    bool m_spectrumVisible;
+};
+
+#endif // AUDIOSERVICE_H
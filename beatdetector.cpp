@@ -0,0 +1,426 @@
+#include "beatdetector.h"
+#include <QElapsedTimer>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PET_FLUX_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PET_FLUX_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const double EnvelopeSeconds = 6.0;//估计节拍用的通量长度
+const double MinBpm = 60.0;
+const double MaxBpm = 180.0;
+const double PreferredBpm = 120.0;//自相关按与它相差的八度数加权，减少快一倍/慢一倍的误判
+const int ThresholdHops = 24;//起音门限取前面这么多帧的平均
+const float ThresholdRatio = 1.4f;
+const float MinFlux = 0.02f;//静音和底噪不算起音
+const double MinOnsetGap = 0.1;//秒
+const double MinConfidence = 0.15;//自相关峰值相对零延迟的比例
+const double MatchWindow = 0.2;//起音离预测节拍不超过周期的这个比例才算对上
+const double PhaseGain = 0.3;//对上时相位向起音移动的比例
+const double LostSeconds = 4.0;//这么久没有起音对上节拍就不再发出
+const int ProcessMs = 10;
+const int AheadMs = 60;//节拍提前发出，界面线程按时刻定时
+const std::size_t ReadChunk = 4096;
+
+} // namespace
+
+// ==================== BeatTracker ====================
+
+BeatTracker::BeatTracker(int sampleRate)
+    : m_sampleRate(sampleRate > 0 ? sampleRate : 48000)
+    , m_fft(FftSize)
+    , m_window(Fft::hannWindow(FftSize))
+    , m_history(FftSize, 0.0f)
+    , m_historyPos(0)
+    , m_re(FftSize)
+    , m_im(FftSize)
+    , m_magnitude(FftSize / 2, 0.0f)
+    , m_envelope(std::size_t(EnvelopeSeconds * m_sampleRate / Hop), 0.0f)
+    , m_frames(0)
+    , m_hops(0)
+    , m_hopFill(0)
+    , m_lastOnsetHop(-1000)
+    , m_onsets(0)
+    , m_period(0)
+    , m_beat(0)
+    , m_lastMatch(-1e12)
+{
+}
+
+void BeatTracker::process(const float *stereo, qint64 frames)
+{
+    const std::size_t mask = FftSize - 1;
+    for (qint64 f = 0; f < frames; ++f) {
+        m_history[m_historyPos] = 0.5f * (stereo[f * 2] + stereo[f * 2 + 1]);
+        m_historyPos = (m_historyPos + 1) & mask;
+        ++m_frames;
+        if (++m_hopFill == Hop) {
+            m_hopFill = 0;
+            analyzeHop();
+        }
+    }
+}
+
+qint64 BeatTracker::frames() const
+{
+    return m_frames;
+}
+
+bool BeatTracker::isLocked() const
+{
+    return m_period > 0 && m_frames - m_lastMatch < LostSeconds * m_sampleRate;
+}
+
+double BeatTracker::period() const
+{
+    return m_period;
+}
+
+double BeatTracker::beatAfter(double frame) const
+{
+    if (m_period <= 0) {
+        return frame;
+    }
+    return m_beat + std::floor((frame - m_beat) / m_period + 1) * m_period;
+}
+
+qint64 BeatTracker::onsets() const
+{
+    return m_onsets;
+}
+
+float BeatTracker::envelope(qint64 hop) const
+{
+    if (hop < 0 || m_hops - hop > qint64(m_envelope.size())) {
+        return 0.0f;
+    }
+    return m_envelope[std::size_t(hop % qint64(m_envelope.size()))];
+}
+
+/*
+ * 压缩后的幅度（幅度的平方根，让弱的频点也有分量）逐点与上一帧相减，只累加增加的部分，
+ * 同时把本帧的幅度存为下一次的 previous。bins 是4的倍数
+ */
+float BeatTracker::spectralFlux(const float *re, const float *im, float *previous, int bins, bool simd)
+{
+    const float scale = 2.0f / FftSize;//满幅正弦波的峰值约为 0.5
+    int k = 0;
+    float flux = 0.0f;
+#if defined(PET_FLUX_SSE)
+    if (simd) {
+        const __m128 scale4 = _mm_set1_ps(scale * scale);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 sum = zero;
+        for (; k + 4 <= bins; k += 4) {
+            const __m128 r = _mm_loadu_ps(re + k);
+            const __m128 i = _mm_loadu_ps(im + k);
+            const __m128 power = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(i, i)), scale4);
+            const __m128 magnitude = _mm_sqrt_ps(_mm_sqrt_ps(power));
+            sum = _mm_add_ps(sum, _mm_max_ps(_mm_sub_ps(magnitude, _mm_loadu_ps(previous + k)), zero));
+            _mm_storeu_ps(previous + k, magnitude);
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, sum);
+        flux = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#elif defined(PET_FLUX_NEON)
+    if (simd) {
+        const float32x4_t scale4 = vdupq_n_f32(scale * scale);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t sum = zero;
+        for (; k + 4 <= bins; k += 4) {
+            const float32x4_t r = vld1q_f32(re + k);
+            const float32x4_t i = vld1q_f32(im + k);
+            const float32x4_t power = vmulq_f32(vmlaq_f32(vmulq_f32(r, r), i, i), scale4);
+            const float32x4_t magnitude = vsqrtq_f32(vsqrtq_f32(power));
+            sum = vaddq_f32(sum, vmaxq_f32(vsubq_f32(magnitude, vld1q_f32(previous + k)), zero));
+            vst1q_f32(previous + k, magnitude);
+        }
+        flux = vaddvq_f32(sum);
+    }
+#else
+    Q_UNUSED(simd);
+#endif
+    for (; k < bins; ++k) {
+        const float power = (re[k] * re[k] + im[k] * im[k]) * scale * scale;
+        const float magnitude = std::sqrt(std::sqrt(power));
+        flux += std::max(magnitude - previous[k], 0.0f);
+        previous[k] = magnitude;
+    }
+    return flux;
+}
+
+/*
+ * 一帧：算通量，检查上一帧是不是起音（比前后两帧都大且超过门限），每秒估计一次节拍周期
+ */
+void BeatTracker::analyzeHop()
+{
+    const std::size_t mask = FftSize - 1;
+    for (int i = 0; i < FftSize; ++i) {
+        m_re[i] = m_history[(m_historyPos + i) & mask] * m_window[i];
+        m_im[i] = 0.0f;
+    }
+    m_fft.transform(m_re.data(), m_im.data());
+    const float flux = spectralFlux(m_re.data(), m_im.data(), m_magnitude.data(), FftSize / 2);
+    m_envelope[std::size_t(m_hops % qint64(m_envelope.size()))] = flux;
+    ++m_hops;
+
+    const qint64 candidate = m_hops - 2;
+    const float value = envelope(candidate);
+    if (candidate > ThresholdHops && value > envelope(candidate - 1) && value >= envelope(candidate + 1)) {
+        float mean = 0.0f;
+        for (int i = 1; i <= ThresholdHops; ++i) {
+            mean += envelope(candidate - i);
+        }
+        mean /= ThresholdHops;
+        const qint64 gap = qint64(MinOnsetGap * m_sampleRate / Hop);
+        if (value > mean * ThresholdRatio + MinFlux && candidate - m_lastOnsetHop >= gap) {
+            m_lastOnsetHop = candidate;
+            ++m_onsets;
+            // 窗口中心：这一帧结束的位置往前半个窗口
+            onOnset(double((candidate + 1) * Hop - FftSize / 2));
+        }
+    }
+
+    if (m_hops % qMax<qint64>(1, m_sampleRate / Hop) == 0 && m_hops >= qint64(m_envelope.size()) / 2) {
+        estimateTempo();
+    }
+}
+
+/*
+ * 通量去掉均值后做自相关，按与 PreferredBpm 相差的八度数加权后取最大值，抛物线插值得到小数周期
+ */
+void BeatTracker::estimateTempo()
+{
+    const qint64 count = qMin<qint64>(m_hops, qint64(m_envelope.size()));
+    const qint64 first = m_hops - count;
+    std::vector<float> values(count);
+    double mean = 0.0;
+    for (qint64 i = 0; i < count; ++i) {
+        values[i] = envelope(first + i);
+        mean += values[i];
+    }
+    mean /= count;
+    for (float &value : values) {
+        value -= float(mean);
+    }
+
+    const double hopsPerSecond = double(m_sampleRate) / Hop;
+    const int minLag = qMax(1, int(std::floor(hopsPerSecond * 60.0 / MaxBpm)));
+    const int maxLag = int(std::ceil(hopsPerSecond * 60.0 / MinBpm));
+    if (count <= maxLag * 2) {
+        return;
+    }
+    auto correlate = [&values, count](int lag) {
+        double sum = 0.0;
+        for (qint64 i = 0; i + lag < count; ++i) {
+            sum += double(values[i]) * values[i + lag];
+        }
+        return sum / double(count - lag);
+    };
+    const double energy = correlate(0);
+    if (energy <= 0.0) {
+        m_period = 0;
+        return;
+    }
+    m_correlation.assign(maxLag + 2, 0.0f);
+    int best = -1;
+    double bestScore = 0.0;
+    for (int lag = minLag - 1; lag <= maxLag + 1; ++lag) {
+        m_correlation[lag] = float(correlate(lag) / energy);
+        if (lag < minLag || lag > maxLag) {
+            continue;
+        }
+        const double octaves = std::log2(60.0 * hopsPerSecond / lag / PreferredBpm);
+        const double score = m_correlation[lag] * std::exp(-0.5 * octaves * octaves);
+        if (score > bestScore) {
+            bestScore = score;
+            best = lag;
+        }
+    }
+    if (best < 0 || m_correlation[best] < MinConfidence) {
+        m_period = 0;
+        return;
+    }
+    const double left = m_correlation[best - 1];
+    const double middle = m_correlation[best];
+    const double right = m_correlation[best + 1];
+    const double denominator = left - 2 * middle + right;
+    const double offset = denominator < 0 ? qBound(-0.5, 0.5 * (left - right) / denominator, 0.5) : 0.0;
+    const double period = (best + offset) * Hop;
+    // 和上次相近时平滑，否则直接换成新的速度
+    m_period = m_period > 0 && std::fabs(period - m_period) < m_period * 0.05 ? m_period * 0.7 + period * 0.3 : period;
+
+    // 相位：在一个周期内逐帧移动，沿各拍的位置累加通量，取最大的（重拍通量大，不容易落在反拍上）
+    const double periodHops = m_period / Hop;
+    qint64 bestHop = m_hops - 1;
+    double bestSum = -1.0;
+    for (int phase = 0; phase < int(std::ceil(periodHops)); ++phase) {
+        double sum = 0.0;
+        for (double hop = double(m_hops - 1 - phase); hop >= double(first); hop -= periodHops) {
+            sum += envelope(std::llround(hop));
+        }
+        if (sum > bestSum) {
+            bestSum = sum;
+            bestHop = m_hops - 1 - phase;
+        }
+    }
+    m_beat = double((bestHop + 1) * Hop - FftSize / 2);
+    m_lastMatch = double(m_frames);
+}
+
+/*
+ * 两次估计之间，起音落在预测节拍附近时把相位往起音拉一点
+ */
+void BeatTracker::onOnset(double frame)
+{
+    if (m_period <= 0) {
+        return;
+    }
+    const double beats = std::round((frame - m_beat) / m_period);
+    const double expected = m_beat + beats * m_period;
+    const double error = frame - expected;
+    if (std::fabs(error) <= MatchWindow * m_period) {
+        m_beat = expected + error * PhaseGain;
+        m_lastMatch = frame;
+    }
+}
+
+// ==================== BeatWorker ====================
+
+BeatWorker::BeatWorker(const AudioTap &tap, int sampleRate, const std::atomic<int> *latencyMs, QObject *parent)
+    : QObject{parent}
+    , m_tap(tap)
+    , m_sampleRate(sampleRate > 0 ? sampleRate : 48000)
+    , m_latencyMs(latencyMs)
+    , m_timer(nullptr)
+    , m_tracker(sampleRate)
+    , m_input(ReadChunk)
+    , m_published(0)
+{
+}
+
+void BeatWorker::start()
+{
+    m_tap->clear();
+    if (!m_timer) {
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        m_timer->setInterval(ProcessMs);
+        connect(m_timer, &QTimer::timeout, this, &BeatWorker::process);
+    }
+    m_timer->start();
+}
+
+void BeatWorker::stop()
+{
+    if (m_timer) {
+        m_timer->stop();
+    }
+    // 暂停期间没有数据：重新开始时节拍多半已经对不上，等起音重新对上后再发出
+    m_tracker = BeatTracker(m_sampleRate);
+    m_published = 0;
+}
+
+/*
+ * 取出全部新数据，然后把离现在不到 AheadMs 的预测节拍发出去
+ */
+void BeatWorker::process()
+{
+    for (;;) {
+        const std::size_t got = m_tap->read(m_input.data(), m_input.size());
+        m_tracker.process(m_input.data(), qint64(got / 2));
+        if (got < m_input.size()) {
+            break;
+        }
+    }
+    if (!m_tracker.isLocked()) {
+        return;
+    }
+
+    const qint64 now = BeatDetector::now();
+    const double frames = double(m_tracker.frames());
+    const double period = m_tracker.period();
+    const int latency = m_latencyMs->load(std::memory_order_relaxed);
+    auto timeOf = [&](double frame) {
+        return now + qint64(std::llround((frame - frames) * 1000.0 / m_sampleRate)) + latency;
+    };
+    double next = m_tracker.beatAfter(qMax(m_published + period / 2, frames - period));
+    while (timeOf(next) <= now + AheadMs) {
+        if (timeOf(next) >= now) {
+            emit beat(timeOf(next), int(std::lround(period * 1000.0 / m_sampleRate)));
+        }
+        m_published = next;
+        next += period;
+    }
+}
+
+// ==================== BeatDetector ====================
+
+/*
+ * BeatDetector 构造函数
+ *
+ * @param sampleRate：播放引擎的输出采样率
+ */
+BeatDetector::BeatDetector(int sampleRate, QObject *parent)
+    : QObject{parent}
+    , m_tap(std::make_shared<AudioRingBuffer<float>>(std::size_t(sampleRate / 4) * 2))//约0.25秒
+    , m_latencyMs(0)
+    , m_worker(new BeatWorker(m_tap, sampleRate, &m_latencyMs))
+    , m_active(false)
+{
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &BeatDetector::requestStart, m_worker, &BeatWorker::start);
+    connect(this, &BeatDetector::requestStop, m_worker, &BeatWorker::stop);
+    connect(m_worker, &BeatWorker::beat, this, &BeatDetector::beat);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+BeatDetector::~BeatDetector()
+{
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+qint64 BeatDetector::now()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
+
+AudioTap BeatDetector::tap() const
+{
+    return m_tap;
+}
+
+bool BeatDetector::isActive() const
+{
+    return m_active;
+}
+
+void BeatDetector::setLatency(int msec)
+{
+    m_latencyMs.store(qMax(0, msec), std::memory_order_relaxed);
+}
+
+void BeatDetector::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+    m_active = active;
+    if (active) {
+        emit requestStart();
+    } else {
+        emit requestStop();
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef BEATDETECTOR_H
+#define BEATDETECTOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <vector>
+#include "audioringbuffer.h"
+#include "fft.h"
+
+/*
+ * BeatTracker：从立体声采样中检测起音、估计节拍
+ *
+ * 每 Hop 帧（48kHz 时约11ms）对最近 FftSize 帧做加窗FFT，幅度压缩后与上一帧相减，
+ * 正的部分求和得到谱通量（SIMD 每次算4个频点）；通量超过近期平均的局部峰值记为起音。
+ * 每秒用最近6秒的通量做一次自相关，在 60~180 BPM 之间找节拍周期，
+ * 沿各拍位置累加通量找出相位，两次估计之间由落在预测节拍附近的起音微调。所有位置都以读入的采样帧数计。
+ */
+class BeatTracker
+{
+public:
+    static const int FftSize = 1024;
+    static const int Hop = FftSize / 2;
+
+    explicit BeatTracker(int sampleRate);
+
+    void process(const float *stereo, qint64 frames);//交错立体声
+    qint64 frames() const;//已经读入的帧数
+    bool isLocked() const;//有可信的周期，且最近几秒起音与节拍对得上
+    double period() const;//节拍周期（帧）
+    double beatAfter(double frame) const;//frame 之后预测的第一拍
+    qint64 onsets() const;//检测到的起音个数
+
+    static float spectralFlux(const float *re, const float *im, float *previous, int bins, bool simd = true);
+
+private:
+    void analyzeHop();
+    void estimateTempo();
+    void onOnset(double frame);
+    float envelope(qint64 hop) const;
+
+    int m_sampleRate;
+    Fft m_fft;
+    std::vector<float> m_window;
+    std::vector<float> m_history;//最近 FftSize 个单声道采样（环形）
+    std::size_t m_historyPos;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_magnitude;//上一帧压缩后的幅度
+    std::vector<float> m_envelope;//最近6秒每帧的通量（环形）
+    std::vector<float> m_correlation;
+    qint64 m_frames;
+    qint64 m_hops;
+    int m_hopFill;
+    qint64 m_lastOnsetHop;
+    qint64 m_onsets;
+    double m_period;//0 表示还没有把握
+    double m_beat;//最近一次对上的节拍位置
+    double m_lastMatch;//最近一次起音与预测节拍对上的位置
+};
+
+/*
+ * BeatWorker：在工作线程中每 10ms 取出混音输出交给 BeatTracker，把预测的节拍换算成时刻发出
+ *
+ * 刚取出的最后一帧大约就是现在写入音频输出的，再加上输出缓冲区的延迟才被听到。
+ */
+class BeatWorker : public QObject
+{
+    Q_OBJECT
+public:
+    BeatWorker(const AudioTap &tap, int sampleRate, const std::atomic<int> *latencyMs, QObject *parent = nullptr);
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void beat(qint64 timeMs, int periodMs);
+
+private slots:
+    void process();
+
+private:
+    AudioTap m_tap;
+    int m_sampleRate;
+    const std::atomic<int> *m_latencyMs;
+    QTimer *m_timer;
+    BeatTracker m_tracker;
+    std::vector<float> m_input;
+    double m_published;//最近一次发出的节拍位置（帧）
+};
+
+/*
+ * BeatDetector：音乐节拍检测
+ *
+ * 和频谱分析一样，由播放引擎把混音输出写入 tap()；正在播放时激活（窗口隐藏时也是），
+ * 暂停或停止时分析线程停下。节拍时刻用单调时钟 now()，界面线程可以直接按它定时。
+ */
+class BeatDetector : public QObject
+{
+    Q_OBJECT
+public:
+    BeatDetector(int sampleRate, QObject *parent = nullptr);
+    ~BeatDetector();
+
+    static qint64 now();//单调时钟（毫秒），所有线程一致
+
+    AudioTap tap() const;
+    bool isActive() const;
+    void setLatency(int msec);//音频输出的延迟，随时可以更新
+
+public slots:
+    void setActive(bool active);
+
+signals:
+    void beat(qint64 timeMs, int periodMs);//timeMs：这一拍被听到的时刻，通常还在将来
+    void requestStart();
+    void requestStop();
+
+private:
+    AudioTap m_tap;
+    std::atomic<int> m_latencyMs;
+    QThread m_workerThread;
+    BeatWorker *m_worker;
+    bool m_active;
+};
+
+#endif // BEATDETECTOR_H
@@ -1,4 +1,5 @@
 #include "chatroom.h"
+#include "windowchrome.h"
 #include <QWidget>
 #include <QTextEdit>
 #include <QLineEdit>
@@ -9,18 +10,29 @@
 #include <QStringList>
 #include <QRandomGenerator>
 #include <QKeyEvent>
-#include <QMouseEvent>
 #include <QTimer>
 #include <QDateTime>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QSettings>
+#include <QTextDocument>
+#include <QTextDocumentFragment>
 
 chatroom::chatroom(QWidget *parent)
     : QWidget{parent},
-    m_dragging(false),
     isDarkTheme(true), // 默认使用深色主题
-    aiEnabled(false)   // AI功能默认关闭
+    aiEnabled(false),  // AI功能默认关闭
+    fileIngestor(nullptr),
+    voiceInput(nullptr),
+    petVoice(nullptr),
+    streamingReply(false),
+    streamTailStart(0),
+    streamEnd(0),
+    streamMood(PetMood::Calm)
 {
     setWindowFlags(Qt::Tool | Qt::FramelessWindowHint);
     setAttribute(Qt::WA_TranslucentBackground);
+    chrome = WindowChrome::install(this);//阴影和背景只在尺寸或主题改变时重新绘制
     setFixedSize(200, 320);// 增加高度以容纳AI按钮
 
     initializeResponses();
@@ -31,6 +43,16 @@ chatroom::chatroom(QWidget *parent)
     aiManager = new aimanager(this);
     connect(aiManager, &aimanager::modelLoaded, this, &chatroom::onAImodelLoaded);
     connect(aiManager, &aimanager::responseGenerated, this, &chatroom::onAIResponseGenerated);
+    connect(aiManager, &aimanager::responseChunk, this, &chatroom::onAIResponseChunk);
+
+    //语音回复：固定台词在后台预先合成并缓存到磁盘，之后播放没有合成延迟
+    QSettings settings;
+    if (settings.value("voice/speakReplies", true).toBool()) {
+        petVoice = new PetVoice(this);
+        connect(petVoice, &PetVoice::speakingChanged, this, &chatroom::speakingChanged);
+        petVoice->warmCache(QStringList() << greetingsResponses << questionResponses << emotionResponses
+                                          << specialResponses << randomResponses);
+    }
 }
 
 chatroom::~chatroom()
@@ -42,6 +64,26 @@ chatroom::~chatroom()
     }
 }
 
+void chatroom::releaseResources()
+{
+    if (aiManager) {
+        aiManager->releaseConnections();
+    }
+    if (voiceInput) {
+        voiceInput->stop();
+        voiceInput->deleteLater();//连同识别线程和语音模型一起释放，下次使用时重新创建
+        voiceInput = nullptr;
+    }
+}
+
+void chatroom::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    if (voiceInput) {
+        voiceInput->stop();//窗口看不见时不再占用麦克风
+    }
+}
+
 void chatroom::initializeResponses()
 {
     // 问候语回复 - 增加更多变化
@@ -145,6 +187,9 @@ void chatroom::analyzeMessage(const QString &message)
 {
     QString lowerMsg = message.toLower();
 
+    // 用户的情绪多半会反映在回复里，先让桌宠准备对应的动画
+    emit moodAnticipated(PetMood::classify(message));
+
     if (aiEnabled && aiManager->isModelLoaded()) {
         aiManager->generateResponse(message);
         return;
@@ -153,92 +198,92 @@ void chatroom::analyzeMessage(const QString &message)
     // 问候语识别; 原有的规则匹配逻辑保持不变
     if (lowerMsg.contains("你好") || lowerMsg.contains("嗨") || lowerMsg.contains("hello") ||
         lowerMsg.contains("hi") || lowerMsg.contains("hey") || lowerMsg.contains("hola")) {
-        generatePetResponse(getRandomResponse(greetingsResponses));
+        generatePetResponse(getRandomResponse(greetingsResponses), true);
     }
     // 时间问候
     else if (lowerMsg.contains("早上好") || lowerMsg.contains("早安") || lowerMsg.contains("good morning")) {
-        generatePetResponse("早上好！新的一天开始啦～🌞");
+        generatePetResponse("早上好！新的一天开始啦～🌞", true);
     }
     else if (lowerMsg.contains("晚上好") || lowerMsg.contains("晚安") || lowerMsg.contains("good night")) {
-        generatePetResponse("晚安～祝你好梦！🌙");
+        generatePetResponse("晚安～祝你好梦！🌙", true);
     }
     // 问题识别
     else if (lowerMsg.contains("吗？") || lowerMsg.contains("吗?") || lowerMsg.contains("为什么") ||
              lowerMsg.contains("怎么") || lowerMsg.contains("如何") || lowerMsg.contains("？") ||
              lowerMsg.contains("?") || lowerMsg.contains("怎么办") || lowerMsg.contains("啥") ||
              lowerMsg.contains("什么") || lowerMsg.contains("为何")) {
-        generatePetResponse(getRandomResponse(questionResponses));
+        generatePetResponse(getRandomResponse(questionResponses), true);
     }
     // 情绪识别
     else if (lowerMsg.contains("伤心") || lowerMsg.contains("难过") || lowerMsg.contains("不开心") ||
              lowerMsg.contains("生气") || lowerMsg.contains("郁闷") || lowerMsg.contains("哭") ||
              lowerMsg.contains("委屈") || lowerMsg.contains("沮丧") || lowerMsg.contains("压力") ||
              lowerMsg.contains("累") || lowerMsg.contains("疲惫") || lowerMsg.contains("失望")) {
-        generatePetResponse(getRandomResponse(emotionResponses));
+        generatePetResponse(getRandomResponse(emotionResponses), true);
     }
     //问名字
     else if(lowerMsg.contains("名字"))
     {
-        generatePetResponse("猫猫");
+        generatePetResponse("猫猫", true);
     }
     // 开心情绪
     else if (lowerMsg.contains("开心") || lowerMsg.contains("高兴") || lowerMsg.contains("快乐") ||
              lowerMsg.contains("幸福") || lowerMsg.contains("兴奋") || lowerMsg.contains("哈哈") ||
              lowerMsg.contains("呵呵") || lowerMsg.contains("嘻嘻")) {
-        generatePetResponse("看到你开心我也好开心！(*^▽^*)");
+        generatePetResponse("看到你开心我也好开心！(*^▽^*)", true);
     }
     // 食物相关
     else if (lowerMsg.contains("吃饭") || lowerMsg.contains("饿") || lowerMsg.contains("食物") ||
              lowerMsg.contains("吃") || lowerMsg.contains("美食") || lowerMsg.contains("餐厅") ||
              lowerMsg.contains("零食") || lowerMsg.contains("美味")) {
-        generatePetResponse("吃饭？我也好饿啊～可以分我一点吗？🐟");
+        generatePetResponse("吃饭？我也好饿啊～可以分我一点吗？🐟", true);
     }
     // 睡眠相关
     else if (lowerMsg.contains("睡觉") || lowerMsg.contains("困") || lowerMsg.contains("晚安") ||
              lowerMsg.contains("睡眠") || lowerMsg.contains("做梦") || lowerMsg.contains("床")) {
-        generatePetResponse("睡觉？晚安哦！好梦～(。-ω-)zzz");
+        generatePetResponse("睡觉？晚安哦！好梦～(。-ω-)zzz", true);
     }
     // 游戏娱乐
     else if (lowerMsg.contains("游戏") || lowerMsg.contains("玩") || lowerMsg.contains("娱乐") ||
              lowerMsg.contains("电影") || lowerMsg.contains("音乐") || lowerMsg.contains("电视剧") ||
              lowerMsg.contains("动漫") || lowerMsg.contains("小说")) {
-        generatePetResponse("游戏？我也喜欢玩！不过我只能玩虚拟的毛线球～");
+        generatePetResponse("游戏？我也喜欢玩！不过我只能玩虚拟的毛线球～", true);
     }
     // 情感表达
     else if (lowerMsg.contains("爱") || lowerMsg.contains("喜欢") || lowerMsg.contains("love") ||
              lowerMsg.contains("想念") || lowerMsg.contains("思念") || lowerMsg.contains("在乎")) {
-        generatePetResponse("爱你？我也爱你哦！٩(◕‿◕｡)۶");
+        generatePetResponse("爱你？我也爱你哦！٩(◕‿◕｡)۶", true);
     }
     // 天气相关
     else if (lowerMsg.contains("天气") || lowerMsg.contains("下雨") || lowerMsg.contains("晴天") ||
              lowerMsg.contains("刮风") || lowerMsg.contains("温度") || lowerMsg.contains("气候")) {
-        generatePetResponse("今天的天气很适合和主人一起玩耍呢！");
+        generatePetResponse("今天的天气很适合和主人一起玩耍呢！", true);
     }
     // 工作学习
     else if (lowerMsg.contains("工作") || lowerMsg.contains("学习") || lowerMsg.contains("考试") ||
              lowerMsg.contains("作业") || lowerMsg.contains("项目") || lowerMsg.contains("任务")) {
-        generatePetResponse("加油加油！我相信你一定可以的！💪");
+        generatePetResponse("加油加油！我相信你一定可以的！💪", true);
     }
     // 宠物相关
     else if (lowerMsg.contains("猫") || lowerMsg.contains("狗") || lowerMsg.contains("宠物") ||
              lowerMsg.contains("动物") || lowerMsg.contains("喵") || lowerMsg.contains("汪")) {
         if(lowerMsg.contains("猫"))
         {
-            generatePetResponse("你喜欢小猫猫吗~");
+            generatePetResponse("你喜欢小猫猫吗~", true);
         }
         else
         {
-            generatePetResponse("喵喵！我也喜欢小动物呢～");
+            generatePetResponse("喵喵！我也喜欢小动物呢～", true);
         }
     }
     // 感谢道歉
     else if (lowerMsg.contains("谢谢") || lowerMsg.contains("感谢") || lowerMsg.contains("多谢") ||
              lowerMsg.contains("对不起") || lowerMsg.contains("抱歉") || lowerMsg.contains("不好意思")) {
-        generatePetResponse("不用客气啦！能帮到你我很开心呢～");
+        generatePetResponse("不用客气啦！能帮到你我很开心呢～", true);
     }
     else {
         // 随机回复或者根据其他关键词
-        generatePetResponse(getRandomResponse(randomResponses));
+        generatePetResponse(getRandomResponse(randomResponses), true);
     }
 }
 
@@ -249,7 +294,7 @@ void chatroom::toggleAI()
     {
         aiToggleButton->setText("🧠");
         aiToggleButton->setToolTip("关闭AI智能对话");
-        generatePetResponse("AI猫娘模式已开启！现在我可以更智能地和你聊天了喵～🌟");
+        generatePetResponse("AI猫娘模式已开启！现在我可以更智能地和你聊天了喵～🌟", true);
 
         if (!aiManager->isModelLoaded())
         {
@@ -260,7 +305,7 @@ void chatroom::toggleAI()
     {
         aiToggleButton->setText("🤖");
         aiToggleButton->setToolTip("开启AI智能对话");
-        generatePetResponse("AI模式已关闭，切换回普通猫猫对话模式～");
+        generatePetResponse("AI模式已关闭，切换回普通猫猫对话模式～", true);
     }
 }
 
@@ -268,28 +313,119 @@ void chatroom::loadAIModel()
 {
     // 改为使用模型名称而不是文件路径
     QString modelName = "qwen2.5:latest"; // 或你安装的其他模型
-    generatePetResponse("正在连接Ollama服务，请确保Ollama已运行... ⏳");
+    generatePetResponse("正在连接Ollama服务，请确保Ollama已运行... ⏳", true);
 
     if (!aiManager->loadModel(modelName)) {
-        generatePetResponse("Ollama连接失败，请检查服务是否启动");
+        generatePetResponse("Ollama连接失败，请检查服务是否启动", true);
     }
 }
 
-void chatroom::generatePetResponse(const QString &response)
+void chatroom::generatePetResponse(const QString &response, bool cacheable)
 {
+    // 回复在"思考"之前就已确定，趁这段延迟在后台准备情绪动画
+    const PetMood::Mood mood = PetMood::classify(response);
+    emit moodAnticipated(mood);
+
     // 随机延迟回复，模拟思考时间
     int delay = QRandomGenerator::global()->bounded(500, 1500);
-    QTimer::singleShot(delay, [this, response]() {
-        QString timestamp = QDateTime::currentDateTime().toString("HH:mm");
-        chatDisplay->append(QString("[%1] 喵: %2").arg(timestamp, response));
-
-        // 自动滚动到底部
-        QTextCursor cursor = chatDisplay->textCursor();
-        cursor.movePosition(QTextCursor::End);
-        chatDisplay->setTextCursor(cursor);
+    QTimer::singleShot(delay, this, [this, response, cacheable, mood]() {
+        appendPetMessage(response);
+        emit moodExpressed(mood);
+        // 语音合成在后台线程进行；只有固定台词写入磁盘缓存，AI回复和带参数的提示（如错误信息）不缓存
+        if (petVoice) {
+            petVoice->speak(response, cacheable);
+        }
     });
 }
 
+void chatroom::appendPetMessage(const QString &text)
+{
+    QString timestamp = QDateTime::currentDateTime().toString("HH:mm");
+    chatDisplay->append(QString("[%1] 喵: %2").arg(timestamp, text));
+
+    // 自动滚动到底部
+    QTextCursor cursor = chatDisplay->textCursor();
+    cursor.movePosition(QTextCursor::End);
+    chatDisplay->setTextCursor(cursor);
+}
+
+/*
+ * 文件按钮：选择本地文本/Markdown/代码/PDF文件，交给 FileIngestor 分块读取并由AI总结
+ * 读取在后台线程进行，每段摘要完成后立即显示在聊天窗口中，阅读进度显示在输入框提示文字里
+ */
+void chatroom::openFile()
+{
+    if (!aiEnabled || !aiManager->isModelLoaded()) {
+        generatePetResponse("读文件需要AI帮忙哦，请先点🤖开启AI模式喵～", true);
+        return;
+    }
+    if (fileIngestor && fileIngestor->isRunning()) {
+        generatePetResponse("上一个文件还没读完呢，稍等一下喵～", true);
+        return;
+    }
+
+    QString filePath = QFileDialog::getOpenFileName(this, "选择要总结的文件", QString(),
+                                                    FileIngestor::supportedFilters().join(";;"));
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    if (!fileIngestor) {
+        fileIngestor = new FileIngestor(aiManager, this);
+        connect(fileIngestor, &FileIngestor::progress, this, [this](int percent, const QString &message) {
+            inputField->setPlaceholderText(QString("📖 %1 (%2%)").arg(message).arg(percent));
+        });
+        connect(fileIngestor, &FileIngestor::partialSummary, this, [this](int index, const QString &summary) {
+            appendPetMessage(QString("第%1段：%2").arg(index + 1).arg(summary));
+        });
+        connect(fileIngestor, &FileIngestor::finished, this, [this](const QString &summary) {
+            inputField->setPlaceholderText("输入消息...按回车发送");
+            appendPetMessage(QString("读完啦！整体总结：%1").arg(summary));
+        });
+        connect(fileIngestor, &FileIngestor::failed, this, [this](const QString &error) {
+            inputField->setPlaceholderText("输入消息...按回车发送");
+            appendPetMessage(QString("文件读取失败了 😢 %1").arg(error));
+        });
+    }
+
+    appendPetMessage(QString("收到文件 %1，开始认真阅读～📖").arg(QFileInfo(filePath).fileName()));
+    fileIngestor->start(filePath);
+}
+
+/*
+ * 语音按钮：开始/结束离线语音输入
+ * 识别在后台线程完成，说话过程中临时结果实时显示在输入框里，一句话说完后固定下来，
+ * 结束后文字留在输入框中，由用户确认后发送
+ */
+void chatroom::toggleVoiceInput()
+{
+    if (!voiceInput) {
+        voiceInput = new VoiceInput(this);
+        connect(voiceInput, &VoiceInput::partialTranscript, this, [this](const QString &text) {
+            inputField->setText(voiceCommitted + text);
+        });
+        connect(voiceInput, &VoiceInput::finalTranscript, this, [this](const QString &text) {
+            voiceCommitted += text;
+            inputField->setText(voiceCommitted);
+        });
+        connect(voiceInput, &VoiceInput::activeChanged, this, [this](bool active) {
+            voiceButton->setText(active ? "⏹" : "🎤");
+            voiceButton->setToolTip(active ? "结束语音输入" : "语音输入");
+            inputField->setPlaceholderText(active ? "正在听你说话喵..." : "输入消息...按回车发送");
+        });
+        connect(voiceInput, &VoiceInput::errorOccurred, this, [this](const QString &error) {
+            generatePetResponse(QString("语音输入用不了了 😿 %1").arg(error));
+        });
+    }
+
+    if (voiceInput->isActive()) {
+        voiceInput->stop();
+    } else {
+        voiceCommitted = inputField->text();
+        voiceInput->startMicrophone();
+    }
+}
+
 void chatroom::toggleTheme()
 {
     isDarkTheme = !isDarkTheme;
@@ -297,12 +433,12 @@ void chatroom::toggleTheme()
         themeButton->setText("🌙");
         themeButton->setToolTip("切换到浅色主题");
         applyDarkTheme();
-        generatePetResponse("切换到深色主题啦～保护眼睛哦 (。-ω-)zzz");
+        generatePetResponse("切换到深色主题啦～保护眼睛哦 (。-ω-)zzz", true);
     } else {
         themeButton->setText("☀️");
         themeButton->setToolTip("切换到深色主题");
         applyLightTheme();
-        generatePetResponse("切换到浅色主题啦～明亮又清爽！☀️");
+        generatePetResponse("切换到浅色主题啦～明亮又清爽！☀️", true);
     }
 }
 
@@ -310,21 +446,134 @@ void chatroom::onAImodelLoaded(bool success)
 {
     if(success)
     {
-        generatePetResponse("AI模型加载成功！现在可以使用智能对话啦～🚀");
+        generatePetResponse("AI模型加载成功！现在可以使用智能对话啦～🚀", true);
         aiToggleButton->setToolTip("关闭AI智能对话");
     }
     else
     {
-        generatePetResponse("AI模型加载失败，将使用普通对话模式 😢");
+        generatePetResponse("AI模型加载失败，将使用普通对话模式 😢", true);
         aiEnabled = false;
         aiToggleButton->setText("🤖");
         aiToggleButton->setToolTip("AI加载失败");
     }
+    if (!pendingQuestion.isEmpty()) {
+        const QString question = pendingQuestion;
+        pendingQuestion.clear();
+        analyzeMessage(question);
+    }
 }
 
 void chatroom::onAIResponseGenerated(const QString &response)
 {
-    generatePetResponse(response);
+    if (streamingReply) {
+        streamingReply = false;
+        showStreamUpdate(markdown.finish());
+        if (response == streamedText) {
+            emit moodExpressed(PetMood::classify(streamedText));
+            // 回复已经边收边显示过了，只需要念出来（念渲染后的纯文本，不念Markdown符号）
+            if (petVoice) {
+                petVoice->speak(QTextDocumentFragment::fromHtml(streamedHtml).toPlainText(), false);
+            }
+            return;
+        }
+        // 流式输出中途出错，错误信息另起一条显示
+    }
+    generatePetResponse(response);//AI回复每次都不同，不写入语音缓存
+}
+
+/*
+ * AI流式回复：第一段到达时新建一条消息，之后每段只重新渲染最后一个未写完的块
+ */
+void chatroom::onAIResponseChunk(const QString &delta)
+{
+    if (!streamingReply) {
+        streamingReply = true;
+        markdown.reset();
+        streamedText.clear();
+        streamedHtml.clear();
+        streamMood = PetMood::Calm;
+        QString timestamp = QDateTime::currentDateTime().toString("HH:mm");
+        chatDisplay->append(QString("[%1] 喵: ").arg(timestamp));
+        streamTailStart = chatDisplay->document()->characterCount() - 1;
+        streamEnd = streamTailStart;
+    }
+    streamedText += delta;
+    const MarkdownRenderer::Update update = markdown.append(delta);
+    showStreamUpdate(update);
+
+    // 每定稿一个块重新判断一次情绪，情绪有变化就提前准备动画，回复结束时即可切换
+    if (!update.committedHtml.isEmpty()) {
+        const PetMood::Mood mood = PetMood::classify(streamedText);
+        if (mood != streamMood) {
+            streamMood = mood;
+            emit moodAnticipated(mood);
+        }
+    }
+}
+
+/*
+ * 更新流式回复的显示
+ *
+ * 删除上一次显示的尾部，依次插入新定稿的块和新的尾部。定稿的块之后不再改动，
+ * 每次更新只涉及尾部附近的文字，与整条消息长度无关。
+ */
+void chatroom::showStreamUpdate(const MarkdownRenderer::Update &update)
+{
+    QTextDocument *document = chatDisplay->document();
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+    if (document->characterCount() - 1 != streamEnd) {
+        // 流式输出期间插入了其他消息：移除旧的尾部，在末尾另起一段继续
+        cursor.setPosition(streamTailStart);
+        cursor.setPosition(streamEnd, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertBlock();
+        streamTailStart = cursor.position();
+    } else {
+        cursor.setPosition(streamTailStart);
+        cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+    }
+    if (!update.committedHtml.isEmpty()) {
+        cursor.insertHtml(update.committedHtml);
+        streamTailStart = cursor.position();
+        streamedHtml += update.committedHtml;
+    }
+    if (!update.tailHtml.isEmpty()) {
+        cursor.insertHtml(update.tailHtml);
+    }
+    cursor.endEditBlock();
+    streamEnd = document->characterCount() - 1;
+
+    // 自动滚动到底部
+    QTextCursor end = chatDisplay->textCursor();
+    end.movePosition(QTextCursor::End);
+    chatDisplay->setTextCursor(end);
+}
+
+void chatroom::say(const QString &text)
+{
+    appendPetMessage(text);
+    emit moodExpressed(PetMood::classify(text));
+    if (petVoice) {
+        petVoice->speak(text, false);
+    }
+}
+
+void chatroom::ask(const QString &question)
+{
+    QString timestamp = QDateTime::currentDateTime().toString("HH:mm");
+    chatDisplay->append(QString("[%1] 你: %2").arg(timestamp, question));
+
+    if (!aiEnabled) {
+        toggleAI();
+    }
+    if (!aiManager->isModelLoaded()) {
+        pendingQuestion = question;//onAImodelLoaded 时再问，加载失败就用普通对话回答
+        return;
+    }
+    analyzeMessage(question);
 }
 
 void chatroom::sendMessage()
@@ -363,7 +612,7 @@ void chatroom::setupUI()
 
     fileButton = new QPushButton("📎", this);
     fileButton->setFixedSize(32, 32);   // 正方形
-    fileButton->setToolTip("上传文件");
+    fileButton->setToolTip("让猫猫读文件（文本/Markdown/代码/PDF）");
 
     voiceButton = new QPushButton("🎤", this);
     voiceButton->setFixedSize(32, 32);  // 正方形
@@ -428,12 +677,8 @@ void chatroom::setupUI()
     connect(inputField, &QLineEdit::returnPressed, this, &chatroom::sendMessage);
     connect(sendButton, &QPushButton::clicked, this, &chatroom::sendMessage);
     connect(themeButton, &QPushButton::clicked, this, &chatroom::toggleTheme);
-    connect(fileButton, &QPushButton::clicked, [this]() {
-        generatePetResponse("文件上传功能正在开发中呢～");
-    });
-    connect(voiceButton, &QPushButton::clicked, [this]() {
-        generatePetResponse("语音输入功能正在开发中喵～");
-    });
+    connect(fileButton, &QPushButton::clicked, this, &chatroom::openFile);
+    connect(voiceButton, &QPushButton::clicked, this, &chatroom::toggleVoiceInput);
     connect(closeButton, &QPushButton::clicked, [this]() {
         close();
     });
@@ -503,7 +748,7 @@ void chatroom::setupStyle()
                   );
 
     inputField->setPlaceholderText("输入消息...按回车发送");
-    setFixedSize(240, 280);
+    setFixedSize(QSize(240, 280).grownBy(chrome->margins()));//面板240x280，外圈留给阴影
 }
 
 void chatroom::applyLightTheme()
@@ -790,43 +1035,6 @@ void chatroom::applyDarkTheme()
         );
 }
 
-// 鼠标按下事件 - 开始拖动
-void chatroom::mousePressEvent(QMouseEvent *event)
-{
-    if (event->button() == Qt::LeftButton) {
-        m_dragging = true;
-        m_dragPosition = event->globalPosition().toPoint() - frameGeometry().topLeft();
-        event->accept();
-
-        // 改变光标形状提示可拖动
-        setCursor(Qt::ClosedHandCursor);
-    }
-    QWidget::mousePressEvent(event);
-}
-
-// 鼠标移动事件 - 处理拖动
-void chatroom::mouseMoveEvent(QMouseEvent *event)
-{
-    if (m_dragging && (event->buttons() & Qt::LeftButton)) {
-        move(event->globalPosition().toPoint() - m_dragPosition);
-        event->accept();
-    }
-    QWidget::mouseMoveEvent(event);
-}
-
-// 鼠标释放事件 - 结束拖动
-void chatroom::mouseReleaseEvent(QMouseEvent *event)
-{
-    if (event->button() == Qt::LeftButton) {
-        m_dragging = false;
-        event->accept();
-
-        // 恢复光标形状
-        setCursor(Qt::ArrowCursor);
-    }
-    QWidget::mouseReleaseEvent(event);
-}
-
 // ESC键关闭
 void chatroom::keyPressEvent(QKeyEvent *event)
 {
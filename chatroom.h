@@ -12,6 +12,13 @@
 #include <QRandomGenerator>
 #include <QKeyEvent>
 #include "aimanager.h"
+#include "fileingestor.h"
+#include "speechinput.h"
+#include "speechoutput.h"
+#include "markdownrenderer.h"
+#include "petmood.h"
+
+class WindowChrome;
 class chatroom : public QWidget
 {
     Q_OBJECT
@@ -20,18 +27,27 @@ public:
      ~chatroom();
 
     void keyPressEvent(QKeyEvent *event) override;
+    void releaseResources();//窗口长时间隐藏时释放AI连接和语音识别，聊天记录保留
+    void say(const QString &text);//让猫猫说一句话（远程命令），窗口不必显示
+    void ask(const QString &question);//向AI提问（远程命令），AI没开时先打开，连接好后再问
+
+signals:
+    void speakingChanged(bool speaking);//猫猫开始/结束说话，音乐播放器据此压低音量
+    void moodAnticipated(PetMood::Mood mood);//即将显示的回复大概率带有这种情绪，桌宠提前准备动画
+    void moodExpressed(PetMood::Mood mood);//回复已经显示，桌宠切换到对应情绪
 
 protected:
-    void mousePressEvent(QMouseEvent *event) override;
-    void mouseMoveEvent(QMouseEvent *event) override;
-    void mouseReleaseEvent(QMouseEvent *event) override;
+    void hideEvent(QHideEvent *event) override;//窗口关闭或隐藏时结束语音输入
 
 private slots:
     void sendMessage();
-    void generatePetResponse(const QString &response);
+    void generatePetResponse(const QString &response, bool cacheable = false);//cacheable：固定台词，语音可以缓存
     void toggleTheme(); // 主题切换槽函数
     void onAImodelLoaded(bool success);//AI模型加载完成槽函数
     void onAIResponseGenerated(const QString &response);//AI回复生成槽函数
+    void onAIResponseChunk(const QString &delta);//AI流式回复的新片段
+    void openFile();//选择本地文件并让AI分段总结
+    void toggleVoiceInput();//开始/结束离线语音输入
 
 private:
     QTextEdit *chatDisplay;
@@ -44,13 +60,25 @@ private:
     QPushButton *aiToggleButton;//AI开关按钮
     QVBoxLayout *mainLayout;
     QHBoxLayout *buttonLayout;
+    WindowChrome *chrome;//阴影和面板背景
 
-    bool m_dragging;
-    QPoint m_dragPosition;
     bool isDarkTheme; // 主题状态标志
     bool aiEnabled;//AI功能开关状态
 
     aimanager *aiManager;//AI管理器实例
+    FileIngestor *fileIngestor;//文件摘要任务，首次使用时创建
+    VoiceInput *voiceInput;//离线语音识别，首次使用时创建
+    QString voiceCommitted;//本次语音输入中已确定的文字
+    QString pendingQuestion;//等AI连接好再问的问题
+    PetVoice *petVoice;//把回复念出来
+
+    MarkdownRenderer markdown;//AI流式回复的增量渲染
+    bool streamingReply;//正在显示一条流式回复
+    QString streamedText;//流式回复的原始文本
+    QString streamedHtml;//流式回复中已定稿的HTML
+    int streamTailStart;//显示区域中尾部（未写完的块）的起始位置
+    int streamEnd;//上一次更新后显示区域的末尾位置，用于发现期间插入的其他消息
+    PetMood::Mood streamMood;//流式回复目前读到的情绪
 
     QStringList greetingsResponses;
     QStringList questionResponses;
@@ -58,6 +86,8 @@ private:
     QStringList randomResponses;
     QStringList specialResponses;
 
+    void appendPetMessage(const QString &text);//立即追加一条猫猫消息（不模拟思考延迟）
+    void showStreamUpdate(const MarkdownRenderer::Update &update);//只替换流式回复的尾部
     void setupUI();
     void setupStyle();
     void applyDarkTheme();    // 深色主题
@@ -0,0 +1,224 @@
+#include "dragcontroller.h"
+#include <QWidget>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QMouseEvent>
+#include <QMoveEvent>
+#include <QSettings>
+
+/*
+ * DragController 构造函数
+ *
+ * 合并移动的间隔取主显示器的刷新周期
+ */
+DragController::DragController(QObject *parent)
+    : QObject{parent}
+    , m_hasPending(false)
+{
+    QSettings settings;
+    m_snap = qMax(0, settings.value("drag/snapDistance", 16).toInt());
+
+    QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal rate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+    m_frameTimer.setInterval(qBound(4, qRound(1000 / rate), 33));
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    m_frameTimer.setSingleShot(true);
+    connect(&m_frameTimer, &QTimer::timeout, this, &DragController::applyMove);
+}
+
+void DragController::attach(QWidget *window)
+{
+    m_attached.insert(window);
+    watch(window);
+}
+
+void DragController::setDockTarget(QWidget *window, QWidget *leader)
+{
+    m_dockTargets.insert(window, leader);
+    watch(window);
+    watch(leader);
+}
+
+void DragController::dock(QWidget *window, QWidget *leader)
+{
+    m_leaders.insert(window, leader);
+    watch(window);
+    watch(leader);
+}
+
+void DragController::undock(QWidget *window)
+{
+    m_leaders.remove(window);
+}
+
+bool DragController::isDocked(QWidget *window) const
+{
+    return !m_leaders.value(window).isNull();
+}
+
+void DragController::setSnapDistance(int pixels)
+{
+    m_snap = qMax(0, pixels);
+}
+
+int DragController::snapDistance() const
+{
+    return m_snap;
+}
+
+void DragController::watch(QWidget *window)
+{
+    if (m_watched.contains(window)) {
+        return;
+    }
+    m_watched.insert(window);
+    window->installEventFilter(this);
+    connect(window, &QObject::destroyed, this, [this, window]() {
+        m_watched.remove(window);
+        m_attached.remove(window);
+        m_dockTargets.remove(window);
+        m_leaders.remove(window);
+    });
+}
+
+bool DragController::eventFilter(QObject *watched, QEvent *event)
+{
+    QWidget *window = static_cast<QWidget *>(watched);
+    switch (event->type()) {
+    case QEvent::MouseButtonPress: {
+        auto mouseEvent = static_cast<QMouseEvent *>(event);
+        if (mouseEvent->button() == Qt::LeftButton && m_attached.contains(window)) {
+            m_window = window;
+            m_offset = mouseEvent->globalPosition().toPoint() - window->frameGeometry().topLeft();
+            m_hasPending = false;
+            undock(window);
+            window->setCursor(Qt::ClosedHandCursor);//改变光标形状提示正在拖动
+            emit dragStarted(window);
+        }
+        break;
+    }
+    case QEvent::MouseMove: {
+        auto mouseEvent = static_cast<QMouseEvent *>(event);
+        if (window == m_window && (mouseEvent->buttons() & Qt::LeftButton)) {
+            m_pending = mouseEvent->globalPosition().toPoint() - m_offset;
+            m_hasPending = true;
+            // 距上一次移动已经超过一帧时立即移动，否则等到下一帧
+            if (!m_frameTimer.isActive()) {
+                applyMove();
+            }
+            return true;
+        }
+        break;
+    }
+    case QEvent::MouseButtonRelease: {
+        auto mouseEvent = static_cast<QMouseEvent *>(event);
+        if (window == m_window && mouseEvent->button() == Qt::LeftButton) {
+            finishDrag();
+        }
+        break;
+    }
+    case QEvent::Move: {
+        // 被跟随的窗口移动了（拖动或自由活动），停靠在它旁边的窗口平移同样的距离
+        auto moveEvent = static_cast<QMoveEvent *>(event);
+        const QPoint delta = moveEvent->pos() - moveEvent->oldPos();
+        if (delta.isNull()) {
+            break;
+        }
+        for (auto it = m_leaders.constBegin(); it != m_leaders.constEnd(); ++it) {
+            if (it.value().data() == window && it.key() != m_window) {
+                it.key()->move(it.key()->pos() + delta);
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+/*
+ * 把最新的目标位置应用到窗口上，然后等一帧再处理后续的移动
+ */
+void DragController::applyMove()
+{
+    if (!m_window || !m_hasPending) {
+        return;
+    }
+    m_hasPending = false;
+    const QPoint pos = snapped(m_window, m_pending);
+    if (pos != m_window->pos()) {
+        m_window->move(pos);
+    }
+    m_frameTimer.start();
+}
+
+void DragController::finishDrag()
+{
+    m_frameTimer.stop();
+    applyMove();
+    m_frameTimer.stop();
+    QWidget *window = m_window;
+    m_window = nullptr;
+    window->unsetCursor();
+
+    QWidget *leader = m_dockTargets.value(window);
+    QPoint pos;
+    if (leader && leader->isVisible() && dockPosition(window, leader, &pos)) {
+        window->move(pos);
+        dock(window, leader);
+    }
+    emit dragFinished(window);
+}
+
+/*
+ * 靠近窗口所在屏幕可用区域的边缘时吸附过去
+ */
+QPoint DragController::snapped(QWidget *window, const QPoint &pos) const
+{
+    if (m_snap <= 0) {
+        return pos;
+    }
+    const QSize size = window->frameGeometry().size();
+    QScreen *screen = QGuiApplication::screenAt(pos + QPoint(size.width() / 2, size.height() / 2));
+    if (!screen) {
+        return pos;
+    }
+    const QRect area = screen->availableGeometry();
+    QPoint result = pos;
+    if (qAbs(pos.x() - area.left()) <= m_snap) {
+        result.setX(area.left());
+    } else if (qAbs(pos.x() + size.width() - 1 - area.right()) <= m_snap) {
+        result.setX(area.right() + 1 - size.width());
+    }
+    if (qAbs(pos.y() - area.top()) <= m_snap) {
+        result.setY(area.top());
+    } else if (qAbs(pos.y() + size.height() - 1 - area.bottom()) <= m_snap) {
+        result.setY(area.bottom() + 1 - size.height());
+    }
+    return result;
+}
+
+/*
+ * window 的某条边与 leader 相对的边相距不超过吸附距离、且两者在另一方向上有重叠时，视为紧挨
+ */
+bool DragController::dockPosition(QWidget *window, QWidget *leader, QPoint *pos) const
+{
+    const int reach = qMax(m_snap, 8);
+    const QRect r = window->frameGeometry();
+    const QRect l = leader->frameGeometry();
+    const bool rowOverlap = r.top() < l.bottom() && r.bottom() > l.top();
+    const bool columnOverlap = r.left() < l.right() && r.right() > l.left();
+    if (rowOverlap && qAbs(r.left() - (l.right() + 1)) <= reach) {
+        *pos = QPoint(l.right() + 1, r.top());
+    } else if (rowOverlap && qAbs(r.right() + 1 - l.left()) <= reach) {
+        *pos = QPoint(l.left() - r.width(), r.top());
+    } else if (columnOverlap && qAbs(r.top() - (l.bottom() + 1)) <= reach) {
+        *pos = QPoint(r.left(), l.bottom() + 1);
+    } else if (columnOverlap && qAbs(r.bottom() + 1 - l.top()) <= reach) {
+        *pos = QPoint(r.left(), l.top() - r.height());
+    } else {
+        return false;
+    }
+    return true;
+}
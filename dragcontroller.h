@@ -0,0 +1,66 @@
+#ifndef DRAGCONTROLLER_H
+#define DRAGCONTROLLER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QPoint>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+
+class QWidget;
+
+/*
+ * DragController：所有无边框窗口共用的拖动处理
+ *
+ * 窗口只需 attach()，不再各自重写鼠标事件：
+ *  - 拖动时只记录最新的目标位置，每个显示帧最多 move() 一次。高回报率鼠标每秒上千个移动事件，
+ *    半透明窗口每次移动都要重新合成，合并后移动次数不超过刷新率；
+ *  - 靠近屏幕可用区域的边缘（配置项 drag/snapDistance，默认16像素，0为关闭）时吸附到边缘；
+ *  - 停靠：窗口可以停靠在另一个窗口（桌宠）旁边，之后随它一起移动。拖动停靠的窗口即脱离，
+ *    松开时紧挨着目标窗口的边缘则重新停靠。
+ */
+class DragController : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DragController(QObject *parent = nullptr);
+
+    void attach(QWidget *window);//按住窗口空白处（子控件不处理的鼠标事件）即可拖动
+    void setDockTarget(QWidget *window, QWidget *leader);//window 松开在 leader 边缘时停靠到它
+    void dock(QWidget *window, QWidget *leader);//保持当前的相对位置跟随 leader
+    void undock(QWidget *window);
+    bool isDocked(QWidget *window) const;
+
+    void setSnapDistance(int pixels);
+    int snapDistance() const;
+
+signals:
+    void dragStarted(QWidget *window);
+    void dragFinished(QWidget *window);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void applyMove();
+
+private:
+    void watch(QWidget *window);
+    QPoint snapped(QWidget *window, const QPoint &pos) const;
+    bool dockPosition(QWidget *window, QWidget *leader, QPoint *pos) const;//紧挨 leader 时给出对齐后的位置
+    void finishDrag();
+
+    QSet<QWidget*> m_attached;
+    QSet<QWidget*> m_watched;
+    QPointer<QWidget> m_window;//正在拖动的窗口
+    QPoint m_offset;//按下位置相对窗口左上角的偏移
+    QPoint m_pending;//还没有应用的目标位置
+    bool m_hasPending;
+    QTimer m_frameTimer;
+    QHash<QWidget*, QPointer<QWidget>> m_dockTargets;
+    QHash<QWidget*, QPointer<QWidget>> m_leaders;//已停靠的窗口 → 跟随的窗口
+    int m_snap;
+};
+
+#endif // DRAGCONTROLLER_H
@@ -0,0 +1,167 @@
+#include "fft.h"
+#include <QtGlobal>
+#include <QtMath>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PET_FFT_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PET_FFT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// 一级蝶形：b 乘旋转因子后与 a 相加减
+inline void butterfly(float *re, float *im, int a, int b, float wr, float wi)
+{
+    const float tr = re[b] * wr - im[b] * wi;
+    const float ti = re[b] * wi + im[b] * wr;
+    re[b] = re[a] - tr;
+    im[b] = im[a] - ti;
+    re[a] += tr;
+    im[a] += ti;
+}
+
+void stageScalar(float *re, float *im, int n, int half, const float *wr, const float *wi)
+{
+    for (int start = 0; start < n; start += half * 2) {
+        for (int k = 0; k < half; ++k) {
+            butterfly(re, im, start + k, start + k + half, wr[k], wi[k]);
+        }
+    }
+}
+
+#ifdef PET_FFT_SSE
+
+void stageSimd(float *re, float *im, int n, int half, const float *wr, const float *wi)
+{
+    for (int start = 0; start < n; start += half * 2) {
+        float *ar = re + start;
+        float *ai = im + start;
+        float *br = ar + half;
+        float *bi = ai + half;
+        for (int k = 0; k < half; k += 4) {
+            const __m128 wr4 = _mm_loadu_ps(wr + k);
+            const __m128 wi4 = _mm_loadu_ps(wi + k);
+            const __m128 br4 = _mm_loadu_ps(br + k);
+            const __m128 bi4 = _mm_loadu_ps(bi + k);
+            const __m128 tr = _mm_sub_ps(_mm_mul_ps(br4, wr4), _mm_mul_ps(bi4, wi4));
+            const __m128 ti = _mm_add_ps(_mm_mul_ps(br4, wi4), _mm_mul_ps(bi4, wr4));
+            const __m128 ar4 = _mm_loadu_ps(ar + k);
+            const __m128 ai4 = _mm_loadu_ps(ai + k);
+            _mm_storeu_ps(br + k, _mm_sub_ps(ar4, tr));
+            _mm_storeu_ps(bi + k, _mm_sub_ps(ai4, ti));
+            _mm_storeu_ps(ar + k, _mm_add_ps(ar4, tr));
+            _mm_storeu_ps(ai + k, _mm_add_ps(ai4, ti));
+        }
+    }
+}
+
+#elif defined(PET_FFT_NEON)
+
+void stageSimd(float *re, float *im, int n, int half, const float *wr, const float *wi)
+{
+    for (int start = 0; start < n; start += half * 2) {
+        float *ar = re + start;
+        float *ai = im + start;
+        float *br = ar + half;
+        float *bi = ai + half;
+        for (int k = 0; k < half; k += 4) {
+            const float32x4_t wr4 = vld1q_f32(wr + k);
+            const float32x4_t wi4 = vld1q_f32(wi + k);
+            const float32x4_t br4 = vld1q_f32(br + k);
+            const float32x4_t bi4 = vld1q_f32(bi + k);
+            const float32x4_t tr = vmlsq_f32(vmulq_f32(br4, wr4), bi4, wi4);
+            const float32x4_t ti = vmlaq_f32(vmulq_f32(br4, wi4), bi4, wr4);
+            const float32x4_t ar4 = vld1q_f32(ar + k);
+            const float32x4_t ai4 = vld1q_f32(ai + k);
+            vst1q_f32(br + k, vsubq_f32(ar4, tr));
+            vst1q_f32(bi + k, vsubq_f32(ai4, ti));
+            vst1q_f32(ar + k, vaddq_f32(ar4, tr));
+            vst1q_f32(ai + k, vaddq_f32(ai4, ti));
+        }
+    }
+}
+
+#endif
+
+} // namespace
+
+Fft::Fft(int size)
+    : m_size(size)
+{
+    Q_ASSERT(size >= 2 && (size & (size - 1)) == 0);
+    int bits = 0;
+    while ((1 << bits) < size) {
+        ++bits;
+    }
+    m_reverse.resize(size);
+    for (int i = 0; i < size; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_reverse[i] = reversed;
+    }
+    m_twiddleRe.resize(size);
+    m_twiddleIm.resize(size);
+    for (int half = 1; half < size; half *= 2) {
+        for (int k = 0; k < half; ++k) {
+            const double angle = M_PI * k / half;
+            m_twiddleRe[half - 1 + k] = float(std::cos(angle));
+            m_twiddleIm[half - 1 + k] = float(-std::sin(angle));
+        }
+    }
+}
+
+int Fft::size() const
+{
+    return m_size;
+}
+
+void Fft::transform(float *re, float *im, bool simd) const
+{
+    for (int i = 0; i < m_size; ++i) {
+        const int j = m_reverse[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (int half = 1; half < m_size; half *= 2) {
+        const float *wr = m_twiddleRe.data() + half - 1;
+        const float *wi = m_twiddleIm.data() + half - 1;
+#if defined(PET_FFT_SSE) || defined(PET_FFT_NEON)
+        if (simd && half >= 4) {
+            stageSimd(re, im, m_size, half, wr, wi);
+            continue;
+        }
+#else
+        Q_UNUSED(simd);
+#endif
+        stageScalar(re, im, m_size, half, wr, wi);
+    }
+}
+
+std::vector<float> Fft::hannWindow(int size)
+{
+    std::vector<float> window(std::size_t(qMax(size, 0)), 1.0f);
+    for (int i = 0; size > 1 && i < size; ++i) {
+        window[std::size_t(i)] = float(0.5 - 0.5 * std::cos(2 * M_PI * i / (size - 1)));
+    }
+    return window;
+}
+
+QString Fft::kernelName()
+{
+#if defined(PET_FFT_SSE)
+    return QStringLiteral("SSE2");
+#elif defined(PET_FFT_NEON)
+    return QStringLiteral("NEON");
+#else
+    return QStringLiteral("scalar");
+#endif
+}
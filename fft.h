@@ -0,0 +1,34 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QString>
+#include <vector>
+
+/*
+ * Fft：固定长度的复数FFT（基2，按时间抽取）
+ *
+ * 位反转表和每一级的旋转因子在构造时算好，各级的旋转因子连续存放，
+ * 蝶形运算可以整段读入向量寄存器：
+ *  - SSE2（x86_64 的基本指令集）/ NEON（ARM64）：每次算4个蝶形；
+ *  - 前两级（每组不足4个蝶形）和其余平台逐个计算。
+ * 频谱分析每秒只做几十次2048点变换，瓶颈在内存而不是算力，不再按CPU特性细分。
+ */
+class Fft
+{
+public:
+    explicit Fft(int size);//size 必须是2的幂
+
+    int size() const;
+    // 原地变换，re/im 各 size 个元素；simd 为 false 时强制逐个计算（用于性能对比）
+    void transform(float *re, float *im, bool simd = true) const;
+    static QString kernelName();
+    static std::vector<float> hannWindow(int size);//对称 Hann 窗，频谱分析和节拍检测共用
+
+private:
+    int m_size;
+    std::vector<int> m_reverse;//位反转后的下标
+    std::vector<float> m_twiddleRe;//第 s 级（每组 h=2^s 个蝶形）的旋转因子从下标 h-1 开始
+    std::vector<float> m_twiddleIm;
+};
+
+#endif // FFT_H
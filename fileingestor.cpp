@@ -0,0 +1,493 @@
+#include "fileingestor.h"
+#include "aimanager.h"
+#include <QFileInfo>
+#include <QDebug>
+#ifdef HAVE_QT_PDF
+#include <QPdfDocument>
+#include <QPdfSelection>
+#endif
+
+namespace {
+
+// 粗略估算token数：ASCII字符约4个一个token，中日韩等多字节字符约1个字一个token
+// 以"四分之一token"为单位计数，避免浮点运算
+int tokenQuarters(ushort ch)
+{
+    return ch < 0x80 ? 1 : 4;
+}
+
+int estimateTokenCount(const QString &text)
+{
+    qint64 quarters = 0;
+    for (const QChar ch : text) {
+        if (!ch.isLowSurrogate()) {
+            quarters += tokenQuarters(ch.unicode());
+        }
+    }
+    return int(quarters / 4);
+}
+
+} // namespace
+
+FileChunkReader::FileChunkReader(QObject *parent)
+    : QObject{parent}
+    , m_mapped(nullptr)
+    , m_offset(0)
+    , m_chunkTokens(1200)
+    , m_chunkIndex(0)
+    , m_session(0)
+#ifdef HAVE_QT_PDF
+    , m_pdf(nullptr)
+    , m_page(0)
+#endif
+{
+}
+
+FileChunkReader::~FileChunkReader()
+{
+    close();
+}
+
+/*
+ * @brief 打开文件并准备分块读取
+ *
+ * 文本文件优先使用 QFile::map 做内存映射，由操作系统按需换页，读多大的文件都不会整体进内存；
+ * 映射失败（如某些网络文件系统）时改为按片段 seek+read。
+ */
+void FileChunkReader::open(const QString &filePath, int chunkTokens, int session)
+{
+    close();
+    m_session = session;
+    m_chunkTokens = qMax(64, chunkTokens);
+
+    if (QFileInfo(filePath).suffix().compare("pdf", Qt::CaseInsensitive) == 0) {
+#ifdef HAVE_QT_PDF
+        m_pdf = new QPdfDocument(this);
+        if (m_pdf->load(filePath) != QPdfDocument::Error::None) {
+            emit failed(m_session, QString("无法打开PDF文件：%1").arg(filePath));
+            close();
+            return;
+        }
+        emit opened(m_session, m_pdf->pageCount());
+#else
+        emit failed(m_session, "当前版本未启用PDF支持");
+#endif
+        return;
+    }
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        emit failed(m_session, QString("无法打开文件：%1").arg(m_file.errorString()));
+        return;
+    }
+    if (m_file.size() > 0) {
+        m_mapped = m_file.map(0, m_file.size());
+    }
+    emit opened(m_session, m_file.size());
+}
+
+void FileChunkReader::readNext()
+{
+    QString text;
+    bool ok = false;
+    qint64 unitsDone = 0;
+#ifdef HAVE_QT_PDF
+    if (m_pdf) {
+        ok = readPdfChunk(&text);
+        unitsDone = m_page;
+    } else
+#endif
+    if (m_file.isOpen()) {
+        ok = readTextChunk(&text);
+        unitsDone = m_offset;
+    }
+
+    if (ok) {
+        emit chunkReady(m_session, m_chunkIndex++, text, unitsDone);
+    } else {
+        close();
+        emit finished(m_session);
+    }
+}
+
+void FileChunkReader::close()
+{
+    if (m_mapped) {
+        m_file.unmap(const_cast<uchar*>(m_mapped));
+        m_mapped = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_window.clear();
+    m_offset = 0;
+    m_chunkIndex = 0;
+#ifdef HAVE_QT_PDF
+    if (m_pdf) {
+        m_pdf->deleteLater();
+        m_pdf = nullptr;
+    }
+    m_page = 0;
+    m_pending.clear();
+#endif
+}
+
+bool FileChunkReader::readTextChunk(QString *text)
+{
+    const qint64 size = m_file.size();
+    if (m_offset >= size) {
+        return false;
+    }
+
+    // 最坏情况下每个token占4字节，窗口按此取上限，保证能凑满一个片段
+    const qint64 windowLength = qMin<qint64>(size - m_offset, qint64(m_chunkTokens) * 4 + 4);
+    const bool atEof = m_offset + windowLength >= size;
+    const char *data = nullptr;
+    if (m_mapped) {
+        data = reinterpret_cast<const char*>(m_mapped) + m_offset;
+    } else {
+        m_file.seek(m_offset);
+        m_window = m_file.read(windowLength);
+        if (m_window.size() != windowLength) {
+            return false;
+        }
+        data = m_window.constData();
+    }
+
+    const qint64 length = chunkEnd(data, windowLength, atEof);
+    *text = QString::fromUtf8(data, length);//只转换当前片段
+    m_offset += length;
+    return true;
+}
+
+/*
+ * @brief 确定片段结尾
+ *
+ * 从窗口开头累计估算token，达到预算时停在一个完整UTF-8字符之前；
+ * 然后在片段最后20%范围内向前寻找换行符，尽量不把一行/一段从中间截断。
+ */
+qint64 FileChunkReader::chunkEnd(const char *data, qint64 length, bool atEof) const
+{
+    const qint64 budget = qint64(m_chunkTokens) * 4;
+    qint64 quarters = 0;
+    qint64 end = length;
+    for (qint64 i = 0; i < length; ++i) {
+        const uchar byte = uchar(data[i]);
+        if ((byte & 0xC0) == 0x80) {
+            continue;//UTF-8后续字节
+        }
+        if (quarters >= budget) {
+            end = i;
+            break;
+        }
+        quarters += tokenQuarters(byte);
+    }
+
+    if (end == length && !atEof) {
+        // 窗口用完却没到文件末尾：退回到最后一个字符的起始位置，避免截断多字节字符
+        while (end > 0 && (uchar(data[end - 1]) & 0xC0) == 0x80) {
+            --end;
+        }
+        if (end > 0 && uchar(data[end - 1]) >= 0xC0) {
+            --end;
+        }
+    }
+    if (end < length) {
+        for (qint64 i = end - 1; i > end * 4 / 5; --i) {
+            if (data[i] == '\n') {
+                end = i + 1;
+                break;
+            }
+        }
+    }
+    return end > 0 ? end : length;
+}
+
+#ifdef HAVE_QT_PDF
+bool FileChunkReader::readPdfChunk(QString *text)
+{
+    // 按页提取文字，凑够一个片段就停，剩余文字留给下一次
+    while (estimateTokenCount(m_pending) < m_chunkTokens && m_page < m_pdf->pageCount()) {
+        m_pending += m_pdf->getAllText(m_page++).text();
+        m_pending += '\n';
+    }
+    if (m_pending.trimmed().isEmpty()) {
+        return false;
+    }
+
+    qint64 quarters = 0;
+    int cut = 0;
+    while (cut < m_pending.size() && quarters < qint64(m_chunkTokens) * 4) {
+        quarters += tokenQuarters(m_pending.at(cut).unicode());
+        ++cut;
+    }
+    if (cut < m_pending.size() && m_pending.at(cut).isLowSurrogate()) {
+        ++cut;
+    }
+    *text = m_pending.left(cut);
+    m_pending.remove(0, cut);
+    return true;
+}
+#endif
+
+/*
+ * FileIngestor 构造函数
+ *
+ * 读取器运行在独立线程中，所有交互都通过排队的信号槽完成
+ */
+FileIngestor::FileIngestor(aimanager *ai, QObject *parent)
+    : QObject{parent}
+    , m_ai(ai)
+    , m_reader(new FileChunkReader)
+    , m_maxConcurrency(2)
+    , m_chunkTokens(1200)
+    , m_running(false)
+    , m_session(0)
+    , m_readPending(false)
+    , m_readerDone(false)
+    , m_totalUnits(0)
+    , m_unitsDone(0)
+    , m_level(0)
+    , m_reduceSubmitted(0)
+{
+    m_reader->moveToThread(&m_readerThread);
+    connect(&m_readerThread, &QThread::finished, m_reader, &QObject::deleteLater);
+    connect(this, &FileIngestor::requestOpen, m_reader, &FileChunkReader::open);
+    connect(this, &FileIngestor::requestChunk, m_reader, &FileChunkReader::readNext);
+    connect(this, &FileIngestor::requestClose, m_reader, &FileChunkReader::close);
+    connect(m_reader, &FileChunkReader::opened, this, &FileIngestor::onOpened);
+    connect(m_reader, &FileChunkReader::chunkReady, this, &FileIngestor::onChunkReady);
+    connect(m_reader, &FileChunkReader::finished, this, &FileIngestor::onReaderFinished);
+    connect(m_reader, &FileChunkReader::failed, this, &FileIngestor::onReaderFailed);
+    connect(m_ai, &aimanager::promptFinished, this, &FileIngestor::onPromptFinished);
+    m_readerThread.start();
+}
+
+FileIngestor::~FileIngestor()
+{
+    cancel();
+    m_readerThread.quit();
+    m_readerThread.wait();
+}
+
+QStringList FileIngestor::supportedFilters()
+{
+    QStringList filters;
+    filters << "文本和代码 (*.txt *.md *.markdown *.log *.csv *.json *.xml *.yaml *.yml *.ini *.c *.cc *.cpp *.h *.hpp "
+               "*.py *.js *.ts *.java *.go *.rs *.cs *.html *.css *.sh)";
+#ifdef HAVE_QT_PDF
+    filters << "PDF文档 (*.pdf)";
+#endif
+    filters << "所有文件 (*)";
+    return filters;
+}
+
+void FileIngestor::setMaxConcurrency(int count)
+{
+    m_maxConcurrency = qMax(1, count);
+}
+
+void FileIngestor::setChunkTokens(int tokens)
+{
+    m_chunkTokens = qMax(64, tokens);
+}
+
+bool FileIngestor::isRunning() const
+{
+    return m_running;
+}
+
+void FileIngestor::start(const QString &filePath)
+{
+    cancel();
+
+    m_fileName = QFileInfo(filePath).fileName();
+    m_running = true;
+    ++m_session;
+    m_readPending = false;
+    m_readerDone = false;
+    m_totalUnits = 0;
+    m_unitsDone = 0;
+    m_level = 0;
+    m_requests.clear();
+    m_summaries.clear();
+    m_reduceQueue.clear();
+    m_reduceSubmitted = 0;
+
+    emit progress(0, QString("开始读取 %1").arg(m_fileName));
+    emit requestOpen(filePath, m_chunkTokens, m_session);
+}
+
+void FileIngestor::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+    // 已发出的AI请求无法撤回，清空编号表后它们的结果会被忽略
+    m_running = false;
+    m_requests.clear();
+    m_reduceQueue.clear();
+    emit requestClose();
+}
+
+void FileIngestor::onOpened(int session, qint64 totalUnits)
+{
+    if (!m_running || session != m_session) {
+        return;
+    }
+    m_totalUnits = totalUnits;
+    pump();
+}
+
+void FileIngestor::onChunkReady(int session, int index, const QString &text, qint64 unitsDone)
+{
+    if (!m_running || session != m_session) {
+        return;
+    }
+    m_readPending = false;
+    m_unitsDone = unitsDone;
+
+    const QString prompt = QString("下面是文件《%1》的第%2个片段，请用中文简要概括其要点，不超过5句话：\n\n%3")
+                               .arg(m_fileName).arg(index + 1).arg(text);
+    const int requestId = m_ai->submitPrompt(prompt);
+    if (requestId < 0) {
+        fail("AI模型未加载");
+        return;
+    }
+    m_requests.insert(requestId, index);
+
+    const int percent = m_totalUnits > 0 ? int(m_unitsDone * 100 / m_totalUnits) : 0;
+    emit progress(percent, QString("正在阅读第%1段").arg(index + 1));
+    pump();
+}
+
+void FileIngestor::onReaderFinished(int session)
+{
+    if (!m_running || session != m_session) {
+        return;
+    }
+    m_readPending = false;
+    m_readerDone = true;
+    pump();
+}
+
+void FileIngestor::onReaderFailed(int session, const QString &error)
+{
+    if (!m_running || session != m_session) {
+        return;
+    }
+    fail(error);
+}
+
+void FileIngestor::onPromptFinished(int requestId, bool success, const QString &text)
+{
+    if (!m_running || !m_requests.contains(requestId)) {
+        return;
+    }
+    const int index = m_requests.take(requestId);
+    if (!success) {
+        fail(text);
+        return;
+    }
+
+    m_summaries.insert(index, text.trimmed());
+    if (m_level == 0) {
+        emit partialSummary(index, text.trimmed());
+    }
+    pump();
+}
+
+/*
+ * @brief 调度下一步工作
+ *
+ * map阶段：进行中的AI请求未达上限时，让读取线程预先切出下一个片段（同一时间只切一个）；
+ * reduce阶段：在上限内提交等待中的合并分组；
+ * 当前阶段全部完成后进入下一轮合并。
+ */
+void FileIngestor::pump()
+{
+    if (!m_running) {
+        return;
+    }
+
+    if (m_level == 0) {
+        if (!m_readerDone && !m_readPending && m_requests.size() < m_maxConcurrency) {
+            m_readPending = true;
+            emit requestChunk();
+        }
+    } else {
+        while (!m_reduceQueue.isEmpty() && m_requests.size() < m_maxConcurrency) {
+            const QStringList group = m_reduceQueue.takeFirst();
+            const QString prompt = QString("下面是文件《%1》若干部分的摘要，请把它们合并成一份连贯的中文摘要：\n\n%2")
+                                       .arg(m_fileName, group.join("\n\n"));
+            const int requestId = m_ai->submitPrompt(prompt);
+            if (requestId < 0) {
+                fail("AI模型未加载");
+                return;
+            }
+            m_requests.insert(requestId, m_reduceSubmitted++);
+        }
+    }
+
+    if (m_readerDone && !m_readPending && m_requests.isEmpty() && m_reduceQueue.isEmpty()) {
+        startReduce();
+    }
+}
+
+/*
+ * @brief 开始新一轮合并
+ *
+ * 按顺序把本轮摘要分组，每组总长度不超过一个片段的token预算，且至少包含两份摘要，
+ * 保证每一轮摘要数量至少减半，最终收敛成一份。
+ */
+void FileIngestor::startReduce()
+{
+    if (m_summaries.isEmpty()) {
+        fail(m_level == 0 ? "文件里没有可以读取的文字" : "摘要合并失败");
+        return;
+    }
+    if (m_summaries.size() == 1) {
+        finish(m_summaries.first());
+        return;
+    }
+
+    QList<QStringList> groups;
+    QStringList current;
+    int currentTokens = 0;
+    for (const QString &summary : std::as_const(m_summaries)) {
+        const int tokens = estimateTokenCount(summary);
+        if (current.size() >= 2 && currentTokens + tokens > m_chunkTokens) {
+            groups.append(current);
+            current.clear();
+            currentTokens = 0;
+        }
+        current.append(summary);
+        currentTokens += tokens;
+    }
+    if (current.size() == 1 && !groups.isEmpty()) {
+        groups.last().append(current.first());
+    } else if (!current.isEmpty()) {
+        groups.append(current);
+    }
+
+    ++m_level;
+    m_summaries.clear();
+    m_reduceQueue = groups;
+    m_reduceSubmitted = 0;
+    emit progress(100, QString("正在合并%1组摘要").arg(groups.size()));
+    pump();
+}
+
+void FileIngestor::finish(const QString &summary)
+{
+    m_running = false;
+    emit requestClose();
+    emit progress(100, "阅读完成");
+    emit finished(summary);
+}
+
+void FileIngestor::fail(const QString &error)
+{
+    cancel();
+    emit failed(error);
+}
@@ -0,0 +1,132 @@
+#ifndef FILEINGESTOR_H
+#define FILEINGESTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QThread>
+#include <QHash>
+#include <QMap>
+
+#ifdef HAVE_QT_PDF
+class QPdfDocument;
+#endif
+
+class aimanager;
+
+/*
+ * FileChunkReader：在后台线程中按块读取文件
+ *
+ * 文本类文件通过内存映射读取（映射失败时退化为分段读取），PDF按页提取文字。
+ * 每次 readNext() 只切出一个约 chunkTokens 个token的片段并转换成 QString，
+ * 整个文件不会一次性载入内存。
+ */
+class FileChunkReader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileChunkReader(QObject *parent = nullptr);
+    ~FileChunkReader();
+
+public slots:
+    void open(const QString &filePath, int chunkTokens, int session);
+    void readNext();//读取下一个片段，结果通过chunkReady或finished返回
+    void close();
+
+signals:
+    // session：打开文件时传入的会话编号，用来丢弃已取消任务的迟到结果
+    void opened(int session, qint64 totalUnits);//总进度单位：文本为字节数，PDF为页数
+    void chunkReady(int session, int index, const QString &text, qint64 unitsDone);
+    void finished(int session);
+    void failed(int session, const QString &error);
+
+private:
+    bool readTextChunk(QString *text);
+#ifdef HAVE_QT_PDF
+    bool readPdfChunk(QString *text);
+#endif
+    qint64 chunkEnd(const char *data, qint64 length, bool atEof) const;//在UTF-8字符边界上确定片段结尾
+
+    QFile m_file;
+    const uchar *m_mapped;//内存映射地址，映射失败时为nullptr
+    QByteArray m_window;//未映射时的分段读取缓冲区
+    qint64 m_offset;
+    int m_chunkTokens;
+    int m_chunkIndex;
+    int m_session;
+#ifdef HAVE_QT_PDF
+    QPdfDocument *m_pdf;
+    int m_page;
+    QString m_pending;//上一页未用完的文字
+#endif
+};
+
+/*
+ * FileIngestor：对本地文件做 map-reduce 式摘要
+ *
+ * map阶段：读取线程逐块产出片段，每个片段交给AI生成局部摘要，同时进行的请求数不超过 maxConcurrency；
+ * reduce阶段：把局部摘要分组合并，直到只剩一份整体摘要。
+ * 局部摘要一完成就通过 partialSummary 发出，聊天窗口可以边读边显示。
+ */
+class FileIngestor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileIngestor(aimanager *ai, QObject *parent = nullptr);
+    ~FileIngestor();
+
+    static QStringList supportedFilters();//文件对话框使用的过滤器
+
+    void setMaxConcurrency(int count);
+    void setChunkTokens(int tokens);
+    bool isRunning() const;
+
+public slots:
+    void start(const QString &filePath);
+    void cancel();
+
+signals:
+    void progress(int percent, const QString &message);
+    void partialSummary(int index, const QString &summary);
+    void finished(const QString &summary);
+    void failed(const QString &error);
+
+    // 转发给读取线程
+    void requestOpen(const QString &filePath, int chunkTokens, int session);
+    void requestChunk();
+    void requestClose();
+
+private slots:
+    void onOpened(int session, qint64 totalUnits);
+    void onChunkReady(int session, int index, const QString &text, qint64 unitsDone);
+    void onReaderFinished(int session);
+    void onReaderFailed(int session, const QString &error);
+    void onPromptFinished(int requestId, bool success, const QString &text);
+
+private:
+    void pump();//在并发上限内继续请求片段或提交合并任务
+    void startReduce();
+    void finish(const QString &summary);
+    void fail(const QString &error);
+
+    aimanager *m_ai;
+    QThread m_readerThread;
+    FileChunkReader *m_reader;
+    QString m_fileName;
+    int m_maxConcurrency;
+    int m_chunkTokens;
+    bool m_running;
+    int m_session;//每次start()递增
+    bool m_readPending;//读取线程正在切片
+    bool m_readerDone;
+    qint64 m_totalUnits;
+    qint64 m_unitsDone;
+    int m_level;//0为map阶段，>=1为第几轮reduce
+    QHash<int, int> m_requests;//请求编号 -> 片段/分组序号
+    QMap<int, QString> m_summaries;//本轮已完成的摘要，按序号排列
+    QList<QStringList> m_reduceQueue;//等待提交的合并分组
+    int m_reduceSubmitted;//本轮已提交的分组数，用作分组序号
+};
+
+#endif // FILEINGESTOR_H
@@ -0,0 +1,230 @@
+#include "frameexpander.h"
+#include <QtGlobal>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PET_EXPAND_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PET_TARGET(features)
+#else
+#define PET_TARGET(features) __attribute__((target(features)))
+#endif
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#define PET_EXPAND_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+void expandScalar(const uchar *indices, int indexStride, const QRgb *palette, int,
+                  QRgb *dst, int dstStride, int width, int height)
+{
+    for (int y = 0; y < height; ++y) {
+        const uchar *source = indices + y * indexStride;
+        QRgb *line = dst + y * dstStride;
+        for (int x = 0; x < width; ++x) {
+            line[x] = palette[source[x]];
+        }
+    }
+}
+
+#ifdef PET_EXPAND_X86
+
+struct CpuFeatures
+{
+    bool ssse3;
+    bool avx2;
+};
+
+CpuFeatures detectCpu()
+{
+    CpuFeatures features = {false, false};
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    features.ssse3 = (info[2] & (1 << 9)) != 0;
+    // AVX2 还需要操作系统保存 YMM 寄存器
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        features.avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    features.ssse3 = __builtin_cpu_supports("ssse3");
+    features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return features;
+}
+
+const CpuFeatures &cpu()
+{
+    static const CpuFeatures features = detectCpu();
+    return features;
+}
+
+PET_TARGET("avx2")
+void expandAvx2(const uchar *indices, int indexStride, const QRgb *palette, int colors,
+                QRgb *dst, int dstStride, int width, int height)
+{
+    const int *table = reinterpret_cast<const int *>(palette);
+    for (int y = 0; y < height; ++y) {
+        const uchar *source = indices + y * indexStride;
+        QRgb *line = dst + y * dstStride;
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(source + x));
+            const __m256i lanes = _mm256_cvtepu8_epi32(bytes);
+            const __m256i pixels = _mm256_i32gather_epi32(table, lanes, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(line + x), pixels);
+        }
+        for (; x < width; ++x) {
+            line[x] = palette[source[x]];
+        }
+    }
+    Q_UNUSED(colors);
+}
+
+/*
+ * 不超过16色：按 B、G、R、A 拆成4个16字节的表，PSHUFB 一次查16个索引，再交错成像素
+ */
+PET_TARGET("ssse3")
+void expandSsse3(const uchar *indices, int indexStride, const QRgb *palette, int colors,
+                 QRgb *dst, int dstStride, int width, int height)
+{
+    alignas(16) uchar planes[4][16] = {};
+    for (int c = 0; c < colors; ++c) {
+        planes[0][c] = uchar(palette[c]);
+        planes[1][c] = uchar(palette[c] >> 8);
+        planes[2][c] = uchar(palette[c] >> 16);
+        planes[3][c] = uchar(palette[c] >> 24);
+    }
+    const __m128i blue = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[0]));
+    const __m128i green = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[1]));
+    const __m128i red = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[2]));
+    const __m128i alpha = _mm_load_si128(reinterpret_cast<const __m128i *>(planes[3]));
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *source = indices + y * indexStride;
+        QRgb *line = dst + y * dstStride;
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+            const __m128i b = _mm_shuffle_epi8(blue, index);
+            const __m128i g = _mm_shuffle_epi8(green, index);
+            const __m128i r = _mm_shuffle_epi8(red, index);
+            const __m128i a = _mm_shuffle_epi8(alpha, index);
+            const __m128i bgLow = _mm_unpacklo_epi8(b, g);
+            const __m128i bgHigh = _mm_unpackhi_epi8(b, g);
+            const __m128i raLow = _mm_unpacklo_epi8(r, a);
+            const __m128i raHigh = _mm_unpackhi_epi8(r, a);
+            __m128i *out = reinterpret_cast<__m128i *>(line + x);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(bgLow, raLow));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLow, raLow));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHigh, raHigh));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHigh, raHigh));
+        }
+        for (; x < width; ++x) {
+            line[x] = palette[source[x]];
+        }
+    }
+}
+
+#endif // PET_EXPAND_X86
+
+#ifdef PET_EXPAND_NEON
+
+/*
+ * 每个通道拆成最多4段64字节的表：TBL 查第一段，超出范围的索引保持0，
+ * 后面各段用 TBX 减去段起点再查，不在本段的结果保持不变
+ */
+void expandNeon(const uchar *indices, int indexStride, const QRgb *palette, int colors,
+                QRgb *dst, int dstStride, int width, int height)
+{
+    alignas(16) uchar planes[4][256] = {};
+    for (int c = 0; c < colors; ++c) {
+        planes[0][c] = uchar(palette[c]);
+        planes[1][c] = uchar(palette[c] >> 8);
+        planes[2][c] = uchar(palette[c] >> 16);
+        planes[3][c] = uchar(palette[c] >> 24);
+    }
+    const int segments = (colors + 63) / 64;
+    uint8x16x4_t tables[4][4];
+    for (int channel = 0; channel < 4; ++channel) {
+        for (int s = 0; s < segments; ++s) {
+            for (int part = 0; part < 4; ++part) {
+                tables[channel][s].val[part] = vld1q_u8(planes[channel] + 64 * s + 16 * part);
+            }
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *source = indices + y * indexStride;
+        QRgb *line = dst + y * dstStride;
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const uint8x16_t index = vld1q_u8(source + x);
+            uint8x16x4_t pixel;
+            for (int channel = 0; channel < 4; ++channel) {
+                uint8x16_t value = vqtbl4q_u8(tables[channel][0], index);
+                for (int s = 1; s < segments; ++s) {
+                    value = vqtbx4q_u8(value, tables[channel][s], vsubq_u8(index, vdupq_n_u8(uchar(64 * s))));
+                }
+                pixel.val[channel] = value;
+            }
+            vst4q_u8(reinterpret_cast<uchar *>(line + x), pixel);
+        }
+        for (; x < width; ++x) {
+            line[x] = palette[source[x]];
+        }
+    }
+}
+
+#endif // PET_EXPAND_NEON
+
+typedef void (*ExpandKernel)(const uchar *, int, const QRgb *, int, QRgb *, int, int, int);
+
+ExpandKernel selectKernel(int colors, const char **name)
+{
+#if defined(PET_EXPAND_X86)
+    if (colors <= 16 && cpu().ssse3) {
+        *name = "SSSE3";
+        return expandSsse3;
+    }
+    if (cpu().avx2) {
+        *name = "AVX2";
+        return expandAvx2;
+    }
+#elif defined(PET_EXPAND_NEON)
+    Q_UNUSED(colors);
+    *name = "NEON";
+    return expandNeon;
+#else
+    Q_UNUSED(colors);
+#endif
+    *name = "scalar";
+    return expandScalar;
+}
+
+} // namespace
+
+void FrameExpander::expand(const uchar *indices, int indexStride, const QRgb *palette, int colors,
+                           QRgb *dst, int dstStride, int width, int height, bool simd)
+{
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    const char *name = nullptr;
+    ExpandKernel kernel = simd ? selectKernel(colors, &name) : expandScalar;
+    kernel(indices, indexStride, palette, colors, dst, dstStride, width, height);
+}
+
+QString FrameExpander::kernelName(int colors)
+{
+    const char *name = nullptr;
+    selectKernel(colors, &name);
+    return QString::fromLatin1(name);
+}
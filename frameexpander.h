@@ -0,0 +1,31 @@
+#ifndef FRAMEEXPANDER_H
+#define FRAMEEXPANDER_H
+
+#include <QString>
+#include <QRgb>
+
+/*
+ * FrameExpander：把调色板索引展开成预乘ARGB像素
+ *
+ * 缓存中的动画帧以每像素1字节的索引存放，播放时才逐帧展开到播放器的画布上。
+ * 展开是纯查表，按运行时检测到的CPU特性选择实现：
+ *  - NEON（ARM64）：按颜色通道拆成4张字节表，用 TBL/TBX 一次查16个像素，支持全部256色；
+ *  - AVX2：用 gather 指令一次查8个像素；
+ *  - SSSE3：调色板不超过16色时（增量帧常见）用 PSHUFB 一次查16个像素；
+ *  - 其余情况逐像素查表。
+ */
+class FrameExpander
+{
+public:
+    /*
+     * @param indices：索引区域左上角，indexStride 为每行字节数
+     * @param palette：预乘ARGB调色板，colors 为颜色数（1~256），索引不能超出
+     * @param dst：目标区域左上角，dstStride 为每行像素数
+     * @param simd：为 false 时强制使用逐像素实现（用于性能对比）
+     */
+    static void expand(const uchar *indices, int indexStride, const QRgb *palette, int colors,
+                       QRgb *dst, int dstStride, int width, int height, bool simd = true);
+    static QString kernelName(int colors);//给定颜色数时实际使用的实现
+};
+
+#endif // FRAMEEXPANDER_H
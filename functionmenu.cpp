@@ -1,12 +1,15 @@
 #include "functionmenu.h"
-#include "musicplayer.h"
 #include <QLayout>
 #include <QMessageBox>
+#include "windowchrome.h"
 functionMenu::functionMenu(QWidget *parent)
     : QWidget{parent}
 {
     setWindowFlags(Qt::Popup|Qt::FramelessWindowHint);//设置窗口标志：弹出式无边框窗口
     setAttribute(Qt::WA_TranslucentBackground);//设置窗口属性：创建透明或半透明窗口
+    WindowShadow shadow;
+    shadow.cornerRadius = 10;//与样式表中面板的圆角一致
+    WindowChrome::install(this, shadow);//和聊天、音乐窗口一样使用预先渲染的阴影
     // 在C++中，当你在成员函数中使用一个名称时，编译器按以下顺序查找：
     //         当前作用域的局部变量
     //         类的成员变量
@@ -18,6 +21,10 @@ functionMenu::functionMenu(QWidget *parent)
     m_layout->setContentsMargins(10,10,10,10);//设置布局整体与其父容器边界之间的边距。左上右下
     //设置样式(可选)
     setStyleSheet(
+        "functionMenu {"
+        "   background-color: #1a1a2e;"
+        "   border-radius: 10px;"
+        "}"
         "QPushButton {"
         "   background-color: #2c3e50;"
         "   color: white;"
@@ -91,9 +98,8 @@ void functionMenu::addFunction(const QString &name, const QIcon &icon)
         emit functionClicked(name);
 
         if (name == "音乐") {
-            // 创建音乐播放器窗口，传递正确的父窗口
-            MusicPlayer *musicPlayer = new MusicPlayer(this->parentWidget());
-            musicPlayer->show();
+            // 音乐播放器由 WindowManager 统一创建和复用，这里只发出 functionClicked 信号
+            hide();
         } else {
             QMessageBox::information(nullptr, name, "该功能正在开发中！");
         }
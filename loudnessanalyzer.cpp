@@ -0,0 +1,244 @@
+#include "loudnessanalyzer.h"
+#include "trackdecoder.h"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QThread>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+#include <memory>
+
+namespace {
+
+const qint64 IdleMs = 1500;//最近一次输入之后这么久才继续分析
+const double AbsoluteGateLufs = -70.0;
+const double RelativeGateLu = -10.0;
+
+double blockLoudness(double meanSquare)
+{
+    return -0.691 + 10.0 * std::log10(meanSquare + 1e-20);
+}
+
+} // namespace
+
+// ==================== LoudnessMeter ====================
+
+/*
+ * 按采样率换算K加权滤波器系数（与 BS.1770 给出的 48kHz 系数一致）
+ */
+LoudnessMeter::LoudnessMeter(int sampleRate)
+    : m_subBlockFrames(qMax(1, sampleRate / 10))
+    , m_subBlockPos(0)
+    , m_subBlockSum(0.0)
+    , m_peak(0.0f)
+{
+    const double rate = sampleRate;
+    {
+        const double f0 = 1681.974450955533;
+        const double gain = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(M_PI * f0 / rate);
+        const double vh = std::pow(10.0, gain / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        m_shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        m_shelf.b1 = 2.0 * (k * k - vh) / a0;
+        m_shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        m_shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        m_shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(M_PI * f0 / rate);
+        const double a0 = 1.0 + k / q + k * k;
+        m_highpass.b0 = 1.0;
+        m_highpass.b1 = -2.0;
+        m_highpass.b2 = 1.0;
+        m_highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+        m_highpass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    std::fill(&m_state[0][0], &m_state[0][0] + 8, 0.0);
+}
+
+void LoudnessMeter::process(const float *stereo, qint64 frames)
+{
+    for (qint64 f = 0; f < frames; ++f) {
+        for (int c = 0; c < 2; ++c) {
+            const double x = stereo[f * 2 + c];
+            m_peak = qMax(m_peak, float(std::fabs(x)));
+            double *z = m_state[c];
+            const double y1 = m_shelf.b0 * x + z[0];
+            z[0] = m_shelf.b1 * x - m_shelf.a1 * y1 + z[1];
+            z[1] = m_shelf.b2 * x - m_shelf.a2 * y1;
+            const double y2 = m_highpass.b0 * y1 + z[2];
+            z[2] = m_highpass.b1 * y1 - m_highpass.a1 * y2 + z[3];
+            z[3] = m_highpass.b2 * y1 - m_highpass.a2 * y2;
+            m_subBlockSum += y2 * y2;
+        }
+        if (++m_subBlockPos == m_subBlockFrames) {
+            m_subBlocks.push_back(m_subBlockSum / m_subBlockFrames);
+            m_subBlockSum = 0.0;
+            m_subBlockPos = 0;
+        }
+    }
+}
+
+double LoudnessMeter::integratedLoudness() const
+{
+    // 400ms 的块由相邻4个100ms段组成；不足400ms的短音频整段算一块
+    std::vector<double> blocks;
+    if (m_subBlocks.size() < 4) {
+        double sum = 0.0;
+        for (double value : m_subBlocks) {
+            sum += value;
+        }
+        if (!m_subBlocks.empty()) {
+            blocks.push_back(sum / m_subBlocks.size());
+        }
+    } else {
+        blocks.reserve(m_subBlocks.size() - 3);
+        for (std::size_t i = 3; i < m_subBlocks.size(); ++i) {
+            blocks.push_back((m_subBlocks[i - 3] + m_subBlocks[i - 2] + m_subBlocks[i - 1] + m_subBlocks[i]) / 4.0);
+        }
+    }
+
+    auto gatedMean = [&blocks](double threshold, int *count) {
+        double sum = 0.0;
+        *count = 0;
+        for (double block : blocks) {
+            if (blockLoudness(block) > threshold) {
+                sum += block;
+                ++*count;
+            }
+        }
+        return *count > 0 ? sum / *count : 0.0;
+    };
+    int count = 0;
+    const double absolute = gatedMean(AbsoluteGateLufs, &count);
+    if (count == 0) {
+        return AbsoluteGateLufs;
+    }
+    const double relativeGate = qMax(AbsoluteGateLufs, blockLoudness(absolute) + RelativeGateLu);
+    const double gated = gatedMean(relativeGate, &count);
+    return count > 0 ? blockLoudness(gated) : blockLoudness(absolute);
+}
+
+float LoudnessMeter::peak() const
+{
+    return m_peak;
+}
+
+// ==================== LoudnessAnalyzer ====================
+
+/*
+ * LoudnessAnalyzer 构造函数
+ *
+ * 最多两个最低优先级的线程；监听整个程序的输入事件判断用户是否在操作
+ */
+LoudnessAnalyzer::LoudnessAnalyzer(QObject *parent)
+    : QObject{parent}
+    , m_lastInput(-IdleMs)
+    , m_stopping(false)
+{
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 4, 2));
+    m_pool.setThreadPriority(QThread::LowestPriority);
+    m_clock.start();
+    QCoreApplication::instance()->installEventFilter(this);
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    m_stopping.store(true);
+    QCoreApplication::instance()->removeEventFilter(this);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+bool LoudnessAnalyzer::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::TouchBegin:
+        m_lastInput.store(m_clock.elapsed(), std::memory_order_relaxed);
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void LoudnessAnalyzer::enqueue(const QStringList &names)
+{
+    for (const QString &name : names) {
+        if (m_queued.contains(name)) {
+            continue;
+        }
+        m_queued.insert(name);
+        m_pool.start([this, name]() {
+            waitWhileBusy();
+            if (m_stopping.load()) {
+                return;
+            }
+            double loudness = 0.0;
+            float peak = 0.0f;
+            const bool ok = analyze(name, &loudness, &peak, [this]() {
+                waitWhileBusy();
+                return !m_stopping.load();
+            });
+            if (m_stopping.load()) {
+                return;//被中止的不算分析失败，下次启动时重新分析
+            }
+            const float gain = ok ? float(ReferenceLufs - loudness) : 0.0f;
+            QMetaObject::invokeMethod(this, [this, name, ok, gain, peak]() {
+                onAnalyzed(name, ok, gain, peak);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+int LoudnessAnalyzer::pending() const
+{
+    return m_queued.size();
+}
+
+/*
+ * 解码整首歌并测量响度，可在任意工作线程中调用
+ *
+ * @param keepGoing：每解码一块调用一次，返回 false 时中止
+ */
+bool LoudnessAnalyzer::analyze(const QString &name, double *loudness, float *peak, const std::function<bool()> &keepGoing)
+{
+    std::unique_ptr<LoudnessMeter> meter;
+    QString error;
+    const bool ok = TrackDecoder::decode(name, [&](const float *stereo, qint64 frames, int sampleRate, qint64) {
+        if (!meter) {
+            meter.reset(new LoudnessMeter(sampleRate > 0 ? sampleRate : 44100));
+        }
+        meter->process(stereo, frames);
+        return keepGoing();
+    }, &error);
+    if (!ok || !meter) {
+        qDebug() << "响度分析失败:" << name << error;
+        return false;
+    }
+    *loudness = meter->integratedLoudness();
+    *peak = meter->peak();
+    return true;
+}
+
+void LoudnessAnalyzer::waitWhileBusy()
+{
+    while (!m_stopping.load() && m_clock.elapsed() - m_lastInput.load(std::memory_order_relaxed) < IdleMs) {
+        QThread::msleep(100);
+    }
+}
+
+void LoudnessAnalyzer::onAnalyzed(const QString &name, bool ok, float gainDb, float peak)
+{
+    m_queued.remove(name);
+    emit analyzed(name, ok, gainDb, peak);
+}
@@ -0,0 +1,83 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/*
+ * LoudnessMeter：EBU R128 / ITU-R BS.1770 综合响度
+ *
+ * 两级K加权滤波（高频搁架 + 高通）后按100ms累计均方值，400ms一块、重叠75%，
+ * 先按 -70 LUFS 绝对门限、再按低于平均10 LU 的相对门限剔除安静段落后求平均。
+ */
+class LoudnessMeter
+{
+public:
+    explicit LoudnessMeter(int sampleRate);
+
+    void process(const float *stereo, qint64 frames);//交错立体声
+    double integratedLoudness() const;//LUFS；全是静音时返回 -70
+    float peak() const;//采样峰值（线性）
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    Biquad m_shelf;
+    Biquad m_highpass;
+    double m_state[2][4];//每个声道两级滤波的状态（直接II型转置）
+    int m_subBlockFrames;//100ms
+    int m_subBlockPos;
+    double m_subBlockSum;
+    std::vector<double> m_subBlocks;//每100ms的均方值（两声道相加）
+    float m_peak;
+};
+
+/*
+ * LoudnessAnalyzer：在低优先级线程池中逐首分析响度
+ *
+ * 结果按 ReplayGain 2.0 的参考电平（-18 LUFS）换算成增益。
+ * 用户正在操作（1.5 秒内有鼠标或键盘输入）时分析线程暂停，免得和界面抢CPU和磁盘。
+ */
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr double ReferenceLufs = -18.0;
+
+    explicit LoudnessAnalyzer(QObject *parent = nullptr);
+    ~LoudnessAnalyzer();
+
+    void enqueue(const QStringList &names);//资源包中的名称或本地文件的绝对路径，已在队列中的忽略
+    int pending() const;
+
+    static bool analyze(const QString &name, double *loudness, float *peak, const std::function<bool()> &keepGoing);
+
+signals:
+    // ok 为 false 表示无法解码，之后不再重试
+    void analyzed(const QString &name, bool ok, float gainDb, float peak);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void waitWhileBusy();//在线程池中调用：用户在操作时等待
+    void onAnalyzed(const QString &name, bool ok, float gainDb, float peak);
+
+    QThreadPool m_pool;
+    QSet<QString> m_queued;
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_lastInput;//最近一次用户输入的时刻（m_clock 毫秒）
+    std::atomic<bool> m_stopping;
+};
+
+#endif // LOUDNESSANALYZER_H
@@ -1,109 +1,151 @@
 #include<QApplication>
 #include<QWidget>
-#include<QRandomGenerator>
-#include<QMovie>
 #include<QLabel>
 #include<QTimer>
 #include<QMenu>
 #include<QMessageBox>
+#include<QSettings>
+#include<QScreen>
+#include<QList>
+#include<QActionGroup>
 #include"functionmenu.h"
 #include"chatroom.h"
+#include"windowmanager.h"
+#include"animationcache.h"
+#include"animationscheduler.h"
+#include"petmood.h"
+#include"petwindow.h"
+#include"motionengine.h"
+#include"dragcontroller.h"
+#include"assetpack.h"
+#include"audioservice.h"
+#include"beatdetector.h"
+#include"singleinstance.h"
+#include<cstdio>
 
-class DraggableWidget : public QWidget
+//命令已经交给正在运行的桌宠：按它的回复决定退出码
+static int forwarded(const QString &reply)
 {
-public:
-    DraggableWidget(QWidget *parent = nullptr) : QWidget(parent), m_dragging(false)
+    if(reply != "ok")
     {
-        setMouseTracking(true);//启用鼠标跟踪
+        fprintf(stderr,"%s\n",qPrintable(reply));
+        return 1;
     }
-protected:
-    void mousePressEvent(QMouseEvent *event) override
+    return 0;
+}
+
+int main(int argc,char *argv[])
+{
+    //桌宠已经在运行时，把命令行交给它后立即退出：不创建 QApplication，也不读取资源包
+    QStringList arguments;
+    for(int i=1;i<argc;++i)
     {
-        if(event->button()==Qt::LeftButton)
-        {
-            m_dragPosition = event->globalPos() - frameGeometry().topLeft();
-            m_dragging = true;
-            event->accept();
-        }
+        arguments.append(QString::fromLocal8Bit(argv[i]));
     }
-    void mouseMoveEvent(QMouseEvent *event) override
+    SingleInstance::Command command;
+    QString error;
+    if(!SingleInstance::parseArguments(arguments,&command,&error))
     {
-        if (m_dragging && (event->buttons() & Qt::LeftButton)) {
-            move(event->globalPos() - m_dragPosition);
-            event->accept();
-        }
+        fprintf(stderr,"%s\n%s",qPrintable(error),qPrintable(SingleInstance::usage()));
+        return 2;
+    }
+    QString reply;
+    if(SingleInstance::forward(command,&reply))
+    {
+        return forwarded(reply);
     }
 
-    void mouseReleaseEvent(QMouseEvent *event) override
+    QApplication app(argc,argv);
+    QCoreApplication::setOrganizationName("AIMew");//QSettings、缓存目录等使用的组织名和应用名
+    QCoreApplication::setApplicationName("Petmiao");
+    //在加载资源、创建窗口之前开始监听，命令要等进入事件循环后才处理
+    SingleInstance instance;
+    if(!instance.listen() && SingleInstance::forward(command,&reply))
     {
-        if (event->button() == Qt::LeftButton) {
-            m_dragging = false;
-            event->accept();
-        }
+        //两个进程几乎同时启动：上面转发时对方还没开始监听，现在它已经在监听了，交给它后退出，不显示第二只桌宠
+        return forwarded(reply);
     }
+    AssetLibrary::instance();//在解码线程启动前挂载资源包（只映射目录，条目用到时才读入）
+    //所有桌宠共用：动画在后台线程预先解码并缓存，切换时只替换指针，不在界面线程解码GIF
+    AnimationCache animationCache;
+    //所有动画共用一个限帧率的时钟，窗口不可见时暂停，用户离开时降帧
+    AnimationScheduler animationScheduler;
 
-private:
-    bool m_dragging;
-    QPoint m_dragPosition;
-};
+    //所有桌宠共用一个运动引擎：固定步长模拟，窗口移动按显示器刷新合并
+    MotionEngine motionEngine;
+    QObject::connect(&animationScheduler,&AnimationScheduler::stateChanged,&motionEngine,[&motionEngine](AnimationScheduler::State state){
+        motionEngine.setSuspended(state != AnimationScheduler::Running);//动画暂停或用户离开时不再走动
+    });
+    //所有窗口共用的拖动：每帧最多移动一次，靠近屏幕边缘时吸附，聊天和音乐窗口可以停靠在主桌宠旁边
+    DragController dragController;
 
-int main(int argc,char *argv[])
-{
-    QApplication app(argc,argv);
-    DraggableWidget w;//使用可拖拽的窗口类
-    w.setWindowFlag(Qt::FramelessWindowHint);//隐藏标题栏窗口
-    w.setWindowTitle("o(=•ェ•=)m");
-    w.setFixedSize(240,240);
+    //桌宠列表保存在配置项 pets（角色、位置、活动方式）中，默认只有一只内置猫猫
+    //第一只是主桌宠：功能窗口以它为父窗口，不能送走
+    struct SavedPet
+    {
+        QString character;
+        QPoint pos;
+        MotionEngine::Behavior behavior;
+    };
+    QSettings settings;
+    QList<SavedPet> savedPets;
+    const int savedCount = settings.beginReadArray("pets");
+    for(int i=0;i<savedCount;++i)
+    {
+        settings.setArrayIndex(i);
+        const int behavior = qBound(int(MotionEngine::Stay),settings.value("behavior",MotionEngine::Stay).toInt(),int(MotionEngine::Follow));
+        savedPets.append({settings.value("character").toString(),settings.value("pos",QPoint(-1,-1)).toPoint(),MotionEngine::Behavior(behavior)});
+    }
+    settings.endArray();
+    if(savedPets.isEmpty())
+    {
+        savedPets.append({PetWindow::defaultCharacter(),QPoint(-1,-1),MotionEngine::Stay});
+    }
 
-    //gif动画窗口
-    QLabel *gifLabel = new QLabel(&w);
-    gifLabel->setAlignment(Qt::AlignCenter);
+    PetWindow w(&animationCache,&animationScheduler,savedPets.first().character);
+    QList<PetWindow*> pets;
     QTimer *switchTimer = new QTimer(&w);
-    auto loadRandomGif = [&]()
-    {
-        int num = QRandomGenerator::global()->bounded(1,12);//生成1~11;上限1，下限12(不包含12)
-        QString animationPath = QString(":/image/animation%1.gif").arg(num);
-        QMovie *movie = new QMovie(animationPath);
-        if(movie->isValid())
+    QObject::connect(&animationCache,&AnimationCache::animationFailed,[&](const QString &path, const QString &){
+        //报错
+        QMessageBox::warning(&w,"资源缺失",QString("动画资源文件不存在:\n%1\n请确保资源包 petmiao.pak 在程序目录中。").arg(path));
+    });
+    //所有桌宠一起换日常动画，同一角色的动画只解码一次；放音乐时等到下一拍再换
+    bool switchOnBeat = false;
+    auto switchIdle = [&pets](){
+        for(PetWindow *pet : pets)
         {
-            QMovie *oldMovie = gifLabel->movie();
-            if(oldMovie)
+            pet->mood()->nextIdle();
+        }
+    };
+    QObject::connect(switchTimer,&QTimer::timeout,[&](){
+        if(animationScheduler.isBeatSynced())
+        {
+            switchOnBeat = true;
+            return;
+        }
+        switchIdle();
+    });
+    QObject::connect(&animationScheduler,&AnimationScheduler::beatReached,[&](){
+        if(switchOnBeat)
+        {
+            switchOnBeat = false;
+            switchIdle();
+        }
+    });
+    switchTimer->setInterval(5000);//5秒切换一次，只在动画正常播放时计时
+    QObject::connect(&animationScheduler,&AnimationScheduler::stateChanged,switchTimer,[switchTimer](AnimationScheduler::State state){
+        if(state == AnimationScheduler::Running)
+        {
+            if(!switchTimer->isActive())
             {
-                oldMovie->stop();
-                delete oldMovie;
+                switchTimer->start();
             }
-            gifLabel->setMovie(movie);
-            movie->start();
         }
         else
         {
-            //报错
-            QMessageBox::warning(&w,"资源缺失",QString("动画资源文件不存在:\n%1\n请确保文件已添加到资源中。").arg(animationPath));
+            switchTimer->stop();
         }
-    };
-    QObject::connect(switchTimer,&QTimer::timeout,[&](){
-        loadRandomGif();
     });
-    loadRandomGif();//初始加载一次
-    switchTimer->start(5000);//启动定时器，5秒切换一次
-
-    //主窗口文字标签1
-    QLabel *titleLabel = new QLabel("你好啊！o(=•ェ•=)m",&w);
-    titleLabel->setAlignment(Qt::AlignCenter);
-    titleLabel->setStyleSheet(
-        R"(
-            QLabel
-            {
-                background-color: black;
-                color: white;
-                font-size: 16px;
-                font-weight: bold;
-                border: none;
-            }
-        )"
-    );
-    titleLabel->setGeometry(0,0,240,30);
-
     //为窗口 w 创建一个右键上下文菜单，包含四个选项：
     QMenu *contextMenu = new QMenu(&w);
     contextMenu->addSeparator();//分隔符,目前显示还有点问题
@@ -130,11 +172,28 @@ int main(int argc,char *argv[])
         "   margin: 5px 0px 5px 0px;"   // 分隔符边距
         "}"
     );
+    PetWindow *menuPet = &w;//右键菜单所属的桌宠
     QAction *functionmenuAction = contextMenu->addAction("显示功能菜单");//向 rightMenu 这个菜单中添加一个菜单项,文本显示为"显示功能菜单"
     QAction *chatAction = contextMenu->addAction("聊天");
     QAction *quitAction = contextMenu->addAction("退出");
     QAction *helpAction = contextMenu->addAction("帮助");
-    w.setContextMenuPolicy(Qt::CustomContextMenu);//必须设置此项;.setContextMenuPolic()设置该部件处理上下文菜单（通常由鼠标右键点击触发）的策略;Qt::CustomContextMenu我将不使用默认的上下文菜单行为，而是要自己处理并显示一个自定义的菜单。
+    QMenu *behaviorMenu = contextMenu->addMenu("活动方式");
+    QActionGroup *behaviorGroup = new QActionGroup(behaviorMenu);
+    const QList<QPair<MotionEngine::Behavior,QString>> behaviors = {
+        {MotionEngine::Stay,"待在原地"},{MotionEngine::Wander,"四处走走"},{MotionEngine::Follow,"跟着鼠标"}};
+    for(const auto &behavior : behaviors)
+    {
+        QAction *action = behaviorMenu->addAction(behavior.second);
+        action->setCheckable(true);
+        action->setData(int(behavior.first));
+        behaviorGroup->addAction(action);
+    }
+    QObject::connect(behaviorGroup,&QActionGroup::triggered,[&](QAction *action){
+        motionEngine.setBehavior(menuPet,MotionEngine::Behavior(action->data().toInt()));
+    });
+    QMenu *addPetMenu = contextMenu->addMenu("添加桌宠");
+    QAction *removePetAction = contextMenu->addAction("送走这只桌宠");
+    //PetWindow 构造时已 setContextMenuPolicy(Qt::CustomContextMenu)：不使用默认的上下文菜单行为，而是要自己处理并显示一个自定义的菜单。
     //处理自定义右键菜单请求;
     // 信号连接
     //     信号源：&w（窗口部件）的 customContextMenuRequested 信号
@@ -148,32 +207,99 @@ int main(int argc,char *argv[])
     //                     菜单显示：调用 contextMenu->exec() 在正确位置显示菜单
     //工作流程
     //  用户右键点击 → 触发 customContextMenuRequested 信号 →Lambda 函数执行 → 坐标转换 → 显示菜单
-    QObject::connect(&w,&QWidget::customContextMenuRequested,[&](const QPoint &pos)//[]捕获列表，()参数，{}函数体，Lambda 表达式
+    //添加一只桌宠：没有保存的位置时放到下一个显示器的中央，每个显示器一只，多出来的错开摆放
+    auto addPet = [&](PetWindow *pet, QPoint pos, MotionEngine::Behavior behavior){
+        QObject::connect(pet,&QWidget::customContextMenuRequested,[&, pet](const QPoint &pos)//[]捕获列表，()参数，{}函数体，Lambda 表达式
+            {
+                menuPet = pet;
+                removePetAction->setEnabled(pet != &w);
+                for(QAction *action : behaviorGroup->actions())
+                {
+                    action->setChecked(action->data().toInt() == motionEngine.behavior(pet));
+                }
+                contextMenu->exec(pet->mapToGlobal(pos));//转换为全局坐标位置
+            }
+        );
+        if(!QGuiApplication::screenAt(pos))
         {
-            contextMenu->exec(w.mapToGlobal(pos));//转换为全局坐标位置
+            const QList<QScreen*> screens = QGuiApplication::screens();
+            const int index = pets.size();
+            const QRect area = screens.at(index % screens.size())->availableGeometry();
+            const int offset = 40 * (index / screens.size());
+            pos = area.center() - QPoint(pet->width()/2,pet->height()/2) + QPoint(offset,offset);
         }
-    );
+        pet->move(pos);
+        pets.append(pet);
+        dragController.attach(pet);
+        motionEngine.addBody(pet,behavior);
+        animationScheduler.watchWindow(pet);
+        pet->mood()->nextIdle();//初始加载一次
+        pet->show();
+    };
+    QObject::connect(&motionEngine,&MotionEngine::facingChanged,[](QWidget *window, bool right){
+        static_cast<PetWindow*>(window)->setFacingRight(right);
+    });
+    addPet(&w,savedPets.first().pos,savedPets.first().behavior);
+    for(int i=1;i<savedPets.size();++i)
+    {
+        addPet(new PetWindow(&animationCache,&animationScheduler,savedPets.at(i).character),savedPets.at(i).pos,savedPets.at(i).behavior);
+    }
+    const QStringList characters = PetWindow::characters();
+    for(const QString &character : characters)
+    {
+        QAction *action = addPetMenu->addAction(PetWindow::characterName(character));
+        QObject::connect(action,&QAction::triggered,[&, character](){
+            addPet(new PetWindow(&animationCache,&animationScheduler,character),QPoint(-1,-1),MotionEngine::Stay);
+        });
+    }
+    QObject::connect(removePetAction,&QAction::triggered,[&](){
+        if(menuPet != &w)
+        {
+            pets.removeOne(menuPet);
+            menuPet->deleteLater();
+            menuPet = &w;
+        }
+    });
+    //退出时保存每只桌宠的角色、位置和活动方式
+    QObject::connect(&app,&QCoreApplication::aboutToQuit,[&](){
+        QSettings settings;
+        settings.beginWriteArray("pets",pets.size());
+        for(int i=0;i<pets.size();++i)
+        {
+            settings.setArrayIndex(i);
+            settings.setValue("character",pets.at(i)->character());
+            settings.setValue("pos",pets.at(i)->pos());
+            settings.setValue("behavior",int(motionEngine.behavior(pets.at(i))));
+        }
+        settings.endArray();
+    });
     // triggered 和 clicked 有什么区别？
     //     triggered: 用户通过任何方式触发的动作（点击、快捷键、菜单等;主要用于 QAction 类
     //     clicked: 仅当用户鼠标点击时触发;主要用于 QPushButton、QToolButton 等按钮类组件
     //功能菜单显示
-    QObject::connect(functionmenuAction,&QAction::triggered,[&](){
-        //QMessageBox::information(nullptr, "提示", "功能菜单正在开发中");
-        //创建一个function实例，但不会立即显示
-        functionMenu *function = new functionMenu(&w);
-        //QPoint menuPos = w.mapToGlobal(QPoint(w.width(),0));//&w窗口右侧
-        QPoint menuPos = w.mapToGlobal(QPoint(-function->width()-10,0));//设置functionMenu的位置，&w窗口左侧
-        function->move(menuPos);
-        function->show();
+    //各功能窗口交给会话管理器：只创建一次，之后重复打开时复用同一个实例
+    WindowManager windowManager(&w,&dragController);
+    //聊天中的情绪所有桌宠一起反应
+    QObject::connect(&windowManager,&WindowManager::chatCreated,[&](chatroom *chat){
+        QObject::connect(chat,&chatroom::moodAnticipated,chat,[&pets](PetMood::Mood mood){
+            for(PetWindow *pet : pets)
+            {
+                pet->mood()->anticipate(mood);
+            }
+        });
+        QObject::connect(chat,&chatroom::moodExpressed,chat,[&pets](PetMood::Mood mood){
+            for(PetWindow *pet : pets)
+            {
+                pet->mood()->react(mood);
+            }
+        });
     });
-    QObject::connect(chatAction,&QAction::triggered,[&](){
-        // QMessageBox::information(nullptr, "聊天功能", "即将支持与桌面宠物聊天互动！");
-        //创建一个chatroom实例，但不会立即显示
-        chatroom *chat = new chatroom(&w);
-        QPoint chatPos = w.mapToGlobal(QPoint(0,w.height()));
-        chat->move(chatPos);
-        chat->show();
+    //音乐的节拍送给动画时钟：换帧和换动画都落在拍子上
+    QObject::connect(&windowManager,&WindowManager::audioServiceCreated,[&](AudioService *audio){
+        QObject::connect(audio->beatDetector(),&BeatDetector::beat,&animationScheduler,&AnimationScheduler::beat);
     });
+    QObject::connect(functionmenuAction,&QAction::triggered,&windowManager,&WindowManager::showFunctionMenu);
+    QObject::connect(chatAction,&QAction::triggered,&windowManager,&WindowManager::showChat);
     // 连接退出动作到退出程序
     QObject::connect(quitAction,&QAction::triggered,[](){
         QApplication::quit();// 直接退出应用程序
@@ -182,6 +308,70 @@ int main(int argc,char *argv[])
         QMessageBox::information(nullptr, "帮助", "帮助提示功能正在开发中");
     });
 
-    w.show();
-    return app.exec();
+    //远程命令：之后再启动的进程、脚本和快捷键通过本地套接字控制这只桌宠
+    auto runCommand = [&](const QString &name, const QString &argument){
+        if(name == "show")
+        {
+            for(PetWindow *pet : pets)
+            {
+                pet->show();
+                pet->raise();
+            }
+            w.activateWindow();
+        }
+        else if(name == "play")
+        {
+            windowManager.audioService()->play();//不创建播放器窗口，只在后台播放
+        }
+        else if(name == "pause")
+        {
+            windowManager.audioService()->pause();
+        }
+        else if(name == "toggle")
+        {
+            windowManager.audioService()->playPause();
+        }
+        else if(name == "next")
+        {
+            windowManager.audioService()->next();
+        }
+        else if(name == "prev")
+        {
+            windowManager.audioService()->previous();
+        }
+        else if(name == "say")
+        {
+            windowManager.chatWindow()->say(argument);
+        }
+        else if(name == "ask")
+        {
+            windowManager.showChat();//回答显示在聊天窗口中
+            windowManager.chatWindow()->ask(argument);
+        }
+        else if(name == "chat")
+        {
+            windowManager.showChat();
+        }
+        else if(name == "music")
+        {
+            windowManager.showMusicPlayer();
+        }
+        else if(name == "quit")
+        {
+            QApplication::quit();
+        }
+    };
+    QObject::connect(&instance,&SingleInstance::commandReceived,runCommand);
+    //第一次启动时带的命令在进入事件循环后执行
+    if(command.name != "show")
+    {
+        QTimer::singleShot(0,&app,[runCommand,command](){
+            runCommand(command.name,command.argument);
+        });
+    }
+
+    const int result = app.exec();
+    pets.removeOne(&w);
+    qDeleteAll(pets);
+    return result;
 }
@@ -0,0 +1,350 @@
+#include "markdownrenderer.h"
+#include <QRegularExpression>
+#include <QStringList>
+
+namespace {
+
+enum LineKind { BlankLine, FenceLine, HeadingLine, ListLine, QuoteLine, IndentedLine, TextLine };
+
+int leadingSpaces(QStringView line)
+{
+    int i = 0;
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) {
+        ++i;
+    }
+    return i;
+}
+
+// 列表项："- "、"* "、"+ "、"1. "、"1) "；返回内容起始位置，不是列表项时返回-1
+int listContentStart(QStringView line)
+{
+    int i = leadingSpaces(line);
+    if (i >= line.size()) {
+        return -1;
+    }
+    const QChar c = line[i];
+    if (c == '-' || c == '*' || c == '+') {
+        ++i;
+    } else if (c.isDigit()) {
+        const int digitsStart = i;
+        while (i < line.size() && line[i].isDigit() && i - digitsStart < 9) {
+            ++i;
+        }
+        if (i >= line.size() || (line[i] != '.' && line[i] != ')')) {
+            return -1;
+        }
+        ++i;
+    } else {
+        return -1;
+    }
+    if (i < line.size() && line[i] != ' ' && line[i] != '\t') {
+        return -1;
+    }
+    return qMin<int>(i + 1, line.size());
+}
+
+// 代码围栏：至少三个连续的 ` 或 ~，返回围栏字符，不是围栏时返回空字符
+QChar fenceChar(QStringView line)
+{
+    const int i = leadingSpaces(line);
+    if (i > 3 || line.size() - i < 3) {
+        return QChar();
+    }
+    const QChar c = line[i];
+    if ((c != '`' && c != '~') || line[i + 1] != c || line[i + 2] != c) {
+        return QChar();
+    }
+    return c;
+}
+
+int headingLevel(QStringView line)
+{
+    int level = 0;
+    while (level < line.size() && line[level] == '#') {
+        ++level;
+    }
+    if (level == 0 || level > 6) {
+        return 0;
+    }
+    if (level < line.size() && line[level] != ' ' && line[level] != '\t') {
+        return 0;
+    }
+    return level;
+}
+
+LineKind classify(QStringView line)
+{
+    if (line.trimmed().isEmpty()) {
+        return BlankLine;
+    }
+    if (!fenceChar(line).isNull()) {
+        return FenceLine;
+    }
+    if (headingLevel(line) > 0) {
+        return HeadingLine;
+    }
+    if (listContentStart(line) >= 0) {
+        return ListLine;
+    }
+    const int indent = leadingSpaces(line);
+    if (line[indent] == '>') {
+        return QuoteLine;
+    }
+    return indent > 0 ? IndentedLine : TextLine;
+}
+
+// 对已转义的文本应用强调和链接
+QString applyEmphasis(QString html)
+{
+    static const QRegularExpression link(QStringLiteral("\\[([^\\]]+)\\]\\((https?://[^\\s)]+)\\)"));
+    static const QRegularExpression bold(QStringLiteral("\\*\\*(?=\\S)(.+?)(?<=\\S)\\*\\*"));
+    static const QRegularExpression boldUnderscore(QStringLiteral("(?<!\\w)__(?=\\S)(.+?)(?<=\\S)__(?!\\w)"));
+    static const QRegularExpression italic(QStringLiteral("(?<![\\*\\w])\\*(?=[^\\s\\*])(.+?)(?<=[^\\s\\*])\\*(?![\\*\\w])"));
+    static const QRegularExpression italicUnderscore(QStringLiteral("(?<!\\w)_(?=\\S)(.+?)(?<=\\S)_(?!\\w)"));
+    static const QRegularExpression strike(QStringLiteral("~~(?=\\S)(.+?)(?<=\\S)~~"));
+
+    html.replace(link, QStringLiteral("<a href=\"\\2\">\\1</a>"));
+    html.replace(bold, QStringLiteral("<b>\\1</b>"));
+    html.replace(boldUnderscore, QStringLiteral("<b>\\1</b>"));
+    html.replace(italic, QStringLiteral("<i>\\1</i>"));
+    html.replace(italicUnderscore, QStringLiteral("<i>\\1</i>"));
+    html.replace(strike, QStringLiteral("<s>\\1</s>"));
+    return html;
+}
+
+} // namespace
+
+MarkdownRenderer::MarkdownRenderer()
+{
+    reset();
+}
+
+void MarkdownRenderer::reset()
+{
+    m_pending.clear();
+    m_lineStart = 0;
+    m_blockKind = None;
+    m_fenceChar = QChar();
+    m_committed.clear();
+    m_empty = true;
+}
+
+bool MarkdownRenderer::isEmpty() const
+{
+    return m_empty;
+}
+
+/*
+ * 追加一段新文本
+ *
+ * 只从新文本开始处找换行（之前的未完成行里一定没有换行），逐行更新块状态。
+ * 返回本次新定稿的块和重新渲染的尾部。
+ */
+MarkdownRenderer::Update MarkdownRenderer::append(const QString &delta)
+{
+    m_committed.clear();
+    if (!delta.isEmpty()) {
+        m_empty = false;
+    }
+
+    int from = m_pending.size();
+    m_pending += delta;
+    int newline;
+    while ((newline = m_pending.indexOf('\n', from)) >= 0) {
+        const int start = m_lineStart;
+        m_lineStart = newline + 1;
+        processLine(QStringView(m_pending).mid(start, newline - start), start, newline + 1);
+        from = m_lineStart;
+    }
+
+    Update update;
+    update.committedHtml = m_committed;
+    update.tailHtml = renderBlock(m_pending);
+    return update;
+}
+
+MarkdownRenderer::Update MarkdownRenderer::finish()
+{
+    m_committed.clear();
+    commit(m_pending.size());
+    m_blockKind = None;
+
+    Update update;
+    update.committedHtml = m_committed;
+    return update;
+}
+
+/*
+ * 处理一行完整的文本，决定它属于当前块，还是让当前块结束
+ *
+ * @param start/end：这一行在 m_pending 中的起止位置（end 包含换行符）
+ */
+void MarkdownRenderer::processLine(QStringView line, int start, int end)
+{
+    // 提交会修改 m_pending，先把这一行需要的信息取出来
+    const LineKind kind = classify(line);
+    const QChar fence = kind == FenceLine ? fenceChar(line) : QChar();
+
+    if (m_blockKind == Code) {
+        if (fence == m_fenceChar) {
+            commit(end);
+            m_blockKind = None;
+        }
+        return;
+    }
+
+    switch (kind) {
+    case BlankLine:
+        commit(end);
+        m_blockKind = None;
+        break;
+    case FenceLine:
+        commit(start);
+        m_blockKind = Code;
+        m_fenceChar = fence;
+        break;
+    case HeadingLine:
+        commit(start);
+        commit(end - start);
+        m_blockKind = None;
+        break;
+    case ListLine:
+        if (m_blockKind != List) {
+            commit(start);
+            m_blockKind = List;
+        }
+        break;
+    case QuoteLine:
+        if (m_blockKind != Quote) {
+            commit(start);
+            m_blockKind = Quote;
+        }
+        break;
+    case IndentedLine:
+        // 缩进行视为当前块（通常是列表项）的延续
+        if (m_blockKind == None) {
+            m_blockKind = Paragraph;
+        }
+        break;
+    case TextLine:
+        if (m_blockKind != Paragraph) {
+            commit(start);
+            m_blockKind = Paragraph;
+        }
+        break;
+    }
+}
+
+void MarkdownRenderer::commit(int length)
+{
+    if (length <= 0) {
+        return;
+    }
+    const QString block = m_pending.left(length);
+    m_pending.remove(0, length);
+    m_lineStart -= length;
+    m_committed += renderBlock(block);
+}
+
+/*
+ * 把一个块渲染成 QTextDocument 支持的HTML子集
+ *
+ * 未闭合的代码块也按代码块显示，这样流式输出时代码不会先以普通段落出现再跳变。
+ */
+QString MarkdownRenderer::renderBlock(const QString &markdown)
+{
+    int begin = 0;
+    int stop = markdown.size();
+    while (begin < stop && markdown[begin] == '\n') {
+        ++begin;
+    }
+    while (stop > begin && markdown[stop - 1].isSpace()) {
+        --stop;
+    }
+    if (begin >= stop) {
+        return QString();
+    }
+
+    const QStringList lines = markdown.mid(begin, stop - begin).split('\n');
+    const QString &first = lines.first();
+
+    const QChar fence = fenceChar(first);
+    if (!fence.isNull()) {
+        int last = lines.size();
+        if (last > 1 && fenceChar(lines.last()) == fence) {
+            --last;
+        }
+        QStringList code;
+        for (int i = 1; i < last; ++i) {
+            code << lines.at(i).toHtmlEscaped();
+        }
+        return QStringLiteral("<pre>%1</pre>").arg(code.join('\n'));
+    }
+
+    const int level = headingLevel(first);
+    if (level > 0) {
+        // 聊天窗口很窄，标题整体降两级显示
+        const int tag = qMin(level + 2, 6);
+        return QStringLiteral("<h%1>%2</h%1>").arg(tag).arg(renderInline(QStringView(first).mid(level).trimmed()));
+    }
+
+    const int contentStart = listContentStart(first);
+    if (contentStart >= 0) {
+        const bool ordered = first[leadingSpaces(first)].isDigit();
+        QStringList items;
+        for (const QString &line : lines) {
+            const int start = listContentStart(line);
+            if (start >= 0) {
+                items << line.mid(start).trimmed();
+            } else if (!items.isEmpty()) {
+                items.last() += QLatin1Char(' ');
+                items.last() += line.trimmed();
+            }
+        }
+        QString html = ordered ? QStringLiteral("<ol>") : QStringLiteral("<ul>");
+        for (const QString &item : items) {
+            html += QStringLiteral("<li>") + renderInline(item) + QStringLiteral("</li>");
+        }
+        html += ordered ? QStringLiteral("</ol>") : QStringLiteral("</ul>");
+        return html;
+    }
+
+    const int indent = leadingSpaces(first);
+    if (indent < first.size() && first[indent] == '>') {
+        QStringList quoted;
+        for (const QString &line : lines) {
+            QStringView text = QStringView(line).trimmed();
+            if (text.startsWith('>')) {
+                text = text.mid(1).trimmed();
+            }
+            quoted << renderInline(text);
+        }
+        return QStringLiteral("<blockquote>%1</blockquote>").arg(quoted.join(QStringLiteral("<br>")));
+    }
+
+    QStringList paragraph;
+    for (const QString &line : lines) {
+        paragraph << renderInline(QStringView(line).trimmed());
+    }
+    return QStringLiteral("<p>%1</p>").arg(paragraph.join(QStringLiteral("<br>")));
+}
+
+QString MarkdownRenderer::renderInline(QStringView text)
+{
+    // 先按反引号切出行内代码，代码里的内容不做强调处理
+    QString html;
+    int pos = 0;
+    while (pos < text.size()) {
+        const int open = text.indexOf('`', pos);
+        const int close = open >= 0 ? text.indexOf('`', open + 1) : -1;
+        if (close < 0) {
+            html += applyEmphasis(text.mid(pos).toString().toHtmlEscaped());
+            break;
+        }
+        html += applyEmphasis(text.mid(pos, open - pos).toString().toHtmlEscaped());
+        html += QStringLiteral("<code>") + text.mid(open + 1, close - open - 1).toString().toHtmlEscaped()
+                + QStringLiteral("</code>");
+        pos = close + 1;
+    }
+    return html;
+}
@@ -0,0 +1,50 @@
+#ifndef MARKDOWNRENDERER_H
+#define MARKDOWNRENDERER_H
+
+#include <QString>
+#include <QStringView>
+
+/*
+ * MarkdownRenderer：流式AI回复的增量Markdown渲染
+ *
+ * 回复按块（段落、列表、引用、标题、代码块）切分。新文本到达时只扫描新增的完整行：
+ * 遇到空行、标题行、闭合的代码围栏或块类型变化，就把前面的块定稿并渲染成HTML，之后不再改动；
+ * 最后一个还没写完的块每次重新渲染。因此每次追加的开销只和新增文本及最后一块的长度有关，
+ * 与整条消息的长度无关。
+ *
+ * 只依赖 QtCore，不操作界面，显示由调用方负责（见 chatroom）。
+ */
+class MarkdownRenderer
+{
+public:
+    struct Update
+    {
+        QString committedHtml;//本次新定稿的块，追加到已显示内容之后，不会再变化
+        QString tailHtml;//尚未写完的最后一块，替换上一次显示的尾部
+    };
+
+    MarkdownRenderer();
+
+    void reset();
+    Update append(const QString &delta);
+    Update finish();//回复结束：把尾部也定稿
+    bool isEmpty() const;
+
+    static QString renderBlock(const QString &markdown);//把一个完整的块渲染成HTML
+    static QString renderInline(QStringView text);//行内元素：代码、粗体、斜体、删除线、链接
+
+private:
+    enum BlockKind { None, Paragraph, List, Quote, Code };
+
+    void processLine(QStringView line, int start, int end);
+    void commit(int length);//把 m_pending 的前 length 个字符作为一个块定稿
+
+    QString m_pending;//最后一个块起始处之后的文本
+    int m_lineStart;//m_pending 中第一个尚未扫描的行首
+    BlockKind m_blockKind;
+    QChar m_fenceChar;//当前代码块的围栏字符（` 或 ~）
+    QString m_committed;//本次 append 中新定稿的HTML
+    bool m_empty;
+};
+
+#endif // MARKDOWNRENDERER_H
@@ -0,0 +1,274 @@
+#include "motionengine.h"
+#include <QWidget>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QCursor>
+#include <QMouseEvent>
+#include <QRandomGenerator>
+#include <cmath>
+
+namespace {
+
+const double StepSeconds = 1.0 / 60;//固定模拟步长
+const double MaxCatchUp = 0.25;//定时器被耽误时最多补模拟的时间，避免卡顿后瞬移
+const double WalkSpeed = 70;//闲逛速度（像素/秒）
+const double FollowSpeed = 240;//跟随速度
+const double FollowStart = 120;//鼠标离开这么远才开始跟
+const double RestMin = 2;//每次休息的秒数范围
+const double RestMax = 8;
+const int RestCheckMs = 200;//都在休息时的检查间隔
+
+double randomBetween(double low, double high)
+{
+    return low + QRandomGenerator::global()->generateDouble() * (high - low);
+}
+
+// 窗口左上角可以到达的范围：窗口所在显示器的可用区域（不含任务栏）
+QRectF reachableArea(const QWidget *window, const QPointF &position)
+{
+    const QPoint center = position.toPoint() + QPoint(window->width() / 2, window->height() / 2);
+    QScreen *screen = QGuiApplication::screenAt(center);
+    if (!screen) {
+        screen = QGuiApplication::primaryScreen();
+    }
+    const QRect area = screen->availableGeometry();
+    return QRectF(area.left(), area.top(), qMax(0, area.width() - window->width()), qMax(0, area.height() - window->height()));
+}
+
+int frameInterval()
+{
+    QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal rate = screen ? screen->refreshRate() : 60;
+    return qBound(4, qRound(1000 / (rate > 0 ? rate : 60)), 33);
+}
+
+} // namespace
+
+MotionEngine::MotionEngine(QObject *parent)
+    : QObject{parent}
+    , m_accumulator(0)
+    , m_suspended(false)
+    , m_moves(0)
+{
+    connect(&m_timer, &QTimer::timeout, this, &MotionEngine::tick);
+}
+
+void MotionEngine::addBody(QWidget *window, Behavior behavior)
+{
+    if (find(window)) {
+        setBehavior(window, behavior);
+        return;
+    }
+    Body body;
+    body.window = window;
+    body.behavior = behavior;
+    body.position = window->pos();
+    body.previous = body.position;
+    body.target = body.position;
+    body.shown = window->pos();
+    body.rest = randomBetween(0, RestMin);
+    body.walking = false;
+    body.facingRight = false;
+    body.held = false;
+    m_bodies.append(body);
+
+    window->installEventFilter(this);
+    connect(window, &QObject::destroyed, this, [this, window]() {
+        for (int i = m_bodies.size() - 1; i >= 0; --i) {
+            if (m_bodies.at(i).window.isNull() || m_bodies.at(i).window.data() == window) {
+                m_bodies.removeAt(i);
+            }
+        }
+        updateTimer();
+    });
+    updateTimer();
+}
+
+void MotionEngine::setBehavior(QWidget *window, Behavior behavior)
+{
+    Body *body = find(window);
+    if (!body) {
+        return;
+    }
+    body->behavior = behavior;
+    body->walking = false;
+    body->rest = 0.5;
+    body->position = window->pos();
+    body->previous = body->position;
+    body->shown = window->pos();
+    updateTimer();
+}
+
+MotionEngine::Behavior MotionEngine::behavior(QWidget *window) const
+{
+    for (const Body &body : m_bodies) {
+        if (body.window.data() == window) {
+            return body.behavior;
+        }
+    }
+    return Stay;
+}
+
+void MotionEngine::setSuspended(bool suspended)
+{
+    m_suspended = suspended;
+    updateTimer();
+}
+
+qint64 MotionEngine::moveCount() const
+{
+    return m_moves;
+}
+
+/*
+ * 按住桌宠时交给拖动处理，松开后从窗口的新位置继续
+ */
+bool MotionEngine::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonRelease) {
+        auto mouseEvent = static_cast<QMouseEvent *>(event);
+        Body *body = find(qobject_cast<QWidget *>(watched));
+        if (body && mouseEvent->button() == Qt::LeftButton) {
+            body->held = event->type() == QEvent::MouseButtonPress;
+            body->walking = false;
+            body->rest = randomBetween(RestMin, RestMax);
+            updateTimer();
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+/*
+ * 一拍：先按固定步长补上经过的时间，再在最后两步之间插值，每个窗口最多移动一次
+ */
+void MotionEngine::tick()
+{
+    // 窗口被拖动或被系统挪过时，从窗口的实际位置继续
+    for (Body &body : m_bodies) {
+        if (body.window && (body.held || body.window->pos() != body.shown)) {
+            body.position = body.window->pos();
+            body.previous = body.position;
+            body.shown = body.window->pos();
+        }
+    }
+
+    m_accumulator += qMin(m_clock.restart() / 1000.0, MaxCatchUp);
+    while (m_accumulator >= StepSeconds) {
+        for (Body &body : m_bodies) {
+            step(body, StepSeconds);
+        }
+        m_accumulator -= StepSeconds;
+    }
+
+    const double alpha = m_accumulator / StepSeconds;
+    for (Body &body : m_bodies) {
+        if (!body.window || body.held) {
+            continue;
+        }
+        const QPoint position = (body.previous + (body.position - body.previous) * alpha).toPoint();
+        if (position != body.shown) {
+            body.window->move(position);
+            body.shown = position;
+            ++m_moves;
+        }
+        const double dx = body.position.x() - body.previous.x();
+        if (std::abs(dx) > 0.01 && (dx > 0) != body.facingRight) {
+            body.facingRight = dx > 0;
+            emit facingChanged(body.window, body.facingRight);
+        }
+    }
+    updateTimer();
+}
+
+/*
+ * 推进一个模拟步
+ *
+ * @param dt：步长（秒），固定为 StepSeconds
+ */
+void MotionEngine::step(Body &body, double dt)
+{
+    body.previous = body.position;
+    if (!body.window || body.held || body.behavior == Stay) {
+        return;
+    }
+    const QRectF bounds = reachableArea(body.window, body.position);
+    double speed = WalkSpeed;
+
+    if (body.behavior == Follow) {
+        // 停在鼠标右下方，不挡住鼠标
+        const QPointF cursor = QCursor::pos() + QPointF(24, 24);
+        body.target = QPointF(qBound(bounds.left(), cursor.x(), bounds.right()),
+                              qBound(bounds.top(), cursor.y(), bounds.bottom()));
+        const QPointF delta = body.target - body.position;
+        if (!body.walking && std::hypot(delta.x(), delta.y()) < FollowStart) {
+            return;
+        }
+        body.walking = true;
+        speed = FollowSpeed;
+    } else if (!body.walking) {
+        body.rest -= dt;
+        if (body.rest > 0) {
+            return;
+        }
+        // 走向底边（任务栏上方）的随机一点，不在底边时先落到底边
+        body.target = QPointF(randomBetween(bounds.left(), bounds.right()), bounds.bottom());
+        body.walking = true;
+    }
+
+    const QPointF delta = body.target - body.position;
+    const double distance = std::hypot(delta.x(), delta.y());
+    const double travel = speed * dt;
+    if (distance <= travel) {
+        body.position = body.target;
+        body.walking = false;
+        body.rest = randomBetween(RestMin, RestMax);
+    } else {
+        body.position += delta * (travel / distance);
+    }
+}
+
+/*
+ * 有桌宠在走动时按显示器刷新率触发；都在休息时低频检查；没有需要活动的桌宠时停止
+ */
+void MotionEngine::updateTimer()
+{
+    bool active = false;
+    for (const Body &body : m_bodies) {
+        active = active || (body.window && body.behavior != Stay);
+    }
+    if (m_suspended || !active) {
+        m_timer.stop();
+        return;
+    }
+
+    const bool moving = anyMoving();
+    const int interval = moving ? frameInterval() : RestCheckMs;
+    if (!m_timer.isActive()) {
+        m_clock.restart();
+        m_accumulator = 0;
+    }
+    if (!m_timer.isActive() || m_timer.interval() != interval) {
+        m_timer.setTimerType(moving ? Qt::PreciseTimer : Qt::CoarseTimer);
+        m_timer.start(interval);
+    }
+}
+
+bool MotionEngine::anyMoving() const
+{
+    for (const Body &body : m_bodies) {
+        if (body.window && body.walking && !body.held) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MotionEngine::Body *MotionEngine::find(QWidget *window)
+{
+    for (Body &body : m_bodies) {
+        if (body.window && body.window.data() == window) {
+            return &body;
+        }
+    }
+    return nullptr;
+}
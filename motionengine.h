@@ -0,0 +1,81 @@
+#ifndef MOTIONENGINE_H
+#define MOTIONENGINE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QPointF>
+#include <QList>
+
+class QWidget;
+
+/*
+ * MotionEngine：桌宠在桌面上自由活动的运动引擎
+ *
+ * 所有桌宠共用一个引擎：
+ *  - 模拟以固定步长（1/60秒）推进，和定时器的实际间隔无关，行为在任何帧率下都一样；
+ *  - 窗口移动按显示器刷新率合并：每次定时器触发时，在上一步和这一步的位置之间插值，
+ *    每个窗口最多 move() 一次，位置没变就不移动；
+ *  - 所有桌宠都在休息时降到低频检查，全部待在原地或动画暂停时定时器完全停止。
+ * 模拟只有几次浮点运算，动画解码在后台线程，不会和界面线程抢时间。
+ *
+ * 用户拖动桌宠时引擎让出控制，松开后从新位置继续。
+ */
+class MotionEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum Behavior {
+        Stay,//待在原地
+        Wander,//沿屏幕底边走走停停
+        Follow//跟着鼠标
+    };
+    Q_ENUM(Behavior)
+
+    explicit MotionEngine(QObject *parent = nullptr);
+
+    void addBody(QWidget *window, Behavior behavior = Stay);
+    void setBehavior(QWidget *window, Behavior behavior);
+    Behavior behavior(QWidget *window) const;
+    void setSuspended(bool suspended);//动画暂停或用户离开时停止活动
+    qint64 moveCount() const;//累计调用 move() 的次数（性能测量用）
+
+signals:
+    void facingChanged(QWidget *window, bool right);//行走方向改变
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void tick();
+
+private:
+    struct Body
+    {
+        QPointer<QWidget> window;
+        Behavior behavior;
+        QPointF position;//当前模拟步的位置（窗口左上角）
+        QPointF previous;//上一模拟步的位置，用于插值
+        QPointF target;
+        QPoint shown;//最后一次 move() 到的位置
+        double rest;//剩余的休息秒数
+        bool walking;
+        bool facingRight;
+        bool held;//正在被拖动
+    };
+
+    Body *find(QWidget *window);
+    void step(Body &body, double dt);
+    void updateTimer();
+    bool anyMoving() const;
+
+    QList<Body> m_bodies;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    double m_accumulator;//还没有模拟的时间（秒）
+    bool m_suspended;
+    qint64 m_moves;
+};
+
+#endif // MOTIONENGINE_H
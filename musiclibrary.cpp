@@ -0,0 +1,468 @@
+#include "musiclibrary.h"
+#include "tagreader.h"
+#include "loudnessanalyzer.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+const quint32 IndexMagic = 0x504C4942;//"PLIB"
+const quint32 IndexVersion = 2;//2：增加响度
+const int SaveDelayMs = 10000;
+const float MinGainDb = -20.0f;
+const float MaxGainDb = 12.0f;
+const int BatchSize = 256;//每读完这么多首的标签发出一次，播放列表逐步填充
+
+} // namespace
+
+LibraryScanner::LibraryScanner(QObject *parent)
+    : QObject{parent}
+    , m_latest(0)
+{
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 8));
+}
+
+QStringList LibraryScanner::nameFilters()
+{
+    return {"*.mp3", "*.flac", "*.ogg", "*.opus", "*.wav", "*.m4a"};
+}
+
+void LibraryScanner::supersede(int generation)
+{
+    m_latest.storeRelaxed(generation);
+}
+
+bool LibraryScanner::superseded(int generation) const
+{
+    return m_latest.loadRelaxed() != generation;
+}
+
+/*
+ * 读取索引：UTF-8 字符串和64位整数紧凑排列，5万首约几MB，一次读入
+ */
+bool LibraryScanner::loadIndex(const QString &indexPath, QVector<LibraryTrack> *tracks)
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0, version = 0, count = 0;
+    stream >> magic >> version >> count;
+    if (magic != IndexMagic || version < 1 || version > IndexVersion) {
+        return false;
+    }
+    tracks->reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray path, title, artist, album;
+        LibraryTrack track;
+        stream >> path >> track.size >> track.modified >> title >> artist >> album;
+        if (version >= 2) {
+            stream >> track.analyzed >> track.gain >> track.peak;
+        }
+        track.path = QString::fromUtf8(path);
+        track.title = QString::fromUtf8(title);
+        track.artist = QString::fromUtf8(artist);
+        track.album = QString::fromUtf8(album);
+        tracks->append(track);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        tracks->clear();//索引损坏时当作没有索引，重新扫描
+        return false;
+    }
+    return true;
+}
+
+bool LibraryScanner::saveIndex(const QString &indexPath, const QVector<LibraryTrack> &tracks)
+{
+    QDir().mkpath(QFileInfo(indexPath).absolutePath());
+    QSaveFile file(indexPath);//写完整后再替换旧索引，中途退出不会留下半个文件
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << IndexMagic << IndexVersion << quint32(tracks.size());
+    for (const LibraryTrack &track : tracks) {
+        stream << track.path.toUtf8() << track.size << track.modified
+               << track.title.toUtf8() << track.artist.toUtf8() << track.album.toUtf8()
+               << track.analyzed << track.gain << track.peak;
+    }
+    return file.commit();
+}
+
+/*
+ * 扫描
+ *
+ * @param folders：要扫描的目录（包括子目录）
+ * @param indexPath：索引文件
+ * @param generation：本次扫描的编号
+ */
+void LibraryScanner::scan(const QStringList &folders, const QString &indexPath, int generation)
+{
+    if (superseded(generation)) {
+        return;
+    }
+    QVector<LibraryTrack> indexed;
+    loadIndex(indexPath, &indexed);
+    if (!indexed.isEmpty()) {
+        emit tracksFound(generation, indexed);//先显示上次的结果
+    }
+    QHash<QString, int> known;
+    known.reserve(indexed.size());
+    for (int i = 0; i < indexed.size(); ++i) {
+        known.insert(indexed.at(i).path, i);
+    }
+
+    QVector<bool> seen(indexed.size(), false);
+    QSet<QString> visited;
+    QVector<LibraryTrack> result;
+    result.reserve(indexed.size());
+    QVector<LibraryTrack> pending;
+    int parsed = 0;
+    auto flush = [&]() {
+        readTags(&pending);
+        emit tracksFound(generation, pending);
+        result += pending;
+        parsed += pending.size();
+        pending.clear();
+    };
+
+    for (const QString &folder : folders) {
+        QDirIterator it(folder, nameFilters(), QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            if (superseded(generation)) {
+                return;
+            }
+            const QString path = it.next();
+            if (visited.contains(path)) {
+                continue;//目录有重叠
+            }
+            visited.insert(path);
+            const QFileInfo info = it.fileInfo();
+            const qint64 size = info.size();
+            const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+            const int row = known.value(path, -1);
+            if (row >= 0) {
+                seen[row] = true;
+                const LibraryTrack &old = indexed.at(row);
+                if (old.size == size && old.modified == modified) {
+                    result.append(old);//没有变化，不读文件
+                    continue;
+                }
+            }
+            LibraryTrack track;
+            track.path = path;
+            track.size = size;
+            track.modified = modified;
+            pending.append(track);
+            if (pending.size() >= BatchSize) {
+                flush();
+            }
+        }
+    }
+    if (!pending.isEmpty()) {
+        flush();
+    }
+
+    QStringList removed;
+    for (int i = 0; i < indexed.size(); ++i) {
+        if (!seen.at(i)) {
+            removed.append(indexed.at(i).path);
+        }
+    }
+    if (!removed.isEmpty()) {
+        emit tracksRemoved(generation, removed);
+    }
+    if ((parsed > 0 || !removed.isEmpty()) && !saveIndex(indexPath, result)) {
+        qWarning() << "无法保存曲库索引:" << indexPath;
+    }
+    emit finished(generation, result.size(), parsed);
+}
+
+void LibraryScanner::save(const QString &indexPath, const QVector<LibraryTrack> &tracks)
+{
+    if (!saveIndex(indexPath, tracks)) {
+        qWarning() << "无法保存曲库索引:" << indexPath;
+    }
+}
+
+/*
+ * 每个文件一个任务，各自写自己的元素；等整批完成后再返回
+ */
+void LibraryScanner::readTags(QVector<LibraryTrack> *batch)
+{
+    for (int i = 0; i < batch->size(); ++i) {
+        LibraryTrack *track = &(*batch)[i];
+        m_pool.start([track]() {
+            TrackTags tags;
+            TagReader::read(track->path, &tags);
+            track->title = tags.title.isEmpty() ? QFileInfo(track->path).completeBaseName() : tags.title;
+            track->artist = tags.artist;
+            track->album = tags.album;
+        });
+    }
+    m_pool.waitForDone();
+}
+
+/*
+ * MusicLibrary 构造函数
+ *
+ * 配置了音乐目录时立即在后台加载索引并增量扫描
+ */
+MusicLibrary::MusicLibrary(QObject *parent)
+    : QObject{parent}
+    , m_scanner(new LibraryScanner)
+    , m_generation(0)
+    , m_scanning(false)
+    , m_loudness(new LoudnessAnalyzer(this))
+    , m_indexDirty(false)
+{
+    qRegisterMetaType<QVector<LibraryTrack>>();
+    QSettings settings;
+    m_folders = settings.value("music/folders").toStringList();
+    m_builtinLoudness = settings.value("music/builtinLoudness").toMap();
+    connect(m_loudness, &LoudnessAnalyzer::analyzed, this, &MusicLibrary::onAnalyzed);
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SaveDelayMs);
+    connect(&m_saveTimer, &QTimer::timeout, this, &MusicLibrary::saveIndex);
+
+    m_scanner->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_scanner, &QObject::deleteLater);
+    connect(this, &MusicLibrary::requestScan, m_scanner, &LibraryScanner::scan);
+    connect(m_scanner, &LibraryScanner::tracksFound, this, &MusicLibrary::onTracksFound);
+    connect(m_scanner, &LibraryScanner::tracksRemoved, this, &MusicLibrary::onTracksRemoved);
+    connect(m_scanner, &LibraryScanner::finished, this, &MusicLibrary::onFinished);
+    connect(this, &MusicLibrary::requestSave, m_scanner, &LibraryScanner::save);
+    m_workerThread.start(QThread::LowPriority);
+
+    if (!m_folders.isEmpty()) {
+        rescan();
+    }
+}
+
+MusicLibrary::~MusicLibrary()
+{
+    m_scanner->supersede(-1);//正在进行的扫描尽快结束
+    m_workerThread.quit();
+    m_workerThread.wait();
+    if (m_indexDirty && !m_scanning) {
+        LibraryScanner::saveIndex(indexPath(), m_tracks);//退出前写回还没保存的响度
+    }
+}
+
+QStringList MusicLibrary::folders() const
+{
+    return m_folders;
+}
+
+void MusicLibrary::addFolder(const QString &folder)
+{
+    const QString path = QDir::cleanPath(QDir(folder).absolutePath());
+    if (m_folders.contains(path)) {
+        return;
+    }
+    m_folders.append(path);
+    QSettings settings;
+    settings.setValue("music/folders", m_folders);
+    rescan();
+}
+
+void MusicLibrary::removeFolder(const QString &folder)
+{
+    if (m_folders.removeAll(QDir::cleanPath(folder)) == 0) {
+        return;
+    }
+    QSettings settings;
+    settings.setValue("music/folders", m_folders);
+    rescan();
+}
+
+const QVector<LibraryTrack> &MusicLibrary::tracks() const
+{
+    return m_tracks;
+}
+
+bool MusicLibrary::isScanning() const
+{
+    return m_scanning;
+}
+
+QString MusicLibrary::indexPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/library.idx";
+}
+
+/*
+ * 重新扫描：之前还没结束的扫描被取代，它的结果不再采用
+ */
+void MusicLibrary::rescan()
+{
+    ++m_generation;
+    m_scanning = true;
+    m_scanner->supersede(m_generation);
+    emit requestScan(m_folders, indexPath(), m_generation);
+}
+
+void MusicLibrary::onTracksFound(int generation, const QVector<LibraryTrack> &tracks)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    const int first = m_tracks.size();
+    for (const LibraryTrack &track : tracks) {
+        auto it = m_rows.constFind(track.path);
+        if (it == m_rows.constEnd()) {
+            m_rows.insert(track.path, m_tracks.size());
+            m_tracks.append(track);
+            continue;
+        }
+        LibraryTrack &existing = m_tracks[it.value()];
+        const bool changed = existing.title != track.title || existing.artist != track.artist || existing.album != track.album;
+        const bool keepLoudness = existing.analyzed && !track.analyzed
+                                  && existing.size == track.size && existing.modified == track.modified;
+        const LibraryTrack previous = existing;
+        existing = track;
+        if (keepLoudness) {
+            // 索引里还没有刚分析出的结果
+            existing.analyzed = true;
+            existing.gain = previous.gain;
+            existing.peak = previous.peak;
+        }
+        if (changed) {
+            emit trackChanged(it.value());
+        }
+    }
+    if (m_tracks.size() > first) {
+        emit tracksAdded(first, m_tracks.size() - first);
+    }
+}
+
+void MusicLibrary::onTracksRemoved(int generation, const QStringList &paths)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    const QSet<QString> gone(paths.cbegin(), paths.cend());
+    QVector<LibraryTrack> kept;
+    kept.reserve(m_tracks.size());
+    for (const LibraryTrack &track : std::as_const(m_tracks)) {
+        if (!gone.contains(track.path)) {
+            kept.append(track);
+        }
+    }
+    m_tracks.swap(kept);
+    m_rows.clear();
+    for (int i = 0; i < m_tracks.size(); ++i) {
+        m_rows.insert(m_tracks.at(i).path, i);
+    }
+    emit tracksRemoved(paths);
+}
+
+void MusicLibrary::onFinished(int generation, int total, int parsed)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    m_scanning = false;
+    qDebug() << "曲库扫描完成:" << total << "首，重新读取标签" << parsed << "首";
+    emit scanFinished(total);
+
+    QStringList missing;
+    for (const LibraryTrack &track : std::as_const(m_tracks)) {
+        if (!track.analyzed) {
+            missing.append(track.path);
+        }
+    }
+    m_loudness->enqueue(missing);
+    if (m_indexDirty) {
+        m_saveTimer.start();
+    }
+}
+
+void MusicLibrary::analyzeBuiltins(const QStringList &names)
+{
+    QStringList missing;
+    for (const QString &name : names) {
+        if (!m_builtinLoudness.contains(name)) {
+            missing.append(name);
+        }
+    }
+    m_loudness->enqueue(missing);
+}
+
+/*
+ * 回放增益：先限制在 -20~+12 dB，再保证峰值不超过满幅
+ */
+float MusicLibrary::playbackGain(const QString &name) const
+{
+    float gainDb = 0.0f;
+    float peak = 0.0f;
+    auto row = m_rows.constFind(name);
+    if (row != m_rows.constEnd()) {
+        const LibraryTrack &track = m_tracks.at(row.value());
+        if (!track.analyzed) {
+            return 1.0f;
+        }
+        gainDb = track.gain;
+        peak = track.peak;
+    } else if (m_builtinLoudness.contains(name)) {
+        const QVariantList values = m_builtinLoudness.value(name).toList();
+        gainDb = values.value(0).toFloat();
+        peak = values.value(1).toFloat();
+    } else {
+        return 1.0f;
+    }
+    float factor = std::pow(10.0f, qBound(MinGainDb, gainDb, MaxGainDb) / 20.0f);
+    if (peak > 0.0f) {
+        factor = qMin(factor, 1.0f / peak);
+    }
+    return factor;
+}
+
+void MusicLibrary::onAnalyzed(const QString &name, bool ok, float gainDb, float peak)
+{
+    if (!QDir::isAbsolutePath(name)) {
+        m_builtinLoudness.insert(name, QVariantList{gainDb, peak});
+        QSettings settings;
+        settings.setValue("music/builtinLoudness", m_builtinLoudness);
+        return;
+    }
+    auto row = m_rows.constFind(name);
+    if (row == m_rows.constEnd()) {
+        return;//分析期间被移出了曲库
+    }
+    LibraryTrack &track = m_tracks[row.value()];
+    track.analyzed = true;
+    track.gain = ok ? gainDb : 0.0f;
+    track.peak = ok ? peak : 0.0f;
+    m_indexDirty = true;
+    if (!m_scanning && !m_saveTimer.isActive()) {
+        m_saveTimer.start();
+    }
+}
+
+/*
+ * 在扫描线程中写回索引（和扫描排在同一个线程，不会同时写）。扫描进行中不写，等扫描完成
+ */
+void MusicLibrary::saveIndex()
+{
+    if (m_scanning || !m_indexDirty) {
+        return;
+    }
+    m_indexDirty = false;
+    emit requestSave(indexPath(), m_tracks);
+}
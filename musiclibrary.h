@@ -0,0 +1,128 @@
+#ifndef MUSICLIBRARY_H
+#define MUSICLIBRARY_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QMetaType>
+#include <QTimer>
+
+class LoudnessAnalyzer;
+
+// 曲库中的一首歌
+struct LibraryTrack
+{
+    QString path;//本地文件的绝对路径
+    QString title;//没有标签时为文件名
+    QString artist;
+    QString album;
+    qint64 size = 0;//文件大小和修改时间，用于判断标签是否需要重新读取
+    qint64 modified = 0;
+    bool analyzed = false;//已经分析过响度（无法解码的也算，不再重试）
+    float gain = 0;//回放增益（dB），把综合响度调到 -18 LUFS
+    float peak = 0;//采样峰值（线性），限制增益不削波
+};
+Q_DECLARE_METATYPE(LibraryTrack)
+
+/*
+ * LibraryScanner：在后台线程中扫描音乐目录
+ *
+ * 先读入上次保存的索引并立即发出，然后遍历目录只比较文件大小和修改时间：
+ * 没变的直接沿用，新增或改过的文件分批交给线程池读取标签，每批读完就发出；
+ * 已经不存在的文件从索引中移除。有变化时写回索引。
+ */
+class LibraryScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LibraryScanner(QObject *parent = nullptr);
+
+    static bool loadIndex(const QString &indexPath, QVector<LibraryTrack> *tracks);
+    static bool saveIndex(const QString &indexPath, const QVector<LibraryTrack> &tracks);
+    static QStringList nameFilters();
+
+    void supersede(int generation);//可在任意线程调用：编号不是 generation 的扫描尽快结束，不写回索引
+
+public slots:
+    void scan(const QStringList &folders, const QString &indexPath, int generation);
+    void save(const QString &indexPath, const QVector<LibraryTrack> &tracks);
+
+signals:
+    // generation：发起扫描时的编号，用来丢弃已被新一轮扫描取代的结果
+    void tracksFound(int generation, const QVector<LibraryTrack> &tracks);//新增或标签有变化的歌曲
+    void tracksRemoved(int generation, const QStringList &paths);
+    void finished(int generation, int total, int parsed);
+
+private:
+    void readTags(QVector<LibraryTrack> *batch);//用线程池并行读取一批文件的标签
+    bool superseded(int generation) const;
+
+    QThreadPool m_pool;
+    QAtomicInt m_latest;
+};
+
+/*
+ * MusicLibrary：用户音乐目录的曲库
+ *
+ * 目录保存在配置项 music/folders 中，索引（路径、大小、修改时间、标题、艺术家、专辑）
+ * 保存在应用数据目录下的 library.idx。再次启动时先显示索引中的歌曲，再在后台增量更新，
+ * 几万首歌的曲库也能立即出现在播放列表中。
+ *
+ * 扫描完成后，还没有分析过响度的歌交给 LoudnessAnalyzer 在后台分析，结果写回索引，
+ * 重启后不再重复分析。资源包中的内置歌曲的结果保存在配置项 music/builtinLoudness 中。
+ */
+class MusicLibrary : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MusicLibrary(QObject *parent = nullptr);
+    ~MusicLibrary();
+
+    QStringList folders() const;
+    void addFolder(const QString &folder);
+    void removeFolder(const QString &folder);
+    const QVector<LibraryTrack> &tracks() const;
+    bool isScanning() const;
+    void analyzeBuiltins(const QStringList &names);
+    float playbackGain(const QString &name) const;//按响度归一的线性增益，未分析过时为1
+
+    static QString indexPath();
+
+public slots:
+    void rescan();
+
+signals:
+    void tracksAdded(int first, int count);//新增的歌曲追加在 tracks() 末尾
+    void trackChanged(int row);//标签有变化
+    void tracksRemoved(const QStringList &paths);//已经从 tracks() 中移除
+    void scanFinished(int total);
+    void requestScan(const QStringList &folders, const QString &indexPath, int generation);
+    void requestSave(const QString &indexPath, const QVector<LibraryTrack> &tracks);
+
+private slots:
+    void onTracksFound(int generation, const QVector<LibraryTrack> &tracks);
+    void onTracksRemoved(int generation, const QStringList &paths);
+    void onFinished(int generation, int total, int parsed);
+    void onAnalyzed(const QString &name, bool ok, float gainDb, float peak);
+    void saveIndex();
+
+private:
+    QStringList m_folders;
+    QVector<LibraryTrack> m_tracks;
+    QHash<QString, int> m_rows;//路径 → tracks() 中的位置
+    QThread m_workerThread;
+    LibraryScanner *m_scanner;
+    int m_generation;
+    bool m_scanning;
+    LoudnessAnalyzer *m_loudness;
+    QVariantMap m_builtinLoudness;//资源包名称 → [增益, 峰值]
+    QTimer m_saveTimer;//响度结果攒一会儿再写回索引
+    bool m_indexDirty;
+};
+
+#endif // MUSICLIBRARY_H
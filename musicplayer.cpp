@@ -1,51 +1,53 @@
 #include "musicplayer.h"
-#include <QMouseEvent>
 #include <QDir>
 #include <QFileDialog>
 #include <QTime>
 #include <QStyle>
 #include <QApplication>
-#include <QTimer>
-#include <QGraphicsDropShadowEffect>
-#include <QSystemTrayIcon>
 #include <QMenu>
 #include <QAction>
 #include <QCloseEvent>
-#include <QDirIterator>
+#include <QStandardPaths>
+#include "audioservice.h"
+#include "windowchrome.h"
+#include "musiclibrary.h"
+#include "playbackengine.h"
+#include "playlistmodel.h"
+#include "spectrumwidget.h"
+#include "waveformcache.h"
+#include "waveformslider.h"
 
 /*
  * MusicPlayer 构造函数
- * 初始化音乐播放器窗口和组件
+ * 初始化音乐播放器窗口和组件，显示服务当前的歌曲和进度
  *
+ * @param audio：播放服务，窗口销毁后继续播放
  * @param parent：父窗口部件，用于窗口定位和内存管理
  */
-MusicPlayer::MusicPlayer(QWidget *parent)
-    : QWidget(parent), m_dragging(false), m_currentIndex(0)// 初始化父类和成员变量
+MusicPlayer::MusicPlayer(AudioService *audio, QWidget *parent)
+    : QWidget(parent), m_audio(audio), m_shownIndex(-1)// 初始化父类和成员变量
 {
     // 设置窗口属性：工具窗口、无边框、透明背景
     setWindowFlags(Qt::Tool | Qt::FramelessWindowHint);
     setAttribute(Qt::WA_TranslucentBackground);
-    setFixedSize(280, 400);// 固定窗口尺寸
-
-    // 初始化媒体播放组件
-    m_player = new QMediaPlayer(this);// 创建媒体播放器
-    m_audioOutput = new QAudioOutput(this);// 创建音频输出
-    m_player->setAudioOutput(m_audioOutput);// 设置播放器的音频输出
-    m_audioOutput->setVolume(0.6);// 默认音量设置60%
+    // 阴影预先渲染成九宫格缓存，重绘（如播放进度每次更新）时只贴图，不再离屏模糊整个窗口
+    WindowChrome *chrome = WindowChrome::install(this);
+    setFixedSize(QSize(280, 430).grownBy(chrome->margins()));// 固定面板尺寸，外圈留给阴影
 
     // 初始化各种组件
     setupUI();// 设置用户界面
     setupConnections();// 建立信号槽连接
     applyBlueBlackTheme();// 应用蓝黑主题
-    loadSongs();// 加载音乐文件
-    createTrayIcon();// 创建系统托盘图标
 
-    // 添加阴影效果增强视觉体验
-    auto shadowEffect = new QGraphicsDropShadowEffect(this);
-    shadowEffect->setBlurRadius(10);// 阴影模糊半径
-    shadowEffect->setColor(QColor(0, 0, 0, 160));// 半透明黑色阴影
-    shadowEffect->setOffset(0, 5);// 阴影偏移量
-    setGraphicsEffect(shadowEffect);//应用阴影效果
+    // 窗口可能是在播放中重建的：从服务读出当前状态
+    PlaybackEngine *engine = m_audio->engine();
+    m_filterEdit->setText(m_audio->model()->filter());
+    m_volumeSlider->setValue(m_audio->volume());
+    m_playBtn->setText(engine->state() == PlaybackEngine::PlayingState ? "⏸" : "▶");
+    showCurrent();
+    onDurationChanged(engine->duration());
+    onPositionChanged(engine->position());
+    m_progressSlider->setPeaks(m_audio->waveform()->peaks());//波形可能早就算好了
 
     // 如果有父窗口，将播放器定位在父窗口右侧
     if (parent) {
@@ -56,20 +58,11 @@ MusicPlayer::MusicPlayer(QWidget *parent)
 
 /*
  * MusicPlayer 析构函数
- * 负责清理资源和确保安全退出
+ * 不再显示频谱时停止分析；播放由服务继续
  */
 MusicPlayer::~MusicPlayer()
 {
-    // 停止媒体播放，释放音频设备资源
-    m_player->stop();
-
-    // 清理系统托盘图标
-    if (m_trayIcon) {
-        m_trayIcon->hide();  // 隐藏托盘图标，避免残留
-    }
-
-    // 注意：QObject 的父子关系会自动销毁子对象
-    // m_player 和 m_trayIcon 作为子对象会被自动删除
+    m_audio->setSpectrumVisible(false);
 }
 
 /*
@@ -129,10 +122,17 @@ void MusicPlayer::setupUI()
         "}"
         );
 
+    // 曲库按钮：添加/移除音乐文件夹
+    m_libraryBtn = new QPushButton("📁", titleWidget);
+    m_libraryBtn->setFixedSize(22, 22);
+    m_libraryBtn->setToolTip("音乐文件夹");
+    m_libraryBtn->setStyleSheet(m_minimizeBtn->styleSheet());
+
     // 标题栏布局：标签居左，按钮居右
     QHBoxLayout *titleLayout = new QHBoxLayout(titleWidget);
     titleLayout->setContentsMargins(10, 0, 10, 0);// 布局边距
     titleLayout->addWidget(m_titleLabel);// 添加标题标签
+    titleLayout->addWidget(m_libraryBtn);
     titleLayout->addWidget(m_minimizeBtn);// 添加最小化按钮
     titleLayout->addWidget(m_closeBtn);// 添加关闭按钮
 
@@ -172,12 +172,17 @@ void MusicPlayer::setupUI()
     songInfoLayout->addWidget(m_songTitle);// 添加歌曲标题
     songInfoLayout->addWidget(m_songArtist);// 添加歌手信息
 
+    // 频谱：播放时随音乐跳动
+    m_spectrumView = new SpectrumWidget(m_audio->spectrum(), songInfoWidget);
+    m_spectrumView->setFixedHeight(26);
+    songInfoLayout->addWidget(m_spectrumView);
+
     // ==================== 进度条区域 ====================
     QWidget *progressWidget = new QWidget(this);
     progressWidget->setStyleSheet("background: transparent;");// 透明背景
 
-    //进度条滑块，水平方向
-    m_progressSlider = new QSlider(Qt::Horizontal, progressWidget);
+    //进度条滑块，水平方向；波形算出来之前（或无法解码时）按下面的样式显示
+    m_progressSlider = new WaveformSlider(progressWidget);
     m_progressSlider->setStyleSheet(/* 自定义滑块样式：蓝色渐变进度 */
         "QSlider::groove:horizontal {"
         "    border: none;"
@@ -294,10 +299,34 @@ void MusicPlayer::setupUI()
     QLabel *playlistLabel = new QLabel("🎼 播放列表", playlistWidget);
     playlistLabel->setStyleSheet("color: #4cc9f0; font-size: 12px; font-weight: bold;");
 
-    // 播放列表控件
-    m_playlist = new QListWidget(playlistWidget);
+    // 筛选框：输入时即时筛选标题、艺术家和专辑
+    m_filterEdit = new QLineEdit(playlistWidget);
+    m_filterEdit->setPlaceholderText("搜索...");
+    m_filterEdit->setClearButtonEnabled(true);
+    m_filterEdit->setFixedHeight(20);
+    m_filterEdit->setStyleSheet(
+        "QLineEdit {"
+        "    background: rgba(26, 26, 46, 0.4);"
+        "    border: 1px solid rgba(76, 201, 240, 0.3);"
+        "    border-radius: 6px;"
+        "    color: #e2e8f0;"
+        "    font-size: 10px;"
+        "    padding: 0 6px;"
+        "}"
+        );
+
+    QHBoxLayout *playlistHeader = new QHBoxLayout();
+    playlistHeader->setContentsMargins(0, 0, 0, 0);
+    playlistHeader->addWidget(playlistLabel);
+    playlistHeader->addWidget(m_filterEdit);
+
+    // 播放列表控件：模型按需生成可见行的文字，几万首歌也只绘制看得见的几行
+    m_playlist = new QListView(playlistWidget);
+    m_playlist->setModel(m_audio->model());
+    m_playlist->setUniformItemSizes(true);// 行高相同，不需要逐行测量
+    m_playlist->setEditTriggers(QAbstractItemView::NoEditTriggers);
     m_playlist->setStyleSheet(/* 半透明背景、蓝色边框、自定义选中效果 */
-        "QListWidget {"
+        "QListView {"
         "    background: rgba(26, 26, 46, 0.4);"
         "    border: 1px solid rgba(76, 201, 240, 0.3);"
         "    border-radius: 8px;"
@@ -305,12 +334,12 @@ void MusicPlayer::setupUI()
         "    font-size: 11px;"
         "    outline: none;"
         "}"
-        "QListWidget::item {"
+        "QListView::item {"
         "    padding: 6px 10px;"
         "    border-bottom: 1px solid rgba(76, 201, 240, 0.1);"
         "    background: transparent;"
         "}"
-        "QListWidget::item:selected {"
+        "QListView::item:selected {"
         "    background: rgba(76, 201, 240, 0.3);"
         "    border-radius: 4px;"
         "}"
@@ -320,7 +349,7 @@ void MusicPlayer::setupUI()
     QVBoxLayout *playlistLayout = new QVBoxLayout(playlistWidget);
     playlistLayout->setSpacing(5);
     playlistLayout->setContentsMargins(0, 0, 0, 0);
-    playlistLayout->addWidget(playlistLabel);// 播放列表标题
+    playlistLayout->addLayout(playlistHeader);// 播放列表标题和筛选框
     playlistLayout->addWidget(m_playlist);// 播放列表控件
 
     // ==================== 主布局 ====================
@@ -342,18 +371,49 @@ void MusicPlayer::setupUI()
 
 void MusicPlayer::setupConnections()
 {
-    connect(m_playBtn, &QPushButton::clicked, this, &MusicPlayer::playPause);
-    connect(m_prevBtn, &QPushButton::clicked, this, &MusicPlayer::prevSong);
-    connect(m_nextBtn, &QPushButton::clicked, this, &MusicPlayer::nextSong);
+    PlaybackEngine *engine = m_audio->engine();
+    connect(m_playBtn, &QPushButton::clicked, m_audio, &AudioService::playPause);
+    connect(m_prevBtn, &QPushButton::clicked, m_audio, &AudioService::previous);
+    connect(m_nextBtn, &QPushButton::clicked, m_audio, &AudioService::next);
     connect(m_closeBtn, &QPushButton::clicked, this, &MusicPlayer::hide);
     connect(m_minimizeBtn, &QPushButton::clicked, this, &MusicPlayer::minimizeToTray);  // 新增
-    connect(m_progressSlider, &QSlider::sliderMoved, m_player, &QMediaPlayer::setPosition);
-    connect(m_player, &QMediaPlayer::positionChanged, this, &MusicPlayer::onPositionChanged);
-    connect(m_player, &QMediaPlayer::durationChanged, this, &MusicPlayer::onDurationChanged);
-    connect(m_playlist, &QListWidget::itemClicked, this, &MusicPlayer::onPlaylistItemClicked);
-    connect(m_volumeSlider, &QSlider::valueChanged, this, [this](int value) {
-        m_audioOutput->setVolume(value / 100.0);
+    connect(m_libraryBtn, &QPushButton::clicked, this, &MusicPlayer::showLibraryMenu);
+    // 拖动过程中只移动滑块，松开时才跳转：每次跳转都要重新解码
+    connect(m_progressSlider, &QSlider::sliderReleased, this, [this, engine]() {
+        engine->setPosition(m_progressSlider->value());
+    });
+    connect(engine, &PlaybackEngine::positionChanged, this, &MusicPlayer::onPositionChanged);
+    connect(engine, &PlaybackEngine::durationChanged, this, &MusicPlayer::onDurationChanged);
+    connect(m_audio, &AudioService::currentChanged, this, &MusicPlayer::showCurrent);
+    connect(m_audio->waveform(), &WaveformCache::peaksChanged, this, [this]() {
+        m_progressSlider->setPeaks(m_audio->waveform()->peaks());
     });
+    connect(engine, &PlaybackEngine::stateChanged, this, [this](PlaybackEngine::State state) {
+        m_playBtn->setText(state == PlaybackEngine::PlayingState ? "⏸" : "▶");
+    });
+    connect(m_playlist, &QListView::clicked, this, &MusicPlayer::onPlaylistClicked);
+    connect(m_filterEdit, &QLineEdit::textChanged, m_audio->model(), &PlaylistModel::setFilter);
+    // 筛选或排序的结果出来后，重新选中当前歌曲
+    connect(m_audio->model(), &QAbstractItemModel::modelReset, this, &MusicPlayer::selectCurrent);
+    connect(m_volumeSlider, &QSlider::valueChanged, m_audio, &AudioService::setVolume);
+}
+
+/*
+ * 歌手一栏显示服务的状态；换了歌时进度条归零，等引擎报告新的进度
+ */
+void MusicPlayer::showCurrent()
+{
+    static const char *const statusText[] = {"准备播放...", "准备播放", "播放中...", "文件不存在"};
+    m_songTitle->setText(m_audio->currentTitle());
+    m_songArtist->setText(statusText[m_audio->status()]);
+    if (m_audio->currentIndex() != m_shownIndex) {
+        m_shownIndex = m_audio->currentIndex();
+        if (!m_progressSlider->isSliderDown()) {
+            m_progressSlider->setValue(0);
+        }
+        m_currentTime->setText("0:00");
+    }
+    selectCurrent();
 }
 
 void MusicPlayer::applyBlueBlackTheme()
@@ -369,164 +429,96 @@ void MusicPlayer::applyBlueBlackTheme()
         );
 }
 
-void MusicPlayer::loadSongs()
+void MusicPlayer::selectCurrent()
 {
-    //清空现有歌曲
-    m_songs.clear();
-    m_playlist->clear();
-    //扫描资源文件中的MP3文件
-    QStringList musicFilters;
-    musicFilters << "*.mp3"<<"*.wav"<<"*.flac";
-    //扫描资源文件中的音乐文件
-    QDirIterator it(":", musicFilters, QDir::Files, QDirIterator::Subdirectories);
-    while(it.hasNext())
-    {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QString baseName = QFileInfo(filePath).baseName(); // 不带扩展名的文件名
-        // 添加到歌曲列表
-        m_songs.append(qMakePair(baseName, filePath));
-        m_playlist->addItem(QString("🎵 %1").arg(baseName));
-
-        qDebug() << "找到音乐文件:" << filePath;
-    }
-    // 如果没有找到音乐文件，添加默认提示
-    if (m_songs.isEmpty()) {
-        m_songs.append(qMakePair(QString("未找到音乐文件"), QString("请将MP3文件添加到资源中")));
-        m_playlist->addItem("🎵 未找到音乐文件");
-        qDebug() << "未找到音乐文件，请检查资源文件配置";
-    }
-
-    // 设置第一首歌为当前歌曲
-    if (!m_songs.isEmpty()) {
-        m_songTitle->setText(m_songs[0].first);
-        m_songArtist->setText("准备播放...");
-        m_playlist->setCurrentRow(0);
-    }
-}
-
-
-
-void MusicPlayer::createTrayIcon()
-{
-    // 创建托盘图标
-    m_trayIcon = new QSystemTrayIcon(this);
-    m_trayIcon->setIcon(QIcon(":/image/icon.png")); // 请替换为实际图标路径
-    m_trayIcon->setToolTip("猫猫音乐");
-
-    // 创建托盘菜单
-    m_trayMenu = new QMenu(this);
-    QAction *restoreAction = new QAction("恢复窗口", this);
-    QAction *quitAction = new QAction("退出", this);
-
-    connect(restoreAction, &QAction::triggered, this, &QWidget::showNormal);
-    connect(quitAction, &QAction::triggered, qApp, &QApplication::quit);
-
-    m_trayMenu->addAction(restoreAction);
-    m_trayMenu->addAction(quitAction);
-
-    m_trayIcon->setContextMenu(m_trayMenu);
-
-    // 托盘图标点击事件
-    connect(m_trayIcon, &QSystemTrayIcon::activated, this, &MusicPlayer::onTrayIconActivated);
-
-    m_trayIcon->show();
-}
-
-void MusicPlayer::minimizeToTray()
-{
-    // 最小化到系统托盘
-    hide();
-    if (m_trayIcon) {
-        m_trayIcon->showMessage(
-            "猫猫音乐播放器",
-            "播放器已最小化到系统托盘",
-            QSystemTrayIcon::Information,
-            2000
-            );
+    const PlaylistModel *model = m_audio->model();
+    const int row = model->rowOf(m_audio->currentIndex());
+    if (row < 0) {
+        m_playlist->clearSelection();
+        return;
     }
+    const QModelIndex index = model->index(row);
+    m_playlist->setCurrentIndex(index);
+    m_playlist->scrollTo(index);
 }
 
-//播放逻辑
-void MusicPlayer::playPause()
+void MusicPlayer::showLibraryMenu()
 {
-    if(m_songs.isEmpty())
-    {
-        qDebug()<<"没有可播放的音乐文件";
-        return;
+    MusicLibrary *library = m_audio->library();
+    PlaylistModel *model = m_audio->model();
+    PlaybackEngine *engine = m_audio->engine();
+    QMenu menu(this);
+    QAction *addAction = menu.addAction("添加音乐文件夹...");
+    QAction *rescanAction = menu.addAction(library->isScanning() ? "正在扫描..." : "重新扫描");
+    rescanAction->setEnabled(!library->folders().isEmpty() && !library->isScanning());
+    const QStringList folders = library->folders();
+    if (!folders.isEmpty()) {
+        menu.addSeparator();
     }
-    if (m_player->playbackState() == QMediaPlayer::PlayingState)
-    {
-        m_player->pause();
-        m_playBtn->setText("▶");
+    QList<QAction *> removeActions;
+    for (const QString &folder : folders) {
+        removeActions.append(menu.addAction("移除 " + QDir::toNativeSeparators(folder)));
     }
-    else
-    {
-        QString filePath = m_songs[m_currentIndex].second;
-
-        // 修改这里：使用 QUrl 而不是 QUrl::fromLocalFile
-        if (filePath.startsWith(":")) {
-            // 资源文件
-            m_player->setSource(QUrl(filePath));
-        } else {
-            // 本地文件
-            m_player->setSource(QUrl::fromLocalFile(filePath));
-        }
-
-        m_player->play();
-        m_playBtn->setText("⏸");
 
-        // 更新歌曲信息
-        m_songTitle->setText(m_songs[m_currentIndex].first);
-        m_songArtist->setText("播放中...");
-
-        qDebug() << "正在播放:" << filePath;
+    // 排序：在后台线程完成，结果出来后列表一次刷新
+    menu.addSeparator();
+    QMenu *sortMenu = menu.addMenu("排序");
+    const QList<QPair<QString, PlaylistQuery::SortKey>> sortKeys = {
+        qMakePair(QString("按加入顺序"), PlaylistQuery::SortNone),
+        qMakePair(QString("按标题"), PlaylistQuery::SortTitle),
+        qMakePair(QString("按艺术家"), PlaylistQuery::SortArtist),
+        qMakePair(QString("按专辑"), PlaylistQuery::SortAlbum),
+    };
+    for (const auto &sortKey : sortKeys) {
+        QAction *action = sortMenu->addAction(sortKey.first);
+        action->setCheckable(true);
+        action->setChecked(model->sortKey() == sortKey.second);
+        connect(action, &QAction::triggered, this, [model, key = sortKey.second]() {
+            model->setSortKey(key);
+        });
     }
-}
-
 
-void MusicPlayer::updateCurrentSong()
-{
-    if (m_currentIndex >= 0 && m_currentIndex < m_songs.size()) {
-        m_playlist->setCurrentRow(m_currentIndex);
-        m_songTitle->setText(m_songs[m_currentIndex].first);
-
-        // 停止当前播放
-        m_player->stop();
-        m_playBtn->setText("▶");
-
-        // 如果是真实音乐文件，准备播放
-        QString filePath = m_songs[m_currentIndex].second;
-        if (QFile::exists(filePath)) {
-            m_songArtist->setText("准备播放");
-            m_player->setSource(QUrl::fromLocalFile(filePath));
-        } else {
-            m_songArtist->setText("文件不存在");
-        }
-
-        // 重置进度条
-        m_progressSlider->setValue(0);
-        m_currentTime->setText("0:00");
+    // 切歌方式：0 为无缝衔接，否则为淡入淡出的时长
+    QMenu *transitionMenu = menu.addMenu("切歌方式");
+    const QList<QPair<QString, int>> transitions = {
+        qMakePair(QString("无缝衔接"), 0),
+        qMakePair(QString("淡入淡出 2 秒"), 2000),
+        qMakePair(QString("淡入淡出 5 秒"), 5000),
+    };
+    for (const auto &transition : transitions) {
+        QAction *action = transitionMenu->addAction(transition.first);
+        action->setCheckable(true);
+        action->setChecked(engine->crossfade() == transition.second);
+        connect(action, &QAction::triggered, this, [engine, msec = transition.second]() {
+            engine->setCrossfade(msec);
+        });
     }
-}
 
-void MusicPlayer::nextSong()
-{
-    if (m_songs.isEmpty()) return;
-
-    m_currentIndex = (m_currentIndex + 1) % m_songs.size();
-    updateCurrentSong();
-
-    // 如果正在播放，自动播放下一首
-    if (m_player->playbackState() == QMediaPlayer::PlayingState) {
-        QTimer::singleShot(100, this, &MusicPlayer::playPause);
+    // 音量均衡：按后台分析的响度把每首歌调到相近的音量，切换后当前歌曲立即生效
+    QAction *normalizeAction = menu.addAction("音量均衡");
+    normalizeAction->setCheckable(true);
+    normalizeAction->setChecked(m_audio->isNormalized());
+    connect(normalizeAction, &QAction::toggled, m_audio, &AudioService::setNormalized);
+
+    QAction *chosen = menu.exec(m_libraryBtn->mapToGlobal(QPoint(0, m_libraryBtn->height())));
+    if (chosen == addAction) {
+        const QString folder = QFileDialog::getExistingDirectory(this, "选择音乐文件夹",
+                                                                 QStandardPaths::writableLocation(QStandardPaths::MusicLocation));
+        if (!folder.isEmpty()) {
+            library->addFolder(folder);
+        }
+    } else if (chosen == rescanAction) {
+        library->rescan();
+    } else if (removeActions.contains(chosen)) {
+        library->removeFolder(folders.at(removeActions.indexOf(chosen)));
     }
 }
 
-void MusicPlayer::prevSong()
+void MusicPlayer::minimizeToTray()
 {
-    m_currentIndex = (m_currentIndex - 1 + m_songs.size()) % m_songs.size();
-    updateCurrentSong();
+    // 最小化到系统托盘（托盘图标由会话管理器持有，窗口销毁后仍在）
+    hide();
+    emit minimizedToTray();
 }
 
 void MusicPlayer::onPositionChanged(qint64 position)
@@ -543,64 +535,33 @@ void MusicPlayer::onPositionChanged(qint64 position)
 void MusicPlayer::onDurationChanged(qint64 duration)
 {
     m_progressSlider->setRange(0, duration);
+    m_audio->waveform()->request(m_audio->engine()->source());// 换歌（包括自动接上下一首）时都会通知时长
 
     QTime totalTime(0, 0);
     totalTime = totalTime.addMSecs(duration);
     m_totalTime->setText(totalTime.toString("m:ss"));
 }
 
-void MusicPlayer::onPlaylistItemClicked(QListWidgetItem *item)
-{
-    m_currentIndex = m_playlist->row(item);
-    updateCurrentSong();
-}
-
-void MusicPlayer::onTrayIconActivated(QSystemTrayIcon::ActivationReason reason)
-{
-    if (reason == QSystemTrayIcon::DoubleClick) {
-        if (isHidden()) {
-            showNormal();
-            activateWindow();
-        } else {
-            hide();
-        }
-    }
-}
-
-void MusicPlayer::mousePressEvent(QMouseEvent *event)
+void MusicPlayer::onPlaylistClicked(const QModelIndex &index)
 {
-    if (event->button() == Qt::LeftButton) {
-        m_dragging = true;
-        m_dragPosition = event->globalPosition().toPoint() - frameGeometry().topLeft();
-        setCursor(Qt::ClosedHandCursor);
-    }
-    QWidget::mousePressEvent(event);
+    m_audio->selectTrack(m_audio->model()->trackAt(index.row()));
 }
 
-void MusicPlayer::mouseMoveEvent(QMouseEvent *event)
+void MusicPlayer::showEvent(QShowEvent *event)
 {
-    if (m_dragging && (event->buttons() & Qt::LeftButton)) {
-        move(event->globalPosition().toPoint() - m_dragPosition);
-    }
-    QWidget::mouseMoveEvent(event);
+    QWidget::showEvent(event);
+    m_audio->setSpectrumVisible(true);
 }
 
-void MusicPlayer::mouseReleaseEvent(QMouseEvent *event)
+void MusicPlayer::hideEvent(QHideEvent *event)
 {
-    if (event->button() == Qt::LeftButton) {
-        m_dragging = false;
-        setCursor(Qt::ArrowCursor);
-    }
-    QWidget::mouseReleaseEvent(event);
+    QWidget::hideEvent(event);
+    m_audio->setSpectrumVisible(false);
 }
 
 void MusicPlayer::closeEvent(QCloseEvent *event)
 {
-    // 重写关闭事件：最小化到托盘而不是退出
-    if (m_trayIcon && m_trayIcon->isVisible()) {
-        hide();
-        event->ignore();
-    } else {
-        event->accept();
-    }
+    // 重写关闭事件：隐藏到托盘而不是关闭，音乐继续播放
+    hide();
+    event->ignore();
 }
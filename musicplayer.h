@@ -2,80 +2,78 @@
 #define MUSICPLAYER_H
 
 #include <QWidget>
-#include <QMediaPlayer>
-#include <QAudioOutput>
 #include <QSlider>
 #include <QLabel>
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QListWidget>
-#include <QSystemTrayIcon>
+#include <QListView>
+#include <QLineEdit>
 #include <QCloseEvent>
 #include <QDebug>  // 调试支持
 #include <QFileInfo>  // 文件信息支持
+
+class AudioService;
+class SpectrumWidget;
+class WaveformSlider;
+
+/*
+ * MusicPlayer：音乐播放器窗口
+ *
+ * 只是 AudioService 的视图：按钮和列表操作交给服务，歌曲信息、进度和波形跟着服务更新。
+ * 窗口可以随时销毁重建，音乐不受影响；重建时从服务读出当前状态。
+ */
 class MusicPlayer : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit MusicPlayer(QWidget *parent = nullptr);
+    explicit MusicPlayer(AudioService *audio, QWidget *parent = nullptr);
     ~MusicPlayer();
 
+signals:
+    void minimizedToTray();
+
 protected:
-    void mousePressEvent(QMouseEvent *event) override;
-    void mouseMoveEvent(QMouseEvent *event) override;
-    void mouseReleaseEvent(QMouseEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private slots:
-    void playPause();
-    void nextSong();
-    void prevSong();
     void onPositionChanged(qint64 position);
     void onDurationChanged(qint64 duration);
-    void onPlaylistItemClicked(QListWidgetItem *item);
-    void onTrayIconActivated(QSystemTrayIcon::ActivationReason reason);
+    void onPlaylistClicked(const QModelIndex &index);
     void minimizeToTray();  // 新增
+    void showLibraryMenu();
+    void showCurrent();//显示当前歌曲的标题和状态，并在列表中选中
 
 private:
     void setupUI();
     void setupConnections();
     void applyBlueBlackTheme();
-    void loadSongs();
-    void createTrayIcon();
+    void selectCurrent();//在列表中选中并显示当前歌曲
 
-    QMediaPlayer *m_player;
-    QAudioOutput *m_audioOutput;
+    AudioService *m_audio;
 
     // UI组件
     QLabel *m_titleLabel;
     QLabel *m_songTitle;
     QLabel *m_songArtist;
-    QSlider *m_progressSlider;
+    SpectrumWidget *m_spectrumView;
+    WaveformSlider *m_progressSlider;//画出当前歌曲的波形
     QSlider *m_volumeSlider;
     QLabel *m_currentTime;
     QLabel *m_totalTime;
     QPushButton *m_playBtn;
     QPushButton *m_prevBtn;
     QPushButton *m_nextBtn;
-    QListWidget *m_playlist;
+    QListView *m_playlist;
+    QLineEdit *m_filterEdit;
     QPushButton *m_closeBtn;
     QPushButton *m_minimizeBtn;
+    QPushButton *m_libraryBtn;
 
-    // 拖动相关
-    bool m_dragging;
-    QPoint m_dragPosition;
-
-    // 歌曲列表
-    QList<QPair<QString, QString>> m_songs;
-    int m_currentIndex;
-
-    // 系统托盘
-    QSystemTrayIcon *m_trayIcon;
-    QMenu *m_trayMenu;
-
-    void updateCurrentSong();
+    int m_shownIndex;//标签上显示的歌曲，换歌时进度归零
 };
 
 #endif // MUSICPLAYER_H
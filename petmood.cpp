@@ -0,0 +1,162 @@
+#include "petmood.h"
+#include "assetpack.h"
+#include <QRandomGenerator>
+#include <QStringList>
+
+/*
+ * PetMood 构造函数
+ *
+ * 两个情绪动画体积不大，启动后就以普通优先级预取，第一次反应也不用等解码
+ */
+PetMood::PetMood(AnimationCache *cache, AnimationPlayer *player, const QString &character, QObject *parent)
+    : QObject{parent}
+    , m_cache(cache)
+    , m_player(player)
+    , m_character(character)
+    , m_mood(Calm)
+    , m_calmTimer(new QTimer(this))
+{
+    m_calmTimer->setSingleShot(true);
+    m_calmTimer->setInterval(6000);
+    connect(m_calmTimer, &QTimer::timeout, this, &PetMood::calmDown);
+    connect(m_cache, &AnimationCache::animationReady, this, &PetMood::onAnimationReady);
+
+    // 日常动画取角色目录下所有 animation*，用户资源包新增的动画也会参与随机
+    const QStringList names = AssetLibrary::instance().list(m_character + "animation");
+    for (const QString &name : names) {
+        if (name.endsWith(".sprite") || name.endsWith(".gif")) {
+            m_idleAnimations.append(name);
+        }
+    }
+    if (m_idleAnimations.isEmpty()) {
+        m_idleAnimations.append("image/animation1.sprite");//qrc中编入的必需品
+    }
+
+    m_nextIdle = randomIdleAnimation();
+    m_cache->prefetch(m_nextIdle, true);
+    for (Mood mood : {Happy, Angry}) {
+        if (AssetLibrary::instance().contains(animationFor(mood))) {
+            m_cache->prefetch(animationFor(mood));
+        }
+    }
+}
+
+PetMood::Mood PetMood::mood() const
+{
+    return m_mood;
+}
+
+/*
+ * 判断文字的情绪：数开心和生气的关键词、颜文字、emoji，多的一方获胜，相同时视为平静
+ */
+PetMood::Mood PetMood::classify(const QString &text)
+{
+    static const QStringList happyWords = {
+        "开心", "高兴", "快乐", "幸福", "哈哈", "嘻嘻", "好耶", "太棒", "喜欢", "爱你",
+        "(*^▽^*)", "٩(◕‿◕｡)۶", "o(≧▽≦)o", "😄", "😊", "😆", "🎉", "🥰", "❤"
+    };
+    static const QStringList angryWords = {
+        "生气", "气死", "讨厌", "愤怒", "可恶", "烦死", "哼", "笨蛋",
+        "(╯°□°）╯", "😠", "😡", "💢", "🤬"
+    };
+
+    int happy = 0;
+    int angry = 0;
+    for (const QString &word : happyWords) {
+        happy += text.count(word);
+    }
+    for (const QString &word : angryWords) {
+        angry += text.count(word);
+    }
+    if (happy > angry) {
+        return Happy;
+    }
+    if (angry > happy) {
+        return Angry;
+    }
+    return Calm;
+}
+
+/*
+ * 预计即将切换到某个情绪：把目标动画提前解码
+ */
+void PetMood::anticipate(PetMood::Mood mood)
+{
+    if (mood != Calm && AssetLibrary::instance().contains(animationFor(mood))) {
+        m_cache->prefetch(animationFor(mood), true);
+    }
+}
+
+void PetMood::react(PetMood::Mood mood)
+{
+    if (mood == Calm) {
+        return;//平静的回复不打断当前动画
+    }
+    if (!AssetLibrary::instance().contains(animationFor(mood))) {
+        return;//资源包里没有这个情绪的动画，保持日常动画
+    }
+    m_calmTimer->start();//同一情绪连续出现时延长持续时间
+    if (mood == m_mood) {
+        return;
+    }
+    m_mood = mood;
+    show(animationFor(mood));
+    emit moodChanged(m_mood);
+}
+
+void PetMood::nextIdle()
+{
+    if (m_mood != Calm) {
+        return;
+    }
+    show(m_nextIdle);
+    //切换完立刻预取下一个，切换间隔内足够在后台解码完
+    m_nextIdle = randomIdleAnimation();
+    m_cache->prefetch(m_nextIdle);
+}
+
+void PetMood::calmDown()
+{
+    m_mood = Calm;
+    emit moodChanged(m_mood);
+    nextIdle();
+}
+
+void PetMood::onAnimationReady(const QString &path, AnimationPtr animation)
+{
+    if (path == m_wantedPath && m_player->animation() != animation) {
+        m_player->setAnimation(animation);
+    }
+}
+
+QString PetMood::animationFor(Mood mood) const
+{
+    switch (mood) {
+    case Happy:
+        return m_character + "cachinnation.sprite";
+    case Angry:
+        return m_character + "angry.sprite";
+    case Calm:
+        break;
+    }
+    return randomIdleAnimation();
+}
+
+QString PetMood::randomIdleAnimation() const
+{
+    return m_idleAnimations.at(QRandomGenerator::global()->bounded(m_idleAnimations.size()));
+}
+
+/*
+ * 显示一个动画：命中缓存时直接替换指针，否则以紧急优先级解码，完成后再显示
+ */
+void PetMood::show(const QString &path)
+{
+    m_wantedPath = path;
+    AnimationPtr animation = m_cache->get(path);
+    if (animation) {
+        m_player->setAnimation(animation);
+    } else {
+        m_cache->prefetch(path, true);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef PETMOOD_H
+#define PETMOOD_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include "animationcache.h"
+
+/*
+ * PetMood：桌宠情绪状态机，决定当前播放哪个动画
+ *
+ * 平静时在资源包的日常动画中随机切换；聊天中出现开心或生气的内容时切到对应的情绪动画，
+ * 持续一段时间后回到平静。
+ *
+ * 状态切换分两步：
+ *  - anticipate()：预计可能切换（用户刚发出消息、回复已选好但还在"思考"、AI回复还在生成），
+ *    以紧急优先级在后台解码目标动画；
+ *  - react()：回复真正显示时切换。目标动画已经在缓存里，切换只是替换指针，下一帧就能看到；
+ *    万一还没解码完，先保持当前动画，解码完成后再切过去，不会阻塞界面。
+ */
+class PetMood : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mood { Calm, Happy, Angry };
+    Q_ENUM(Mood)
+
+    PetMood(AnimationCache *cache, AnimationPlayer *player, const QString &character = "image/", QObject *parent = nullptr);//character：角色的资源目录
+
+    Mood mood() const;
+    static Mood classify(const QString &text);//根据关键词和表情判断一段文字的情绪
+
+public slots:
+    void anticipate(PetMood::Mood mood);
+    void react(PetMood::Mood mood);
+    void nextIdle();//平静时换一个随机日常动画（由切换定时器调用）
+
+signals:
+    void moodChanged(PetMood::Mood mood);
+
+private slots:
+    void onAnimationReady(const QString &path, AnimationPtr animation);
+    void calmDown();
+
+private:
+    QString animationFor(Mood mood) const;
+    QString randomIdleAnimation() const;
+    void show(const QString &path);
+
+    AnimationCache *m_cache;
+    AnimationPlayer *m_player;
+    QString m_character;
+    Mood m_mood;
+    QString m_wantedPath;//应该显示的动画，还没解码完时等 animationReady
+    QStringList m_idleAnimations;
+    QString m_nextIdle;//下一次日常切换的动画，提前解码
+    QTimer *m_calmTimer;//情绪动画持续的时间
+};
+
+#endif // PETMOOD_H
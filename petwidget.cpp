@@ -0,0 +1,154 @@
+#include "petwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+
+PetWidget::PetWidget(QWidget *parent)
+    : QWidget{parent}
+    , m_displayValid(false)
+    , m_scale(1.0)
+    , m_mirrored(false)
+{
+}
+
+void PetWidget::setScale(qreal scale)
+{
+    if (qFuzzyCompare(scale, m_scale) || scale <= 0) {
+        return;
+    }
+    m_scale = scale;
+    updateGeometry();
+    clearCache();
+}
+
+qreal PetWidget::scale() const
+{
+    return m_scale;
+}
+
+void PetWidget::setMirrored(bool mirrored)
+{
+    if (mirrored == m_mirrored) {
+        return;
+    }
+    m_mirrored = mirrored;
+    clearCache();
+}
+
+bool PetWidget::isMirrored() const
+{
+    return m_mirrored;
+}
+
+void PetWidget::setTint(const QColor &color)
+{
+    if (color == m_tint) {
+        return;
+    }
+    m_tint = color;
+    clearCache();
+}
+
+QColor PetWidget::tint() const
+{
+    return m_tint;
+}
+
+QSize PetWidget::sizeHint() const
+{
+    return m_frameSize.isEmpty() ? QSize(240, 240) : m_frameSize * m_scale;
+}
+
+/*
+ * 显示新的一帧
+ *
+ * 只变换并刷新变化的区域；显示图像无效时（刚启动、尺寸或设置改变）整幅重新生成
+ */
+void PetWidget::showFrame(const QImage &frame, const QRect &dirty)
+{
+    if (frame.size() != m_frameSize) {
+        m_frameSize = frame.size();
+        m_displayValid = false;
+        updateGeometry();
+    }
+    if (!m_displayValid) {
+        render(frame, frame.rect());
+        m_displayValid = true;
+        update();
+    } else if (!dirty.isEmpty()) {
+        render(frame, dirty);
+        update(mapFromFrame(dirty).translated(targetRect().topLeft()));
+    }
+}
+
+void PetWidget::clearCache()
+{
+    m_displayValid = false;
+    if (!m_frameSize.isEmpty()) {
+        emit fullFrameRequested();
+    }
+}
+
+void PetWidget::paintEvent(QPaintEvent *event)
+{
+    if (m_display.isNull()) {
+        return;
+    }
+    const QRect target = targetRect();
+    // 显示图像已经是最终尺寸，直接按像素一一对应复制需要刷新的部分
+    const QRect area = event->rect() & target;
+    if (area.isEmpty()) {
+        return;
+    }
+    QPainter painter(this);
+    painter.drawImage(area.topLeft(), m_display, area.translated(-target.topLeft()));
+}
+
+/*
+ * 把帧中的一块区域按当前设置变换后写进显示图像
+ *
+ * 裁剪到目标区域后，光栅绘制引擎只处理这一块像素
+ */
+void PetWidget::render(const QImage &frame, const QRect &rect)
+{
+    const QSize size = targetRect().size();
+    if (m_display.size() != size) {
+        m_display = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        m_display.fill(Qt::transparent);
+    }
+    const QRect area = mapFromFrame(rect);
+    QPainter painter(&m_display);
+    painter.setClipRect(area);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    if (m_mirrored) {
+        painter.translate(size.width(), 0);
+        painter.scale(-1, 1);
+    }
+    if (!qFuzzyCompare(m_scale, 1.0)) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.scale(m_scale, m_scale);
+    }
+    painter.drawImage(0, 0, frame);
+    if (m_tint.isValid() && m_tint.alpha() > 0) {
+        // SourceAtop 只给不透明的部分上色，透明背景保持不变
+        painter.resetTransform();
+        painter.setCompositionMode(QPainter::CompositionMode_SourceAtop);
+        painter.fillRect(area, m_tint);
+    }
+}
+
+QRect PetWidget::targetRect() const
+{
+    const QSize size = (QSizeF(m_frameSize) * m_scale).toSize();
+    return QRect(QPoint((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+}
+
+QRect PetWidget::mapFromFrame(const QRect &rect) const
+{
+    QRect source = rect;
+    if (m_mirrored) {
+        source.moveLeft(m_frameSize.width() - rect.right() - 1);
+    }
+    const QRectF scaled(source.x() * m_scale, source.y() * m_scale, source.width() * m_scale, source.height() * m_scale);
+    // 缩放时边缘像素会受相邻像素影响，向外多取一圈
+    return scaled.toAlignedRect().adjusted(-1, -1, 1, 1) & QRect(QPoint(0, 0), targetRect().size());
+}
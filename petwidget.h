@@ -0,0 +1,54 @@
+#ifndef PETWIDGET_H
+#define PETWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QColor>
+
+/*
+ * PetWidget：自绘的桌宠动画控件
+ *
+ * 只保留一张按当前缩放、镜像、着色设置变换好的显示图像。换帧时只把变化的区域变换后
+ * 写进显示图像，并只刷新这一块，paintEvent 也只绘制需要刷新的部分。
+ * 不为每一帧缓存整幅贴图，动画帧在缓存中可以保持紧凑的索引形式（见 IndexedFrame）。
+ * 改变缩放、镜像或着色时丢弃显示图像，通过 fullFrameRequested 要一帧完整画面重新生成。
+ */
+class PetWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit PetWidget(QWidget *parent = nullptr);
+
+    void setScale(qreal scale);
+    qreal scale() const;
+    void setMirrored(bool mirrored);//水平镜像（朝向另一侧）
+    bool isMirrored() const;
+    void setTint(const QColor &color);//用半透明颜色给桌宠着色，无效颜色表示不着色，透明度决定强度
+    QColor tint() const;
+
+    QSize sizeHint() const override;
+
+public slots:
+    void showFrame(const QImage &frame, const QRect &dirty);//dirty 为帧坐标下变化的区域；不保留 frame 的引用
+    void clearCache();//丢弃显示图像，下一帧整幅重新生成
+
+signals:
+    void fullFrameRequested();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    void render(const QImage &frame, const QRect &rect);
+    QRect targetRect() const;//动画在控件中的位置（居中）
+    QRect mapFromFrame(const QRect &rect) const;//帧坐标映射到显示图像坐标
+
+    QImage m_display;//变换后的当前画面，尺寸为 targetRect().size()
+    bool m_displayValid;
+    QSize m_frameSize;
+    qreal m_scale;
+    bool m_mirrored;
+    QColor m_tint;
+};
+
+#endif // PETWIDGET_H
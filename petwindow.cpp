@@ -0,0 +1,108 @@
+#include "petwindow.h"
+#include "animationcache.h"
+#include "petwidget.h"
+#include "petmood.h"
+#include "assetpack.h"
+#include <QLabel>
+#include <QSettings>
+#include <QSet>
+
+/*
+ * PetWindow 构造函数
+ *
+ * @param character：角色目录（如 "pets/tabby/"），为空或资源包中没有这个角色时使用内置角色
+ */
+PetWindow::PetWindow(AnimationCache *cache, AnimationScheduler *scheduler, const QString &character, QWidget *parent)
+    : QWidget{parent}
+    , m_character(characters().contains(character) ? character : defaultCharacter())
+    , m_mirrored(false)
+{
+    setMouseTracking(true);//启用鼠标跟踪
+    setWindowFlag(Qt::FramelessWindowHint);//隐藏标题栏窗口
+    setWindowTitle("o(=•ェ•=)m");
+    setContextMenuPolicy(Qt::CustomContextMenu);
+    //桌宠大小和朝向可以通过配置项 pet/scale、pet/mirrored 调整，改变时不需要重新解码动画
+    QSettings settings;
+    const qreal petScale = qBound(0.25, settings.value("pet/scale", 1.0).toReal(), 4.0);
+    setFixedSize(qRound(240 * petScale), qRound(240 * petScale));
+
+    //动画窗口：自绘控件，只重绘两帧之间变化的区域
+    m_view = new PetWidget(this);
+    m_view->setScale(petScale);
+    m_mirrored = settings.value("pet/mirrored", false).toBool();
+    m_view->setMirrored(m_mirrored);
+    m_view->setGeometry(0, 0, width(), height());
+    //播放器只有当前动画指针、帧序号和一张画布，帧数据来自共享的缓存
+    m_player = new AnimationPlayer(scheduler, this);
+    connect(m_player, &AnimationPlayer::frameChanged, m_view, &PetWidget::showFrame);
+    connect(m_view, &PetWidget::fullFrameRequested, m_player, &AnimationPlayer::refresh);
+    //情绪状态机：平静时随机播放日常动画，聊天中出现情绪时切换到对应动画
+    m_mood = new PetMood(cache, m_player, m_character, this);
+
+    //主窗口文字标签
+    QLabel *titleLabel = new QLabel("你好啊！o(=•ェ•=)m", this);
+    titleLabel->setAlignment(Qt::AlignCenter);
+    titleLabel->setStyleSheet(
+        R"(
+            QLabel
+            {
+                background-color: black;
+                color: white;
+                font-size: 16px;
+                font-weight: bold;
+                border: none;
+            }
+        )"
+    );
+    titleLabel->setGeometry(0, 0, width(), 30);
+}
+
+QString PetWindow::character() const
+{
+    return m_character;
+}
+
+PetMood *PetWindow::mood() const
+{
+    return m_mood;
+}
+
+void PetWindow::setFacingRight(bool right)
+{
+    m_view->setMirrored(m_mirrored != right);
+}
+
+QString PetWindow::defaultCharacter()
+{
+    return "image/";
+}
+
+/*
+ * 列出资源包中的角色：内置角色，以及 pets/ 下每个含有日常动画的目录
+ */
+QStringList PetWindow::characters()
+{
+    QStringList result = {defaultCharacter()};
+    QSet<QString> seen;
+    const QStringList names = AssetLibrary::instance().list("pets/");
+    for (const QString &name : names) {
+        const int slash = name.indexOf('/', 5);
+        if (slash < 0 || !name.mid(slash + 1).startsWith("animation")) {
+            continue;
+        }
+        const QString character = name.left(slash + 1);
+        if (!seen.contains(character)) {
+            seen.insert(character);
+            result << character;
+        }
+    }
+    return result;
+}
+
+QString PetWindow::characterName(const QString &character)
+{
+    if (character == defaultCharacter()) {
+        return "猫猫";
+    }
+    return character.section('/', 1, 1);
+}
@@ -0,0 +1,46 @@
+#ifndef PETWINDOW_H
+#define PETWINDOW_H
+
+#include <QWidget>
+#include <QString>
+#include <QStringList>
+
+class AnimationCache;
+class AnimationScheduler;
+class AnimationPlayer;
+class PetWidget;
+class PetMood;
+
+/*
+ * PetWindow：一只桌宠的窗口
+ *
+ * 同一进程里可以有多只桌宠（每个显示器一只，或不同角色），它们共用一个动画缓存和一个时钟：
+ * 解码好的帧只有一份，由缓存按资源名称共享；每只桌宠只持有轻量的状态——
+ * 播放器（当前动画指针、帧序号、一张画布）、情绪状态机和窗口位置。
+ *
+ * 角色是资源包中的一个目录：内置角色为 image/，用户资源包可以添加 pets/<名称>/，
+ * 目录下放 animation*.sprite（日常）、cachinnation.sprite（开心）、angry.sprite（生气）。
+ */
+class PetWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    PetWindow(AnimationCache *cache, AnimationScheduler *scheduler, const QString &character = QString(), QWidget *parent = nullptr);
+
+    QString character() const;
+    PetMood *mood() const;
+    void setFacingRight(bool right);//自由活动时朝向行走的方向（动画素材默认朝左）
+
+    static QString defaultCharacter();
+    static QStringList characters();//资源包中所有可用的角色目录
+    static QString characterName(const QString &character);//菜单中显示的名称
+
+private:
+    QString m_character;
+    PetWidget *m_view;
+    AnimationPlayer *m_player;
+    PetMood *m_mood;
+    bool m_mirrored;//配置项 pet/mirrored
+};
+
+#endif // PETWINDOW_H
@@ -0,0 +1,884 @@
+#include "playbackengine.h"
+#include "assetpack.h"
+#include "trackdecoder.h"
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QAudioSink>
+#include <QAudioDevice>
+#include <QMediaDevices>
+#include <QDir>
+#include <QFileInfo>
+#include <QUrl>
+#include <QSettings>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const double StreamSeconds = 2.5;//每首歌最多预先解码的时长
+const std::size_t PumpThreshold = 16384;//缓冲区至少空出这么多个采样才从解码器取下一块
+const int TickMs = 20;
+const qint64 PositionStepMs = 200;//进度通知的最小间隔
+const qint64 OutputBufferUs = 100000;//音频输出的缓冲区：100ms
+
+// 输出格式：默认设备的采样率，立体声浮点；设备不支持浮点时用16位整数
+QAudioFormat outputFormat()
+{
+    const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    const int rate = device.preferredFormat().sampleRate();
+    QAudioFormat format;
+    format.setSampleRate(rate > 0 ? rate : 48000);
+    format.setChannelCount(2);
+    format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isNull() && !device.isFormatSupported(format)) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    }
+    return format;
+}
+
+} // namespace
+
+// ==================== PlaybackDeck ====================
+
+PlaybackDeck::PlaybackDeck(const QAudioFormat &format, QObject *parent)
+    : QObject{parent}
+    , m_format(format)
+    , m_decoder(nullptr)
+    , m_device(nullptr)
+    , m_gain(1.0f)
+    , m_duration(0)
+    , m_skip(0)
+    , m_finished(false)
+    , m_phase(0)
+    , m_pendingOffset(0)
+{
+    m_previous[0] = m_previous[1] = 0.0f;
+}
+
+PlaybackDeck::~PlaybackDeck()
+{
+    unload();
+}
+
+/*
+ * 打开一首歌并开始解码
+ *
+ * @param name：资源包中的名称（如 music/x.mp3）或本地文件的绝对路径
+ * @param startMs：从这个位置开始（跳转、释放后恢复），之前的数据解码后丢弃
+ * @param gain：混音时乘上的增益（线性）
+ */
+bool PlaybackDeck::load(const QString &name, qint64 startMs, float gain)
+{
+    unload();
+    m_decoder = new QAudioDecoder(this);
+    QAudioFormat request;
+    request.setSampleRate(m_format.sampleRate());
+    request.setChannelCount(2);
+    request.setSampleFormat(QAudioFormat::Float);
+    m_decoder->setAudioFormat(request);//后端不支持时按实际格式转换
+    if (QDir::isAbsolutePath(name)) {
+        if (!QFileInfo::exists(name)) {
+            unload();
+            return false;
+        }
+        m_decoder->setSource(QUrl::fromLocalFile(name));
+    } else {
+        m_device = AssetLibrary::instance().open(name, this);
+        if (!m_device) {
+            unload();
+            return false;
+        }
+        m_decoder->setSourceDevice(m_device);
+    }
+
+    m_name = name;
+    m_stream = std::make_shared<PlaybackStream>(std::size_t(StreamSeconds * m_format.sampleRate() * 2));
+    setGain(gain);
+    m_stream->startFrame = startMs * m_format.sampleRate() / 1000;
+    m_skip = m_stream->startFrame;
+
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &PlaybackDeck::pump);
+    connect(m_decoder, &QAudioDecoder::finished, this, [this]() {
+        m_finished = true;
+        pump();
+    });
+    connect(m_decoder, &QAudioDecoder::durationChanged, this, [this](qint64 duration) {
+        m_duration = duration;
+        m_stream->totalFrames.store(duration * m_format.sampleRate() / 1000);
+        emit durationChanged(duration);
+    });
+    connect(m_decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), this, [this](QAudioDecoder::Error) {
+        // 解码失败时当作这首歌结束，混音器会接着播下一首
+        qDebug() << "解码失败:" << m_name << m_decoder->errorString();
+        m_finished = true;
+        m_pending.clear();
+        m_stream->ended.store(true, std::memory_order_release);
+        emit failed(m_decoder->errorString());
+    });
+    m_decoder->start();
+    return true;
+}
+
+void PlaybackDeck::unload()
+{
+    if (m_decoder) {
+        m_decoder->disconnect(this);
+        m_decoder->stop();
+        m_decoder->deleteLater();
+        m_decoder = nullptr;
+    }
+    if (m_device) {
+        m_device->deleteLater();//解码器之后销毁
+        m_device = nullptr;
+    }
+    m_stream.reset();
+    m_name.clear();
+    m_gain = 1.0f;
+    m_duration = 0;
+    m_skip = 0;
+    m_finished = false;
+    m_phase = 0;
+    m_previous[0] = m_previous[1] = 0.0f;
+    m_pending.clear();
+    m_pending.shrink_to_fit();
+    m_input.clear();
+    m_input.shrink_to_fit();
+    m_pendingOffset = 0;
+}
+
+/*
+ * 缓冲区有空间时才从解码器取数据；跳转时丢弃的数据不占空间，尽快取
+ */
+void PlaybackDeck::pump()
+{
+    if (!m_stream) {
+        return;
+    }
+    writePending();
+    while (m_decoder && m_pending.empty() && m_decoder->bufferAvailable()
+           && (m_skip > 0 || m_stream->ring.freeSpace() >= PumpThreshold)) {
+        convert(m_decoder->read());
+    }
+    if (m_finished && m_pending.empty() && !(m_decoder && m_decoder->bufferAvailable())) {
+        m_stream->ended.store(true, std::memory_order_release);
+    }
+}
+
+QString PlaybackDeck::name() const
+{
+    return m_name;
+}
+
+void PlaybackDeck::setGain(float gain)
+{
+    m_gain = gain;
+    if (m_stream) {
+        m_stream->gain.store(gain, std::memory_order_relaxed);
+    }
+}
+
+float PlaybackDeck::gain() const
+{
+    return m_gain;
+}
+
+StreamPtr PlaybackDeck::stream() const
+{
+    return m_stream;
+}
+
+bool PlaybackDeck::isFresh() const
+{
+    return m_stream && m_stream->startFrame == 0 && m_stream->consumed.load() == 0;
+}
+
+qint64 PlaybackDeck::duration() const
+{
+    return m_duration;
+}
+
+/*
+ * 任意格式 -> 立体声浮点 -> 输出采样率（线性插值），结果先放进 m_pending 再写入缓冲区
+ */
+void PlaybackDeck::convert(const QAudioBuffer &buffer)
+{
+    const qint64 frames = TrackDecoder::toStereo(buffer, &m_input);
+    if (frames <= 0) {
+        return;
+    }
+    const QAudioFormat format = buffer.format();
+
+    const int rate = format.sampleRate();
+    if (rate <= 0 || rate == m_format.sampleRate()) {
+        m_pending.assign(m_input.begin(), m_input.end());
+    } else {
+        // m_phase 以本块为坐标，-1 表示上一块的最后一帧；插值要用到 index+1，
+        // 所以正好落在本块最后一帧的位置留到下一块（此时为-1）再算
+        const double step = double(rate) / m_format.sampleRate();
+        m_pending.clear();
+        m_pending.reserve(std::size_t(frames / step) * 2 + 4);
+        while (m_phase < frames - 1) {
+            const int index = int(std::floor(m_phase));
+            const float fraction = float(m_phase - index);
+            for (int c = 0; c < 2; ++c) {
+                const float a = index < 0 ? m_previous[c] : m_input[index * 2 + c];
+                const float b = m_input[(index + 1) * 2 + c];
+                m_pending.push_back(a + (b - a) * fraction);
+            }
+            m_phase += step;
+        }
+        m_phase -= frames;
+    }
+    m_previous[0] = m_input[(frames - 1) * 2];
+    m_previous[1] = m_input[(frames - 1) * 2 + 1];
+
+    m_pendingOffset = 0;
+    if (m_skip > 0) {
+        const qint64 drop = qMin<qint64>(m_skip, qint64(m_pending.size() / 2));
+        m_skip -= drop;
+        m_pendingOffset = std::size_t(drop) * 2;
+    }
+    writePending();
+}
+
+void PlaybackDeck::writePending()
+{
+    if (m_pendingOffset < m_pending.size()) {
+        m_pendingOffset += m_stream->ring.write(m_pending.data() + m_pendingOffset, m_pending.size() - m_pendingOffset);
+    }
+    if (m_pendingOffset >= m_pending.size()) {
+        m_pending.clear();
+        m_pendingOffset = 0;
+    }
+}
+
+// ==================== PlaybackMixer ====================
+
+PlaybackMixer::PlaybackMixer(const QAudioFormat &format, QObject *parent)
+    : QIODevice{parent}
+    , m_format(format)
+    , m_route(new Route)
+    , m_hazard(nullptr)
+    , m_fadeFrames(0)
+    , m_drained(false)
+{
+}
+
+// 音频输出已经停止（PlaybackEngine 的析构先停掉 QAudioSink）
+PlaybackMixer::~PlaybackMixer()
+{
+    delete m_route.load();
+    for (Route *route : m_retired) {
+        delete route;
+    }
+}
+
+void PlaybackMixer::setStreams(const StreamPtr &current, const StreamPtr &next)
+{
+    Route *route = editRoute();
+    route->current = current;
+    route->next = next;
+    m_drained.store(false);
+    publish(route);
+}
+
+void PlaybackMixer::setNext(const StreamPtr &next)
+{
+    Route *route = editRoute();
+    route->next = next;
+    if (next) {
+        m_drained.store(false);
+    }
+    publish(route);
+}
+
+bool PlaybackMixer::addTap(const AudioTap &tap)
+{
+    const Route *old = m_route.load();
+    for (const AudioTap &slot : old->taps) {
+        if (slot == tap) {
+            return true;
+        }
+    }
+    for (int i = 0; i < MaxTaps; ++i) {
+        if (!old->taps[i]) {
+            Route *route = editRoute();
+            route->taps[i] = tap;
+            publish(route);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PlaybackMixer::removeTap(const AudioTap &tap)
+{
+    Route *route = editRoute();
+    for (AudioTap &slot : route->taps) {
+        if (slot == tap) {
+            slot.reset();
+        }
+    }
+    publish(route);
+}
+
+StreamPtr PlaybackMixer::current() const
+{
+    const Route *route = m_route.load();
+    return route->advanced.load() ? route->next : route->current;
+}
+
+void PlaybackMixer::setCrossfadeFrames(qint64 frames)
+{
+    m_fadeFrames.store(qMax<qint64>(0, frames));
+}
+
+bool PlaybackMixer::isDrained() const
+{
+    return m_drained.load();
+}
+
+void PlaybackMixer::reserve(qint64 frames)
+{
+    if (m_mix.size() < std::size_t(frames * 2)) {
+        m_mix.resize(frames * 2);
+        m_fadeOut.resize(frames * 2);
+    }
+}
+
+/*
+ * 路由只由界面线程创建和释放，所以界面线程可以直接读 m_route 指向的内容
+ */
+PlaybackMixer::Route *PlaybackMixer::editRoute() const
+{
+    const Route *old = m_route.load();
+    const bool advanced = old->advanced.load();
+    Route *route = new Route;
+    route->current = advanced ? old->next : old->current;
+    route->next = advanced ? StreamPtr() : old->next;
+    std::copy(std::begin(old->taps), std::end(old->taps), std::begin(route->taps));
+    return route;
+}
+
+void PlaybackMixer::publish(Route *route)
+{
+    m_retired.push_back(m_route.exchange(route));
+    releaseRetired();
+}
+
+void PlaybackMixer::releaseRetired()
+{
+    const Route *busy = m_hazard.load();
+    auto kept = std::remove_if(m_retired.begin(), m_retired.end(), [busy](Route *route) {
+        if (route == busy) {
+            return false;
+        }
+        delete route;//歌曲缓冲区的最后一个引用在这里（界面线程）释放
+        return true;
+    });
+    m_retired.erase(kept, m_retired.end());
+}
+
+/*
+ * 音频线程：先标记再确认路由没有被换掉，之后界面线程就不会释放它，直到回调结束清除标记
+ */
+PlaybackMixer::Route *PlaybackMixer::acquire()
+{
+    Route *route = m_route.load();
+    for (;;) {
+        m_hazard.store(route);
+        Route *again = m_route.load();
+        if (again == route) {
+            return route;
+        }
+        route = again;
+    }
+}
+
+bool PlaybackMixer::isSequential() const
+{
+    return true;
+}
+
+qint64 PlaybackMixer::bytesAvailable() const
+{
+    // 读不到数据时补静音，对输出来说总是有数据
+    return m_format.bytesForDuration(100000) + QIODevice::bytesAvailable();
+}
+
+/*
+ * 音频线程：混音后转换成输出格式。读不到数据时补静音，总是填满请求的长度（最多 reserve() 预留的帧数）
+ */
+qint64 PlaybackMixer::readData(char *data, qint64 maxSize)
+{
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const qint64 frames = bytesPerFrame > 0 ? qMin<qint64>(maxSize / bytesPerFrame, qint64(m_mix.size() / 2)) : 0;
+    if (frames <= 0) {
+        return 0;
+    }
+    Route *route = acquire();
+    mix(route, m_mix.data(), frames);
+    for (const AudioTap &tap : route->taps) {
+        if (tap && tap->freeSpace() >= std::size_t(frames * 2)) {
+            tap->write(m_mix.data(), frames * 2);//只写整块，分析线程跟不上时丢弃这一块
+        }
+    }
+    m_hazard.store(nullptr);
+    if (m_format.sampleFormat() == QAudioFormat::Float) {
+        std::memcpy(data, m_mix.data(), frames * bytesPerFrame);
+    } else {
+        qint16 *out = reinterpret_cast<qint16 *>(data);
+        for (qint64 i = 0; i < frames * 2; ++i) {
+            out[i] = qint16(qBound(-32768, int(std::lround(m_mix[i] * 32767.0f)), 32767));
+        }
+    }
+    return frames * bytesPerFrame;
+}
+
+qint64 PlaybackMixer::writeData(const char *data, qint64 size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;//只读设备
+}
+
+/*
+ * 混音
+ *
+ * 不淡入淡出时只读当前歌曲，读到结尾立即接着读下一首；
+ * 淡入淡出时在当前歌曲的最后 fade 帧里，以下一首的进度为准同时读两首，
+ * 当前歌曲提前结束的部分当作静音
+ */
+void PlaybackMixer::mix(Route *route, float *out, qint64 frames)
+{
+    std::fill(out, out + frames * 2, 0.0f);
+    const bool advanced = route->advanced.load();
+    PlaybackStream *current = advanced ? route->next.get() : route->current.get();
+    PlaybackStream *next = advanced ? nullptr : route->next.get();
+
+    qint64 produced = 0;
+    while (produced < frames && current) {
+        const qint64 fade = m_fadeFrames.load(std::memory_order_relaxed);
+        const qint64 total = current->totalFrames.load(std::memory_order_relaxed);
+        const qint64 played = current->startFrame + current->consumed.load(std::memory_order_relaxed);
+        const bool canFade = next && fade > 0 && total > fade;
+        float *dst = out + produced * 2;
+        qint64 want = frames - produced;
+
+        if (!canFade || played < total - fade) {
+            if (canFade) {
+                want = qMin(want, total - fade - played);
+            }
+            const qint64 got = qint64(current->ring.read(dst, std::size_t(want * 2)) / 2);
+            const float gain = current->gain.load(std::memory_order_relaxed);
+            if (gain != 1.0f) {
+                for (qint64 i = 0; i < got * 2; ++i) {
+                    dst[i] *= gain;
+                }
+            }
+            current->consumed.fetch_add(got, std::memory_order_relaxed);
+            produced += got;
+            if (got < want) {
+                if (current->ended.load(std::memory_order_acquire) && current->ring.available() == 0) {
+                    if (!advance(route, &current, &next)) {
+                        break;
+                    }
+                    continue;
+                }
+                break;//解码跟不上，剩下的补静音
+            }
+            continue;
+        }
+
+        const qint64 got = qint64(next->ring.read(dst, std::size_t(want * 2)) / 2);
+        const qint64 gotOut = qint64(current->ring.read(m_fadeOut.data(), std::size_t(got * 2)) / 2);
+        std::fill(m_fadeOut.begin() + gotOut * 2, m_fadeOut.begin() + got * 2, 0.0f);
+        const float levelIn = next->gain.load(std::memory_order_relaxed);
+        const float levelOut = current->gain.load(std::memory_order_relaxed);
+        for (qint64 i = 0; i < got; ++i) {
+            const double g = qMin(1.0, double(next->fadePos + i) / fade) * M_PI / 2;
+            const float gainIn = float(std::sin(g)) * levelIn;
+            const float gainOut = float(std::cos(g)) * levelOut;
+            dst[i * 2] = dst[i * 2] * gainIn + m_fadeOut[i * 2] * gainOut;
+            dst[i * 2 + 1] = dst[i * 2 + 1] * gainIn + m_fadeOut[i * 2 + 1] * gainOut;
+        }
+        next->fadePos += got;
+        next->consumed.fetch_add(got, std::memory_order_relaxed);
+        current->consumed.fetch_add(gotOut, std::memory_order_relaxed);
+        produced += got;
+        const bool currentDone = current->ended.load(std::memory_order_acquire) && current->ring.available() == 0;
+        if (next->fadePos >= fade || currentDone) {
+            if (!advance(route, &current, &next)) {
+                break;
+            }
+            continue;
+        }
+        if (got < want) {
+            break;
+        }
+    }
+}
+
+/*
+ * 当前歌曲结束，换成下一首。界面线程已经发布了新的路由时不再继续，下次回调按新的路由播放
+ *
+ * @return 还有可以继续读的歌曲
+ */
+bool PlaybackMixer::advance(Route *route, PlaybackStream **current, PlaybackStream **next)
+{
+    if (m_route.load() != route) {
+        return false;
+    }
+    if (!*next) {
+        m_drained.store(true);
+        return false;
+    }
+    route->advanced.store(true);
+    *current = *next;
+    *next = nullptr;
+    return true;
+}
+
+// ==================== PlaybackEngine ====================
+
+/*
+ * PlaybackEngine 构造函数
+ *
+ * 音频输出在第一次播放时才创建
+ */
+PlaybackEngine::PlaybackEngine(QObject *parent)
+    : QObject{parent}
+    , m_format(outputFormat())
+    , m_active(0)
+    , m_sink(nullptr)
+    , m_state(StoppedState)
+    , m_volume(1.0f)
+    , m_sourceGain(1.0f)
+    , m_resumePosition(0)
+    , m_released(false)
+    , m_lastPosition(-1)
+{
+    for (int i = 0; i < 2; ++i) {
+        m_decks[i] = new PlaybackDeck(m_format, this);
+        PlaybackDeck *deck = m_decks[i];
+        connect(deck, &PlaybackDeck::durationChanged, this, [this, deck](qint64 duration) {
+            if (deck == activeDeck()) {
+                emit durationChanged(duration);
+            }
+        });
+        connect(deck, &PlaybackDeck::failed, this, &PlaybackEngine::errorOccurred);
+    }
+    m_mixer = new PlaybackMixer(m_format, this);
+    m_mixer->open(QIODevice::ReadOnly);
+
+    QSettings settings;
+    setCrossfade(settings.value("music/crossfadeMs", 0).toInt());
+
+    m_timer.setInterval(TickMs);
+    connect(&m_timer, &QTimer::timeout, this, &PlaybackEngine::tick);
+}
+
+PlaybackEngine::~PlaybackEngine()
+{
+    if (m_sink) {
+        m_sink->stop();
+    }
+    m_mixer->setStreams(StreamPtr(), StreamPtr());
+}
+
+/*
+ * 换到一首歌
+ *
+ * 正是预先缓冲好的下一首时直接换过去；否则在当前解码器中重新打开。
+ * 之后需要重新调用 setNext()
+ */
+bool PlaybackEngine::load(const QString &name, qint64 positionMs, float gain)
+{
+    syncDecks();
+    if (positionMs == 0 && nextDeck()->name() == name && nextDeck()->isFresh()) {
+        m_active = 1 - m_active;
+        nextDeck()->unload();
+        activeDeck()->setGain(gain);
+    } else if (!activeDeck()->load(name, positionMs, gain)) {
+        return false;
+    }
+    m_source = name;
+    m_sourceGain = gain;
+    m_released = false;
+    m_resumePosition = 0;
+    m_mixer->setStreams(activeDeck()->stream(), StreamPtr());
+    emit durationChanged(activeDeck()->duration());
+    m_lastPosition = positionMs;
+    emit positionChanged(positionMs);
+    return true;
+}
+
+void PlaybackEngine::setNext(const QString &name, float gain)
+{
+    syncDecks();
+    PlaybackDeck *deck = nextDeck();
+    if (m_released) {
+        return;
+    }
+    if (name.isEmpty()) {
+        deck->unload();
+        m_mixer->setNext(StreamPtr());
+        return;
+    }
+    if (deck->name() == name && deck->isFresh()) {
+        deck->setGain(gain);
+    } else if (!deck->load(name, 0, gain)) {
+        m_mixer->setNext(StreamPtr());
+        return;
+    }
+    m_mixer->setNext(deck->stream());
+}
+
+void PlaybackEngine::setGain(float gain)
+{
+    syncDecks();
+    m_sourceGain = gain;
+    activeDeck()->setGain(gain);
+}
+
+QString PlaybackEngine::source() const
+{
+    return m_source;
+}
+
+PlaybackEngine::State PlaybackEngine::state() const
+{
+    return m_state;
+}
+
+qint64 PlaybackEngine::position() const
+{
+    const StreamPtr stream = activeDeck()->stream();
+    if (m_released || !stream) {
+        return m_resumePosition;
+    }
+    return (stream->startFrame + stream->consumed.load()) * 1000 / m_format.sampleRate();
+}
+
+qint64 PlaybackEngine::duration() const
+{
+    return activeDeck()->duration();
+}
+
+void PlaybackEngine::setVolume(float volume)
+{
+    m_volume = volume;
+    if (m_sink) {
+        m_sink->setVolume(volume);
+    }
+}
+
+void PlaybackEngine::setCrossfade(int msec)
+{
+    m_crossfadeMs = qBound(0, msec, 12000);
+    m_mixer->setCrossfadeFrames(qint64(m_crossfadeMs) * m_format.sampleRate() / 1000);
+    QSettings settings;
+    settings.setValue("music/crossfadeMs", m_crossfadeMs);
+}
+
+int PlaybackEngine::crossfade() const
+{
+    return m_crossfadeMs;
+}
+
+int PlaybackEngine::sampleRate() const
+{
+    return m_format.sampleRate();
+}
+
+void PlaybackEngine::addTap(const AudioTap &tap)
+{
+    if (tap && !m_mixer->addTap(tap)) {
+        qWarning() << "混音输出的分析接口已满";
+    }
+}
+
+void PlaybackEngine::removeTap(const AudioTap &tap)
+{
+    m_mixer->removeTap(tap);
+}
+
+/*
+ * 拉模式下音频输出总是把自己的缓冲区填满，混音器写入 tap 的数据要等缓冲区里已有的播完才被听到
+ */
+int PlaybackEngine::outputLatency() const
+{
+    if (!m_sink) {
+        return int(OutputBufferUs / 1000);
+    }
+    const qint64 queued = qMax<qint64>(0, m_sink->bufferSize() - m_sink->bytesFree());
+    return int(m_format.durationForBytes(queued) / 1000);
+}
+
+/*
+ * 释放：关闭音频输出，卸载两个解码器和缓冲区，只记住歌曲和进度
+ */
+void PlaybackEngine::release()
+{
+    if (m_released || m_source.isEmpty()) {
+        return;
+    }
+    m_resumePosition = position();
+    m_timer.stop();
+    if (m_sink) {
+        m_sink->stop();
+        delete m_sink;
+        m_sink = nullptr;
+    }
+    m_mixer->setStreams(StreamPtr(), StreamPtr());
+    m_decks[0]->unload();
+    m_decks[1]->unload();
+    m_released = true;
+    if (m_state == PlayingState) {
+        setState(PausedState);
+    }
+}
+
+void PlaybackEngine::play()
+{
+    if (m_source.isEmpty()) {
+        return;
+    }
+    if (m_released && !load(m_source, m_resumePosition, m_sourceGain)) {
+        return;
+    }
+    if (m_mixer->isDrained()) {
+        load(m_source, 0, m_sourceGain);//播完后再按播放从头开始
+    }
+    ensureOutput();
+    m_timer.start();
+    setState(PlayingState);
+}
+
+void PlaybackEngine::pause()
+{
+    if (m_state != PlayingState) {
+        return;
+    }
+    if (m_sink) {
+        m_sink->suspend();
+    }
+    m_timer.stop();
+    setState(PausedState);
+    emit positionChanged(position());
+}
+
+void PlaybackEngine::stop()
+{
+    if (m_sink) {
+        m_sink->suspend();
+    }
+    m_timer.stop();
+    if (!m_source.isEmpty() && !m_released) {
+        load(m_source, 0, m_sourceGain);
+    }
+    setState(StoppedState);
+}
+
+/*
+ * 跳转：当前解码器从头解码并丢弃目标位置之前的数据，已经预先打开的下一首保持不变
+ * （QAudioDecoder 不能定位，跳得越靠后等得越久），所以进度条只在松开时调用一次
+ */
+void PlaybackEngine::setPosition(qint64 msec)
+{
+    if (m_source.isEmpty()) {
+        return;
+    }
+    if (m_released) {
+        m_resumePosition = msec;
+        emit positionChanged(msec);
+        return;
+    }
+    syncDecks();
+    if (!activeDeck()->load(m_source, qMax<qint64>(0, msec), m_sourceGain)) {
+        return;
+    }
+    m_mixer->setStreams(activeDeck()->stream(), nextDeck()->isFresh() ? nextDeck()->stream() : StreamPtr());
+    m_lastPosition = msec;
+    emit positionChanged(msec);
+}
+
+/*
+ * 播放时每 20ms：补充两个解码器的缓冲区，跟上混音器的换歌，按一定间隔通知进度
+ */
+void PlaybackEngine::tick()
+{
+    m_decks[0]->pump();
+    m_decks[1]->pump();
+    syncDecks();
+    m_mixer->releaseRetired();
+
+    if (m_state == PlayingState && m_mixer->isDrained()) {
+        if (m_sink) {
+            m_sink->suspend();
+        }
+        m_timer.stop();
+        setState(StoppedState);
+        return;
+    }
+    const qint64 now = position();
+    if (qAbs(now - m_lastPosition) >= PositionStepMs) {
+        m_lastPosition = now;
+        emit positionChanged(now);
+    }
+}
+
+void PlaybackEngine::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        emit stateChanged(state);
+    }
+}
+
+/*
+ * 混音器已经换到下一首的缓冲区时，对应的解码器成为当前解码器，原来的卸载
+ */
+void PlaybackEngine::syncDecks()
+{
+    const StreamPtr current = m_mixer->current();
+    if (!current || current == activeDeck()->stream() || current != nextDeck()->stream()) {
+        return;
+    }
+    activeDeck()->unload();
+    m_active = 1 - m_active;
+    m_source = activeDeck()->name();
+    m_sourceGain = activeDeck()->gain();
+    m_lastPosition = -PositionStepMs;
+    emit durationChanged(activeDeck()->duration());
+    emit advanced(m_source);
+}
+
+void PlaybackEngine::ensureOutput()
+{
+    if (!m_sink) {
+        m_sink = new QAudioSink(QMediaDevices::defaultAudioOutput(), m_format, this);
+        m_sink->setBufferSize(m_format.bytesForDuration(OutputBufferUs));//切歌和暂停的响应更快
+        m_sink->setVolume(m_volume);
+        // 音频线程里不再分配：后端实际的缓冲区可能比请求的大，至少留半秒
+        m_mixer->reserve(qMax<qint64>(m_format.framesForBytes(m_sink->bufferSize()), m_format.sampleRate() / 2));
+        m_sink->start(m_mixer);
+    } else if (m_sink->state() == QAudio::SuspendedState) {
+        m_sink->resume();
+    } else if (m_sink->state() == QAudio::StoppedState) {
+        m_sink->start(m_mixer);
+    }
+}
+
+PlaybackDeck *PlaybackEngine::activeDeck() const
+{
+    return m_decks[m_active];
+}
+
+PlaybackDeck *PlaybackEngine::nextDeck() const
+{
+    return m_decks[1 - m_active];
+}
@@ -0,0 +1,223 @@
+#ifndef PLAYBACKENGINE_H
+#define PLAYBACKENGINE_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <QTimer>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "audioringbuffer.h"
+
+class QAudioDecoder;
+class QAudioBuffer;
+class QAudioSink;
+
+/*
+ * PlaybackStream：一首歌解码后的PCM（输出采样率的交错立体声浮点）
+ *
+ * 解码在界面线程写入，混音在音频线程读取，中间只隔一个无锁环形缓冲区。
+ */
+struct PlaybackStream
+{
+    explicit PlaybackStream(std::size_t capacity) : ring(capacity) {}
+
+    AudioRingBuffer<float> ring;
+    std::atomic<bool> ended{false};//解码完毕且全部写入了缓冲区
+    std::atomic<qint64> consumed{0};//混音器已经取走的帧数
+    std::atomic<qint64> totalFrames{0};//按时长估算的总帧数，未知时为0
+    std::atomic<float> gain{1.0f};//响度均衡的增益（线性），混音时乘上
+    qint64 startFrame = 0;//跳转后从这一帧开始
+    qint64 fadePos = 0;//作为下一首淡入了多少帧（只在音频线程使用）
+};
+typedef std::shared_ptr<PlaybackStream> StreamPtr;
+
+/*
+ * PlaybackDeck：一个解码器
+ *
+ * 把 QAudioDecoder 的输出转换成混音格式写入 PlaybackStream。缓冲区放不下时不再取数据，
+ * 解码器随之停下，所以预先打开的下一首只解码开头几秒。
+ */
+class PlaybackDeck : public QObject
+{
+    Q_OBJECT
+public:
+    PlaybackDeck(const QAudioFormat &format, QObject *parent = nullptr);
+    ~PlaybackDeck();
+
+    bool load(const QString &name, qint64 startMs, float gain = 1.0f);//name：资源包中的名称或本地文件的绝对路径
+    void setGain(float gain);
+    void unload();
+    void pump();//把解码好的数据搬进缓冲区
+
+    QString name() const;
+    float gain() const;
+    StreamPtr stream() const;
+    bool isFresh() const;//从头开始且还没被播放过
+    qint64 duration() const;
+
+signals:
+    void durationChanged(qint64 duration);
+    void failed(const QString &error);
+
+private:
+    void convert(const QAudioBuffer &buffer);
+    void writePending();
+
+    QAudioFormat m_format;
+    QAudioDecoder *m_decoder;
+    QIODevice *m_device;//资源包中的歌曲
+    QString m_name;
+    float m_gain;
+    StreamPtr m_stream;
+    qint64 m_duration;
+    qint64 m_skip;//跳转时还要丢弃的帧数
+    bool m_finished;
+    double m_phase;//重采样的小数位置
+    float m_previous[2];//上一块的最后一帧（跨块插值用）
+    std::vector<float> m_input;
+    std::vector<float> m_pending;//缓冲区放不下的部分
+    std::size_t m_pendingOffset;
+};
+
+/*
+ * PlaybackMixer：音频输出以拉模式读取的混音设备
+ *
+ * 当前歌曲读完立即接着读下一首（同一次回调内，没有间隙）；设置了淡入淡出时，
+ * 在当前歌曲的最后几秒按等功率曲线同时混入下一首。读不到数据时补静音，输出不会中断。
+ *
+ * 音频线程不加锁、不分配内存、不释放任何东西：歌曲和 tap 由界面线程打包成一个只读的路由，
+ * 通过原子指针发布；音频线程每次回调开始时取一份并标记为正在使用，
+ * 换下来的旧路由留在界面线程，等音频线程不再使用后在界面线程释放。
+ */
+class PlaybackMixer : public QIODevice
+{
+    Q_OBJECT
+public:
+    PlaybackMixer(const QAudioFormat &format, QObject *parent = nullptr);
+    ~PlaybackMixer();
+
+    void setStreams(const StreamPtr &current, const StreamPtr &next);
+    void setNext(const StreamPtr &next);
+    // 混音结果另外写一份到每个 tap（频谱、节拍分析），写不下时丢弃。最多 MaxTaps 个
+    bool addTap(const AudioTap &tap);
+    void removeTap(const AudioTap &tap);
+    StreamPtr current() const;
+    void setCrossfadeFrames(qint64 frames);
+    bool isDrained() const;//当前歌曲已经播完且没有下一首
+    void reserve(qint64 frames);//按音频输出的缓冲区大小预先分配混音缓冲区，只在输出停止时调用
+    void releaseRetired();//释放音频线程已经不再使用的旧路由（界面线程定期调用）
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    static const int MaxTaps = 4;
+    struct Route
+    {
+        StreamPtr current;
+        StreamPtr next;
+        AudioTap taps[MaxTaps];
+        std::atomic<bool> advanced{false};//音频线程已经从 current 换到了 next（只由音频线程写）
+    };
+
+    Route *editRoute() const;//复制当前路由（音频线程已经换过歌时按换过之后的），界面线程修改后再发布
+    void publish(Route *route);
+    Route *acquire();
+    void mix(Route *route, float *out, qint64 frames);
+    bool advance(Route *route, PlaybackStream **current, PlaybackStream **next);
+
+    QAudioFormat m_format;
+    std::atomic<Route *> m_route;//界面线程写，音频线程读
+    std::atomic<Route *> m_hazard;//音频线程正在使用的路由，界面线程不能释放它
+    std::vector<Route *> m_retired;//换下来的旧路由（只在界面线程访问）
+    std::atomic<qint64> m_fadeFrames;
+    std::atomic<bool> m_drained;
+    std::vector<float> m_mix;//预先分配，音频线程只用不扩
+    std::vector<float> m_fadeOut;
+};
+
+/*
+ * PlaybackEngine：无缝衔接/淡入淡出的播放引擎
+ *
+ * 两个解码器混到同一个音频输出：当前歌曲播放时，下一首已经在另一个解码器里打开并解码了开头，
+ * 切歌（自动或手动）只是换一个指针，不需要在界面线程重新打开和探测文件。
+ * 淡入淡出时长由配置项 music/crossfadeMs 设置，0 为无缝衔接。
+ * 每首歌可以带一个增益（响度均衡），在混音时乘上，不增加任何延迟。
+ */
+class PlaybackEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum State {
+        StoppedState,
+        PlayingState,
+        PausedState
+    };
+    Q_ENUM(State)
+
+    explicit PlaybackEngine(QObject *parent = nullptr);
+    ~PlaybackEngine();
+
+    bool load(const QString &name, qint64 positionMs = 0, float gain = 1.0f);//换到这首歌，保持播放/暂停状态
+    void setNext(const QString &name, float gain = 1.0f);//预先打开下一首
+    void setGain(float gain);//修改当前歌曲的增益，立即生效
+    QString source() const;
+    State state() const;
+    qint64 position() const;
+    qint64 duration() const;
+    void setVolume(float volume);
+    void setCrossfade(int msec);
+    int crossfade() const;
+    int sampleRate() const;//输出采样率
+    void addTap(const AudioTap &tap);
+    void removeTap(const AudioTap &tap);
+    int outputLatency() const;//写入 tap 的数据还要多久才被听到（毫秒）
+    void release();//释放音频输出、解码器和缓冲区，保留歌曲和进度，下次播放时恢复
+
+public slots:
+    void play();
+    void pause();
+    void stop();
+    void setPosition(qint64 msec);
+
+signals:
+    void stateChanged(PlaybackEngine::State state);
+    void positionChanged(qint64 position);
+    void durationChanged(qint64 duration);
+    void advanced(const QString &name);//当前歌曲播完，已经接上了下一首
+    void errorOccurred(const QString &error);
+
+private slots:
+    void tick();
+
+private:
+    void setState(State state);
+    void syncDecks();//混音器自己换到下一首之后，调整两个解码器的角色
+    void ensureOutput();
+    PlaybackDeck *activeDeck() const;
+    PlaybackDeck *nextDeck() const;
+
+    QAudioFormat m_format;
+    PlaybackDeck *m_decks[2];
+    int m_active;
+    PlaybackMixer *m_mixer;
+    QAudioSink *m_sink;
+    QTimer m_timer;
+    State m_state;
+    float m_volume;
+    int m_crossfadeMs;
+    QString m_source;
+    float m_sourceGain;
+    qint64 m_resumePosition;//释放后恢复的进度
+    bool m_released;
+    qint64 m_lastPosition;
+};
+
+#endif // PLAYBACKENGINE_H
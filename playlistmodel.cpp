@@ -0,0 +1,463 @@
+#include "playlistmodel.h"
+#include <QCollator>
+#include <algorithm>
+#include <numeric>
+#include <climits>
+
+namespace {
+
+const int ArrangeDelayMs = 100;
+
+} // namespace
+
+// ==================== PlaylistArranger ====================
+
+PlaylistArranger::PlaylistArranger(QObject *parent)
+    : QObject{parent}
+    , m_latest(0)
+    , m_rankEpoch(-1)
+{
+}
+
+void PlaylistArranger::supersede(int generation)
+{
+    m_latest.storeRelaxed(generation);
+}
+
+void PlaylistArranger::run(const PlaylistQuery &query)
+{
+    if (m_latest.loadRelaxed() != query.generation) {
+        return;//已经有更新的请求
+    }
+    const QVector<int> rows = arrange(query);
+    if (m_latest.loadRelaxed() == query.generation) {
+        emit finished(query.generation, rows);
+    }
+}
+
+/*
+ * 筛选（标题、艺术家、专辑中任一包含关键字，不区分大小写）后排序
+ *
+ * @return 按显示顺序排列的歌曲编号
+ */
+QVector<int> PlaylistArranger::arrange(const PlaylistQuery &query)
+{
+    // 每个字符串只匹配一次：-1 未匹配，0 不包含，1 包含
+    QVector<qint8> matches;
+    const bool filtering = !query.filter.isEmpty();
+    if (filtering) {
+        matches.fill(-1, query.strings.size());
+    }
+    auto accepted = [&](int track) {
+        if (!filtering) {
+            return true;
+        }
+        for (int id : {query.title.at(track), query.artist.at(track), query.album.at(track)}) {
+            qint8 &match = matches[id];
+            if (match < 0) {
+                match = query.strings.at(id).contains(query.filter, Qt::CaseInsensitive) ? 1 : 0;
+            }
+            if (match) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    QVector<int> rows;
+    if (query.incremental) {
+        // 关键字变长时结果只会变少，只在上次的结果里找，顺序不变
+        rows.reserve(query.candidates.size());
+        for (int track : query.candidates) {
+            if (track < query.title.size() && accepted(track)) {
+                rows.append(track);
+            }
+        }
+        return rows;
+    }
+    const int count = query.title.size();
+    rows.reserve(count);
+    for (int track = 0; track < count; ++track) {
+        if (accepted(track)) {
+            rows.append(track);
+        }
+    }
+    if (query.sortKey == PlaylistQuery::SortNone) {
+        return rows;
+    }
+
+    const QVector<int> &rank = ranks(query);
+    const QVector<int> *primary = &query.title;
+    const QVector<int> *secondary = &query.artist;
+    if (query.sortKey == PlaylistQuery::SortArtist) {
+        primary = &query.artist;
+        secondary = &query.album;
+    } else if (query.sortKey == PlaylistQuery::SortAlbum) {
+        primary = &query.album;
+        secondary = nullptr;//同一专辑保持加入的顺序（通常即曲目顺序）
+    }
+    std::stable_sort(rows.begin(), rows.end(), [&](int a, int b) {
+        const int ra = rank.at(primary->at(a));
+        const int rb = rank.at(primary->at(b));
+        if (ra != rb) {
+            return ra < rb;
+        }
+        return secondary && rank.at(secondary->at(a)) < rank.at(secondary->at(b));
+    });
+    return rows;
+}
+
+/*
+ * 字符串池中每个字符串的排序名次（按本地习惯排序，数字按数值比较），空字符串排在最后
+ */
+const QVector<int> &PlaylistArranger::ranks(const PlaylistQuery &query)
+{
+    if (m_rankEpoch == query.poolEpoch && m_ranks.size() == query.strings.size()) {
+        return m_ranks;
+    }
+    const QVector<QString> &strings = query.strings;
+    QVector<int> order(strings.size());
+    std::iota(order.begin(), order.end(), 0);
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return collator.compare(strings.at(a), strings.at(b)) < 0;
+    });
+    m_ranks.resize(strings.size());
+    for (int i = 0; i < order.size(); ++i) {
+        m_ranks[order.at(i)] = strings.at(order.at(i)).isEmpty() ? INT_MAX : i;
+    }
+    m_rankEpoch = query.poolEpoch;
+    return m_ranks;
+}
+
+// ==================== PlaylistModel ====================
+
+/*
+ * PlaylistModel 构造函数
+ *
+ * 筛选排序的工作线程随模型创建，优先级较低
+ */
+PlaylistModel::PlaylistModel(QObject *parent)
+    : QAbstractListModel{parent}
+    , m_poolEpoch(0)
+    , m_revision(0)
+    , m_sortKey(PlaylistQuery::SortNone)
+    , m_appliedSortKey(PlaylistQuery::SortNone)
+    , m_appliedRevision(0)
+    , m_pendingSortKey(PlaylistQuery::SortNone)
+    , m_pendingRevision(0)
+    , m_arranger(new PlaylistArranger)
+    , m_generation(0)
+{
+    qRegisterMetaType<PlaylistQuery>();
+    m_arranger->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_arranger, &QObject::deleteLater);
+    connect(this, &PlaylistModel::requestArrange, m_arranger, &PlaylistArranger::run);
+    connect(m_arranger, &PlaylistArranger::finished, this, &PlaylistModel::onArranged);
+    m_workerThread.start(QThread::LowPriority);
+
+    m_arrangeTimer.setSingleShot(true);
+    m_arrangeTimer.setInterval(ArrangeDelayMs);
+    connect(&m_arrangeTimer, &QTimer::timeout, this, &PlaylistModel::arrange);
+}
+
+PlaylistModel::~PlaylistModel()
+{
+    m_arranger->supersede(-1);
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+int PlaylistModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+/*
+ * 显示文字只为可见的行生成，不为每首歌保存
+ */
+QVariant PlaylistModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    const int track = m_rows.at(index.row());
+    if (role == Qt::DisplayRole) {
+        const QString &artist = m_strings.at(m_artist.at(track));
+        return artist.isEmpty() ? QString("🎵 %1").arg(m_strings.at(m_title.at(track)))
+                                : QString("🎵 %1 - %2").arg(m_strings.at(m_title.at(track)), artist);
+    }
+    if (role == Qt::ToolTipRole) {
+        return m_paths.at(track);
+    }
+    return QVariant();
+}
+
+void PlaylistModel::clear()
+{
+    beginResetModel();
+    m_strings.clear();
+    m_stringIds.clear();
+    ++m_poolEpoch;
+    m_title.clear();
+    m_artist.clear();
+    m_album.clear();
+    m_paths.clear();
+    m_pathIds.clear();
+    m_rows.clear();
+    m_rowOfTrack.clear();
+    ++m_revision;
+    m_appliedFilter = m_filter;//空列表对任何条件都成立
+    m_appliedSortKey = m_sortKey;
+    m_appliedRevision = m_revision;
+    m_arranger->supersede(++m_generation);
+    m_arrangeTimer.stop();
+    endResetModel();
+}
+
+/*
+ * 追加歌曲：没有筛选和排序时直接追加在末尾，否则稍后在后台重新筛选
+ */
+void PlaylistModel::appendTracks(const QVector<PlaylistEntry> &entries)
+{
+    if (entries.isEmpty()) {
+        return;
+    }
+    const int first = m_title.size();
+    const int total = first + entries.size();
+    m_title.reserve(total);
+    m_artist.reserve(total);
+    m_album.reserve(total);
+    m_paths.reserve(total);
+    for (const PlaylistEntry &entry : entries) {
+        m_pathIds.insert(entry.path, m_paths.size());
+        m_title.append(intern(entry.title));
+        m_artist.append(intern(entry.artist));
+        m_album.append(intern(entry.album));
+        m_paths.append(entry.path);
+    }
+    m_rowOfTrack.resize(total, -1);
+
+    const bool current = m_appliedRevision == m_revision;
+    ++m_revision;
+    if (isIdentity() && current) {
+        beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + entries.size() - 1);
+        for (int track = first; track < total; ++track) {
+            m_rowOfTrack[track] = m_rows.size();
+            m_rows.append(track);
+        }
+        m_appliedRevision = m_revision;
+        endInsertRows();
+        return;
+    }
+    m_arrangeTimer.start();
+}
+
+/*
+ * 只保留前 count 首（曲库重建时移除曲库部分）。字符串池不回收，下次加入时复用
+ */
+void PlaylistModel::truncate(int count)
+{
+    if (count >= trackCount()) {
+        return;
+    }
+    count = qMax(0, count);
+    beginResetModel();
+    for (int track = count; track < m_paths.size(); ++track) {
+        m_pathIds.remove(m_paths.at(track));
+    }
+    m_title.resize(count);
+    m_artist.resize(count);
+    m_album.resize(count);
+    m_paths.resize(count);
+    m_rows.erase(std::remove_if(m_rows.begin(), m_rows.end(), [count](int track) { return track >= count; }), m_rows.end());
+    resetRows();
+    const bool current = m_appliedRevision == m_revision;
+    ++m_revision;
+    if (current) {
+        m_appliedRevision = m_revision;//剩下的行顺序不变，结果仍然成立
+    }
+    endResetModel();
+    if (!current) {
+        arrange();
+    }
+}
+
+void PlaylistModel::setTrackText(int track, const QString &title, const QString &artist, const QString &album)
+{
+    if (track < 0 || track >= trackCount()) {
+        return;
+    }
+    m_title[track] = intern(title);
+    m_artist[track] = intern(artist);
+    m_album[track] = intern(album);
+    const bool current = m_appliedRevision == m_revision;
+    ++m_revision;
+    const int row = rowOf(track);
+    if (row >= 0) {
+        emit dataChanged(index(row), index(row), {Qt::DisplayRole});
+    }
+    if (isIdentity() && current) {
+        m_appliedRevision = m_revision;
+    } else {
+        m_arrangeTimer.start();
+    }
+}
+
+int PlaylistModel::trackCount() const
+{
+    return m_paths.size();
+}
+
+QString PlaylistModel::title(int track) const
+{
+    return track >= 0 && track < trackCount() ? m_strings.at(m_title.at(track)) : QString();
+}
+
+QString PlaylistModel::path(int track) const
+{
+    return track >= 0 && track < trackCount() ? m_paths.at(track) : QString();
+}
+
+int PlaylistModel::findPath(const QString &path) const
+{
+    return m_pathIds.value(path, -1);
+}
+
+int PlaylistModel::trackAt(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows.at(row) : -1;
+}
+
+int PlaylistModel::rowOf(int track) const
+{
+    return track >= 0 && track < m_rowOfTrack.size() ? m_rowOfTrack.at(track) : -1;
+}
+
+int PlaylistModel::neighbour(int track, int step) const
+{
+    const int count = trackCount();
+    if (count == 0) {
+        return -1;
+    }
+    const int row = rowOf(track);
+    if (row < 0) {
+        return ((track + step) % count + count) % count;
+    }
+    const int rows = m_rows.size();
+    return m_rows.at(((row + step) % rows + rows) % rows);
+}
+
+QString PlaylistModel::filter() const
+{
+    return m_filter;
+}
+
+/*
+ * 设置筛选关键字：每次按键都可以调用，只有最后一次的结果会被采用
+ */
+void PlaylistModel::setFilter(const QString &filter)
+{
+    if (m_filter == filter) {
+        return;
+    }
+    m_filter = filter;
+    arrange();
+}
+
+PlaylistQuery::SortKey PlaylistModel::sortKey() const
+{
+    return m_sortKey;
+}
+
+void PlaylistModel::setSortKey(PlaylistQuery::SortKey key)
+{
+    if (m_sortKey == key) {
+        return;
+    }
+    m_sortKey = key;
+    arrange();
+}
+
+/*
+ * 把当前条件交给后台线程。关键字只是在已显示的结果上变长时，只在当前行里继续筛选
+ */
+void PlaylistModel::arrange()
+{
+    m_arrangeTimer.stop();
+    const int generation = ++m_generation;
+    m_arranger->supersede(generation);
+    const bool current = m_appliedRevision == m_revision && m_appliedSortKey == m_sortKey;
+    if (current && m_appliedFilter == m_filter) {
+        return;//正在处理的请求被取消，当前显示的就是结果
+    }
+
+    PlaylistQuery query;
+    query.generation = generation;
+    query.poolEpoch = m_poolEpoch;
+    query.strings = m_strings;
+    query.title = m_title;
+    query.artist = m_artist;
+    query.album = m_album;
+    query.filter = m_filter;
+    query.sortKey = m_sortKey;
+    query.incremental = current && m_filter.contains(m_appliedFilter, Qt::CaseInsensitive);
+    if (query.incremental) {
+        query.candidates = m_rows;
+    }
+    m_pendingFilter = m_filter;
+    m_pendingSortKey = m_sortKey;
+    m_pendingRevision = m_revision;
+    emit requestArrange(query);
+}
+
+void PlaylistModel::onArranged(int generation, const QVector<int> &rows)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    beginResetModel();
+    m_rows = rows;
+    const int count = trackCount();
+    if (m_pendingRevision != m_revision) {
+        // 处理期间有歌曲被移除
+        m_rows.erase(std::remove_if(m_rows.begin(), m_rows.end(), [count](int track) { return track >= count; }), m_rows.end());
+    }
+    resetRows();
+    m_appliedFilter = m_pendingFilter;
+    m_appliedSortKey = m_pendingSortKey;
+    m_appliedRevision = m_pendingRevision;
+    endResetModel();
+    if (m_appliedRevision != m_revision && !m_arrangeTimer.isActive()) {
+        m_arrangeTimer.start();
+    }
+}
+
+int PlaylistModel::intern(const QString &text)
+{
+    auto it = m_stringIds.constFind(text);
+    if (it != m_stringIds.constEnd()) {
+        return it.value();
+    }
+    const int id = m_strings.size();
+    m_strings.append(text);
+    m_stringIds.insert(text, id);
+    return id;
+}
+
+bool PlaylistModel::isIdentity() const
+{
+    return m_filter.isEmpty() && m_sortKey == PlaylistQuery::SortNone
+           && m_appliedFilter.isEmpty() && m_appliedSortKey == PlaylistQuery::SortNone;
+}
+
+// 按 m_rows 重建歌曲到行的映射
+void PlaylistModel::resetRows()
+{
+    m_rowOfTrack.fill(-1, trackCount());
+    for (int row = 0; row < m_rows.size(); ++row) {
+        m_rowOfTrack[m_rows.at(row)] = row;
+    }
+}
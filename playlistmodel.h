@@ -0,0 +1,155 @@
+#ifndef PLAYLISTMODEL_H
+#define PLAYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QThread>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QMetaType>
+
+// 加入播放列表的一首歌
+struct PlaylistEntry
+{
+    QString title;
+    QString artist;
+    QString album;
+    QString path;//资源包中的名称或本地文件的绝对路径
+};
+
+/*
+ * PlaylistQuery：交给后台线程的一次筛选/排序
+ *
+ * 各列都是隐式共享的 QVector，复制只增加引用计数。
+ */
+struct PlaylistQuery
+{
+    enum SortKey {
+        SortNone,//加入的顺序
+        SortTitle,
+        SortArtist,//艺术家，其次专辑
+        SortAlbum
+    };
+
+    int generation = 0;
+    int poolEpoch = 0;//字符串池被清空过几次，用于判断排序名次缓存是否还能用
+    QVector<QString> strings;//字符串池
+    QVector<int> title;//每首歌各列在字符串池中的编号
+    QVector<int> artist;
+    QVector<int> album;
+    bool incremental = false;//只在 candidates 里继续筛选（保持其顺序，不再排序），否则筛选全部歌曲并排序
+    QVector<int> candidates;
+    QString filter;
+    SortKey sortKey = SortNone;
+};
+Q_DECLARE_METATYPE(PlaylistQuery)
+
+/*
+ * PlaylistArranger：在后台线程中筛选和排序
+ *
+ * 字符串先按去重后的字符串池处理：每个字符串只匹配一次、只参与一次排序得到名次，
+ * 再按整数名次给歌曲排序。字符串池只增不减，名次在池没有变化时沿用。
+ */
+class PlaylistArranger : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PlaylistArranger(QObject *parent = nullptr);
+
+    QVector<int> arrange(const PlaylistQuery &query);//可直接调用（同步）
+    void supersede(int generation);//可在任意线程调用：编号不是 generation 的请求直接丢弃
+
+public slots:
+    void run(const PlaylistQuery &query);
+
+signals:
+    void finished(int generation, const QVector<int> &rows);
+
+private:
+    const QVector<int> &ranks(const PlaylistQuery &query);
+
+    QAtomicInt m_latest;
+    int m_rankEpoch;
+    QVector<int> m_ranks;//字符串池编号 → 排序名次
+};
+
+/*
+ * PlaylistModel：虚拟化的播放列表
+ *
+ * 歌曲按列存放：标题、艺术家、专辑是字符串池中的整数编号，每首歌只占几个int，
+ * 显示文字在绘制可见行时才生成。歌曲以加入的顺序编号（track），
+ * 行（row）是筛选排序之后的位置；筛选和排序在后台线程完成后一次替换。
+ */
+class PlaylistModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit PlaylistModel(QObject *parent = nullptr);
+    ~PlaylistModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void clear();
+    void appendTracks(const QVector<PlaylistEntry> &entries);
+    void truncate(int count);//只保留前 count 首
+    void setTrackText(int track, const QString &title, const QString &artist, const QString &album);
+
+    int trackCount() const;
+    QString title(int track) const;
+    QString path(int track) const;
+    int findPath(const QString &path) const;//-1 表示不在列表中
+
+    int trackAt(int row) const;
+    int rowOf(int track) const;//被筛选掉时为 -1
+    int neighbour(int track, int step) const;//按显示顺序的上一首/下一首，被筛选掉时按加入的顺序
+
+    QString filter() const;
+    void setFilter(const QString &filter);
+    PlaylistQuery::SortKey sortKey() const;
+    void setSortKey(PlaylistQuery::SortKey key);
+
+signals:
+    void requestArrange(const PlaylistQuery &query);
+
+private slots:
+    void arrange();
+    void onArranged(int generation, const QVector<int> &rows);
+
+private:
+    int intern(const QString &text);
+    bool isIdentity() const;//没有筛选和排序
+    void resetRows();
+
+    // 歌曲表
+    QVector<QString> m_strings;
+    QHash<QString, int> m_stringIds;
+    int m_poolEpoch;
+    QVector<int> m_title;
+    QVector<int> m_artist;
+    QVector<int> m_album;
+    QVector<QString> m_paths;//和曲库中的路径共享数据
+    QHash<QString, int> m_pathIds;
+    int m_revision;//歌曲表每次变化加一
+
+    // 当前显示
+    QVector<int> m_rows;//行 → 歌曲
+    QVector<int> m_rowOfTrack;//歌曲 → 行
+    QString m_filter;
+    PlaylistQuery::SortKey m_sortKey;
+    QString m_appliedFilter;//m_rows 对应的筛选条件和歌曲表版本
+    PlaylistQuery::SortKey m_appliedSortKey;
+    int m_appliedRevision;
+    QString m_pendingFilter;//后台线程正在处理的请求
+    PlaylistQuery::SortKey m_pendingSortKey;
+    int m_pendingRevision;
+
+    QThread m_workerThread;
+    PlaylistArranger *m_arranger;
+    QTimer m_arrangeTimer;//扫描时歌曲陆续加入，合并成一次重新筛选
+    int m_generation;
+};
+
+#endif // PLAYLISTMODEL_H
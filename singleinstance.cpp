@@ -0,0 +1,176 @@
+#include "singleinstance.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDebug>
+
+namespace {
+
+const int MaxLineLength = 64 * 1024;//一条命令的上限，超过时断开
+const QStringList PlainCommands = {"show", "play", "pause", "toggle", "next", "prev", "chat", "music", "quit"};
+const QStringList ArgumentCommands = {"say", "ask"};
+
+} // namespace
+
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject{parent}
+    , m_server(new QLocalServer(this))
+{
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+}
+
+/*
+ * 套接字名称带上用户名：多个用户同时登录时各自有一只桌宠
+ */
+QString SingleInstance::serverName()
+{
+    QString user = qEnvironmentVariable("USER");
+    if (user.isEmpty()) {
+        user = qEnvironmentVariable("USERNAME");
+    }
+    return QStringLiteral("AIMew.Petmiao.") + user;
+}
+
+bool SingleInstance::isCommand(const QString &name)
+{
+    return PlainCommands.contains(name) || ArgumentCommands.contains(name);
+}
+
+bool SingleInstance::hasArgument(const QString &name)
+{
+    return ArgumentCommands.contains(name);
+}
+
+/*
+ * 命令行：没有命令时是 show；--say、--ask 之后的所有参数连成一句话。
+ * 不认识的参数（-platform、--style fusion 等Qt自己的选项）原样留给 QApplication，
+ * 所以拼错的命令不会报错，而是当作没有命令
+ */
+bool SingleInstance::parseArguments(const QStringList &arguments, Command *command, QString *error)
+{
+    command->name = QStringLiteral("show");
+    command->argument.clear();
+    int first = 0;
+    while (first < arguments.size()
+           && !(arguments.at(first).startsWith("--") && isCommand(arguments.at(first).mid(2)))) {
+        ++first;
+    }
+    if (first == arguments.size()) {
+        return true;
+    }
+    const QString option = arguments.at(first);
+    const QString name = option.mid(2);
+    command->name = name;
+    if (hasArgument(name)) {
+        command->argument = arguments.mid(first + 1).join(' ').simplified();//协议按行分隔，换行变成空格
+        if (command->argument.isEmpty()) {
+            *error = QString("%1 需要一段文字").arg(option);
+            return false;
+        }
+        return true;
+    }
+    for (int i = first + 1; i < arguments.size(); ++i) {
+        const QString extra = arguments.at(i);
+        if (extra.startsWith("--") && isCommand(extra.mid(2))) {
+            *error = QString("一次只能执行一个命令: %1").arg(extra);
+            return false;
+        }
+    }
+    return true;
+}
+
+QString SingleInstance::usage()
+{
+    return QStringLiteral("用法: Petmiao [--show | --play | --pause | --toggle | --next | --prev | --chat | --music | --quit]\n"
+                          "       Petmiao --say 文本\n"
+                          "       Petmiao --ask 问题\n"
+                          "桌宠已经在运行时，命令交给正在运行的桌宠执行。\n"
+                          "其他参数（如 --platform、--style）交给Qt处理。\n");
+}
+
+/*
+ * 只用阻塞调用，不需要事件循环：在第二个进程创建 QApplication 之前调用
+ */
+bool SingleInstance::forward(const Command &command, QString *reply, int timeoutMs)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(timeoutMs)) {
+        return false;//没有正在运行的实例（或者它已经不响应）
+    }
+    QByteArray line = command.name.toUtf8();
+    if (!command.argument.isEmpty()) {
+        line += ' ' + command.argument.toUtf8();
+    }
+    socket.write(line + '\n');
+    if (!socket.waitForBytesWritten(timeoutMs)) {
+        *reply = QStringLiteral("error 发送失败");
+        return true;
+    }
+    while (!socket.canReadLine() && socket.waitForReadyRead(timeoutMs)) {
+    }
+    *reply = socket.canReadLine() ? QString::fromUtf8(socket.readLine()).trimmed() : QStringLiteral("error 没有回复");
+    socket.disconnectFromServer();
+    return true;
+}
+
+/*
+ * 名称被占用时，可能是上次崩溃留下的套接字文件，也可能是另一个实例刚刚启动：
+ * 连得上说明有实例在运行，不抢它的名称；连不上才删掉重新监听
+ */
+bool SingleInstance::listen()
+{
+    const QString name = serverName();
+    if (m_server->listen(name)) {
+        return true;
+    }
+    if (m_server->serverError() == QAbstractSocket::AddressInUseError) {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(500)) {
+            qWarning() << "另一个实例正在运行，不接收远程命令";
+            return false;
+        }
+        QLocalServer::removeServer(name);
+        if (m_server->listen(name)) {
+            return true;
+        }
+    }
+    qWarning() << "无法监听本地套接字:" << name << m_server->errorString();
+    return false;
+}
+
+void SingleInstance::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        if (socket->bytesAvailable() > 0) {
+            onReadyRead(socket);
+        }
+    }
+}
+
+void SingleInstance::onReadyRead(QLocalSocket *socket)
+{
+    while (socket->canReadLine()) {
+        const QString line = QString::fromUtf8(socket->readLine()).trimmed();
+        const int space = line.indexOf(' ');
+        const QString name = space < 0 ? line : line.left(space);
+        const QString argument = space < 0 ? QString() : line.mid(space + 1).trimmed();
+        if (!isCommand(name)) {
+            socket->write("error unknown command\n");
+        } else if (hasArgument(name) && argument.isEmpty()) {
+            socket->write("error missing argument\n");
+        } else {
+            socket->write("ok\n");//先回复，发送方不必等命令执行完
+            socket->flush();
+            emit commandReceived(name, argument);
+        }
+    }
+    if (socket->bytesAvailable() > MaxLineLength) {
+        socket->abort();
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+
+/*
+ * SingleInstance：单实例和远程控制
+ *
+ * 第一个启动的进程监听一个本地套接字（按用户区分，只有当前用户能连接）。之后再启动时，
+ * 在创建 QApplication 和读取资源之前先连过去，把命令行转成一条命令交给正在运行的桌宠，
+ * 收到回复后立即退出，不再启动第二只桌宠。脚本和快捷键也可以这样控制正在运行的桌宠。
+ *
+ * 协议：每条命令一行 UTF-8 文本 "命令 参数\n"，回复一行 "ok" 或 "error 原因"。
+ *   show              显示桌宠（没有参数时的默认命令）
+ *   play/pause/toggle 播放、暂停、切换播放状态
+ *   next/prev         下一首、上一首
+ *   say 文本          让猫猫说一句话
+ *   ask 问题          向AI提问，回答显示在聊天窗口
+ *   chat/music        打开聊天窗口、音乐播放器
+ *   quit              退出
+ * 命令行写作 --play、--say 文本 等。
+ */
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+public:
+    struct Command
+    {
+        QString name;
+        QString argument;
+    };
+
+    explicit SingleInstance(QObject *parent = nullptr);
+
+    static QString serverName();
+    static bool isCommand(const QString &name);
+    static bool hasArgument(const QString &name);
+    static bool parseArguments(const QStringList &arguments, Command *command, QString *error);//arguments 不含程序名
+    static QString usage();
+    // 把命令交给正在运行的实例，不需要 QApplication；没有正在运行的实例时返回 false
+    static bool forward(const Command &command, QString *reply, int timeoutMs = 2000);
+
+    bool listen();//开始接收命令；另一个实例刚刚抢先启动时返回 false，调用方再 forward() 一次
+
+signals:
+    void commandReceived(const QString &name, const QString &argument);
+
+private slots:
+    void onNewConnection();
+
+private:
+    void onReadyRead(QLocalSocket *socket);
+
+    QLocalServer *m_server;
+};
+
+#endif // SINGLEINSTANCE_H
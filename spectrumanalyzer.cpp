@@ -0,0 +1,210 @@
+#include "spectrumanalyzer.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+const int FftSize = 2048;//48kHz 时约43ms，频率分辨率约23Hz
+const int AnalyzeMs = 16;
+const double MinFrequency = 40.0;
+const double MaxFrequency = 16000.0;
+const float FloorDb = -60.0f;//低于这个电平的柱高为0
+const float Decay = 0.88f;//每帧回落的比例
+const std::size_t ReadChunk = 4096;
+
+} // namespace
+
+// ==================== SpectrumHandoff ====================
+
+SpectrumFrame &SpectrumHandoff::back()
+{
+    return m_frames[m_back];
+}
+
+void SpectrumHandoff::publish()
+{
+    m_back = m_middle.exchange(m_back | Fresh, std::memory_order_acq_rel) & ~Fresh;
+}
+
+bool SpectrumHandoff::fetch()
+{
+    if (!(m_middle.load(std::memory_order_acquire) & Fresh)) {
+        return false;
+    }
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~Fresh;
+    return true;
+}
+
+const SpectrumFrame &SpectrumHandoff::front() const
+{
+    return m_frames[m_front];
+}
+
+// ==================== SpectrumWorker ====================
+
+SpectrumWorker::SpectrumWorker(const AudioTap &tap, int sampleRate, SpectrumHandoff *handoff, QObject *parent)
+    : QObject{parent}
+    , m_tap(tap)
+    , m_handoff(handoff)
+    , m_timer(nullptr)
+    , m_fft(FftSize)
+    , m_stopping(false)
+    , m_window(Fft::hannWindow(FftSize))
+    , m_history(FftSize, 0.0f)
+    , m_historyPos(0)
+    , m_input(ReadChunk)
+    , m_re(FftSize)
+    , m_im(FftSize)
+    , m_bandEdges(SpectrumFrame::Bars + 1)
+{
+    // 柱子按对数频率均分，低频每组至少一个频点
+    const double rate = sampleRate > 0 ? sampleRate : 48000;
+    const double top = std::min(MaxFrequency, rate / 2);
+    const int lastBin = FftSize / 2;
+    for (int b = 0; b <= SpectrumFrame::Bars; ++b) {
+        const double frequency = MinFrequency * std::pow(top / MinFrequency, double(b) / SpectrumFrame::Bars);
+        int bin = int(std::lround(frequency * FftSize / rate));
+        if (b > 0) {
+            bin = std::max(bin, m_bandEdges[b - 1] + 1);
+        }
+        m_bandEdges[b] = std::min(std::max(bin, 1), lastBin);
+    }
+    std::fill(std::begin(m_levels), std::end(m_levels), 0.0f);
+}
+
+void SpectrumWorker::start()
+{
+    m_stopping = false;
+    m_tap->clear();//丢掉上次停下时残留的数据
+    if (!m_timer) {
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        m_timer->setInterval(AnalyzeMs);
+        connect(m_timer, &QTimer::timeout, this, &SpectrumWorker::process);
+    }
+    m_timer->start();
+}
+
+void SpectrumWorker::stop()
+{
+    m_stopping = true;
+}
+
+void SpectrumWorker::process()
+{
+    if (!analyze()) {
+        m_timer->stop();
+    }
+}
+
+/*
+ * 取出上次以来的全部数据并入单声道历史，用最近 FftSize 个采样算一帧；
+ * 没有新数据时柱子按比例回落
+ */
+bool SpectrumWorker::analyze()
+{
+    const std::size_t mask = FftSize - 1;
+    std::size_t frames = 0;
+    for (;;) {
+        const std::size_t got = m_tap->read(m_input.data(), m_input.size());
+        for (std::size_t i = 0; i + 1 < got; i += 2) {
+            m_history[m_historyPos] = 0.5f * (m_input[i] + m_input[i + 1]);
+            m_historyPos = (m_historyPos + 1) & mask;
+        }
+        frames += got / 2;
+        if (got < m_input.size()) {
+            break;
+        }
+    }
+
+    if (frames > 0) {
+        for (int i = 0; i < FftSize; ++i) {
+            m_re[i] = m_history[(m_historyPos + i) & mask] * m_window[i];
+            m_im[i] = 0.0f;
+        }
+        m_fft.transform(m_re.data(), m_im.data());
+        const float scale = 4.0f / FftSize;//Hann 窗下满幅正弦波的峰值为 FftSize/4
+        for (int b = 0; b < SpectrumFrame::Bars; ++b) {
+            float power = 0.0f;
+            for (int k = m_bandEdges[b]; k < std::max(m_bandEdges[b + 1], m_bandEdges[b] + 1); ++k) {
+                power = std::max(power, m_re[k] * m_re[k] + m_im[k] * m_im[k]);
+            }
+            const float db = 10.0f * std::log10(power * scale * scale + 1e-12f);
+            const float level = std::clamp((db - FloorDb) / -FloorDb, 0.0f, 1.0f);
+            m_levels[b] = std::max(level, m_levels[b] * Decay);//上升立即跟上，回落平滑
+        }
+    } else {
+        for (float &level : m_levels) {
+            level *= Decay;
+        }
+    }
+
+    SpectrumFrame &frame = m_handoff->back();
+    bool visible = false;
+    for (int b = 0; b < SpectrumFrame::Bars; ++b) {
+        frame.bars[b] = m_levels[b];
+        visible = visible || m_levels[b] > 0.002f;
+    }
+    m_handoff->publish();
+    return !m_stopping || visible;
+}
+
+// ==================== SpectrumAnalyzer ====================
+
+/*
+ * SpectrumAnalyzer 构造函数
+ *
+ * @param sampleRate：播放引擎的输出采样率
+ */
+SpectrumAnalyzer::SpectrumAnalyzer(int sampleRate, QObject *parent)
+    : QObject{parent}
+    , m_tap(std::make_shared<AudioRingBuffer<float>>(std::size_t(sampleRate / 2) * 2))//约半秒
+    , m_worker(new SpectrumWorker(m_tap, sampleRate, &m_handoff))
+    , m_active(false)
+{
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &SpectrumAnalyzer::requestStart, m_worker, &SpectrumWorker::start);
+    connect(this, &SpectrumAnalyzer::requestStop, m_worker, &SpectrumWorker::stop);
+    m_workerThread.start(QThread::LowPriority);//只影响画面，不和音频输出抢CPU
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+AudioTap SpectrumAnalyzer::tap() const
+{
+    return m_tap;
+}
+
+bool SpectrumAnalyzer::isActive() const
+{
+    return m_active;
+}
+
+bool SpectrumAnalyzer::fetch()
+{
+    return m_handoff.fetch();
+}
+
+const SpectrumFrame &SpectrumAnalyzer::frame() const
+{
+    return m_handoff.front();
+}
+
+void SpectrumAnalyzer::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+    m_active = active;
+    if (active) {
+        emit requestStart();
+    } else {
+        emit requestStop();
+    }
+    emit activeChanged(active);
+}
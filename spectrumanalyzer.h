@@ -0,0 +1,112 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "audioringbuffer.h"
+#include "fft.h"
+
+// 一帧频谱：按对数频率分组的柱高（0~1）
+struct SpectrumFrame
+{
+    static const int Bars = 32;
+    float bars[Bars] = {};
+};
+
+/*
+ * SpectrumHandoff：分析线程到界面线程的三缓冲
+ *
+ * 写方总是写自己的后台帧，写完和中间帧交换；读方有新帧时把中间帧换成自己的前台帧。
+ * 两边都不加锁、不等待，读方只会跳过帧，不会读到写了一半的帧。
+ */
+class SpectrumHandoff
+{
+public:
+    SpectrumFrame &back();//分析线程
+    void publish();//分析线程
+    bool fetch();//界面线程：有新帧时换到前台并返回 true
+    const SpectrumFrame &front() const;//界面线程
+
+private:
+    static const int Fresh = 4;
+
+    SpectrumFrame m_frames[3];
+    int m_back = 0;
+    int m_front = 1;
+    std::atomic<int> m_middle{2};
+};
+
+/*
+ * SpectrumWorker：在工作线程中按固定间隔取出混音输出，做加窗FFT并算出各组柱高
+ */
+class SpectrumWorker : public QObject
+{
+    Q_OBJECT
+public:
+    SpectrumWorker(const AudioTap &tap, int sampleRate, SpectrumHandoff *handoff, QObject *parent = nullptr);
+
+public slots:
+    void start();
+    void stop();//不再有新数据：柱子回落到0后停下
+
+private slots:
+    void process();
+
+private:
+    bool analyze();//有新数据时计算一帧，返回是否还需要继续
+
+    AudioTap m_tap;
+    SpectrumHandoff *m_handoff;
+    QTimer *m_timer;
+    Fft m_fft;
+    bool m_stopping;
+    std::vector<float> m_window;//Hann 窗
+    std::vector<float> m_history;//最近 FFT 长度个单声道采样（环形）
+    std::size_t m_historyPos;
+    std::vector<float> m_input;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<int> m_bandEdges;//每组柱子的起止频点
+    float m_levels[SpectrumFrame::Bars];
+};
+
+/*
+ * SpectrumAnalyzer：音乐频谱分析
+ *
+ * 播放引擎把混音后的输出写入 tap()（音频线程只做一次无锁写入，写不下就丢弃），
+ * 分析线程每 16ms 取一次，结果经三缓冲交给界面按屏幕刷新率绘制。
+ * 没有激活时引擎不写入，分析线程也停下。
+ */
+class SpectrumAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    SpectrumAnalyzer(int sampleRate, QObject *parent = nullptr);
+    ~SpectrumAnalyzer();
+
+    AudioTap tap() const;
+    bool isActive() const;
+    bool fetch();//界面线程：是否有新的一帧
+    const SpectrumFrame &frame() const;
+
+public slots:
+    void setActive(bool active);
+
+signals:
+    void activeChanged(bool active);
+    void requestStart();
+    void requestStop();
+
+private:
+    AudioTap m_tap;
+    SpectrumHandoff m_handoff;
+    QThread m_workerThread;
+    SpectrumWorker *m_worker;
+    bool m_active;
+};
+
+#endif // SPECTRUMANALYZER_H
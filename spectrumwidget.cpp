@@ -0,0 +1,81 @@
+#include "spectrumwidget.h"
+#include "spectrumanalyzer.h"
+#include <QPainter>
+#include <QLinearGradient>
+#include <QScreen>
+#include <QGuiApplication>
+#include <algorithm>
+
+SpectrumWidget::SpectrumWidget(SpectrumAnalyzer *analyzer, QWidget *parent)
+    : QWidget{parent}
+    , m_analyzer(analyzer)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal rate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+    m_timer.setInterval(qBound(4, qRound(1000 / rate), 33));
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &SpectrumWidget::refresh);
+    connect(m_analyzer, &SpectrumAnalyzer::activeChanged, this, &SpectrumWidget::onActiveChanged);
+}
+
+void SpectrumWidget::onActiveChanged(bool active)
+{
+    if (active && isVisible()) {
+        m_timer.start();
+    }
+}
+
+void SpectrumWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (m_analyzer->isActive()) {
+        m_timer.start();
+    }
+}
+
+void SpectrumWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_timer.stop();
+}
+
+void SpectrumWidget::refresh()
+{
+    if (m_analyzer->fetch()) {
+        update();
+        return;
+    }
+    if (m_analyzer->isActive()) {
+        return;
+    }
+    // 分析已经关闭：柱子落到底后分析线程不再发出新帧
+    const SpectrumFrame &frame = m_analyzer->frame();
+    const bool silent = std::all_of(std::begin(frame.bars), std::end(frame.bars), [](float bar) { return bar <= 0.002f; });
+    if (silent) {
+        m_timer.stop();
+    }
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    const SpectrumFrame &frame = m_analyzer->frame();
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    QLinearGradient gradient(0, height(), 0, 0);
+    gradient.setColorAt(0, QColor(67, 97, 238, 200));
+    gradient.setColorAt(1, QColor(76, 201, 240, 230));
+    painter.setBrush(gradient);
+
+    const qreal slot = qreal(width()) / SpectrumFrame::Bars;
+    const qreal barWidth = qMax<qreal>(1.0, slot - 2);
+    for (int b = 0; b < SpectrumFrame::Bars; ++b) {
+        const qreal barHeight = frame.bars[b] * height();
+        if (barHeight < 1) {
+            continue;
+        }
+        painter.drawRoundedRect(QRectF(b * slot + 1, height() - barHeight, barWidth, barHeight), 1.5, 1.5);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+
+class SpectrumAnalyzer;
+
+/*
+ * SpectrumWidget：频谱柱状图
+ *
+ * 按屏幕刷新率检查分析器有没有新的一帧，有才重绘；分析停下且柱子落到底后计时器也停下。
+ */
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SpectrumWidget(SpectrumAnalyzer *analyzer, QWidget *parent = nullptr);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void onActiveChanged(bool active);
+    void refresh();
+
+private:
+    SpectrumAnalyzer *m_analyzer;
+    QTimer m_timer;
+};
+
+#endif // SPECTRUMWIDGET_H
@@ -0,0 +1,640 @@
+#include "speechinput.h"
+#include <QAudioSource>
+#include <QMediaDevices>
+#include <QAudioDevice>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#ifdef HAVE_WHISPER
+#include <whisper.h>
+#endif
+
+namespace {
+const int kFrameMs = 20;
+const int kPrerollFrames = 15;//保留开始说话前300ms
+const int kMaxSegmentSeconds = 15;//一句话最长15秒，超过就先输出一次最终结果
+const int kFastFeedMs = 5;//WAV快速模式的灌入间隔：每次500ms音频，最快约100倍实时，不空转界面线程
+const int kConvertBlock = 512;//writeData 每攒够这么多个采样写一次环形缓冲区
+}
+
+// ==================== VoiceActivityDetector ====================
+
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate)
+    : m_frameSize(sampleRate * kFrameMs / 1000)
+    , m_minSpeechFrames(150 / kFrameMs)
+    , m_hangoverFrames(500 / kFrameMs)
+{
+    reset();
+}
+
+int VoiceActivityDetector::frameSize() const
+{
+    return m_frameSize;
+}
+
+VoiceActivityDetector::Event VoiceActivityDetector::process(const float *frame)
+{
+    float energy = 0.0f;
+    for (int i = 0; i < m_frameSize; ++i) {
+        energy += frame[i] * frame[i];
+    }
+    energy /= m_frameSize;
+
+    // 高于噪声约8dB，并且不低于一个绝对下限（安静房间里的底噪）
+    const bool voiced = energy > qMax(m_noiseFloor * 6.0f, 1e-5f);
+
+    if (!m_speaking) {
+        if (voiced) {
+            m_noiseFloor += (energy - m_noiseFloor) * 0.002f;//噪声突然变大时慢慢跟上
+            if (++m_voicedRun >= m_minSpeechFrames) {
+                m_speaking = true;
+                m_silentRun = 0;
+                return SpeechStarted;
+            }
+        } else {
+            m_noiseFloor = m_noiseFloor * 0.95f + energy * 0.05f;
+            m_voicedRun = 0;
+        }
+        return None;
+    }
+
+    if (voiced) {
+        m_silentRun = 0;
+    } else if (++m_silentRun >= m_hangoverFrames) {
+        m_speaking = false;
+        m_voicedRun = 0;
+        return SpeechEnded;
+    }
+    return None;
+}
+
+bool VoiceActivityDetector::isSpeaking() const
+{
+    return m_speaking;
+}
+
+void VoiceActivityDetector::reset()
+{
+    m_noiseFloor = 1e-4f;
+    m_speaking = false;
+    m_voicedRun = 0;
+    m_silentRun = 0;
+}
+
+// ==================== SpeechEngine ====================
+
+SpeechEngine::SpeechEngine()
+    : m_context(nullptr)
+    , m_threads(qBound(1, QThread::idealThreadCount() / 2, 4))//留一半核心给界面和音频
+{
+}
+
+SpeechEngine::~SpeechEngine()
+{
+#ifdef HAVE_WHISPER
+    if (m_context) {
+        whisper_free(static_cast<whisper_context*>(m_context));
+    }
+#endif
+}
+
+bool SpeechEngine::load(const QString &modelPath, const QString &language, QString *error)
+{
+    m_language = language.toUtf8();
+#ifdef HAVE_WHISPER
+    if (m_context) {
+        return true;
+    }
+    whisper_context_params params = whisper_context_default_params();
+    m_context = whisper_init_from_file_with_params(QFile::encodeName(modelPath).constData(), params);
+    if (!m_context) {
+        *error = QString("无法加载语音模型：%1").arg(modelPath);
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(modelPath);
+    *error = "当前版本没有编译离线语音识别引擎（whisper.cpp）";
+    return false;
+#endif
+}
+
+bool SpeechEngine::isLoaded() const
+{
+    return m_context != nullptr;
+}
+
+QString SpeechEngine::transcribe(const float *samples, int count)
+{
+#ifdef HAVE_WHISPER
+    if (!m_context || count <= 0) {
+        return QString();
+    }
+    auto *context = static_cast<whisper_context*>(m_context);
+
+    // whisper 要求至少1秒输入，不足时补静音
+    std::vector<float> padded;
+    if (count < SpeechPipeline::SampleRate + SpeechPipeline::SampleRate / 10) {
+        padded.assign(samples, samples + count);
+        padded.resize(SpeechPipeline::SampleRate + SpeechPipeline::SampleRate / 10, 0.0f);
+        samples = padded.data();
+        count = int(padded.size());
+    }
+
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = m_threads;
+    params.language = m_language.constData();
+    params.translate = false;
+    params.no_context = true;
+    params.single_segment = true;
+    params.no_timestamps = true;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_special = false;
+    params.print_timestamps = false;
+
+    if (whisper_full(context, params, samples, count) != 0) {
+        return QString();
+    }
+    QString text;
+    const int segments = whisper_full_n_segments(context);
+    for (int i = 0; i < segments; ++i) {
+        text += QString::fromUtf8(whisper_full_get_segment_text(context, i));
+    }
+    return text.trimmed();
+#else
+    Q_UNUSED(samples);
+    Q_UNUSED(count);
+    return QString();
+#endif
+}
+
+// ==================== SpeechPipeline ====================
+
+SpeechPipeline::SpeechPipeline(AudioRingBuffer<float> *ring, QObject *parent)
+    : QObject{parent}
+    , m_ring(ring)
+    , m_vad(SampleRate)
+    , m_pollTimer(new QTimer(this))
+    , m_lastPartialSize(0)
+    , m_partialInterval(SampleRate)
+    , m_samples(0)
+    , m_busyNs(0)
+    , m_recognizeNs(0)
+{
+    m_pollTimer->setInterval(30);
+    connect(m_pollTimer, &QTimer::timeout, this, &SpeechPipeline::process);
+}
+
+SpeechPipeline::~SpeechPipeline()
+{
+}
+
+/*
+ * 加载模型（首次调用时，在工作线程中完成，不阻塞界面）并开始轮询环形缓冲区
+ */
+void SpeechPipeline::start(const QString &modelPath, const QString &language)
+{
+    QString error;
+    if (!m_engine.isLoaded() && !m_engine.load(modelPath, language, &error)) {
+        m_ring->clear();
+        emit ready(false, error);
+        return;
+    }
+    m_vad.reset();
+    m_frame.clear();
+    m_preroll.clear();
+    m_segment.clear();
+    m_lastPartialSize = 0;
+    m_partialInterval = SampleRate;
+    m_samples = 0;
+    m_busyNs = 0;
+    m_recognizeNs = 0;
+    m_pollTimer->start();
+    emit ready(true, QString());
+}
+
+void SpeechPipeline::stop()
+{
+    if (!m_pollTimer->isActive()) {
+        return;
+    }
+    process();
+    QElapsedTimer timer;
+    timer.start();
+    finishSegment();
+    m_busyNs += timer.nsecsElapsed();
+    m_pollTimer->stop();
+    m_vad.reset();
+    m_frame.clear();
+    m_preroll.clear();
+    emit stopped(m_samples, m_busyNs, m_recognizeNs);
+}
+
+void SpeechPipeline::process()
+{
+    QElapsedTimer timer;
+    timer.start();
+    float buffer[2048];
+    const int frameSize = m_vad.frameSize();
+    std::size_t count;
+    while ((count = m_ring->read(buffer, 2048)) > 0) {
+        m_samples += qint64(count);
+        std::size_t offset = 0;
+        while (offset < count) {
+            const std::size_t take = qMin<std::size_t>(frameSize - m_frame.size(), count - offset);
+            m_frame.insert(m_frame.end(), buffer + offset, buffer + offset + take);
+            offset += take;
+            if (int(m_frame.size()) == frameSize) {
+                handleFrame(m_frame.data());
+                m_frame.clear();
+            }
+        }
+    }
+    m_busyNs += timer.nsecsElapsed();
+}
+
+void SpeechPipeline::handleFrame(const float *frame)
+{
+    const int frameSize = m_vad.frameSize();
+    const VoiceActivityDetector::Event event = m_vad.process(frame);
+
+    if (event == VoiceActivityDetector::SpeechStarted) {
+        m_segment.assign(m_preroll.begin(), m_preroll.end());
+        m_preroll.clear();
+        emit speechStarted();
+    }
+
+    if (m_vad.isSpeaking() || event == VoiceActivityDetector::SpeechEnded) {
+        m_segment.insert(m_segment.end(), frame, frame + frameSize);
+    } else {
+        m_preroll.insert(m_preroll.end(), frame, frame + frameSize);
+        if (int(m_preroll.size()) > kPrerollFrames * frameSize) {
+            m_preroll.erase(m_preroll.begin(), m_preroll.begin() + frameSize);
+        }
+    }
+
+    if (event == VoiceActivityDetector::SpeechEnded
+        || m_segment.size() >= std::size_t(kMaxSegmentSeconds * SampleRate)) {
+        finishSegment();
+    } else if (m_vad.isSpeaking() && m_segment.size() - m_lastPartialSize >= std::size_t(m_partialInterval)) {
+        emitPartial();
+    }
+}
+
+/*
+ * 对当前这句话已录下的部分做一次临时识别
+ *
+ * 新增音频时长至少是上次识别耗时的两倍，识别慢的机器上会自动降低临时结果的刷新频率，
+ * 保证识别线程的负载始终低于实时
+ */
+void SpeechPipeline::emitPartial()
+{
+    qint64 elapsedNs = 0;
+    const QString text = transcribe(&elapsedNs);
+    const qint64 elapsedMs = elapsedNs / 1000000;
+
+    m_lastPartialSize = m_segment.size();
+    m_partialInterval = qMax<int>(SampleRate, int(elapsedMs * 2 * SampleRate / 1000));
+    if (!text.isEmpty()) {
+        emit partialTranscript(text);
+    }
+}
+
+void SpeechPipeline::finishSegment()
+{
+    // 少于250ms的片段多半是咳嗽、敲键盘之类的噪声
+    if (m_segment.size() > std::size_t(SampleRate / 4)) {
+        const QString text = transcribe();
+        if (!text.isEmpty()) {
+            emit finalTranscript(text);
+        }
+    }
+    m_segment.clear();
+    m_lastPartialSize = 0;
+    m_partialInterval = SampleRate;
+}
+
+QString SpeechPipeline::transcribe(qint64 *elapsedNs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QString text = m_engine.transcribe(m_segment.data(), int(m_segment.size()));
+    const qint64 elapsed = timer.nsecsElapsed();
+    m_recognizeNs += elapsed;
+    if (elapsedNs) {
+        *elapsedNs = elapsed;
+    }
+    return text;
+}
+
+// ==================== AudioCaptureDevice ====================
+
+AudioCaptureDevice::AudioCaptureDevice(AudioRingBuffer<float> *ring, const QAudioFormat &format, QObject *parent)
+    : QIODevice{parent}
+    , m_ring(ring)
+    , m_format(format)
+    , m_step(double(format.sampleRate()) / SpeechPipeline::SampleRate)
+    , m_phase(1.0)
+    , m_previous(0.0f)
+    , m_lowpass(0.0f)
+{
+}
+
+qint64 AudioCaptureDevice::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return 0;//只写设备
+}
+
+/*
+ * 输入PCM -> 单声道浮点 -> 16kHz（线性插值），写入环形缓冲区
+ * 降采样时先做一次简单的一阶低通，减轻混叠
+ */
+qint64 AudioCaptureDevice::writeData(const char *data, qint64 size)
+{
+    const int channels = m_format.channelCount();
+    const int bytesPerSample = m_format.bytesPerSample();
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    if (bytesPerFrame <= 0) {
+        return size;
+    }
+    const qint64 frames = size / bytesPerFrame;
+    const float lowpass = m_step > 1.0 ? float(1.0 / m_step) : 1.0f;
+
+    float block[kConvertBlock];
+    int filled = 0;
+    for (qint64 f = 0; f < frames; ++f) {
+        const char *framePtr = data + f * bytesPerFrame;
+        float mono = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            const char *sample = framePtr + c * bytesPerSample;
+            switch (m_format.sampleFormat()) {
+            case QAudioFormat::UInt8:
+                mono += (uchar(*sample) - 128) / 128.0f;
+                break;
+            case QAudioFormat::Int16:
+                mono += qFromLittleEndian<qint16>(sample) / 32768.0f;
+                break;
+            case QAudioFormat::Int32:
+                mono += qFromLittleEndian<qint32>(sample) / 2147483648.0f;
+                break;
+            case QAudioFormat::Float: {
+                float value;
+                std::memcpy(&value, sample, sizeof(float));
+                mono += value;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        mono /= channels;
+
+        m_lowpass += (mono - m_lowpass) * lowpass;
+        const float x = m_lowpass;
+        while (m_phase <= 1.0) {
+            block[filled++] = m_previous + (x - m_previous) * float(m_phase);
+            m_phase += m_step;
+            if (filled == kConvertBlock) {
+                m_ring->write(block, filled);
+                filled = 0;
+            }
+        }
+        m_phase -= 1.0;
+        m_previous = x;
+    }
+
+    if (filled > 0) {
+        m_ring->write(block, filled);
+    }
+    return frames * bytesPerFrame;
+}
+
+// ==================== VoiceInput ====================
+
+VoiceInput::VoiceInput(QObject *parent)
+    : QObject{parent}
+    , m_ring(SpeechPipeline::SampleRate * 30)//最多缓存30秒，识别偶尔跟不上时不丢音频
+    , m_pipeline(new SpeechPipeline(&m_ring))
+    , m_active(false)
+    , m_source(nullptr)
+    , m_capture(nullptr)
+    , m_wavDataEnd(0)
+    , m_wavBytesPerChunk(0)
+    , m_wavRealtime(true)
+    , m_wavTimer(new QTimer(this))
+{
+    m_pipeline->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_pipeline, &QObject::deleteLater);
+    connect(this, &VoiceInput::requestStart, m_pipeline, &SpeechPipeline::start);
+    connect(this, &VoiceInput::requestStop, m_pipeline, &SpeechPipeline::stop);
+    connect(m_pipeline, &SpeechPipeline::partialTranscript, this, &VoiceInput::partialTranscript);
+    connect(m_pipeline, &SpeechPipeline::finalTranscript, this, &VoiceInput::finalTranscript);
+    connect(m_pipeline, &SpeechPipeline::stopped, this, &VoiceInput::finished);
+    connect(m_pipeline, &SpeechPipeline::ready, this, [this](bool success, const QString &error) {
+        if (!success) {
+            stop();
+            emit errorOccurred(error);
+        }
+    });
+    connect(m_wavTimer, &QTimer::timeout, this, &VoiceInput::feedWav);
+    m_workerThread.start(QThread::LowPriority);//识别在低优先级线程，界面和音频采集优先
+}
+
+VoiceInput::~VoiceInput()
+{
+    stop();
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+bool VoiceInput::isActive() const
+{
+    return m_active;
+}
+
+QString VoiceInput::defaultModelPath()
+{
+    QSettings settings;
+    return settings.value("voice/modelPath",
+                          QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/models/ggml-base.bin")
+        .toString();
+}
+
+void VoiceInput::setModelPath(const QString &path)
+{
+    m_modelPath = path;
+}
+
+void VoiceInput::startMicrophone()
+{
+    if (m_active) {
+        return;
+    }
+    const QAudioDevice device = QMediaDevices::defaultAudioInput();
+    if (device.isNull()) {
+        emit errorOccurred("没有找到麦克风");
+        return;
+    }
+
+    // 优先直接采集16kHz单声道，设备不支持时用设备首选格式，由 AudioCaptureDevice 转换
+    QAudioFormat format;
+    format.setSampleRate(SpeechPipeline::SampleRate);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Int16);
+    if (!device.isFormatSupported(format)) {
+        format = device.preferredFormat();
+    }
+
+    m_capture = new AudioCaptureDevice(&m_ring, format, this);
+    m_capture->open(QIODevice::WriteOnly);
+    m_source = new QAudioSource(device, format, this);
+
+    QSettings settings;
+    emit requestStart(m_modelPath.isEmpty() ? defaultModelPath() : m_modelPath, settings.value("voice/language", "zh").toString());
+    m_source->start(m_capture);
+    setActive(true);
+}
+
+/*
+ * 用WAV文件代替麦克风输入
+ *
+ * 支持 8/16/32 位整数和32位浮点PCM。realtime 为 true 时按20ms一块的节奏灌入，模拟真实麦克风；
+ * 为 false 时每5ms灌入一大块（环形缓冲区剩余空间不足一半时跳过），用于快速验证识别结果和测量处理速度（petbench speech）。
+ */
+bool VoiceInput::startFromWav(const QString &filePath, bool realtime)
+{
+    if (m_active) {
+        stop();
+    }
+
+    m_wavFile.setFileName(filePath);
+    if (!m_wavFile.open(QIODevice::ReadOnly)) {
+        emit errorOccurred(QString("无法打开WAV文件：%1").arg(filePath));
+        return false;
+    }
+
+    const QByteArray riff = m_wavFile.read(12);
+    if (riff.size() < 12 || !riff.startsWith("RIFF") || riff.mid(8, 4) != "WAVE") {
+        closeWav();
+        emit errorOccurred("不是有效的WAV文件");
+        return false;
+    }
+
+    QAudioFormat format;
+    bool haveFormat = false;
+    while (!m_wavFile.atEnd()) {
+        const QByteArray header = m_wavFile.read(8);
+        if (header.size() < 8) {
+            break;
+        }
+        const quint32 chunkSize = qFromLittleEndian<quint32>(header.constData() + 4);
+        if (header.startsWith("fmt ")) {
+            const QByteArray fmt = m_wavFile.read(chunkSize + (chunkSize & 1));
+            if (fmt.size() < 16) {
+                break;//截断或损坏的 fmt 块
+            }
+            const quint16 audioFormat = qFromLittleEndian<quint16>(fmt.constData());
+            const quint16 channels = qFromLittleEndian<quint16>(fmt.constData() + 2);
+            const quint32 sampleRate = qFromLittleEndian<quint32>(fmt.constData() + 4);
+            const quint16 bits = qFromLittleEndian<quint16>(fmt.constData() + 14);
+            format.setSampleRate(int(sampleRate));
+            format.setChannelCount(channels);
+            if (audioFormat == 3 && bits == 32) {
+                format.setSampleFormat(QAudioFormat::Float);
+            } else if (bits == 8) {
+                format.setSampleFormat(QAudioFormat::UInt8);
+            } else if (bits == 16) {
+                format.setSampleFormat(QAudioFormat::Int16);
+            } else if (bits == 32) {
+                format.setSampleFormat(QAudioFormat::Int32);
+            }
+            haveFormat = format.isValid();
+        } else if (header.startsWith("data") && haveFormat) {
+            m_wavDataEnd = m_wavFile.pos() + chunkSize;
+            break;
+        } else {
+            m_wavFile.seek(m_wavFile.pos() + chunkSize + (chunkSize & 1));
+        }
+    }
+    if (!haveFormat || m_wavDataEnd <= 0) {
+        closeWav();
+        emit errorOccurred("WAV文件格式不受支持");
+        return false;
+    }
+
+    m_capture = new AudioCaptureDevice(&m_ring, format, this);
+    m_capture->open(QIODevice::WriteOnly);
+    m_wavRealtime = realtime;
+    m_wavBytesPerChunk = format.bytesForDuration(kFrameMs * 1000);
+
+    QSettings settings;
+    emit requestStart(m_modelPath.isEmpty() ? defaultModelPath() : m_modelPath, settings.value("voice/language", "zh").toString());
+    m_wavTimer->start(realtime ? kFrameMs : kFastFeedMs);
+    setActive(true);
+    return true;
+}
+
+void VoiceInput::feedWav()
+{
+    if (!m_capture || !m_wavFile.isOpen()) {
+        return;
+    }
+
+    qint64 chunk = m_wavBytesPerChunk;
+    if (!m_wavRealtime) {
+        // 快速模式：按环形缓冲区剩余空间决定这次灌多少，留一半余量防止溢出
+        if (m_ring.freeSpace() < m_ring.capacity() / 2) {
+            return;
+        }
+        chunk = m_wavBytesPerChunk * 25;
+    }
+    chunk = qMin(chunk, m_wavDataEnd - m_wavFile.pos());
+    if (chunk > 0) {
+        m_capture->write(m_wavFile.read(chunk));
+    }
+    if (m_wavFile.pos() >= m_wavDataEnd || m_wavFile.atEnd()) {
+        stop();//文件读完：输出最后一句的最终结果
+    }
+}
+
+void VoiceInput::stop()
+{
+    if (!m_active) {
+        return;
+    }
+    if (m_source) {
+        m_source->stop();
+        m_source->deleteLater();
+        m_source = nullptr;
+    }
+    closeWav();
+    if (m_capture) {
+        m_capture->close();
+        m_capture->deleteLater();
+        m_capture = nullptr;
+    }
+    emit requestStop();
+    setActive(false);
+}
+
+void VoiceInput::setActive(bool active)
+{
+    if (m_active != active) {
+        m_active = active;
+        emit activeChanged(active);
+    }
+}
+
+void VoiceInput::closeWav()
+{
+    m_wavTimer->stop();
+    if (m_wavFile.isOpen()) {
+        m_wavFile.close();
+    }
+    m_wavDataEnd = 0;
+}
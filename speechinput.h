@@ -0,0 +1,196 @@
+#ifndef SPEECHINPUT_H
+#define SPEECHINPUT_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QElapsedTimer>
+#include <vector>
+#include "audioringbuffer.h"
+
+class QAudioSource;
+
+/*
+ * VoiceActivityDetector：基于能量的语音活动检测
+ *
+ * 按固定帧长（默认20ms）计算能量，并在静音期间持续跟踪背景噪声。
+ * 能量高于噪声一定倍数且持续 minSpeechMs 才判定开始说话，
+ * 低于阈值持续 hangoverMs 才判定说完，避免句中停顿被切断。
+ */
+class VoiceActivityDetector
+{
+public:
+    enum Event { None, SpeechStarted, SpeechEnded };
+
+    explicit VoiceActivityDetector(int sampleRate = 16000);
+
+    int frameSize() const;//每帧采样数
+    Event process(const float *frame);//输入一帧，返回状态变化
+    bool isSpeaking() const;
+    void reset();
+
+private:
+    int m_frameSize;
+    int m_minSpeechFrames;
+    int m_hangoverFrames;
+    float m_noiseFloor;//背景噪声能量（均方值）
+    bool m_speaking;
+    int m_voicedRun;//连续有声帧数
+    int m_silentRun;//连续静音帧数
+};
+
+/*
+ * SpeechEngine：嵌入式离线语音识别引擎的薄封装
+ *
+ * 启用 whisper.cpp（HAVE_WHISPER）时在CPU上本地推理；未启用时 load() 返回失败。
+ * 非线程安全，只在 SpeechPipeline 所在的工作线程中使用。
+ */
+class SpeechEngine
+{
+public:
+    SpeechEngine();
+    ~SpeechEngine();
+
+    bool load(const QString &modelPath, const QString &language, QString *error);
+    bool isLoaded() const;
+    QString transcribe(const float *samples, int count);//输入16kHz单声道浮点采样
+
+private:
+    void *m_context;//whisper_context
+    int m_threads;
+    QByteArray m_language;
+};
+
+/*
+ * SpeechPipeline：运行在工作线程中的识别流水线
+ *
+ * 定时从环形缓冲区取出采样，做语音活动检测，把一句话的采样交给识别引擎。
+ * 说话过程中定期对已录下的部分做一次识别，得到的临时结果通过 partialTranscript 发出；
+ * 一句话说完（或超过最长时长）后发出 finalTranscript。
+ * 如果临时识别耗时接近音频时长，自动拉长识别间隔，保证整体跟得上实时。
+ * 停止时通过 stopped 报告这次处理的采样数和耗时，用于计算实时率（处理耗时 / 音频时长）。
+ */
+class SpeechPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int SampleRate = 16000;
+
+    explicit SpeechPipeline(AudioRingBuffer<float> *ring, QObject *parent = nullptr);
+    ~SpeechPipeline();
+
+public slots:
+    void start(const QString &modelPath, const QString &language);
+    void stop();//输入结束：处理完缓冲区剩余的采样，把尚未识别的语音作为最终结果输出，然后停止轮询
+
+signals:
+    void ready(bool success, const QString &error);
+    void speechStarted();
+    void partialTranscript(const QString &text);
+    void finalTranscript(const QString &text);
+    void stopped(qint64 samples, qint64 busyNs, qint64 recognizeNs);//busyNs：检测加识别的总耗时，其中识别占 recognizeNs
+
+private slots:
+    void process();
+
+private:
+    void handleFrame(const float *frame);
+    void emitPartial();
+    void finishSegment();
+    QString transcribe(qint64 *elapsedNs = nullptr);//识别当前这句话，耗时计入 m_recognizeNs
+
+    AudioRingBuffer<float> *m_ring;
+    SpeechEngine m_engine;
+    VoiceActivityDetector m_vad;
+    QTimer *m_pollTimer;
+    std::vector<float> m_frame;//未凑满一帧的采样
+    std::vector<float> m_preroll;//开始说话前的最近几帧，避免吞掉开头的辅音
+    std::vector<float> m_segment;//当前这句话的采样
+    std::size_t m_lastPartialSize;
+    int m_partialInterval;//两次临时识别之间至少新增的采样数
+    qint64 m_samples;//本次处理过的采样数
+    qint64 m_busyNs;
+    qint64 m_recognizeNs;
+};
+
+/*
+ * AudioCaptureDevice：把任意格式的PCM转换为16kHz单声道浮点写入环形缓冲区
+ *
+ * 作为 QAudioSource 推模式的目标设备使用，也用于回放WAV文件做测试。
+ * writeData 运行在音频线程，只做格式转换和无锁写入，不分配内存（转换结果先放在栈上的小块里）。
+ */
+class AudioCaptureDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    AudioCaptureDevice(AudioRingBuffer<float> *ring, const QAudioFormat &format, QObject *parent = nullptr);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    AudioRingBuffer<float> *m_ring;
+    QAudioFormat m_format;
+    double m_step;//输入采样率 / 16000
+    double m_phase;//线性插值的小数位置
+    float m_previous;//上一个输入采样（跨块插值用）
+    float m_lowpass;//降采样前的一阶低通滤波状态
+};
+
+/*
+ * VoiceInput：聊天窗口使用的语音输入门面
+ *
+ * 负责麦克风采集（或WAV文件回放）、识别线程的生命周期，并把结果转发到GUI线程。
+ */
+class VoiceInput : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VoiceInput(QObject *parent = nullptr);
+    ~VoiceInput();
+
+    bool isActive() const;
+    static QString defaultModelPath();
+    void setModelPath(const QString &path);//为空时用配置项 voice/modelPath
+
+public slots:
+    void startMicrophone();
+    bool startFromWav(const QString &filePath, bool realtime = true);//用WAV文件代替麦克风，realtime为false时尽快灌入
+    void stop();
+
+signals:
+    void activeChanged(bool active);
+    void partialTranscript(const QString &text);
+    void finalTranscript(const QString &text);
+    void errorOccurred(const QString &error);
+    void finished(qint64 samples, qint64 busyNs, qint64 recognizeNs);//输入结束后识别线程处理完了最后一句
+
+    void requestStart(const QString &modelPath, const QString &language);
+    void requestStop();
+
+private slots:
+    void feedWav();
+
+private:
+    void setActive(bool active);
+    void closeWav();
+
+    AudioRingBuffer<float> m_ring;
+    QString m_modelPath;
+    QThread m_workerThread;
+    SpeechPipeline *m_pipeline;
+    bool m_active;
+    QAudioSource *m_source;
+    AudioCaptureDevice *m_capture;
+    QFile m_wavFile;
+    qint64 m_wavDataEnd;
+    int m_wavBytesPerChunk;//实时回放时每20ms的字节数
+    bool m_wavRealtime;
+    QTimer *m_wavTimer;
+};
+
+#endif // SPEECHINPUT_H
@@ -0,0 +1,531 @@
+#include "speechoutput.h"
+#include <QAudioSink>
+#include <QMediaDevices>
+#include <QAudioDevice>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QSettings>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QTimer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <cstring>
+#ifdef HAVE_QT_TTS
+#include <QTextToSpeech>
+#endif
+
+namespace {
+
+/*
+ * 合成音频缓存：文件名为句子文本的SHA1，引擎不同放在不同子目录
+ * 文件内容：魔数"PTTS" + 采样率 + 声道数 + 采样格式 + PCM数据
+ */
+QString cacheFilePath(const QString &cacheDir, const QString &text)
+{
+    const QByteArray hash = QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return cacheDir + "/" + QString::fromLatin1(hash) + ".pcm";
+}
+
+bool readCache(const QString &path, QByteArray *pcm, QAudioFormat *format)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0;
+    qint32 sampleRate = 0;
+    qint16 channels = 0;
+    qint16 sampleFormat = 0;
+    in >> magic >> sampleRate >> channels >> sampleFormat;
+    if (magic != 0x50545453 || in.status() != QDataStream::Ok) {
+        return false;
+    }
+    format->setSampleRate(sampleRate);
+    format->setChannelCount(channels);
+    format->setSampleFormat(QAudioFormat::SampleFormat(sampleFormat));
+    *pcm = file.readAll();
+    return format->isValid() && !pcm->isEmpty();
+}
+
+/*
+ * 用过的缓存更新修改时间，清理时按修改时间先删最久没用过的
+ */
+void touchCache(const QString &path)
+{
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+}
+
+qint64 writeCache(const QString &path, const QByteArray &pcm, const QAudioFormat &format)
+{
+    QSaveFile file(path);//先写临时文件再改名，读取时不会读到写了一半的缓存
+    if (!file.open(QIODevice::WriteOnly)) {
+        return 0;
+    }
+    QDataStream out(&file);
+    out << quint32(0x50545453) << qint32(format.sampleRate()) << qint16(format.channelCount())
+        << qint16(format.sampleFormat());
+    file.write(pcm);
+    const qint64 size = file.pos();
+    return file.commit() ? size : 0;
+}
+
+QString resolveEngine()
+{
+    QSettings settings;
+    QString engine = settings.value("voice/ttsEngine").toString();
+#ifdef HAVE_QT_TTS
+    if (engine.isEmpty() && QTextToSpeech::availableEngines().contains("flite")) {
+        engine = "flite";//flite 是随Qt提供的嵌入式CPU合成引擎，完全离线
+    }
+#endif
+    return engine;
+}
+
+} // namespace
+
+// ==================== SpeechSynthWorker ====================
+
+SpeechSynthWorker::SpeechSynthWorker(QObject *parent)
+    : QObject{parent}
+    , m_tts(nullptr)
+    , m_cacheLimit(0)
+    , m_cacheBytes(0)
+    , m_current{-2, QString(), false}
+    , m_busy(false)
+{
+}
+
+void SpeechSynthWorker::initialize(const QString &engine, const QString &cacheDir, qint64 cacheLimit)
+{
+    m_cacheDir = cacheDir;
+    m_cacheLimit = cacheLimit;
+    QDir().mkpath(m_cacheDir);
+    const QFileInfoList entries = QDir(m_cacheDir).entryInfoList({"*.pcm"}, QDir::Files);
+    for (const QFileInfo &entry : entries) {
+        m_cacheBytes += entry.size();
+    }
+    trimCache();
+#ifdef HAVE_QT_TTS
+    m_tts = engine.isEmpty() ? new QTextToSpeech(this) : new QTextToSpeech(engine, this);
+    connect(m_tts, &QTextToSpeech::stateChanged, this, [this](QTextToSpeech::State state) {
+        if (!m_busy) {
+            return;
+        }
+        if (state == QTextToSpeech::Ready) {
+            finishCurrent(true);
+        } else if (state == QTextToSpeech::Error) {
+            qWarning() << "语音合成失败:" << m_tts->errorString();
+            finishCurrent(false);
+        }
+    });
+#else
+    Q_UNUSED(engine);
+#endif
+}
+
+void SpeechSynthWorker::synthesize(int sequence, const QString &text, bool cacheable)
+{
+    // 命中缓存的句子不用排队，即使正在合成别的句子也立即送回
+    const QString path = cacheFilePath(m_cacheDir, text);
+    QByteArray pcm;
+    QAudioFormat format;
+    if (readCache(path, &pcm, &format)) {
+        touchCache(path);
+        emit sentenceReady(sequence, pcm, format);
+        return;
+    }
+    m_live.enqueue(Job{sequence, text, cacheable});
+    processNext();
+}
+
+void SpeechSynthWorker::warm(const QStringList &texts)
+{
+    for (const QString &text : texts) {
+        for (const QString &sentence : PetVoice::splitSentences(text)) {
+            if (!QFile::exists(cacheFilePath(m_cacheDir, sentence))) {
+                m_warm.enqueue(Job{-1, sentence, true});
+            }
+        }
+    }
+    processNext();
+}
+
+void SpeechSynthWorker::cancelLive()
+{
+    m_live.clear();
+    if (m_busy && m_current.sequence >= 0) {
+        // 正在合成的句子无法中断：可缓存的照常写缓存，否则合成完直接丢弃
+        m_current.sequence = m_current.cacheable ? -1 : -2;
+    }
+}
+
+void SpeechSynthWorker::processNext()
+{
+    if (m_busy || !m_tts) {
+        return;
+    }
+    while (!m_live.isEmpty() || !m_warm.isEmpty()) {
+        Job job = !m_live.isEmpty() ? m_live.dequeue() : m_warm.dequeue();
+        if (job.sequence == -1 && QFile::exists(cacheFilePath(m_cacheDir, job.text))) {
+            continue;//同一句台词已经预热过
+        }
+        m_current = job;
+        m_busy = true;
+        m_pcm.clear();
+#ifdef HAVE_QT_TTS
+        m_tts->synthesize(job.text, this, [this](const QAudioFormat &format, const QByteArray &bytes) {
+            m_format = format;
+            m_pcm.append(bytes);
+        });
+#endif
+        return;
+    }
+}
+
+void SpeechSynthWorker::finishCurrent(bool success)
+{
+    m_busy = false;
+    if (success && !m_pcm.isEmpty()) {
+        if (m_current.cacheable) {
+            m_cacheBytes += writeCache(cacheFilePath(m_cacheDir, m_current.text), m_pcm, m_format);
+            trimCache();
+        }
+        if (m_current.sequence >= 0) {
+            emit sentenceReady(m_current.sequence, m_pcm, m_format);
+        }
+    } else if (m_current.sequence >= 0) {
+        emit sentenceFailed(m_current.sequence);
+    }
+    m_pcm.clear();
+    // 回到事件循环后再取下一条，让排队中的实时任务先进入队列
+    QTimer::singleShot(0, this, &SpeechSynthWorker::processNext);
+}
+
+/*
+ * 超过上限时按修改时间从旧到新删除，删到上限的3/4，避免每写一句都扫描目录
+ */
+void SpeechSynthWorker::trimCache()
+{
+    if (m_cacheLimit <= 0 || m_cacheBytes <= m_cacheLimit) {
+        return;
+    }
+    const QFileInfoList entries = QDir(m_cacheDir).entryInfoList({"*.pcm"}, QDir::Files, QDir::Time | QDir::Reversed);
+    m_cacheBytes = 0;
+    for (const QFileInfo &entry : entries) {
+        m_cacheBytes += entry.size();
+    }
+    for (const QFileInfo &entry : entries) {
+        if (m_cacheBytes <= m_cacheLimit * 3 / 4) {
+            break;
+        }
+        if (QFile::remove(entry.absoluteFilePath())) {
+            m_cacheBytes -= entry.size();
+        }
+    }
+}
+
+// ==================== SpeechPlaybackDevice ====================
+
+SpeechPlaybackDevice::SpeechPlaybackDevice(QObject *parent)
+    : QIODevice{parent}
+    , m_headOffset(0)
+    , m_finished(true)
+{
+}
+
+void SpeechPlaybackDevice::enqueue(const QByteArray &pcm)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queue.enqueue(pcm);
+}
+
+void SpeechPlaybackDevice::setFinished(bool finished)
+{
+    QMutexLocker locker(&m_mutex);
+    m_finished = finished;
+}
+
+void SpeechPlaybackDevice::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_headOffset = 0;
+    m_finished = true;
+}
+
+bool SpeechPlaybackDevice::isDrained() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finished && m_queue.isEmpty();
+}
+
+qint64 SpeechPlaybackDevice::readData(char *data, qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 written = 0;
+    while (written < maxSize && !m_queue.isEmpty()) {
+        const QByteArray &head = m_queue.head();
+        const qint64 chunk = qMin(maxSize - written, qint64(head.size()) - m_headOffset);
+        std::memcpy(data + written, head.constData() + m_headOffset, size_t(chunk));
+        written += chunk;
+        m_headOffset += chunk;
+        if (m_headOffset >= head.size()) {
+            m_queue.dequeue();
+            m_headOffset = 0;
+        }
+    }
+    if (written == 0 && !m_finished) {
+        // 下一句还在合成：输出静音，保持声卡运行
+        written = qMin<qint64>(maxSize, 1024);
+        std::memset(data, 0, size_t(written));
+    }
+    return written;
+}
+
+qint64 SpeechPlaybackDevice::writeData(const char *data, qint64 size)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;
+}
+
+qint64 SpeechPlaybackDevice::bytesAvailable() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 total = -m_headOffset;
+    for (const QByteArray &chunk : m_queue) {
+        total += chunk.size();
+    }
+    return total + QIODevice::bytesAvailable();
+}
+
+// ==================== PetVoice ====================
+
+PetVoice::PetVoice(QObject *parent)
+    : QObject{parent}
+    , m_worker(new SpeechSynthWorker)
+    , m_sink(nullptr)
+    , m_device(new SpeechPlaybackDevice(this))
+    , m_nextSequence(0)
+    , m_firstSequence(0)
+    , m_playSequence(0)
+    , m_lastSequence(-1)
+    , m_speaking(false)
+{
+    const QString engine = resolveEngine();
+    QSettings settings;
+    const qint64 cacheLimit = settings.value("voice/cacheLimitMB", 64).toLongLong() * 1024 * 1024;
+    m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tts/"
+                 + (engine.isEmpty() ? QString("default") : engine);
+    m_device->open(QIODevice::ReadOnly);
+
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &PetVoice::requestInitialize, m_worker, &SpeechSynthWorker::initialize);
+    connect(this, &PetVoice::requestSynthesize, m_worker, &SpeechSynthWorker::synthesize);
+    connect(this, &PetVoice::requestWarm, m_worker, &SpeechSynthWorker::warm);
+    connect(this, &PetVoice::requestCancel, m_worker, &SpeechSynthWorker::cancelLive);
+    connect(m_worker, &SpeechSynthWorker::sentenceReady, this, &PetVoice::onSentenceReady);
+    connect(m_worker, &SpeechSynthWorker::sentenceFailed, this, &PetVoice::onSentenceFailed);
+    m_workerThread.start(QThread::LowPriority);
+    emit requestInitialize(engine, m_cacheDir, cacheLimit);
+}
+
+PetVoice::~PetVoice()
+{
+    stop();
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+bool PetVoice::isAvailable() const
+{
+#ifdef HAVE_QT_TTS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PetVoice::isSpeaking() const
+{
+    return m_speaking;
+}
+
+/*
+ * 把回复拆成适合逐句合成的短句
+ * 颜文字（括号里没有汉字的部分）和emoji念出来很奇怪，先去掉
+ */
+QStringList PetVoice::splitSentences(const QString &text)
+{
+    static const QRegularExpression kaomoji(R"([\(（][^\(\)（）]*[\)）])");
+    static const QRegularExpression han(R"(\p{Han})");
+    static const QRegularExpression sentence(R"([^。！？!?～~\n]+[。！？!?～~]*)");
+    static const QRegularExpression speakable(R"([\p{L}\p{N}])");
+
+    QString cleaned;
+    int last = 0;
+    QRegularExpressionMatchIterator it = kaomoji.globalMatch(text);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        if (!match.captured().contains(han)) {
+            cleaned += text.mid(last, match.capturedStart() - last);
+            last = match.capturedEnd();
+        }
+    }
+    cleaned += text.mid(last);
+
+    QString withoutEmoji;
+    for (int i = 0; i < cleaned.size(); ++i) {
+        if (cleaned.at(i).isHighSurrogate() && i + 1 < cleaned.size()) {
+            ++i;//跳过辅助平面字符（emoji）
+            continue;
+        }
+        withoutEmoji += cleaned.at(i);
+    }
+
+    QStringList sentences;
+    QRegularExpressionMatchIterator parts = sentence.globalMatch(withoutEmoji);
+    while (parts.hasNext()) {
+        const QString part = parts.next().captured().trimmed();
+        if (part.contains(speakable)) {
+            sentences << part;
+        }
+    }
+    return sentences;
+}
+
+/*
+ * @brief 说出一条回复
+ *
+ * 新的回复会打断正在说的内容。所有句子交给合成线程（命中缓存的在那里直接读出），
+ * 结果按句子编号重新排序后播放。
+ *
+ * @param cacheable 是否写入磁盘缓存（固定台词为true，AI生成的回复为false）
+ */
+void PetVoice::speak(const QString &text, bool cacheable)
+{
+    if (!isAvailable()) {
+        return;
+    }
+    const QStringList sentences = splitSentences(text);
+    if (sentences.isEmpty()) {
+        return;
+    }
+    stop();
+
+    m_device->setFinished(false);
+    m_firstSequence = m_nextSequence;
+    m_playSequence = m_nextSequence;
+    m_lastSequence = m_nextSequence + int(sentences.size()) - 1;
+    for (const QString &sentence : sentences) {
+        emit requestSynthesize(m_nextSequence++, sentence, cacheable);
+    }
+}
+
+void PetVoice::warmCache(const QStringList &texts)
+{
+    if (isAvailable()) {
+        emit requestWarm(texts);
+    }
+}
+
+void PetVoice::stop()
+{
+    emit requestCancel();
+    m_ready.clear();
+    m_failed.clear();
+    m_firstSequence = m_nextSequence;
+    m_playSequence = m_nextSequence;
+    m_lastSequence = m_nextSequence - 1;
+    m_device->clear();
+    if (m_sink) {
+        m_sink->stop();
+    }
+    setSpeaking(false);
+}
+
+void PetVoice::onSentenceReady(int sequence, const QByteArray &pcm, const QAudioFormat &format)
+{
+    deliver(sequence, pcm, format);
+}
+
+void PetVoice::onSentenceFailed(int sequence)
+{
+    if (sequence >= m_firstSequence) {
+        m_failed.insert(sequence);
+        flushOrdered();
+    }
+}
+
+void PetVoice::deliver(int sequence, const QByteArray &pcm, const QAudioFormat &format)
+{
+    if (sequence < m_firstSequence) {
+        return;//属于已被打断的回复
+    }
+
+    // 输出设备按第一句的格式创建；格式变化（换了引擎）时等空闲再重建
+    if (!m_sink || (format != m_sinkFormat && m_sink->state() != QAudio::ActiveState)) {
+        if (m_sink) {
+            m_sink->stop();
+            m_sink->deleteLater();
+        }
+        m_sink = new QAudioSink(QMediaDevices::defaultAudioOutput(), format, this);
+        m_sinkFormat = format;
+        connect(m_sink, &QAudioSink::stateChanged, this, [this](QAudio::State state) {
+            if (state == QAudio::StoppedState
+                || (state == QAudio::IdleState && m_device->isDrained())) {
+                if (state == QAudio::IdleState) {
+                    m_sink->stop();
+                }
+                setSpeaking(false);
+            }
+        });
+    } else if (format != m_sinkFormat) {
+        qWarning() << "语音合成格式不一致，跳过该句";
+        m_failed.insert(sequence);
+        flushOrdered();
+        return;
+    }
+
+    m_ready.insert(sequence, pcm);
+    flushOrdered();
+}
+
+void PetVoice::flushOrdered()
+{
+    bool queued = false;
+    while (m_playSequence <= m_lastSequence) {
+        if (m_ready.contains(m_playSequence)) {
+            m_device->enqueue(m_ready.take(m_playSequence));
+            queued = true;
+        } else if (!m_failed.remove(m_playSequence)) {
+            break;
+        }
+        ++m_playSequence;
+    }
+    if (m_playSequence > m_lastSequence) {
+        m_device->setFinished(true);
+    }
+
+    if (queued && m_sink && m_sink->state() != QAudio::ActiveState) {
+        m_sink->start(m_device);
+        setSpeaking(true);
+    }
+}
+
+void PetVoice::setSpeaking(bool speaking)
+{
+    if (m_speaking != speaking) {
+        m_speaking = speaking;
+        emit speakingChanged(speaking);
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef SPEECHOUTPUT_H
+#define SPEECHOUTPUT_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <QByteArray>
+#include <QStringList>
+#include <QThread>
+#include <QMutex>
+#include <QQueue>
+#include <QMap>
+#include <QSet>
+
+class QAudioSink;
+class QTextToSpeech;
+
+/*
+ * SpeechSynthWorker：运行在工作线程中的离线语音合成
+ *
+ * 使用 QTextToSpeech::synthesize 直接拿到PCM数据（优先选用嵌入式的 flite 引擎），
+ * 不经过系统播放。任务分两种：
+ *  - 实时任务：正在说的回复，先查磁盘缓存，命中时直接发出，否则插到队列最前面；
+ *  - 预热任务：固定台词，空闲时逐条合成并写入磁盘缓存。
+ * 每次只合成一句，合成完再取下一条，因此实时任务最多等待一句预热台词。
+ * 缓存目录超过上限（配置项 voice/cacheLimitMB，默认64MB）时，先删最久没用过的句子。
+ */
+class SpeechSynthWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SpeechSynthWorker(QObject *parent = nullptr);
+
+public slots:
+    void initialize(const QString &engine, const QString &cacheDir, qint64 cacheLimit);
+    void synthesize(int sequence, const QString &text, bool cacheable);//实时任务
+    void warm(const QStringList &texts);//预热任务
+    void cancelLive();//丢弃尚未开始的实时任务
+
+signals:
+    void sentenceReady(int sequence, const QByteArray &pcm, const QAudioFormat &format);
+    void sentenceFailed(int sequence);
+
+private:
+    struct Job
+    {
+        int sequence;//-1 表示预热任务，只写缓存不播放
+        QString text;
+        bool cacheable;
+    };
+
+    void processNext();
+    void finishCurrent(bool success);
+    void trimCache();
+
+    QTextToSpeech *m_tts;
+    QString m_cacheDir;
+    qint64 m_cacheLimit;//字节
+    qint64 m_cacheBytes;//缓存目录目前的大小
+    QQueue<Job> m_live;
+    QQueue<Job> m_warm;
+    Job m_current;
+    bool m_busy;
+    QByteArray m_pcm;
+    QAudioFormat m_format;
+};
+
+/*
+ * SpeechPlaybackDevice：按顺序播放一句句合成好的PCM
+ *
+ * 作为 QAudioSink 拉模式的数据源。后面的句子还在合成时先输出静音，
+ * 保证声卡不会因为欠载进入空闲；全部播完后返回0，让 QAudioSink 自然停止。
+ */
+class SpeechPlaybackDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit SpeechPlaybackDevice(QObject *parent = nullptr);
+
+    void enqueue(const QByteArray &pcm);
+    void setFinished(bool finished);//没有更多句子了
+    void clear();
+    bool isDrained() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+    qint64 bytesAvailable() const override;
+
+private:
+    mutable QMutex m_mutex;//readData 可能在音频线程中调用
+    QQueue<QByteArray> m_queue;
+    qint64 m_headOffset;
+    bool m_finished;
+};
+
+/*
+ * PetVoice：桌宠"开口说话"的门面
+ *
+ * speak() 把回复拆成句子交给工作线程：命中磁盘缓存的句子在那里读出PCM直接送回，零合成延迟；
+ * 其余句子现场合成，第一句合成好就开始播放，后面的句子边播边合成。界面线程不读写缓存文件。
+ * 播放使用独立的 QAudioSink，不占用音乐播放器的音频输出；说话期间发出 speakingChanged(true)，
+ * 供音乐播放器压低音量。
+ */
+class PetVoice : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PetVoice(QObject *parent = nullptr);
+    ~PetVoice();
+
+    bool isAvailable() const;//是否编译了语音合成支持
+    bool isSpeaking() const;
+    static QStringList splitSentences(const QString &text);
+
+public slots:
+    void speak(const QString &text, bool cacheable);
+    void warmCache(const QStringList &texts);//在后台预先合成固定台词
+    void stop();
+
+signals:
+    void speakingChanged(bool speaking);
+
+    void requestInitialize(const QString &engine, const QString &cacheDir, qint64 cacheLimit);
+    void requestSynthesize(int sequence, const QString &text, bool cacheable);
+    void requestWarm(const QStringList &texts);
+    void requestCancel();
+
+private slots:
+    void onSentenceReady(int sequence, const QByteArray &pcm, const QAudioFormat &format);
+    void onSentenceFailed(int sequence);
+
+private:
+    void deliver(int sequence, const QByteArray &pcm, const QAudioFormat &format);
+    void flushOrdered();//按顺序把已就绪的句子送去播放
+    void setSpeaking(bool speaking);
+
+    QThread m_workerThread;
+    SpeechSynthWorker *m_worker;
+    QString m_cacheDir;
+    QAudioSink *m_sink;
+    SpeechPlaybackDevice *m_device;
+    QAudioFormat m_sinkFormat;
+    int m_nextSequence;//下一句的编号
+    int m_firstSequence;//本次回复第一句的编号，更早的结果属于已被打断的回复
+    int m_playSequence;//下一句应该播放的编号
+    int m_lastSequence;//本次回复最后一句的编号
+    QMap<int, QByteArray> m_ready;//已合成但还没轮到播放的句子
+    QSet<int> m_failed;
+    bool m_speaking;
+};
+
+#endif // SPEECHOUTPUT_H
@@ -0,0 +1,374 @@
+#include "spritepack.h"
+#include "frameexpander.h"
+#include <QDataStream>
+#include <QHash>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int HeaderSize = 12;//魔数4 + 版本、宽、高、帧数各2
+const int EntrySize = 18;//x、y、w、h、延迟各2 + 偏移4 + 长度4
+
+/*
+ * 把一帧脏矩形内的像素转换成调色板索引
+ *
+ * @param image：ARGB32（非预乘）
+ * @param palette：输出的调色板（非预乘）；颜色超过256种时为空，pixels 改存预乘ARGB
+ */
+void indexRect(const QImage &image, const QRect &rect, QVector<QRgb> *palette, QByteArray *pixels)
+{
+    QHash<QRgb, int> colors;
+    bool indexed = true;
+    for (int y = rect.top(); y <= rect.bottom() && indexed; ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            if (!colors.contains(line[x])) {
+                if (colors.size() == 256) {
+                    indexed = false;
+                    break;
+                }
+                colors.insert(line[x], colors.size());
+            }
+        }
+    }
+
+    palette->clear();
+    if (indexed) {
+        palette->resize(colors.size());
+        for (auto it = colors.constBegin(); it != colors.constEnd(); ++it) {
+            (*palette)[it.value()] = it.key();
+        }
+        pixels->resize(qsizetype(rect.width()) * rect.height());
+        uchar *out = reinterpret_cast<uchar *>(pixels->data());
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                *out++ = uchar(colors.value(line[x]));
+            }
+        }
+    } else {
+        pixels->resize(qsizetype(rect.width()) * rect.height() * 4);
+        QRgb *out = reinterpret_cast<QRgb *>(pixels->data());
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                *out++ = qPremultiply(line[x]);
+            }
+        }
+    }
+}
+
+// 一帧脏矩形内的像素：能用256色调色板表示就存索引，否则存预乘ARGB
+QByteArray framePayload(const QImage &image, const QRect &rect)
+{
+    QVector<QRgb> palette;
+    QByteArray pixels;
+    indexRect(image, rect, &palette, &pixels);
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint16(palette.size());
+    for (QRgb color : palette) {
+        stream << quint32(color);
+    }
+    if (!palette.isEmpty()) {
+        stream.writeRawData(pixels.constData(), pixels.size());
+    } else {
+        const QRgb *raw = reinterpret_cast<const QRgb *>(pixels.constData());
+        for (qsizetype i = 0; i < pixels.size() / 4; ++i) {
+            stream << quint32(raw[i]);
+        }
+    }
+    return payload;
+}
+
+QVector<QImage> argbImages(const QVector<AnimationFrame> &frames)
+{
+    QVector<QImage> images;
+    images.reserve(frames.size());
+    for (const AnimationFrame &frame : frames) {
+        images << frame.image.convertToFormat(QImage::Format_ARGB32);
+    }
+    return images;
+}
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+} // namespace
+
+/*
+ * 与上一帧相比发生变化的最小矩形，没有变化时返回空矩形
+ *
+ * 两帧的尺寸和格式必须相同（32位像素）
+ */
+QRect SpritePack::changedRect(const QImage &previous, const QImage &current)
+{
+    const int width = current.width();
+    const int rowBytes = width * 4;
+    int top = -1;
+    int bottom = -1;
+    int left = width;
+    int right = -1;
+    for (int y = 0; y < current.height(); ++y) {
+        const QRgb *a = reinterpret_cast<const QRgb *>(previous.constScanLine(y));
+        const QRgb *b = reinterpret_cast<const QRgb *>(current.constScanLine(y));
+        if (std::memcmp(a, b, rowBytes) == 0) {
+            continue;
+        }
+        if (top < 0) {
+            top = y;
+        }
+        bottom = y;
+        for (int x = 0; x < left; ++x) {
+            if (a[x] != b[x]) {
+                left = x;
+                break;
+            }
+        }
+        for (int x = width - 1; x > right; --x) {
+            if (a[x] != b[x]) {
+                right = x;
+                break;
+            }
+        }
+    }
+    if (top < 0) {
+        return QRect();
+    }
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+/*
+ * 把一段动画编码成 .sprite 数据
+ *
+ * @param frames：完整合成后的各帧（GIF的处置方式已由 QImageReader 处理），尺寸必须一致
+ */
+QByteArray SpritePack::encode(const QVector<AnimationFrame> &frames, QString *error)
+{
+    if (frames.isEmpty()) {
+        setError(error, "没有可以打包的帧");
+        return QByteArray();
+    }
+    const QSize size = frames.first().image.size();
+    if (size.isEmpty() || size.width() > 0xFFFF || size.height() > 0xFFFF || frames.size() > 0xFFFF) {
+        setError(error, "动画尺寸或帧数超出格式范围");
+        return QByteArray();
+    }
+
+    for (const AnimationFrame &frame : frames) {
+        if (frame.image.size() != size) {
+            setError(error, "各帧尺寸不一致");
+            return QByteArray();
+        }
+    }
+    const QVector<QImage> images = argbImages(frames);
+
+    QVector<QRect> rects;
+    QVector<QByteArray> blobs;
+    for (int i = 0; i < images.size(); ++i) {
+        const QRect rect = i == 0 ? images.first().rect() : changedRect(images.at(i - 1), images.at(i));
+        rects << rect;
+        blobs << (rect.isEmpty() ? QByteArray() : qCompress(framePayload(images.at(i), rect), 9));
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("PSPK", 4);
+    stream << quint16(Version) << quint16(size.width()) << quint16(size.height()) << quint16(frames.size());
+
+    quint32 offset = HeaderSize + EntrySize * frames.size();
+    for (int i = 0; i < frames.size(); ++i) {
+        const QRect &rect = rects.at(i);
+        stream << quint16(rect.x()) << quint16(rect.y()) << quint16(rect.width()) << quint16(rect.height())
+               << quint16(qBound(0, frames.at(i).delay, 0xFFFF))
+               << offset << quint32(blobs.at(i).size());
+        offset += blobs.at(i).size();
+    }
+    for (const QByteArray &blob : blobs) {
+        stream.writeRawData(blob.constData(), blob.size());
+    }
+    return data;
+}
+
+/*
+ * 解码 .sprite 数据，只解压各帧，不展开成整帧
+ *
+ * @param data：完整的文件内容（可以是映射出来的资源）
+ * @param frames：输出的增量索引帧，调色板已转换成预乘ARGB
+ */
+bool SpritePack::decodeIndexed(const QByteArray &data, QSize *size, QVector<IndexedFrame> *frames, QString *error)
+{
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    if (!isSpritePack(data) || data.size() < HeaderSize) {
+        setError(error, "不是 sprite 动画文件");
+        return false;
+    }
+    const quint16 version = qFromLittleEndian<quint16>(bytes + 4);
+    const int width = qFromLittleEndian<quint16>(bytes + 6);
+    const int height = qFromLittleEndian<quint16>(bytes + 8);
+    const int count = qFromLittleEndian<quint16>(bytes + 10);
+    if (version != Version) {
+        setError(error, QString("不支持的 sprite 版本：%1").arg(version));
+        return false;
+    }
+    if (width == 0 || height == 0 || count == 0 || data.size() < HeaderSize + EntrySize * count) {
+        setError(error, "sprite 文件头损坏");
+        return false;
+    }
+
+    const QRect canvas(0, 0, width, height);
+    frames->clear();
+    frames->reserve(count);
+    QRect changed;//第二帧起所有变化区域的并集
+    for (int i = 0; i < count; ++i) {
+        const uchar *entry = bytes + HeaderSize + EntrySize * i;
+        IndexedFrame frame;
+        frame.rect = QRect(qFromLittleEndian<quint16>(entry), qFromLittleEndian<quint16>(entry + 2),
+                           qFromLittleEndian<quint16>(entry + 4), qFromLittleEndian<quint16>(entry + 6));
+        const int delay = qFromLittleEndian<quint16>(entry + 8);
+        const quint32 offset = qFromLittleEndian<quint32>(entry + 10);
+        const quint32 length = qFromLittleEndian<quint32>(entry + 14);
+        frame.delay = delay > 0 ? delay : 100;
+        frame.dirty = frame.rect;
+
+        if (!frame.rect.isEmpty()) {
+            if (!canvas.contains(frame.rect) || quint64(offset) + length > quint64(data.size())
+                || (i == 0 && frame.rect != canvas)) {
+                setError(error, QString("第%1帧索引损坏").arg(i + 1));
+                return false;
+            }
+            const QByteArray payload = qUncompress(bytes + offset, length);
+            const uchar *p = reinterpret_cast<const uchar *>(payload.constData());
+            const int pixels = frame.rect.width() * frame.rect.height();
+            const int colors = payload.size() >= 2 ? qFromLittleEndian<quint16>(p) : -1;
+            const qsizetype expected = colors > 0 ? 2 + 4 * colors + pixels : 2 + qsizetype(4) * pixels;
+            if (colors < 0 || colors > 256 || payload.size() != expected) {
+                setError(error, QString("第%1帧数据损坏").arg(i + 1));
+                return false;
+            }
+
+            if (colors > 0) {
+                frame.palette.resize(colors);
+                for (int c = 0; c < colors; ++c) {
+                    frame.palette[c] = qPremultiply(qFromLittleEndian<quint32>(p + 2 + 4 * c));
+                }
+                frame.pixels = payload.mid(2 + 4 * colors);
+                // 展开时直接按索引查表，这里先保证不会越界
+                const uchar *indices = reinterpret_cast<const uchar *>(frame.pixels.constData());
+                if (*std::max_element(indices, indices + pixels) >= colors) {
+                    setError(error, QString("第%1帧数据损坏").arg(i + 1));
+                    return false;
+                }
+            } else {
+                frame.pixels.resize(qsizetype(4) * pixels);
+                qFromLittleEndian<quint32>(p + 2, pixels, frame.pixels.data());
+            }
+        } else if (i == 0) {
+            setError(error, "第1帧为空");
+            return false;
+        }
+        if (i > 0) {
+            changed |= frame.rect;
+        }
+        frames->append(frame);
+    }
+    // 第一帧是完整画面，循环回到开头时只有中途变化过的区域可能与最后一帧不同
+    frames->first().dirty = count > 1 ? changed : canvas;
+    *size = canvas.size();
+    return true;
+}
+
+/*
+ * 解码 .sprite 数据并展开成完整的各帧
+ *
+ * 没有变化的帧和上一帧共享同一份像素数据。
+ *
+ * @param frames：输出的预乘ARGB帧
+ */
+bool SpritePack::decode(const QByteArray &data, QVector<AnimationFrame> *frames, QString *error)
+{
+    QSize size;
+    QVector<IndexedFrame> indexed;
+    if (!decodeIndexed(data, &size, &indexed, error)) {
+        return false;
+    }
+    QImage canvas(size, QImage::Format_ARGB32_Premultiplied);
+    frames->clear();
+    frames->reserve(indexed.size());
+    for (const IndexedFrame &frame : indexed) {
+        frame.apply(&canvas);//画布被上一帧共享时写入才真正复制
+        frames->append(AnimationFrame{canvas, frame.delay, frame.dirty});
+    }
+    frames->first().dirty = frames->size() > 1 ? changedRect(frames->last().image, frames->first().image)
+                                               : frames->first().image.rect();
+    return true;
+}
+
+/*
+ * 把完整的各帧转换成增量索引帧（用于不是 .sprite 的动画，如用户资源包里的GIF）
+ *
+ * @param frames：尺寸一致的完整帧
+ */
+QVector<IndexedFrame> SpritePack::index(const QVector<AnimationFrame> &frames)
+{
+    const QVector<QImage> images = argbImages(frames);
+    QVector<IndexedFrame> result;
+    result.reserve(images.size());
+    for (int i = 0; i < images.size(); ++i) {
+        IndexedFrame frame;
+        frame.rect = i == 0 ? images.first().rect() : changedRect(images.at(i - 1), images.at(i));
+        frame.dirty = frame.rect;
+        frame.delay = frames.at(i).delay;
+        if (!frame.rect.isEmpty()) {
+            indexRect(images.at(i), frame.rect, &frame.palette, &frame.pixels);
+            for (QRgb &color : frame.palette) {
+                color = qPremultiply(color);
+            }
+        }
+        result.append(frame);
+    }
+    if (result.size() > 1) {
+        result.first().dirty = changedRect(images.last(), images.first());
+    }
+    return result;
+}
+
+bool SpritePack::isSpritePack(const QByteArray &data)
+{
+    return data.startsWith("PSPK");
+}
+
+qint64 IndexedFrame::bytes() const
+{
+    return sizeof(IndexedFrame) + pixels.size() + palette.size() * qint64(sizeof(QRgb));
+}
+
+/*
+ * 把这一帧画到画布上：有调色板时用 FrameExpander 查表展开，否则逐行复制
+ */
+void IndexedFrame::apply(QImage *canvas) const
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+    const int stride = canvas->bytesPerLine() / 4;
+    QRgb *dst = reinterpret_cast<QRgb *>(canvas->scanLine(rect.y())) + rect.x();
+    if (!palette.isEmpty()) {
+        FrameExpander::expand(reinterpret_cast<const uchar *>(pixels.constData()), rect.width(),
+                              palette.constData(), palette.size(), dst, stride, rect.width(), rect.height());
+        return;
+    }
+    const QRgb *source = reinterpret_cast<const QRgb *>(pixels.constData());
+    for (int y = 0; y < rect.height(); ++y) {
+        std::memcpy(dst + y * stride, source + y * rect.width(), rect.width() * sizeof(QRgb));
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SPRITEPACK_H
+#define SPRITEPACK_H
+
+#include <QImage>
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+#include <QRect>
+
+struct AnimationFrame
+{
+    QImage image;
+    int delay;//这一帧显示的毫秒数
+    QRect dirty;//相对上一帧变化的区域（第一帧相对最后一帧，用于循环），绘制时只刷新这一块
+};
+
+/*
+ * IndexedFrame：缓存中的一帧，只保存相对上一帧变化的区域，像素尽量用8位调色板索引表示
+ *
+ * 240×240的整帧预乘ARGB约230KB，索引形式的增量帧通常只有几KB。播放时由 apply()
+ * 把这一帧展开到画布上（见 FrameExpander），画布上依次叠加各帧即得到完整画面。
+ */
+struct IndexedFrame
+{
+    QRect rect;//保存的区域（第一帧为整幅画面，没有变化的帧为空）
+    QRect dirty;//播放到这一帧时需要刷新的区域（第一帧相对最后一帧）
+    QVector<QRgb> palette;//预乘ARGB，为空表示 pixels 直接是预乘ARGB
+    QByteArray pixels;//rect 内逐行的索引（每像素1字节）或预乘ARGB（每像素4字节）
+    int delay;
+
+    qint64 bytes() const;
+    void apply(QImage *canvas) const;//canvas 须为预乘ARGB，尺寸与动画一致
+};
+
+/*
+ * SpritePack：桌宠动画的紧凑打包格式（.sprite）
+ *
+ * 构建时由 spritepack 工具把GIF转换成这种格式，运行时解码几乎不需要计算：
+ *  - 文件头 + 帧索引：尺寸、帧数，每帧的脏矩形、显示时长、数据位置；
+ *  - 每帧只保存相对上一帧变化的矩形区域，第一帧保存整幅画面；
+ *  - 区域内的像素用该帧自己的调色板（最多256色）索引，颜色超过256种时退化为原始ARGB；
+ *  - 每帧数据单独用zlib压缩（qCompress）。
+ * 运行时只解压成 IndexedFrame 放进缓存，不展开成整帧；需要整帧时用 decode()。
+ *
+ * 所有整数按小端存储：
+ *   "PSPK" | u16 版本 | u16 宽 | u16 高 | u16 帧数
+ *   帧数 × { u16 x, y, w, h | u16 延迟ms | u32 数据偏移 | u32 数据长度 }
+ *   帧数据（qCompress）：u16 调色板颜色数n | n × u32 ARGB | w×h 字节索引
+ *                         （n 为0时：w×h × u32 预乘ARGB）
+ */
+class SpritePack
+{
+public:
+    static const quint16 Version = 1;
+
+    static QByteArray encode(const QVector<AnimationFrame> &frames, QString *error = nullptr);
+    static bool decode(const QByteArray &data, QVector<AnimationFrame> *frames, QString *error = nullptr);
+    static bool decodeIndexed(const QByteArray &data, QSize *size, QVector<IndexedFrame> *frames, QString *error = nullptr);
+    static QVector<IndexedFrame> index(const QVector<AnimationFrame> &frames);//把完整的各帧转换成增量索引帧
+    static bool isSpritePack(const QByteArray &data);
+    static QRect changedRect(const QImage &previous, const QImage &current);//两帧之间变化的最小矩形，相同时为空
+};
+
+#endif // SPRITEPACK_H
@@ -0,0 +1,367 @@
+#include "tagreader.h"
+#include <QFile>
+#include <QStringDecoder>
+
+namespace {
+
+const qint64 MaxFrameSize = 64 * 1024;//超过这个大小的文字帧（或注释块）不读
+const qint64 MaxCommentSize = 1024 * 1024;
+const int MaxOggPages = 16;
+
+quint32 bigEndian32(const char *p)
+{
+    return (quint32(uchar(p[0])) << 24) | (quint32(uchar(p[1])) << 16) | (quint32(uchar(p[2])) << 8) | uchar(p[3]);
+}
+
+quint32 littleEndian32(const char *p)
+{
+    return (quint32(uchar(p[3])) << 24) | (quint32(uchar(p[2])) << 16) | (quint32(uchar(p[1])) << 8) | uchar(p[0]);
+}
+
+// ID3v2 的同步安全整数：每字节只用低7位
+quint32 syncsafe32(const char *p)
+{
+    return (quint32(uchar(p[0]) & 0x7F) << 21) | (quint32(uchar(p[1]) & 0x7F) << 14)
+           | (quint32(uchar(p[2]) & 0x7F) << 7) | (uchar(p[3]) & 0x7F);
+}
+
+// 去掉不同步处理插入的 0xFF 0x00 中的 0x00
+QByteArray removeUnsync(const QByteArray &data)
+{
+    QByteArray result;
+    result.reserve(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        result.append(data.at(i));
+        if (uchar(data.at(i)) == 0xFF && i + 1 < data.size() && data.at(i + 1) == 0) {
+            ++i;
+        }
+    }
+    return result;
+}
+
+/*
+ * 标称 Latin-1 的文字：很多中文歌曲实际写入的是 GBK，
+ * 先按 UTF-8 尝试，不合法时按本地编码解释，纯ASCII直接转换
+ */
+QString decodeLegacy(const QByteArray &bytes)
+{
+    bool ascii = true;
+    for (char c : bytes) {
+        ascii = ascii && uchar(c) < 0x80;
+    }
+    if (ascii) {
+        return QString::fromLatin1(bytes);
+    }
+    QStringDecoder utf8(QStringDecoder::Utf8);
+    const QString text = utf8(bytes);
+    return utf8.hasError() ? QString::fromLocal8Bit(bytes) : text;
+}
+
+QString decodeUtf16(const QByteArray &bytes, bool bigEndian)
+{
+    QString text;
+    text.reserve(bytes.size() / 2);
+    for (int i = 0; i + 1 < bytes.size(); i += 2) {
+        const char16_t unit = bigEndian ? char16_t((uchar(bytes[i]) << 8) | uchar(bytes[i + 1]))
+                                        : char16_t((uchar(bytes[i + 1]) << 8) | uchar(bytes[i]));
+        if (unit == 0) {
+            break;
+        }
+        text.append(QChar(unit));
+    }
+    return text;
+}
+
+// ID3v2 文字帧：第一个字节是编码，多个值以空字符分隔时只取第一个
+QString decodeTextFrame(const QByteArray &payload)
+{
+    if (payload.isEmpty()) {
+        return QString();
+    }
+    const char encoding = payload.at(0);
+    QByteArray data = payload.mid(1);
+    if (encoding == 1 || encoding == 2) {
+        bool bigEndian = encoding == 2;
+        if (data.size() >= 2 && uchar(data[0]) == 0xFE && uchar(data[1]) == 0xFF) {
+            bigEndian = true;
+            data.remove(0, 2);
+        } else if (data.size() >= 2 && uchar(data[0]) == 0xFF && uchar(data[1]) == 0xFE) {
+            bigEndian = false;
+            data.remove(0, 2);
+        }
+        return decodeUtf16(data, bigEndian).trimmed();
+    }
+    const int end = data.indexOf('\0');
+    if (end >= 0) {
+        data.truncate(end);
+    }
+    return (encoding == 3 ? QString::fromUtf8(data) : decodeLegacy(data)).trimmed();
+}
+
+void setIfEmpty(QString *field, const QString &value)
+{
+    if (field->isEmpty() && !value.isEmpty()) {
+        *field = value;
+    }
+}
+
+bool complete(const TrackTags *tags)
+{
+    return !tags->title.isEmpty() && !tags->artist.isEmpty() && !tags->album.isEmpty();
+}
+
+bool found(const TrackTags *tags)
+{
+    return !tags->title.isEmpty() || !tags->artist.isEmpty() || !tags->album.isEmpty();
+}
+
+} // namespace
+
+bool TagReader::read(const QString &path, TrackTags *tags)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return read(&file, tags);
+}
+
+/*
+ * 按文件开头的标志判断格式；MP3 的 ID3v2 缺字段时再看末尾的 ID3v1
+ */
+bool TagReader::read(QIODevice *device, TrackTags *tags)
+{
+    if (!device->seek(0)) {
+        return false;
+    }
+    if (device->peek(3) == "ID3") {
+        readId3v2(device, tags);//结束后位于标签之后，FLAC 文件偶尔也带 ID3v2
+    }
+    const QByteArray magic = device->peek(4);
+    if (magic == "fLaC") {
+        readFlac(device, tags);
+    } else if (magic == "OggS") {
+        readOgg(device, tags);
+    } else if (!complete(tags)) {
+        readId3v1(device, tags);
+    }
+    return found(tags);
+}
+
+/*
+ * ID3v2：逐帧读取帧头，只读 标题/艺术家/专辑 三个文字帧，其余帧（封面等）直接跳过
+ */
+bool TagReader::readId3v2(QIODevice *device, TrackTags *tags)
+{
+    const qint64 start = device->pos();
+    const QByteArray header = device->read(10);
+    if (header.size() < 10 || !header.startsWith("ID3")) {
+        return false;
+    }
+    const int major = uchar(header[3]);
+    const int flags = uchar(header[5]);
+    const qint64 tagEnd = start + 10 + syncsafe32(header.constData() + 6) + ((major >= 4 && (flags & 0x10)) ? 10 : 0);
+    const qint64 framesEnd = start + 10 + syncsafe32(header.constData() + 6);
+    if (major < 2 || major > 4) {
+        device->seek(tagEnd);
+        return false;
+    }
+    const bool tagUnsync = major < 4 && (flags & 0x80);
+
+    if (major >= 3 && (flags & 0x40)) {
+        // 扩展头：2.3 的长度不含自身的4字节，2.4 的长度包含
+        const QByteArray size = device->read(4);
+        if (size.size() < 4) {
+            return false;
+        }
+        const qint64 skip = major == 3 ? bigEndian32(size.constData()) : qint64(syncsafe32(size.constData())) - 4;
+        device->seek(device->pos() + qMax<qint64>(0, skip));
+    }
+
+    const int headerSize = major == 2 ? 6 : 10;
+    while (device->pos() + headerSize <= framesEnd && !complete(tags)) {
+        const QByteArray frame = device->read(headerSize);
+        if (frame.size() < headerSize || frame.at(0) == 0) {
+            break;//到了填充区
+        }
+        QByteArray id;
+        qint64 size;
+        int formatFlags = 0;
+        if (major == 2) {
+            id = frame.left(3);
+            size = (qint64(uchar(frame[3])) << 16) | (uchar(frame[4]) << 8) | uchar(frame[5]);
+        } else {
+            id = frame.left(4);
+            size = major == 4 ? syncsafe32(frame.constData() + 4) : bigEndian32(frame.constData() + 4);
+            formatFlags = uchar(frame[9]);
+        }
+        const qint64 next = device->pos() + size;
+
+        QString *field = nullptr;
+        if (id == "TIT2" || id == "TT2") {
+            field = &tags->title;
+        } else if (id == "TPE1" || id == "TP1") {
+            field = &tags->artist;
+        } else if (id == "TALB" || id == "TAL") {
+            field = &tags->album;
+        }
+        // 压缩或加密的帧不处理（2.3 和 2.4 的标志位不同）
+        const bool unreadable = major == 3 ? (formatFlags & 0xC0) : (major == 4 && (formatFlags & 0x0C));
+        if (field && field->isEmpty() && size > 0 && size <= MaxFrameSize && !unreadable) {
+            QByteArray payload = device->read(size);
+            if (major == 4 && (formatFlags & 0x01)) {
+                payload.remove(0, 4);//数据长度指示
+            }
+            if (tagUnsync || (major == 4 && (formatFlags & 0x02))) {
+                payload = removeUnsync(payload);
+            }
+            *field = decodeTextFrame(payload);
+        }
+        if (next > framesEnd || !device->seek(next)) {
+            break;
+        }
+    }
+    device->seek(tagEnd);
+    return found(tags);
+}
+
+bool TagReader::readId3v1(QIODevice *device, TrackTags *tags)
+{
+    const qint64 size = device->size();
+    if (size < 128 || !device->seek(size - 128)) {
+        return false;
+    }
+    const QByteArray tag = device->read(128);
+    if (tag.size() < 128 || !tag.startsWith("TAG")) {
+        return false;
+    }
+    auto field = [&tag](int offset) {
+        QByteArray bytes = tag.mid(offset, 30);
+        const int end = bytes.indexOf('\0');
+        if (end >= 0) {
+            bytes.truncate(end);
+        }
+        return decodeLegacy(bytes).trimmed();
+    };
+    setIfEmpty(&tags->title, field(3));
+    setIfEmpty(&tags->artist, field(33));
+    setIfEmpty(&tags->album, field(63));
+    return found(tags);
+}
+
+/*
+ * FLAC：逐个元数据块读块头，只读 VORBIS_COMMENT（类型4），跳过 PICTURE 等其他块
+ */
+bool TagReader::readFlac(QIODevice *device, TrackTags *tags)
+{
+    if (device->read(4) != "fLaC") {
+        return false;
+    }
+    for (;;) {
+        const QByteArray header = device->read(4);
+        if (header.size() < 4) {
+            return false;
+        }
+        const bool last = uchar(header[0]) & 0x80;
+        const int type = uchar(header[0]) & 0x7F;
+        const qint64 length = (qint64(uchar(header[1])) << 16) | (uchar(header[2]) << 8) | uchar(header[3]);
+        if (type == 4) {
+            return parseVorbisComment(device->read(qMin(length, MaxCommentSize)), tags);
+        }
+        if (last || !device->seek(device->pos() + length)) {
+            return false;
+        }
+    }
+}
+
+/*
+ * Ogg：按页拼出第一个逻辑流的前两个包，第二个包是 Vorbis 或 Opus 的注释头
+ */
+bool TagReader::readOgg(QIODevice *device, TrackTags *tags)
+{
+    QByteArray packet;
+    int packets = 0;
+    quint32 serial = 0;
+    for (int page = 0; page < MaxOggPages; ++page) {
+        const QByteArray header = device->read(27);
+        if (header.size() < 27 || !header.startsWith("OggS")) {
+            break;
+        }
+        const QByteArray lacing = device->read(uchar(header[26]));
+        qint64 bodySize = 0;
+        for (char lace : lacing) {
+            bodySize += uchar(lace);
+        }
+        const quint32 pageSerial = littleEndian32(header.constData() + 14);
+        if (page == 0) {
+            serial = pageSerial;
+        } else if (pageSerial != serial) {
+            device->seek(device->pos() + bodySize);//其他逻辑流（如 Skeleton）
+            continue;
+        }
+        const QByteArray body = device->read(bodySize);
+        int offset = 0;
+        for (char lace : lacing) {
+            const int length = uchar(lace);
+            if (packets == 1 && packet.size() < MaxCommentSize) {
+                packet.append(body.mid(offset, length));
+            }
+            offset += length;
+            if (length < 255 && ++packets == 2) {
+                break;
+            }
+        }
+        if (packets >= 2 || packet.size() >= MaxCommentSize) {
+            break;
+        }
+    }
+    // 注释包可能因为太大被截断，解析能读到的部分
+    if (packet.startsWith("\x03vorbis")) {
+        return parseVorbisComment(packet.mid(7), tags);
+    }
+    if (packet.startsWith("OpusTags")) {
+        return parseVorbisComment(packet.mid(8), tags);
+    }
+    return false;
+}
+
+/*
+ * Vorbis 注释：小端长度前缀的厂商字符串，之后是若干条 "字段名=值"
+ */
+bool TagReader::parseVorbisComment(const QByteArray &data, TrackTags *tags)
+{
+    const char *p = data.constData();
+    const qint64 size = data.size();
+    if (size < 8) {
+        return false;
+    }
+    qint64 offset = 4 + qint64(littleEndian32(p));
+    if (offset + 4 > size) {
+        return false;
+    }
+    const quint32 count = littleEndian32(p + offset);
+    offset += 4;
+    for (quint32 i = 0; i < count && offset + 4 <= size; ++i) {
+        const qint64 length = littleEndian32(p + offset);
+        offset += 4;
+        if (offset + length > size) {
+            break;
+        }
+        const QByteArray entry = QByteArray::fromRawData(p + offset, int(length));
+        offset += length;
+        const int equals = entry.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        const QByteArray key = entry.left(equals).toUpper();
+        const QString value = QString::fromUtf8(entry.mid(equals + 1)).trimmed();
+        if (key == "TITLE") {
+            setIfEmpty(&tags->title, value);
+        } else if (key == "ARTIST") {
+            setIfEmpty(&tags->artist, value);
+        } else if (key == "ALBUM") {
+            setIfEmpty(&tags->album, value);
+        }
+    }
+    return found(tags);
+}
@@ -0,0 +1,37 @@
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QString>
+
+class QIODevice;
+
+// 一首歌的标签信息，缺少的字段为空
+struct TrackTags
+{
+    QString title;
+    QString artist;
+    QString album;
+};
+
+/*
+ * TagReader：只读文件头部的元数据，不解码音频
+ *
+ * 支持 ID3v2.2/2.3/2.4（MP3）、ID3v1（文件末尾128字节）、FLAC 的 VORBIS_COMMENT 块、
+ * Ogg Vorbis / Opus 的注释包。逐帧/逐块读取，跳过封面图片等不需要的大块数据，
+ * 每个文件通常只读几KB。
+ */
+class TagReader
+{
+public:
+    static bool read(const QString &path, TrackTags *tags);//没有读到任何标签时返回false
+    static bool read(QIODevice *device, TrackTags *tags);
+
+private:
+    static bool readId3v2(QIODevice *device, TrackTags *tags);
+    static bool readId3v1(QIODevice *device, TrackTags *tags);
+    static bool readFlac(QIODevice *device, TrackTags *tags);
+    static bool readOgg(QIODevice *device, TrackTags *tags);
+    static bool parseVorbisComment(const QByteArray &data, TrackTags *tags);
+};
+
+#endif // TAGREADER_H
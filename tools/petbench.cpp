@@ -0,0 +1,1136 @@
+/*
+ * petbench：桌宠各模块的性能测量工具（不参与主程序构建，需 -DBUILD_BENCHMARKS=ON）
+ *
+ * 用法：petbench <场景> [参数]
+ *   markdown [tokens]   流式Markdown渲染：逐token追加，比较增量渲染与整条重渲染
+ *   sprites <gif>...    动画解码：比较 QMovie 与 .sprite 包的解码耗时和内存
+ *   render <gif> [轮数] 动画绘制：比较 QLabel 整体刷新与 PetWidget 局部重绘每帧的CPU时间
+ *   expand <gif> [轮数] 索引帧：缓存占用与整帧ARGB对比，调色板展开的吞吐量（SIMD与逐像素）
+ *   roam [桌宠数] [秒]  自由活动：MotionEngine 与逐事件 move() 的CPU占用和移动次数
+ *   chrome [次数]       窗口阴影：进度条每次更新时 QGraphicsDropShadowEffect 与 WindowChrome 的重绘CPU时间
+ *   library [歌曲数]    曲库扫描：生成带 ID3v2 标签的文件，比较无索引和有索引时首批结果与扫描完成的耗时
+ *   playlist [歌曲数]   播放列表：QListWidget 逐项添加与 PlaylistModel 的填充耗时，逐字输入时的筛选和排序耗时
+ *   fft [点数] [次数]   频谱分析：FFT 吞吐量（SIMD与逐个计算），以及每秒60帧分析占用的单核CPU比例
+ *   loudness [文件]...  响度分析：K加权和门限计算的吞吐量；给出文件时测量解码加分析整首歌的耗时
+ *   beat [BPM] [秒]     节拍检测：合成鼓点上的速度和相位误差、实时分析占用的单核CPU比例，谱通量（SIMD与逐个计算）
+ *   assets <目录>       资源包：同一批文件打成 .pak（映射）和 .rcc（qrc格式），各在一个子进程里比较启动耗时和常驻内存
+ *   speech <wav> [模型] 语音输入：WAV文件尽快灌入语音活动检测和识别，输出识别结果和实时率
+ *
+ * 没有显示器的环境加 -platform offscreen 运行。
+ */
+#include <QApplication>
+#include <QLabel>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMovie>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+#include <functional>
+#include <vector>
+#include <ctime>
+#include <cmath>
+#include "markdownrenderer.h"
+#include "spritepack.h"
+#include "frameexpander.h"
+#include "petwidget.h"
+#include "motionengine.h"
+#include "windowchrome.h"
+#include "musiclibrary.h"
+#include "playlistmodel.h"
+#include "fft.h"
+#include "loudnessanalyzer.h"
+#include "beatdetector.h"
+#include "speechinput.h"
+#include "assetpack.h"
+#include <QListWidget>
+#include <QListView>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QSlider>
+#include <QVBoxLayout>
+#include <QGraphicsDropShadowEffect>
+#include <QTimer>
+#include <QEventLoop>
+#include <QDirIterator>
+#include <QProcess>
+#include <QResource>
+#include <QLibraryInfo>
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+// 生成一条包含段落、列表、代码块和强调的长回复，切成长度1～6个字符的token
+QStringList makeMarkdownTokens(int tokenCount)
+{
+    const QStringList blocks = {
+        QStringLiteral("主人，喵喵来**认真**回答这个问题啦～这里有一些*小建议*，还有 `inline code` 和 [链接](https://example.com)。\n\n"),
+        QStringLiteral("## 步骤\n"),
+        QStringLiteral("1. 先把猫粮准备好\n2. 再把水碗洗干净\n3. 最后~~偷偷~~摸摸猫猫的头\n\n"),
+        QStringLiteral("```cpp\nint main()\n{\n    return meow(42);\n}\n```\n"),
+        QStringLiteral("> 猫猫说：慢慢来，一切都会好起来的。\n\n"),
+        QStringLiteral("- 早上：晒太阳\n- 中午：打盹\n  继续打盹\n- 晚上：追毛线球\n\n"),
+    };
+
+    QRandomGenerator random(20240601);
+    QStringList tokens;
+    int block = 0;
+    int offset = 0;
+    while (tokens.size() < tokenCount) {
+        const QString &text = blocks.at(block);
+        const int length = qMin(random.bounded(1, 7), int(text.size()) - offset);
+        tokens << text.mid(offset, length);
+        offset += length;
+        if (offset >= text.size()) {
+            offset = 0;
+            block = (block + 1) % blocks.size();
+        }
+    }
+    return tokens;
+}
+
+// 对每个token执行一次 step，返回每个token的耗时（纳秒）
+QVector<qint64> timeTokens(const QStringList &tokens, const std::function<void(const QString &)> &step)
+{
+    QVector<qint64> costs;
+    costs.reserve(tokens.size());
+    QElapsedTimer timer;
+    for (const QString &token : tokens) {
+        timer.start();
+        step(token);
+        costs << timer.nsecsElapsed();
+    }
+    return costs;
+}
+
+double averageMicros(const QVector<qint64> &costs, int from, int to)
+{
+    if (to <= from) {
+        return 0;
+    }
+    qint64 total = 0;
+    for (int i = from; i < to; ++i) {
+        total += costs.at(i);
+    }
+    return total / 1000.0 / (to - from);
+}
+
+void report(const char *name, const QVector<qint64> &costs)
+{
+    const int n = costs.size();
+    const int tenth = qMax(1, n / 10);
+    out() << QString("%1  总计 %2 ms，前10% %3 us/token，后10% %4 us/token\n")
+                 .arg(QLatin1String(name), -12)
+                 .arg(averageMicros(costs, 0, n) * n / 1000.0, 0, 'f', 1)
+                 .arg(averageMicros(costs, 0, tenth), 0, 'f', 2)
+                 .arg(averageMicros(costs, n - tenth, n), 0, 'f', 2);
+    out().flush();
+}
+
+int benchMarkdown(const QStringList &args)
+{
+    const int tokenCount = args.isEmpty() ? 20000 : args.first().toInt();
+    const QStringList tokens = makeMarkdownTokens(tokenCount);
+    out() << "流式Markdown渲染，" << tokens.size() << " 个token\n";
+
+    // 增量渲染：每个token只重新渲染最后一个未写完的块
+    MarkdownRenderer renderer;
+    qint64 htmlSize = 0;
+    const QVector<qint64> incremental = timeTokens(tokens, [&](const QString &token) {
+        const MarkdownRenderer::Update update = renderer.append(token);
+        htmlSize += update.committedHtml.size();
+    });
+    htmlSize += renderer.finish().committedHtml.size();
+    report("incremental", incremental);
+
+    // 对照：每个token都把整条消息重新渲染一遍（O(n²)，token数多时只测前一部分）
+    const QStringList head = tokens.mid(0, qMin<int>(tokens.size(), 4000));
+    QString full;
+    const QVector<qint64> naive = timeTokens(head, [&](const QString &token) {
+        full += token;
+        MarkdownRenderer whole;
+        whole.append(full);
+        whole.finish();
+    });
+    report("full-rerender", naive);
+
+    out() << "输出HTML " << htmlSize << " 字符\n";
+    return 0;
+}
+
+qint64 frameBytes(const QVector<AnimationFrame> &frames)
+{
+    qint64 bytes = 0;
+    qint64 previousKey = 0;
+    for (const AnimationFrame &frame : frames) {
+        if (frame.image.cacheKey() != previousKey) {
+            bytes += frame.image.sizeInBytes();
+        }
+        previousKey = frame.image.cacheKey();
+    }
+    return bytes;
+}
+
+int benchSprites(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        out() << "用法：petbench sprites <gif>...\n";
+        return 1;
+    }
+    out() << QString("%1 %2 %3 %4 %5 %6\n")
+                 .arg("文件", -20).arg("GIF KB", 8).arg("sprite KB", 10)
+                 .arg("QMovie ms/轮", 13).arg("sprite ms", 10).arg("常驻 MB", 8);
+
+    for (const QString &path : args) {
+        // QMovie：完整播放一轮需要的解码时间；它只保留当前帧，但每一轮都要重新做LZW解码和合成
+        QMovie movie(path);
+        movie.setCacheMode(QMovie::CacheNone);
+        QElapsedTimer timer;
+        timer.start();
+        int frameCount = 0;
+        if (movie.jumpToFrame(0)) {
+            do {
+                movie.currentImage();
+                ++frameCount;
+            } while (movie.jumpToNextFrame() && movie.currentFrameNumber() != 0);
+        }
+        const double movieMs = timer.nsecsElapsed() / 1e6;
+
+        QImageReader reader(path);
+        QVector<AnimationFrame> frames;
+        QImage image;
+        while (reader.read(&image)) {
+            frames.append(AnimationFrame{image, reader.nextImageDelay()});
+        }
+        const QByteArray packed = SpritePack::encode(frames);
+
+        // sprite 包：一次解码出全部帧，之后播放不再解码
+        QVector<AnimationFrame> decoded;
+        timer.start();
+        SpritePack::decode(packed, &decoded);
+        const double spriteMs = timer.nsecsElapsed() / 1e6;
+
+        out() << QString("%1 %2 %3 %4 %5 %6\n")
+                     .arg(QFileInfo(path).fileName(), -20)
+                     .arg(QFileInfo(path).size() / 1024, 8)
+                     .arg(packed.size() / 1024, 10)
+                     .arg(movieMs, 13, 'f', 2)
+                     .arg(spriteMs, 10, 'f', 2)
+                     .arg(frameBytes(decoded) / 1048576.0, 8, 'f', 1);
+        if (decoded.size() != frameCount) {
+            out() << "  警告：帧数不一致 QMovie " << frameCount << " / sprite " << decoded.size() << "\n";
+        }
+        out().flush();
+    }
+    return 0;
+}
+
+// 和桌宠运行时一样的帧：经过 sprite 编解码，带有每帧的变化区域
+QVector<AnimationFrame> loadPetFrames(const QString &path)
+{
+    QImageReader reader(path);
+    QVector<AnimationFrame> frames;
+    QImage image;
+    while (reader.read(&image)) {
+        frames.append(AnimationFrame{image, reader.nextImageDelay()});
+    }
+    QVector<AnimationFrame> decoded;
+    SpritePack::decode(SpritePack::encode(frames), &decoded);
+    return decoded;
+}
+
+// 逐帧显示并立即处理重绘，返回每帧平均的进程CPU时间（微秒）
+double cpuPerFrame(const QVector<AnimationFrame> &frames, int loops, const std::function<void(const AnimationFrame &)> &show)
+{
+    const std::clock_t start = std::clock();
+    for (int loop = 0; loop < loops; ++loop) {
+        for (const AnimationFrame &frame : frames) {
+            show(frame);
+            QCoreApplication::processEvents();
+        }
+    }
+    const double seconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+    return seconds * 1e6 / (double(loops) * frames.size());
+}
+
+int benchRender(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        out() << "用法：petbench render <gif> [轮数]\n";
+        return 1;
+    }
+    const QVector<AnimationFrame> frames = loadPetFrames(args.first());
+    const int loops = args.size() > 1 ? args.at(1).toInt() : 20;
+    if (frames.isEmpty() || loops <= 0) {
+        out() << "无法读取动画：" << args.first() << "\n";
+        return 1;
+    }
+    const QSize size = frames.first().image.size();
+
+    qint64 dirtyArea = 0;
+    for (const AnimationFrame &frame : frames) {
+        dirtyArea += qint64(frame.dirty.width()) * frame.dirty.height();
+    }
+    out() << frames.size() << " 帧，平均变化区域占画面 "
+          << QString::number(100.0 * dirtyArea / (qint64(size.width()) * size.height() * frames.size()), 'f', 1)
+          << "%\n";
+
+    // 旧做法：QLabel + QMovie，每帧转换成 QPixmap 并整体重绘
+    QLabel label;
+    label.setFixedSize(size);
+    label.setAlignment(Qt::AlignCenter);
+    label.show();
+    QCoreApplication::processEvents();
+    const double labelCpu = cpuPerFrame(frames, loops, [&](const AnimationFrame &frame) {
+        label.setPixmap(QPixmap::fromImage(frame.image));
+    });
+    label.hide();
+
+    // 新做法：PetWidget，只变换和重绘变化区域
+    PetWidget pet;
+    pet.setFixedSize(size);
+    pet.show();
+    QCoreApplication::processEvents();
+    const double petCpu = cpuPerFrame(frames, loops, [&](const AnimationFrame &frame) {
+        pet.showFrame(frame.image, frame.dirty);
+    });
+
+    out() << QString("QLabel    %1 us/帧\nPetWidget %2 us/帧\n").arg(labelCpu, 0, 'f', 1).arg(petCpu, 0, 'f', 1);
+    return 0;
+}
+
+// 把各帧依次展开到画布上，返回展开的像素数
+qint64 expandFrames(const QVector<IndexedFrame> &frames, QImage *canvas, bool simd)
+{
+    const int stride = canvas->bytesPerLine() / 4;
+    qint64 pixels = 0;
+    for (const IndexedFrame &frame : frames) {
+        if (frame.rect.isEmpty() || frame.palette.isEmpty()) {
+            continue;
+        }
+        QRgb *dst = reinterpret_cast<QRgb *>(canvas->scanLine(frame.rect.y())) + frame.rect.x();
+        FrameExpander::expand(reinterpret_cast<const uchar *>(frame.pixels.constData()), frame.rect.width(),
+                              frame.palette.constData(), frame.palette.size(), dst, stride,
+                              frame.rect.width(), frame.rect.height(), simd);
+        pixels += qint64(frame.rect.width()) * frame.rect.height();
+    }
+    return pixels;
+}
+
+// 反复展开，返回每秒百万像素
+double expandThroughput(const QVector<IndexedFrame> &frames, const QSize &size, int loops, bool simd)
+{
+    QImage canvas(size, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+    QElapsedTimer timer;
+    timer.start();
+    qint64 pixels = 0;
+    for (int loop = 0; loop < loops; ++loop) {
+        pixels += expandFrames(frames, &canvas, simd);
+    }
+    return double(pixels) / qMax<qint64>(timer.nsecsElapsed(), 1) * 1e3;
+}
+
+// 整幅的随机索引帧，用来单独比较不同颜色数下的展开速度
+QVector<IndexedFrame> syntheticFrames(const QSize &size, int colors, int count)
+{
+    QRandomGenerator random(colors);
+    QVector<IndexedFrame> frames;
+    for (int i = 0; i < count; ++i) {
+        IndexedFrame frame;
+        frame.rect = QRect(QPoint(0, 0), size);
+        frame.dirty = frame.rect;
+        frame.delay = 100;
+        for (int c = 0; c < colors; ++c) {
+            frame.palette << qPremultiply(random.generate());
+        }
+        frame.pixels.resize(qsizetype(size.width()) * size.height());
+        for (char &index : frame.pixels) {
+            index = char(random.bounded(colors));
+        }
+        frames << frame;
+    }
+    return frames;
+}
+
+int benchExpand(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        out() << "用法：petbench expand <gif> [轮数]\n";
+        return 1;
+    }
+    const QVector<AnimationFrame> frames = loadPetFrames(args.first());
+    const int loops = args.size() > 1 ? args.at(1).toInt() : 200;
+    if (frames.isEmpty() || loops <= 0) {
+        out() << "无法读取动画：" << args.first() << "\n";
+        return 1;
+    }
+    const QSize size = frames.first().image.size();
+    const QVector<IndexedFrame> indexed = SpritePack::index(frames);
+
+    qint64 indexedBytes = 0;
+    int rawFrames = 0;
+    for (const IndexedFrame &frame : indexed) {
+        indexedBytes += frame.bytes();
+        rawFrames += !frame.rect.isEmpty() && frame.palette.isEmpty();
+    }
+    out() << frames.size() << " 帧，整帧ARGB " << QString::number(frameBytes(frames) / 1024.0, 'f', 1)
+          << " KB，增量索引帧 " << QString::number(indexedBytes / 1024.0, 'f', 1) << " KB（节省 "
+          << QString::number(100.0 - 100.0 * indexedBytes / qMax<qint64>(frameBytes(frames), 1), 'f', 1) << "%）";
+    if (rawFrames > 0) {
+        out() << "，其中 " << rawFrames << " 帧颜色超过256种按ARGB存放";
+    }
+    out() << "\n\n";
+
+    out() << QString("%1 %2 %3 %4\n").arg("数据", -14).arg("实现", 8).arg("SIMD MP/s", 10).arg("逐像素 MP/s", 12);
+    const auto report = [&](const QString &name, const QVector<IndexedFrame> &data, int colors) {
+        const double simd = expandThroughput(data, size, loops, true);
+        const double scalar = expandThroughput(data, size, loops, false);
+        out() << QString("%1 %2 %3 %4\n").arg(name, -14).arg(FrameExpander::kernelName(colors), 8)
+                     .arg(simd, 10, 'f', 0).arg(scalar, 12, 'f', 0);
+        out().flush();
+    };
+    int maxColors = 1;
+    for (const IndexedFrame &frame : indexed) {
+        maxColors = qMax(maxColors, int(frame.palette.size()));
+    }
+    report(QFileInfo(args.first()).fileName(), indexed, maxColors);
+    for (int colors : {16, 64, 256}) {
+        report(QString("随机%1色").arg(colors), syntheticFrames(size, colors, 8), colors);
+    }
+    return 0;
+}
+
+// 运行事件循环若干秒，返回这段时间的进程CPU占用（百分比）
+double cpuWhileRunning(int seconds)
+{
+    QEventLoop loop;
+    QTimer::singleShot(seconds * 1000, &loop, &QEventLoop::quit);
+    const std::clock_t start = std::clock();
+    loop.exec();
+    return 100.0 * double(std::clock() - start) / CLOCKS_PER_SEC / seconds;
+}
+
+int benchRoam(const QStringList &args)
+{
+    const int count = args.size() > 0 ? args.at(0).toInt() : 3;
+    const int seconds = args.size() > 1 ? args.at(1).toInt() : 10;
+    if (count <= 0 || seconds <= 0) {
+        out() << "用法：petbench roam [桌宠数] [秒]\n";
+        return 1;
+    }
+    QList<QWidget *> windows;
+    for (int i = 0; i < count; ++i) {
+        auto window = new QWidget(nullptr, Qt::FramelessWindowHint | Qt::Tool);
+        window->setAttribute(Qt::WA_TranslucentBackground);
+        window->setFixedSize(240, 240);
+        window->move(100 + 60 * i, 100);
+        window->show();
+        windows << window;
+    }
+    QCoreApplication::processEvents();
+
+    // 旧做法：每个输入事件（这里用1ms定时器模拟高回报率鼠标）都直接 move() 一次
+    qint64 naiveMoves = 0;
+    QTimer naive;
+    naive.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&naive, &QTimer::timeout, [&]() {
+        for (QWidget *window : windows) {
+            window->move(window->pos() + QPoint(naiveMoves % 200 < 100 ? 1 : -1, 0));
+        }
+        ++naiveMoves;
+    });
+    naive.start(1);
+    const double naiveCpu = cpuWhileRunning(seconds);
+    naive.stop();
+
+    // 新做法：固定步长模拟，按刷新率合并移动
+    MotionEngine engine;
+    for (QWidget *window : windows) {
+        engine.addBody(window, MotionEngine::Wander);
+    }
+    const double engineCpu = cpuWhileRunning(seconds);
+
+    out() << count << " 个窗口，各运行 " << seconds << " 秒\n"
+          << QString("逐事件 move()  CPU %1%  移动 %2 次/秒\n").arg(naiveCpu, 0, 'f', 1).arg(naiveMoves * count / seconds)
+          << QString("MotionEngine   CPU %1%  移动 %2 次/秒\n").arg(engineCpu, 0, 'f', 1).arg(engine.moveCount() / seconds);
+    qDeleteAll(windows);
+    return 0;
+}
+
+// 和音乐播放器一样的半透明窗口：样式表背景 + 一根进度条
+QWidget *makePlayerLikeWindow(QSlider **slider)
+{
+    QWidget *window = new QWidget;
+    window->setObjectName("player");
+    window->setWindowFlags(Qt::Tool | Qt::FramelessWindowHint);
+    window->setAttribute(Qt::WA_TranslucentBackground);
+    window->setStyleSheet("#player { background: qlineargradient(x1:0, y1:0, x2:0, y2:1, stop:0 #1a1a2e, stop:1 #0f3460);"
+                          " border-radius: 16px; border: 2px solid #4cc9f0; }");
+    QVBoxLayout *layout = new QVBoxLayout(window);
+    layout->setContentsMargins(12, 12, 12, 12);
+    *slider = new QSlider(Qt::Horizontal, window);
+    (*slider)->setRange(0, 1000);
+    layout->addStretch();
+    layout->addWidget(*slider);
+    layout->addStretch();
+    return window;
+}
+
+// 逐次推进进度条并立即处理重绘，返回每次更新平均的进程CPU时间（微秒）
+double cpuPerProgressTick(QWidget *window, QSlider *slider, int ticks)
+{
+    window->show();
+    QCoreApplication::processEvents();
+    const std::clock_t start = std::clock();
+    for (int i = 0; i < ticks; ++i) {
+        slider->setValue(i % 1000);
+        QCoreApplication::processEvents();
+    }
+    const double seconds = double(std::clock() - start) / CLOCKS_PER_SEC;
+    window->hide();
+    return seconds * 1e6 / ticks;
+}
+
+int benchChrome(const QStringList &args)
+{
+    const int ticks = args.isEmpty() ? 2000 : args.first().toInt();
+    if (ticks <= 0) {
+        out() << "用法：petbench chrome [次数]\n";
+        return 1;
+    }
+
+    // 旧做法：整个窗口套 QGraphicsDropShadowEffect
+    QSlider *effectSlider = nullptr;
+    QWidget *effectWindow = makePlayerLikeWindow(&effectSlider);
+    effectWindow->setFixedSize(280, 400);
+    auto effect = new QGraphicsDropShadowEffect(effectWindow);
+    effect->setBlurRadius(10);
+    effect->setColor(QColor(0, 0, 0, 160));
+    effect->setOffset(0, 5);
+    effectWindow->setGraphicsEffect(effect);
+    const double effectCpu = cpuPerProgressTick(effectWindow, effectSlider, ticks);
+
+    // 新做法：九宫格阴影和面板背景缓存，只贴脏区域
+    QSlider *chromeSlider = nullptr;
+    QWidget *chromeWindow = makePlayerLikeWindow(&chromeSlider);
+    WindowChrome *chrome = WindowChrome::install(chromeWindow);
+    chromeWindow->setFixedSize(QSize(280, 400).grownBy(chrome->margins()));
+    const double chromeCpu = cpuPerProgressTick(chromeWindow, chromeSlider, ticks);
+
+    out() << ticks << " 次进度更新\n"
+          << QString("QGraphicsDropShadowEffect %1 us/次\n").arg(effectCpu, 0, 'f', 1)
+          << QString("WindowChrome              %1 us/次（缓存重建 %2 次）\n").arg(chromeCpu, 0, 'f', 1).arg(chrome->rebuildCount());
+    delete effectWindow;
+    delete chromeWindow;
+    return 0;
+}
+
+// ID3v2.3 文字帧：UTF-8 编码不在 2.3 中，这里用带BOM的UTF-16
+QByteArray id3TextFrame(const char *id, const QString &text)
+{
+    QByteArray payload("\x01\xFF\xFE", 3);
+    for (QChar c : text) {
+        payload.append(char(c.unicode() & 0xFF));
+        payload.append(char(c.unicode() >> 8));
+    }
+    QByteArray frame(id);
+    const quint32 size = payload.size();
+    frame.append(char(size >> 24)).append(char(size >> 16)).append(char(size >> 8)).append(char(size));
+    frame.append(2, '\0');
+    return frame + payload;
+}
+
+// 一个只有 ID3v2 标签和一段假音频数据的 MP3 文件
+QByteArray fakeMp3(int index)
+{
+    QByteArray frames = id3TextFrame("TIT2", QString("第%1首歌").arg(index))
+                        + id3TextFrame("TPE1", QString("歌手%1").arg(index % 97))
+                        + id3TextFrame("TALB", QString("专辑%1").arg(index % 13));
+    frames.append(256, '\0');//填充区
+    const quint32 size = frames.size();
+    QByteArray header("ID3\x03\x00\x00", 6);
+    header.append(char((size >> 21) & 0x7F)).append(char((size >> 14) & 0x7F))
+          .append(char((size >> 7) & 0x7F)).append(char(size & 0x7F));
+    return header + frames + QByteArray(4096, '\x55');
+}
+
+int benchLibrary(const QStringList &args)
+{
+    const int count = args.isEmpty() ? 5000 : args.first().toInt();
+    QTemporaryDir dir;
+    if (count <= 0 || !dir.isValid()) {
+        out() << "用法：petbench library [歌曲数]\n";
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        const QString folder = dir.path() + QString("/music/%1").arg(i / 500);
+        QDir().mkpath(folder);
+        QFile file(folder + QString("/%1.mp3").arg(i));
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(fakeMp3(i));
+        }
+    }
+    const QStringList folders = {dir.path() + "/music"};
+    const QString indexPath = dir.path() + "/library.idx";
+
+    auto run = [&](const QString &name) {
+        LibraryScanner scanner;
+        QElapsedTimer timer;
+        qint64 firstMs = -1;
+        qint64 totalMs = 0;
+        int tagged = 0;
+        int parsedCount = 0;
+        QObject::connect(&scanner, &LibraryScanner::tracksFound, [&](int, const QVector<LibraryTrack> &tracks) {
+            if (firstMs < 0) {
+                firstMs = timer.elapsed();
+            }
+            for (const LibraryTrack &track : tracks) {
+                tagged += track.artist.isEmpty() ? 0 : 1;
+            }
+        });
+        QObject::connect(&scanner, &LibraryScanner::finished, [&](int, int, int parsed) {
+            totalMs = timer.elapsed();
+            parsedCount = parsed;
+        });
+        scanner.supersede(1);
+        timer.start();
+        scanner.scan(folders, indexPath, 1);
+        out() << QString("%1  首批 %2 ms  完成 %3 ms  读取标签 %4 首  有标签 %5 首\n")
+                     .arg(name).arg(firstMs).arg(totalMs).arg(parsedCount).arg(tagged);
+    };
+    out() << count << " 首歌\n";
+    run("无索引");
+    run("有索引");
+    return 0;
+}
+
+int benchPlaylist(const QStringList &args)
+{
+    const int count = args.isEmpty() ? 100000 : args.first().toInt();
+    if (count <= 0) {
+        out() << "用法：petbench playlist [歌曲数]\n";
+        return 1;
+    }
+    // 曲库的典型分布：每个艺术家十几张专辑，每张专辑十几首
+    const QStringList words = {"blue", "night", "cat", "summer", "rain", "moon", "river", "light", "dream", "home"};
+    QRandomGenerator random(20240601);
+    QVector<PlaylistEntry> entries;
+    entries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        PlaylistEntry entry;
+        entry.title = QString("%1 %2 %3").arg(words.at(random.bounded(words.size())), words.at(random.bounded(words.size()))).arg(i);
+        entry.artist = QString("Artist %1").arg(i / 150);
+        entry.album = QString("Album %1").arg(i / 12);
+        entry.path = QString("/music/%1/%2/%3.mp3").arg(entry.artist, entry.album).arg(i);
+        entries.append(entry);
+    }
+    out() << count << " 首歌\n";
+
+    QElapsedTimer timer;
+    {
+        QListWidget widget;
+        timer.start();
+        QStringList items;
+        for (const PlaylistEntry &entry : std::as_const(entries)) {
+            items.append(QString("🎵 %1 - %2").arg(entry.title, entry.artist));
+        }
+        widget.addItems(items);
+        widget.resize(260, 100);
+        widget.show();
+        QApplication::processEvents();
+        out() << QString("QListWidget    填充并显示 %1 ms\n").arg(timer.elapsed());
+    }
+    {
+        PlaylistModel model;
+        QListView view;
+        view.setUniformItemSizes(true);
+        view.setModel(&model);
+        timer.start();
+        for (int i = 0; i < count; i += 256) {
+            model.appendTracks(entries.mid(i, 256));//和曲库扫描一样分批加入
+        }
+        view.resize(260, 100);
+        view.show();
+        QApplication::processEvents();
+        out() << QString("PlaylistModel  填充并显示 %1 ms\n").arg(timer.elapsed());
+    }
+
+    // 筛选和排序本身（在后台线程中执行的部分）
+    PlaylistQuery query;
+    QHash<QString, int> ids;
+    auto intern = [&](const QString &text) {
+        auto it = ids.constFind(text);
+        if (it != ids.constEnd()) {
+            return it.value();
+        }
+        query.strings.append(text);
+        return *ids.insert(text, query.strings.size() - 1);
+    };
+    for (const PlaylistEntry &entry : std::as_const(entries)) {
+        query.title.append(intern(entry.title));
+        query.artist.append(intern(entry.artist));
+        query.album.append(intern(entry.album));
+    }
+    out() << "字符串池 " << query.strings.size() << " 个\n";
+
+    PlaylistArranger arranger;
+    const QString typed = "night 12";
+    QVector<int> rows;
+    qint64 fullNs = 0;
+    qint64 incrementalNs = 0;
+    for (int length = 1; length <= typed.size(); ++length) {
+        query.filter = typed.left(length);
+        query.incremental = false;
+        timer.start();
+        const QVector<int> full = arranger.arrange(query);
+        fullNs += timer.nsecsElapsed();
+
+        query.incremental = length > 1;
+        query.candidates = rows;
+        timer.start();
+        rows = query.incremental ? arranger.arrange(query) : full;
+        incrementalNs += timer.nsecsElapsed();
+    }
+    out() << QString("逐字输入 \"%1\"  每次全部筛选 %2 ms  在上次结果中筛选 %3 ms  最终 %4 首\n")
+                 .arg(typed).arg(fullNs / 1e6, 0, 'f', 1).arg(incrementalNs / 1e6, 0, 'f', 1).arg(rows.size());
+
+    query.filter.clear();
+    query.incremental = false;
+    query.sortKey = PlaylistQuery::SortTitle;
+    timer.start();
+    arranger.arrange(query);
+    const qint64 coldMs = timer.elapsed();
+    query.sortKey = PlaylistQuery::SortArtist;
+    timer.start();
+    arranger.arrange(query);
+    out() << QString("排序  首次（含字符串名次）%1 ms  之后 %2 ms\n").arg(coldMs).arg(timer.elapsed());
+    return 0;
+}
+
+int benchFft(const QStringList &args)
+{
+    const int size = args.value(0, "2048").toInt();
+    const int rounds = args.value(1, "20000").toInt();
+    if (size < 2 || (size & (size - 1)) != 0 || rounds <= 0) {
+        out() << "用法：petbench fft [点数（2的幂）] [次数]\n";
+        return 1;
+    }
+    Fft fft(size);
+    QRandomGenerator random(20240601);
+    QVector<float> input(size);
+    for (float &value : input) {
+        value = float(random.generateDouble() * 2 - 1);
+    }
+    QVector<float> re(size);
+    QVector<float> im(size);
+    auto run = [&](bool simd) {
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; ++r) {
+            std::copy(input.cbegin(), input.cend(), re.begin());
+            std::fill(im.begin(), im.end(), 0.0f);
+            fft.transform(re.data(), im.data(), simd);
+        }
+        return double(timer.nsecsElapsed()) / rounds;
+    };
+    run(true);//预热
+    const double scalarNs = run(false);
+    const double simdNs = run(true);
+    // 5 N log2 N 是复数FFT浮点运算量的惯用估计
+    const double flops = 5.0 * size * std::log2(double(size));
+    out() << size << " 点，" << rounds << " 次\n"
+          << QString("逐个计算  %1 us/次  %2 MFLOPS\n").arg(scalarNs / 1000, 0, 'f', 2).arg(flops / scalarNs * 1000, 0, 'f', 0)
+          << QString("%1  %2 us/次  %3 MFLOPS  加速 %4x\n").arg(Fft::kernelName(), -8)
+                 .arg(simdNs / 1000, 0, 'f', 2).arg(flops / simdNs * 1000, 0, 'f', 0).arg(scalarNs / simdNs, 0, 'f', 2)
+          << QString("每秒60帧分析  单核CPU %1%\n").arg(simdNs * 60 / 1e7, 0, 'f', 3);
+    return 0;
+}
+
+int benchLoudness(const QStringList &args)
+{
+    // 3分钟 44.1kHz 立体声：-20 dBFS 正弦加噪声
+    const int rate = 44100;
+    const qint64 frames = qint64(rate) * 180;
+    QRandomGenerator random(20240701);
+    std::vector<float> audio(frames * 2);
+    for (qint64 f = 0; f < frames; ++f) {
+        const float value = 0.1f * float(std::sin(2 * M_PI * 440.0 * f / rate)) + 0.01f * float(random.generateDouble() * 2 - 1);
+        audio[f * 2] = value;
+        audio[f * 2 + 1] = value;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    LoudnessMeter meter(rate);
+    for (qint64 f = 0; f < frames; f += 4096) {
+        meter.process(audio.data() + f * 2, qMin<qint64>(4096, frames - f));
+    }
+    const double loudness = meter.integratedLoudness();
+    const qint64 meterNs = timer.nsecsElapsed();
+    out() << QString("3分钟音频  测量 %1 ms（%2 倍实时）  %3 LUFS
+")
+                 .arg(meterNs / 1e6, 0, 'f', 1).arg(180e9 / meterNs, 0, 'f', 0).arg(loudness, 0, 'f', 2);
+
+    for (const QString &path : args) {
+        double value = 0.0;
+        float peak = 0.0f;
+        timer.start();
+        const bool ok = LoudnessAnalyzer::analyze(QFileInfo(path).absoluteFilePath(), &value, &peak, []() { return true; });
+        if (!ok) {
+            out() << path << "  无法解码\n";
+            continue;
+        }
+        out() << QString("%1  解码加分析 %2 ms  %3 LUFS  峰值 %4  增益 %5 dB\n").arg(path).arg(timer.elapsed())
+                     .arg(value, 0, 'f', 2).arg(peak, 0, 'f', 3).arg(LoudnessAnalyzer::ReferenceLufs - value, 0, 'f', 2);
+    }
+    return 0;
+}
+
+int benchBeat(const QStringList &args)
+{
+    const double bpm = args.value(0, "128").toDouble();
+    const int seconds = args.value(1, "30").toInt();
+    if (bpm <= 0 || seconds <= 0) {
+        out() << "用法：petbench beat [BPM] [秒]\n";
+        return 1;
+    }
+    // 合成鼓点：每拍一个低频底鼓，反拍一个短促的噪声（踩镲），背景有噪声
+    const int rate = 48000;
+    const double period = 60.0 / bpm * rate;
+    const double offset = 0.137 * rate;
+    QRandomGenerator random(20240801);
+    auto noise = [&random]() { return float(random.generateDouble() * 2 - 1); };
+    const qint64 frames = qint64(seconds) * rate;
+    std::vector<float> audio(frames * 2);
+    for (qint64 f = 0; f < frames; ++f) {
+        const double kick = std::fmod(f - offset + 1000 * period, period);
+        const double hat = std::fmod(f - offset - period / 2 + 1000 * period, period);
+        float value = 0.01f * noise();
+        if (kick < 0.05 * rate) {
+            value += 0.6f * float(std::exp(-kick / (0.01 * rate)) * std::sin(2 * M_PI * 80.0 * kick / rate));
+        }
+        if (hat < 0.01 * rate) {
+            value += 0.15f * float(std::exp(-hat / (0.003 * rate))) * noise();
+        }
+        audio[f * 2] = value;
+        audio[f * 2 + 1] = value;
+    }
+
+    BeatTracker tracker(rate);
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 f = 0; f < frames; f += 480) {//和分析线程一样每10ms一块
+        tracker.process(audio.data() + f * 2, qMin<qint64>(480, frames - f));
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    const double detected = tracker.period() > 0 ? 60.0 * rate / tracker.period() : 0.0;
+    double error = std::fmod(tracker.beatAfter(double(frames)) - offset + 1000 * period, period);
+    if (error > period / 2) {
+        error -= period;
+    }
+    out() << QString("%1 BPM，%2 秒  检测到 %3 BPM  相位误差 %4 ms  起音 %5 个  锁定 %6\n")
+                 .arg(bpm).arg(seconds).arg(detected, 0, 'f', 2).arg(error * 1000 / rate, 0, 'f', 1)
+                 .arg(tracker.onsets()).arg(tracker.isLocked() ? "是" : "否")
+          << QString("实时分析  单核CPU %1%\n").arg(elapsedNs / (seconds * 1e9) * 100, 0, 'f', 3);
+
+    // 谱通量：512个频点
+    const int bins = BeatTracker::FftSize / 2;
+    const int rounds = 200000;
+    std::vector<float> re(bins);
+    std::vector<float> im(bins);
+    std::vector<float> previous(bins, 0.0f);
+    for (int k = 0; k < bins; ++k) {
+        re[k] = noise() * 100;
+        im[k] = noise() * 100;
+    }
+    auto run = [&](bool simd) {
+        float sum = 0.0f;
+        QElapsedTimer fluxTimer;
+        fluxTimer.start();
+        for (int r = 0; r < rounds; ++r) {
+            re[r % bins] += 1.0f;//每次都有变化
+            sum += BeatTracker::spectralFlux(re.data(), im.data(), previous.data(), bins, simd);
+        }
+        const double ns = double(fluxTimer.nsecsElapsed()) / rounds;
+        static volatile float sink;
+        sink = sum;//结果要用到，避免整段被优化掉
+        return ns;
+    };
+    run(true);//预热
+    const double scalarNs = run(false);
+    const double simdNs = run(true);
+    out() << QString("谱通量  逐个计算 %1 ns/帧  %2 %3 ns/帧  加速 %4x\n")
+                 .arg(scalarNs, 0, 'f', 0).arg(Fft::kernelName()).arg(simdNs, 0, 'f', 0).arg(scalarNs / simdNs, 0, 'f', 2);
+    return 0;
+}
+
+} // namespace
+
+// 本进程的常驻内存（KB），只支持 Linux，其他平台返回 -1
+qint64 residentKb()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+/*
+ * 子进程：只挂载一种资源，再把全部条目读一遍（和桌宠一样留着不释放），输出一行
+ * "挂载us 挂载后KB 读取us 读取后KB 字节数"
+ */
+int assetsChild(const QString &kind, const QString &path)
+{
+    QElapsedTimer timer;
+    timer.start();
+    AssetPack pack;
+    QStringList names;
+    if (kind == "pack") {
+        if (!pack.open(path)) {
+            return 1;
+        }
+        names = pack.names();
+    } else {
+        if (!QResource::registerResource(path)) {
+            return 1;
+        }
+        QDirIterator it(":/bench", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            names.append(it.next());
+        }
+    }
+    const qint64 mountUs = timer.nsecsElapsed() / 1000;
+    const qint64 mountKb = residentKb();
+
+    timer.start();
+    QList<QByteArray> kept;
+    qint64 bytes = 0;
+    quint32 checksum = 0;
+    for (const QString &name : names) {
+        QByteArray data;
+        if (kind == "pack") {
+            data = pack.data(name);
+        } else {
+            QFile file(name);
+            if (file.open(QIODevice::ReadOnly)) {
+                data = file.readAll();
+            }
+        }
+        for (qsizetype i = 0; i < data.size(); i += 4096) {
+            checksum += uchar(data.at(i));//映射的页面只有访问过才算常驻
+        }
+        bytes += data.size();
+        kept.append(data);
+    }
+    const qint64 readUs = timer.nsecsElapsed() / 1000;
+    out() << mountUs << ' ' << mountKb << ' ' << readUs << ' ' << residentKb() << ' ' << bytes << ' ' << (checksum & 1) << "\n";
+    return 0;
+}
+
+/*
+ * 资源包和 qrc 的对比：用 QFile 读 qrc 条目时，每次都要复制（压缩过的还要解压）一份放在堆上；
+ * 资源包取出的数据直接指向映射内存，访问过的页面属于文件缓存，内存紧张时可以回收
+ */
+int benchAssets(const QStringList &args)
+{
+    if (args.size() == 3 && args.first() == "--child") {
+        return assetsChild(args.at(1), args.at(2));
+    }
+    QTemporaryDir dir;
+    if (args.isEmpty() || !QFileInfo(args.first()).isDir() || !dir.isValid()) {
+        out() << "用法：petbench assets <资源目录，如构建目录中的 image 和 music 的上一级>\n";
+        return 1;
+    }
+    const QDir source(args.first());
+    QList<QPair<QString, QString>> files;
+    QString qrc = "<RCC><qresource prefix=\"/bench\">\n";
+    QDirIterator it(source.path(), QDir::Files, QDirIterator::Subdirectories);
+    qint64 total = 0;
+    while (it.hasNext()) {
+        const QString path = it.next();
+        const QString name = source.relativeFilePath(path);
+        files.append(qMakePair(name, path));
+        qrc += QString("<file alias=\"%1\">%2</file>\n").arg(name.toHtmlEscaped(), path.toHtmlEscaped());
+        total += QFileInfo(path).size();
+    }
+    qrc += "</qresource></RCC>\n";
+    const QString packPath = dir.filePath("bench.pak");
+    QString error;
+    if (files.isEmpty() || !AssetPack::write(packPath, files, &error)) {
+        out() << "打包失败：" << error << "\n";
+        return 1;
+    }
+    out() << QString("%1 个文件  %2 MB\n").arg(files.size()).arg(total / 1048576.0, 0, 'f', 1);
+    out() << QString("%1 %2 %3 %4 %5\n").arg("", -6).arg("挂载 ms", 9).arg("挂载后 MB", 10).arg("读全部 ms", 10).arg("读完后 MB", 10);
+
+    auto run = [&](const QString &label, const QString &kind, const QString &path) {
+        QProcess child;
+        child.start(QCoreApplication::applicationFilePath(), {"-platform", "offscreen", "assets", "--child", kind, path});
+        if (!child.waitForFinished(-1) || child.exitCode() != 0) {
+            out() << label << "  子进程失败\n";
+            return;
+        }
+        const QList<QByteArray> fields = child.readAllStandardOutput().trimmed().split(' ');
+        if (fields.size() < 4) {
+            out() << label << "  子进程没有输出结果\n";
+            return;
+        }
+        auto megabytes = [](const QByteArray &kb) {
+            return kb.toLongLong() < 0 ? QString("-") : QString::number(kb.toLongLong() / 1024.0, 'f', 1);
+        };
+        out() << QString("%1 %2 %3 %4 %5\n").arg(label, -6)
+                     .arg(fields.at(0).toLongLong() / 1000.0, 9, 'f', 2).arg(megabytes(fields.at(1)), 10)
+                     .arg(fields.at(2).toLongLong() / 1000.0, 10, 'f', 2).arg(megabytes(fields.at(3)), 10);
+        out().flush();
+    };
+    run(".pak", "pack", packPath);
+
+    // qrc：用Qt自带的 rcc 按默认压缩设置生成二进制资源，和编译进程序的qrc内容一致
+    QString rcc = QLibraryInfo::path(QLibraryInfo::LibraryExecutablesPath) + "/rcc";
+    if (!QFileInfo::exists(rcc)) {
+        rcc = QLibraryInfo::path(QLibraryInfo::BinariesPath) + "/rcc";
+    }
+    QFile qrcFile(dir.filePath("bench.qrc"));
+    if (!qrcFile.open(QIODevice::WriteOnly)) {
+        return 1;
+    }
+    qrcFile.write(qrc.toUtf8());
+    qrcFile.close();
+    const QString rccPath = dir.filePath("bench.rcc");
+    if (QProcess::execute(rcc, {"--binary", qrcFile.fileName(), "-o", rccPath}) != 0) {
+        out() << "找不到 rcc（" << rcc << "），跳过 qrc 对比\n";
+        return 0;
+    }
+    run(".rcc", "rcc", rccPath);
+    out() << "常驻内存只在 Linux 上统计；.pak 读完后的常驻部分是文件映射，.rcc 是复制或解压出的堆内存\n";
+    return 0;
+}
+
+/*
+ * 实时率 = 处理耗时 / 音频时长，小于1才能在说话的同时识别完。
+ * 墙钟实时率包括灌入节奏和线程切换，检测加识别的实时率只算识别线程真正在干活的时间
+ */
+int benchSpeech(const QStringList &args)
+{
+    if (args.isEmpty()) {
+        out() << "用法：petbench speech <PCM格式的WAV文件> [whisper模型，默认用配置项 voice/modelPath]\n";
+        return 1;
+    }
+    VoiceInput input;
+    if (args.size() > 1) {
+        input.setModelPath(QFileInfo(args.at(1)).absoluteFilePath());
+    }
+    QEventLoop loop;
+    QString error;
+    int sentences = 0;
+    qint64 samples = 0;
+    qint64 busyNs = 0;
+    qint64 recognizeNs = 0;
+    QObject::connect(&input, &VoiceInput::finalTranscript, &loop, [&sentences](const QString &text) {
+        ++sentences;
+        out() << "  " << text << "\n";
+        out().flush();
+    });
+    QObject::connect(&input, &VoiceInput::errorOccurred, &loop, [&](const QString &message) {
+        error = message;
+        loop.quit();
+    });
+    QObject::connect(&input, &VoiceInput::finished, &loop, [&](qint64 count, qint64 busy, qint64 recognize) {
+        samples = count;
+        busyNs = busy;
+        recognizeNs = recognize;
+        loop.quit();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!input.startFromWav(QFileInfo(args.at(0)).absoluteFilePath(), false)) {
+        out() << error << "\n";
+        return 1;
+    }
+    loop.exec();
+    const qint64 wallMs = timer.elapsed();
+    if (!error.isEmpty()) {
+        out() << error << "\n";
+        return 1;
+    }
+    const double audioMs = samples * 1000.0 / SpeechPipeline::SampleRate;
+    if (audioMs <= 0) {
+        out() << "没有读到音频\n";
+        return 1;
+    }
+    out() << QString("音频 %1 s  %2 句\n").arg(audioMs / 1000, 0, 'f', 1).arg(sentences);
+    out() << QString("墙钟       %1 ms  实时率 %2\n").arg(wallMs).arg(wallMs / audioMs, 0, 'f', 3);
+    out() << QString("检测加识别 %1 ms  实时率 %2（其中识别 %3 ms）\n")
+                 .arg(busyNs / 1000000).arg(busyNs / 1e6 / audioMs, 0, 'f', 3).arg(recognizeNs / 1000000);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);//QMovie 和控件绘制需要GUI应用对象
+    QStringList args = app.arguments().mid(1);
+    if (args.isEmpty()) {
+        out() << "用法：petbench <markdown|sprites|render|expand|roam|chrome|library|playlist|fft|loudness|beat|assets|speech> [参数]\n";
+        return 1;
+    }
+
+    const QString scenario = args.takeFirst();
+    if (scenario == "markdown") {
+        return benchMarkdown(args);
+    }
+    if (scenario == "sprites") {
+        return benchSprites(args);
+    }
+    if (scenario == "render") {
+        return benchRender(args);
+    }
+    if (scenario == "expand") {
+        return benchExpand(args);
+    }
+    if (scenario == "roam") {
+        return benchRoam(args);
+    }
+    if (scenario == "chrome") {
+        return benchChrome(args);
+    }
+    if (scenario == "library") {
+        return benchLibrary(args);
+    }
+    if (scenario == "playlist") {
+        return benchPlaylist(args);
+    }
+    if (scenario == "fft") {
+        return benchFft(args);
+    }
+    if (scenario == "loudness") {
+        return benchLoudness(args);
+    }
+    if (scenario == "beat") {
+        return benchBeat(args);
+    }
+    if (scenario == "assets") {
+        return benchAssets(args);
+    }
+    if (scenario == "speech") {
+        return benchSpeech(args);
+    }
+    out() << "未知的测试场景：" << scenario << "\n";
+    return 1;
+}
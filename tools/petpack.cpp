@@ -0,0 +1,32 @@
+/*
+ * petpack：构建时把动画和音乐打包成外置资源包（格式见 assetpack.h）
+ *
+ * 用法：petpack <输出.pak> <条目名称> <文件> [<条目名称> <文件> ...]
+ * 条目名称与qrc路径一致，如 image/animation1.sprite、music/夏恋.mp3。
+ * 由 CMake 自动调用；也可以手动运行，把生成的 .pak 放进用户资源包目录来添加动画和音乐。
+ */
+#include <QCoreApplication>
+#include <QTextStream>
+#include "assetpack.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+    const QStringList args = app.arguments();
+    if (args.size() < 4 || args.size() % 2 != 0) {
+        err << "用法：petpack <输出.pak> <条目名称> <文件> [<条目名称> <文件> ...]\n";
+        return 1;
+    }
+
+    QList<QPair<QString, QString>> files;
+    for (int i = 2; i + 1 < args.size(); i += 2) {
+        files.append(qMakePair(args.at(i), args.at(i + 1)));
+    }
+    QString error;
+    if (!AssetPack::write(args.at(1), files, &error)) {
+        err << "打包失败：" << args.at(1) << "：" << error << "\n";
+        return 1;
+    }
+    return 0;
+}
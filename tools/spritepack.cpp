@@ -0,0 +1,50 @@
+/*
+ * spritepack：构建时把GIF动画转换成 .sprite 包（格式见 spritepack.h）
+ *
+ * 用法：spritepack <输入.gif> <输出.sprite>
+ * 由 CMake 在构建主程序前自动调用，一般不需要手动运行。
+ */
+#include <QCoreApplication>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QTextStream>
+#include "spritepack.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+    const QStringList args = app.arguments();
+    if (args.size() != 3) {
+        err << "用法：spritepack <输入.gif> <输出.sprite>\n";
+        return 1;
+    }
+
+    QImageReader reader(args.at(1));
+    QVector<AnimationFrame> frames;
+    QImage image;
+    while (reader.read(&image)) {
+        frames.append(AnimationFrame{image, reader.nextImageDelay()});
+        if (!reader.supportsAnimation()) {
+            break;
+        }
+    }
+    if (frames.isEmpty()) {
+        err << "读取失败：" << args.at(1) << "：" << reader.errorString() << "\n";
+        return 1;
+    }
+
+    QString error;
+    const QByteArray data = SpritePack::encode(frames, &error);
+    if (data.isEmpty()) {
+        err << "打包失败：" << args.at(1) << "：" << error << "\n";
+        return 1;
+    }
+
+    QSaveFile file(args.at(2));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        err << "写入失败：" << args.at(2) << "：" << file.errorString() << "\n";
+        return 1;
+    }
+    return 0;
+}
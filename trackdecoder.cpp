@@ -0,0 +1,121 @@
+#include "trackdecoder.h"
+#include "assetpack.h"
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QEventLoop>
+#include <QIODevice>
+#include <QDir>
+#include <QFileInfo>
+#include <QUrl>
+#include <QtEndian>
+#include <QScopedPointer>
+#include <cstring>
+
+namespace {
+
+float sampleValue(QAudioFormat::SampleFormat format, const char *sample)
+{
+    switch (format) {
+    case QAudioFormat::UInt8:
+        return (uchar(*sample) - 128) / 128.0f;
+    case QAudioFormat::Int16:
+        return qFromUnaligned<qint16>(sample) / 32768.0f;
+    case QAudioFormat::Int32:
+        return qFromUnaligned<qint32>(sample) / 2147483648.0f;
+    case QAudioFormat::Float: {
+        float value;
+        std::memcpy(&value, sample, sizeof(float));
+        return value;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+} // namespace
+
+bool TrackDecoder::decode(const QString &name, const Sink &sink, QString *error)
+{
+    QAudioDecoder decoder;
+    QScopedPointer<QIODevice> device;
+    if (QDir::isAbsolutePath(name)) {
+        if (!QFileInfo::exists(name)) {
+            if (error) {
+                *error = "文件不存在";
+            }
+            return false;
+        }
+        decoder.setSource(QUrl::fromLocalFile(name));
+    } else {
+        device.reset(AssetLibrary::instance().open(name));
+        if (!device) {
+            if (error) {
+                *error = "资源不存在";
+            }
+            return false;
+        }
+        decoder.setSourceDevice(device.data());
+    }
+    QAudioFormat request;
+    request.setSampleFormat(QAudioFormat::Float);//后端不支持时按实际格式转换
+    request.setChannelCount(2);
+    decoder.setAudioFormat(request);
+
+    QEventLoop loop;
+    bool completed = false;
+    qint64 duration = 0;
+    std::vector<float> stereo;
+    QObject::connect(&decoder, &QAudioDecoder::durationChanged, &loop, [&duration](qint64 value) {
+        duration = value;
+    });
+    bool aborted = false;
+    // finished 之前可能还有没读走的数据块，结尾也要读完，否则每首歌的最后一段会漏掉
+    auto drain = [&]() {
+        while (!aborted && decoder.bufferAvailable()) {
+            const QAudioBuffer buffer = decoder.read();
+            const qint64 frames = toStereo(buffer, &stereo);
+            if (frames > 0 && !sink(stereo.data(), frames, buffer.format().sampleRate(), duration)) {
+                aborted = true;
+                decoder.stop();
+                loop.quit();
+            }
+        }
+    };
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, drain);
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&]() {
+        drain();
+        completed = !aborted;
+        loop.quit();
+    });
+    QObject::connect(&decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), &loop, [&](QAudioDecoder::Error) {
+        if (error) {
+            *error = decoder.errorString();
+        }
+        loop.quit();
+    });
+    decoder.start();
+    loop.exec();
+    decoder.stop();
+    return completed;
+}
+
+qint64 TrackDecoder::toStereo(const QAudioBuffer &buffer, std::vector<float> *stereo)
+{
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    const qint64 frames = buffer.frameCount();
+    if (!buffer.isValid() || channels <= 0 || frames <= 0) {
+        return 0;
+    }
+    const char *data = buffer.constData<char>();
+    const int bytesPerSample = format.bytesPerSample();
+    const int bytesPerFrame = format.bytesPerFrame();
+    stereo->resize(frames * 2);
+    float *out = stereo->data();
+    for (qint64 f = 0; f < frames; ++f) {
+        const char *frame = data + f * bytesPerFrame;
+        out[f * 2] = sampleValue(format.sampleFormat(), frame);
+        out[f * 2 + 1] = sampleValue(format.sampleFormat(), frame + (channels > 1 ? bytesPerSample : 0));
+    }
+    return frames;
+}
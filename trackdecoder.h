@@ -0,0 +1,32 @@
+#ifndef TRACKDECODER_H
+#define TRACKDECODER_H
+
+#include <QString>
+#include <functional>
+#include <vector>
+
+class QAudioBuffer;
+
+/*
+ * TrackDecoder：在后台线程中把整首歌解码一遍（响度分析、波形概览用）
+ *
+ * 在调用线程里创建 QAudioDecoder 并运行局部事件循环，直到解码结束、出错或被中止，
+ * 因此只能在工作线程（线程池任务）中调用，不能在界面线程中调用。
+ * 每块数据转换成交错立体声浮点（保持原采样率，单声道复制成两路，多声道取前两路）后交给 sink。
+ */
+class TrackDecoder
+{
+public:
+    /*
+     * @param frames：本块的帧数；durationMs：目前已知的总时长，未知时为0
+     * @return 返回 false 时中止解码
+     */
+    typedef std::function<bool(const float *stereo, qint64 frames, int sampleRate, qint64 durationMs)> Sink;
+
+    // name：资源包中的名称或本地文件的绝对路径。解码到结尾返回 true
+    static bool decode(const QString &name, const Sink &sink, QString *error = nullptr);
+    // 任意格式的一块PCM -> 交错立体声浮点（采样率不变），返回帧数；播放引擎也用它
+    static qint64 toStereo(const QAudioBuffer &buffer, std::vector<float> *stereo);
+};
+
+#endif // TRACKDECODER_H
@@ -0,0 +1,262 @@
+#include "waveformcache.h"
+#include "trackdecoder.h"
+#include "assetpack.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QDebug>
+#include <vector>
+
+namespace {
+
+const quint32 CacheMagic = 0x50574156;//"PWAV"
+const quint32 CacheVersion = 1;
+const int BlockFrames = 512;//先按固定帧数求峰值，总长度确定后再合并成段
+const int ProgressMs = 200;//解码期间发出中间结果的间隔
+const int RecentTracks = 32;
+
+/*
+ * 逐块累计峰值。开始解码时总长度可能还不知道（或只是估计值），所以先按固定的
+ * BlockFrames 记录，每次发出时再按当时的总长度合并成段
+ */
+class PeakAccumulator
+{
+public:
+    void add(const float *stereo, qint64 frames)
+    {
+        for (qint64 f = 0; f < frames; ++f) {
+            const float left = stereo[f * 2];
+            const float right = stereo[f * 2 + 1];
+            m_min = qMin(m_min, qMin(left, right));
+            m_max = qMax(m_max, qMax(left, right));
+            if (++m_blockPos == BlockFrames) {
+                flush();
+            }
+        }
+        m_frames += frames;
+    }
+
+    qint64 frames() const
+    {
+        return m_frames;
+    }
+
+    WaveformPeaks buckets(qint64 totalFrames, bool complete)
+    {
+        if (complete && m_blockPos > 0) {
+            flush();
+        }
+        const int count = WaveformPeaks::Buckets;
+        std::vector<float> minimum(count, 0.0f);
+        std::vector<float> maximum(count, 0.0f);
+        std::vector<bool> touched(count, false);
+        for (std::size_t i = 0; i < m_blocks.size(); i += 2) {
+            const qint64 start = qint64(i / 2) * BlockFrames;
+            const int b = int(qMin<qint64>(count - 1, start * count / totalFrames));
+            minimum[b] = touched[b] ? qMin(minimum[b], m_blocks[i]) : m_blocks[i];
+            maximum[b] = touched[b] ? qMax(maximum[b], m_blocks[i + 1]) : m_blocks[i + 1];
+            touched[b] = true;
+        }
+        WaveformPeaks peaks;
+        peaks.values.resize(count * 2);
+        char *values = peaks.values.data();
+        for (int b = 0; b < count; ++b) {
+            values[b * 2] = char(qRound(qBound(-1.0f, minimum[b], 1.0f) * 127));
+            values[b * 2 + 1] = char(qRound(qBound(-1.0f, maximum[b], 1.0f) * 127));
+        }
+        peaks.filled = complete ? count : int(qMin<qint64>(count, m_frames * count / totalFrames));
+        return peaks;
+    }
+
+private:
+    void flush()
+    {
+        m_blocks.push_back(m_min);
+        m_blocks.push_back(m_max);
+        m_min = 1.0f;
+        m_max = -1.0f;
+        m_blockPos = 0;
+    }
+
+    std::vector<float> m_blocks;//交错的 min、max
+    float m_min = 1.0f;
+    float m_max = -1.0f;
+    int m_blockPos = 0;
+    qint64 m_frames = 0;
+};
+
+} // namespace
+
+/*
+ * WaveformCache 构造函数
+ *
+ * 只用一个低优先级线程：同一时刻只需要算当前这一首
+ */
+WaveformCache::WaveformCache(QObject *parent)
+    : QObject{parent}
+    , m_generation(0)
+    , m_recent(RecentTracks)
+{
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+WaveformCache::~WaveformCache()
+{
+    m_generation.fetchAndAddRelaxed(1);//正在进行的解码尽快结束
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void WaveformCache::request(const QString &name)
+{
+    if (name == m_peaks.name) {
+        return;
+    }
+    const int generation = m_generation.fetchAndAddRelaxed(1) + 1;
+    m_peaks = WaveformPeaks();
+    m_peaks.name = name;
+    if (const WaveformPeaks *recent = m_recent.object(name)) {
+        m_peaks = *recent;
+    } else if (!name.isEmpty()) {
+        m_pool.start([this, name, generation]() {
+            compute(name, generation);
+        });
+    }
+    emit peaksChanged();
+}
+
+const WaveformPeaks &WaveformCache::peaks() const
+{
+    return m_peaks;
+}
+
+bool WaveformCache::superseded(int generation) const
+{
+    return m_generation.loadRelaxed() != generation;
+}
+
+/*
+ * 先查磁盘缓存；没有时完整解码一遍，每隔 ProgressMs 发出一次已完成的部分
+ */
+void WaveformCache::compute(const QString &name, int generation)
+{
+    if (superseded(generation)) {
+        return;
+    }
+    auto publish = [this, generation](const WaveformPeaks &peaks) {
+        QMetaObject::invokeMethod(this, [this, generation, peaks]() {
+            onProgress(generation, peaks);
+        }, Qt::QueuedConnection);
+    };
+
+    const QString path = cachePath(name);
+    WaveformPeaks peaks;
+    if (loadCache(path, &peaks)) {
+        peaks.name = name;
+        publish(peaks);
+        return;
+    }
+
+    PeakAccumulator accumulator;
+    QElapsedTimer timer;
+    timer.start();
+    qint64 totalFrames = 0;
+    QString error;
+    const bool ok = TrackDecoder::decode(name, [&](const float *stereo, qint64 frames, int sampleRate, qint64 durationMs) {
+        accumulator.add(stereo, frames);
+        totalFrames = durationMs * sampleRate / 1000;
+        if (totalFrames > 0 && timer.elapsed() >= ProgressMs) {
+            timer.restart();
+            WaveformPeaks partial = accumulator.buckets(qMax(totalFrames, accumulator.frames()), false);
+            partial.name = name;
+            publish(partial);
+        }
+        return !superseded(generation);
+    }, &error);
+    if (superseded(generation)) {
+        return;
+    }
+    if (!ok || accumulator.frames() == 0) {
+        qDebug() << "无法生成波形:" << name << error;
+        WaveformPeaks failed;
+        failed.name = name;
+        publish(failed);
+        return;
+    }
+    // 以实际解码出的长度为准，时长只是估计
+    peaks = accumulator.buckets(accumulator.frames(), true);
+    peaks.name = name;
+    if (!saveCache(path, peaks)) {
+        qWarning() << "无法保存波形缓存:" << path;
+    }
+    publish(peaks);
+}
+
+void WaveformCache::onProgress(int generation, const WaveformPeaks &peaks)
+{
+    if (superseded(generation)) {
+        return;//已经换歌
+    }
+    m_peaks = peaks;
+    if (peaks.isComplete()) {
+        m_recent.insert(peaks.name, new WaveformPeaks(peaks));
+    }
+    emit peaksChanged();
+}
+
+/*
+ * 缓存文件名：本地文件按路径、大小和修改时间，资源包中的歌按名称和数据大小，文件改动后自然失效
+ */
+QString WaveformCache::cachePath(const QString &name)
+{
+    QByteArray key = name.toUtf8();
+    if (QDir::isAbsolutePath(name)) {
+        const QFileInfo info(name);
+        key += '|' + QByteArray::number(info.size()) + '|' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    } else {
+        key += '|' + QByteArray::number(AssetLibrary::instance().data(name).size());
+    }
+    const QByteArray hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/waveforms/" + QString::fromLatin1(hash) + ".wave";
+}
+
+bool WaveformCache::loadCache(const QString &path, WaveformPeaks *peaks)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0, version = 0;
+    QByteArray values;
+    stream >> magic >> version >> values;
+    if (stream.status() != QDataStream::Ok || magic != CacheMagic || version != CacheVersion
+        || values.size() != WaveformPeaks::Buckets * 2) {
+        return false;//损坏或旧格式时重新计算
+    }
+    peaks->values = values;
+    peaks->filled = WaveformPeaks::Buckets;
+    return true;
+}
+
+bool WaveformCache::saveCache(const QString &path, const WaveformPeaks &peaks)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << CacheMagic << CacheVersion << peaks.values;
+    return file.commit();
+}
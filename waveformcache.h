@@ -0,0 +1,63 @@
+#ifndef WAVEFORMCACHE_H
+#define WAVEFORMCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+/*
+ * WaveformPeaks：一首歌的波形概览
+ *
+ * 整首歌等分成 Buckets 段，每段记录最小值和最大值（两个声道合并，缩放到 ±127）。
+ * 段数固定，与进度条宽度无关，绘制时再合并到像素。
+ */
+struct WaveformPeaks
+{
+    static constexpr int Buckets = 1024;
+
+    QString name;
+    QByteArray values;//交错的 min、max（qint8），共 Buckets*2 个；为空表示无法解码
+    int filled = 0;//已经解码到的段数
+
+    bool isComplete() const { return filled >= Buckets; }
+};
+
+/*
+ * WaveformCache：为当前歌曲提供波形概览
+ *
+ * 在线程池中用 TrackDecoder 把整首歌解码一遍求出每段的峰值，期间定时发出已完成的部分，
+ * 进度条从左往右逐步填满；算完的结果按文件（路径、大小、修改时间）保存在缓存目录的
+ * waveforms/ 下，最近用过的还留在内存里，再次播放时立即显示。
+ * 换歌时正在进行的解码尽快放弃，界面线程从不解码。
+ */
+class WaveformCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WaveformCache(QObject *parent = nullptr);
+    ~WaveformCache();
+
+    void request(const QString &name);//换到这首歌的波形，与当前相同时忽略
+    const WaveformPeaks &peaks() const;
+
+signals:
+    void peaksChanged();
+
+private:
+    void compute(const QString &name, int generation);//在线程池中运行
+    void onProgress(int generation, const WaveformPeaks &peaks);
+    bool superseded(int generation) const;
+    static QString cachePath(const QString &name);
+    static bool loadCache(const QString &path, WaveformPeaks *peaks);
+    static bool saveCache(const QString &path, const WaveformPeaks &peaks);
+
+    QThreadPool m_pool;
+    QAtomicInt m_generation;
+    QCache<QString, WaveformPeaks> m_recent;//最近算完的几首
+    WaveformPeaks m_peaks;
+};
+
+#endif // WAVEFORMCACHE_H
@@ -0,0 +1,135 @@
+#include "waveformslider.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QStyle>
+
+namespace {
+
+const QColor PlayedColor(76, 201, 240);
+const QColor RemainingColor(76, 201, 240, 90);
+const QColor HandleColor(226, 232, 240);
+
+} // namespace
+
+WaveformSlider::WaveformSlider(QWidget *parent)
+    : QSlider{Qt::Horizontal, parent}
+    , m_filledColumns(0)
+    , m_dragging(false)
+{
+    setMinimumHeight(24);
+}
+
+void WaveformSlider::setPeaks(const WaveformPeaks &peaks)
+{
+    m_peaks = peaks;
+    rebuildColumns();
+    update();
+}
+
+void WaveformSlider::resizeEvent(QResizeEvent *event)
+{
+    QSlider::resizeEvent(event);
+    rebuildColumns();
+}
+
+/*
+ * 把 Buckets 段合并到每个像素列，只在波形或宽度变化时计算
+ */
+void WaveformSlider::rebuildColumns()
+{
+    m_columns.clear();
+    m_filledColumns = 0;
+    const int columns = width();
+    if (m_peaks.values.isEmpty() || columns <= 0) {
+        return;
+    }
+    const int buckets = WaveformPeaks::Buckets;
+    const char *values = m_peaks.values.constData();
+    m_columns.resize(columns);
+    for (int x = 0; x < columns; ++x) {
+        const int first = x * buckets / columns;
+        const int last = qMax(first + 1, (x + 1) * buckets / columns);
+        qint8 low = 0;
+        qint8 high = 0;
+        for (int b = first; b < last && b < m_peaks.filled; ++b) {
+            low = qMin(low, qint8(values[b * 2]));
+            high = qMax(high, qint8(values[b * 2 + 1]));
+        }
+        m_columns[x] = qMakePair(low, high);
+        if (last <= m_peaks.filled) {
+            m_filledColumns = x + 1;
+        }
+    }
+}
+
+void WaveformSlider::paintEvent(QPaintEvent *event)
+{
+    if (m_columns.isEmpty()) {
+        QSlider::paintEvent(event);
+        return;
+    }
+    QPainter painter(this);
+    const int middle = height() / 2;
+    const qreal scale = (height() / 2 - 1) / 127.0;
+    const int played = maximum() > minimum()
+                           ? QStyle::sliderPositionFromValue(minimum(), maximum(), sliderPosition(), width())
+                           : 0;
+
+    for (int x = 0; x < m_columns.size(); ++x) {
+        painter.setPen(x < played ? PlayedColor : RemainingColor);
+        if (x >= m_filledColumns) {
+            painter.drawPoint(x, middle);//还没解码到
+            continue;
+        }
+        const int top = middle - qMax(1, qRound(m_columns[x].second * scale));
+        const int bottom = middle + qMax(1, qRound(-m_columns[x].first * scale));
+        painter.drawLine(x, top, x, bottom);
+    }
+
+    // 当前位置
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(PlayedColor, 1.5));
+    painter.setBrush(HandleColor);
+    painter.drawRoundedRect(QRectF(qBound(0, played, width() - 4), 1, 4, height() - 2), 2, 2);
+}
+
+int WaveformSlider::valueAt(int x) const
+{
+    return QStyle::sliderValueFromPosition(minimum(), maximum(), qBound(0, x, width()), width());
+}
+
+/*
+ * 有波形时点哪里跳到哪里；没有波形时保持普通滑块的行为
+ */
+void WaveformSlider::mousePressEvent(QMouseEvent *event)
+{
+    if (m_columns.isEmpty() || event->button() != Qt::LeftButton) {
+        QSlider::mousePressEvent(event);
+        return;
+    }
+    m_dragging = true;
+    setSliderDown(true);
+    setSliderPosition(valueAt(event->position().toPoint().x()));//按下状态下会发出 sliderMoved
+    event->accept();
+}
+
+void WaveformSlider::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_dragging) {
+        QSlider::mouseMoveEvent(event);
+        return;
+    }
+    setSliderPosition(valueAt(event->position().toPoint().x()));
+    event->accept();
+}
+
+void WaveformSlider::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (!m_dragging) {
+        QSlider::mouseReleaseEvent(event);
+        return;
+    }
+    m_dragging = false;
+    setSliderDown(false);
+    event->accept();
+}
@@ -0,0 +1,40 @@
+#ifndef WAVEFORMSLIDER_H
+#define WAVEFORMSLIDER_H
+
+#include <QSlider>
+#include <QVector>
+#include "waveformcache.h"
+
+/*
+ * WaveformSlider：画出当前歌曲波形的进度条
+ *
+ * 已播放的部分高亮，还没解码到的部分只画一条细线。没有波形（无法解码）时按样式表画普通滑块。
+ * 波形按像素列预先合并好，播放进度更新时只重画，不再遍历峰值。
+ * 点击任意位置直接跳转，拖动时和普通滑块一样发出 sliderMoved。
+ */
+class WaveformSlider : public QSlider
+{
+    Q_OBJECT
+public:
+    explicit WaveformSlider(QWidget *parent = nullptr);
+
+    void setPeaks(const WaveformPeaks &peaks);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    void rebuildColumns();
+    int valueAt(int x) const;
+
+    WaveformPeaks m_peaks;
+    QVector<QPair<qint8, qint8>> m_columns;//每个像素列的最小值和最大值
+    int m_filledColumns;
+    bool m_dragging;//按下时有波形，由这里处理拖动
+};
+
+#endif // WAVEFORMSLIDER_H
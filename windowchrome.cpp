@@ -0,0 +1,183 @@
+#include "windowchrome.h"
+#include <QWidget>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPixmapCache>
+#include <QStyle>
+#include <QStyleOption>
+#include <QImage>
+#include <QVector>
+#include <qdrawutil.h>
+
+namespace {
+
+// 对一行（或一列）做一次盒式模糊，step 为相邻像素的间隔
+void boxBlurLine(uchar *data, int count, int step, int radius, QVector<int> *scratch)
+{
+    scratch->resize(count);
+    int *source = scratch->data();
+    for (int i = 0; i < count; ++i) {
+        source[i] = data[i * step];
+    }
+    const int window = 2 * radius + 1;
+    int sum = 0;
+    for (int i = -radius; i <= radius; ++i) {
+        sum += source[qBound(0, i, count - 1)];
+    }
+    for (int i = 0; i < count; ++i) {
+        data[i * step] = uchar(sum / window);
+        sum += source[qMin(i + radius + 1, count - 1)] - source[qMax(i - radius, 0)];
+    }
+}
+
+// 三次盒式模糊近似高斯模糊，作用范围约为 3 * radius
+void blurAlpha(QImage *mask, int radius)
+{
+    QVector<int> scratch;
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int y = 0; y < mask->height(); ++y) {
+            boxBlurLine(mask->scanLine(y), mask->width(), 1, radius, &scratch);
+        }
+        for (int x = 0; x < mask->width(); ++x) {
+            boxBlurLine(mask->bits() + x, mask->height(), mask->bytesPerLine(), radius, &scratch);
+        }
+    }
+}
+
+} // namespace
+
+/*
+ * 给窗口装上阴影和面板背景，窗口销毁时一起销毁
+ *
+ * 窗口需要设置 Qt::WA_TranslucentBackground
+ */
+WindowChrome *WindowChrome::install(QWidget *window, const WindowShadow &shadow)
+{
+    return new WindowChrome(window, shadow);
+}
+
+WindowChrome::WindowChrome(QWidget *window, const WindowShadow &shadow)
+    : QObject{window}
+    , m_window(window)
+    , m_shadow(shadow)
+    , m_dirty(true)
+    , m_rebuilds(0)
+{
+    const int blur = qMax(0, m_shadow.blurRadius);
+    m_margins = QMargins(qMax(0, blur - m_shadow.offset.x()), qMax(0, blur - m_shadow.offset.y()),
+                         qMax(0, blur + m_shadow.offset.x()), qMax(0, blur + m_shadow.offset.y()));
+    m_window->setContentsMargins(m_window->contentsMargins() + m_margins);
+    m_window->installEventFilter(this);
+}
+
+QMargins WindowChrome::margins() const
+{
+    return m_margins;
+}
+
+QRect WindowChrome::panelRect() const
+{
+    return m_window->rect().marginsRemoved(m_margins);
+}
+
+int WindowChrome::rebuildCount() const
+{
+    return m_rebuilds;
+}
+
+/*
+ * 在窗口自己的 paintEvent 之前贴上缓存；尺寸或样式表变化时标记缓存失效
+ */
+bool WindowChrome::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_window) {
+        switch (event->type()) {
+        case QEvent::Resize:
+        case QEvent::StyleChange:
+        case QEvent::PaletteChange:
+            m_dirty = true;
+            break;
+        case QEvent::Paint: {
+            if (m_dirty || m_cache.devicePixelRatio() != m_window->devicePixelRatioF()) {
+                rebuild();
+            }
+            QPainter painter(m_window);
+            painter.setClipRegion(static_cast<QPaintEvent *>(event)->region());
+            painter.drawPixmap(0, 0, m_cache);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+/*
+ * 重建窗口缓存：九宫格阴影拉伸到面板周围，再用样式画出面板背景（渐变、圆角、边框）
+ */
+void WindowChrome::rebuild()
+{
+    const qreal ratio = m_window->devicePixelRatioF();
+    m_cache = QPixmap(m_window->size() * ratio);
+    m_cache.setDevicePixelRatio(ratio);
+    m_cache.fill(Qt::transparent);
+
+    QPainter painter(&m_cache);
+    const QRect panel = panelRect();
+    if (m_shadow.blurRadius > 0 && m_shadow.color.alpha() > 0) {
+        int border = 0;
+        const QPixmap tile = shadowTile(&border);
+        const int blur = m_shadow.blurRadius;
+        const QRect target = panel.translated(m_shadow.offset).adjusted(-blur, -blur, blur, blur);
+        qDrawBorderPixmap(&painter, target, QMargins(border, border, border, border), tile);
+    }
+    QStyleOption option;
+    option.initFrom(m_window);
+    option.rect = panel;
+    m_window->style()->drawPrimitive(QStyle::PE_Widget, &option, &painter, m_window);
+
+    m_dirty = false;
+    ++m_rebuilds;
+}
+
+/*
+ * 九宫格阴影：一个最小的圆角矩形，模糊后四角和四边拉伸即可覆盖任意尺寸的面板
+ *
+ * @param border：九宫格的边宽（模糊范围 + 圆角半径）
+ */
+QPixmap WindowChrome::shadowTile(int *border) const
+{
+    const int blur = m_shadow.blurRadius;
+    const int corner = qMax(0, m_shadow.cornerRadius);
+    *border = blur + corner;
+    const QString key = QString("petmiao-shadow-%1-%2-%3").arg(blur).arg(corner).arg(m_shadow.color.rgba(), 8, 16, QChar('0'));
+    QPixmap tile;
+    if (QPixmapCache::find(key, &tile)) {
+        return tile;
+    }
+
+    const int side = 2 * *border + 1;
+    QImage mask(side, side, QImage::Format_Alpha8);
+    mask.fill(0);
+    {
+        QPainter painter(&mask);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(Qt::black);
+        painter.drawRoundedRect(QRect(blur, blur, 2 * corner + 1, 2 * corner + 1), corner, corner);
+    }
+    blurAlpha(&mask, qMax(1, blur / 3));
+
+    QImage image(side, side, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        painter.drawImage(0, 0, mask);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        painter.fillRect(image.rect(), m_shadow.color);
+    }
+    tile = QPixmap::fromImage(image);
+    QPixmapCache::insert(key, tile);
+    return tile;
+}
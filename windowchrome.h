@@ -0,0 +1,60 @@
+#ifndef WINDOWCHROME_H
+#define WINDOWCHROME_H
+
+#include <QObject>
+#include <QColor>
+#include <QPoint>
+#include <QMargins>
+#include <QPixmap>
+
+class QWidget;
+
+// 阴影参数，默认值与原先音乐播放器上的 QGraphicsDropShadowEffect 一致
+struct WindowShadow
+{
+    int blurRadius = 10;
+    QColor color = QColor(0, 0, 0, 160);
+    QPoint offset = QPoint(0, 5);
+    int cornerRadius = 16;//面板圆角，与样式表中的 border-radius 一致
+};
+
+/*
+ * WindowChrome：半透明无边框窗口的阴影和面板背景
+ *
+ * QGraphicsDropShadowEffect 每次重绘（哪怕只是进度条走了一格）都要把整个窗口画到离屏缓冲、
+ * 模糊后再合成一次。这里改为：
+ *  - 阴影按参数只渲染一次成九宫格小图，所有相同参数的窗口共用（QPixmapCache）；
+ *  - 每个窗口把九宫格阴影和样式表中的面板背景合成一张窗口大小的缓存，只在尺寸、样式表或
+ *    缩放比例改变时重建；
+ *  - 重绘时只把缓存中的脏区域贴上去，子控件照常自己绘制。
+ *
+ * 阴影画在窗口边缘留出的透明边距里，install() 会相应加大窗口的 contentsMargins，
+ * 布局和样式表背景都落在中间的面板区域。
+ */
+class WindowChrome : public QObject
+{
+    Q_OBJECT
+public:
+    static WindowChrome *install(QWidget *window, const WindowShadow &shadow = WindowShadow());
+
+    QMargins margins() const;//阴影占用的边距
+    QRect panelRect() const;//面板（窗口可见部分）在窗口中的位置
+    int rebuildCount() const;//窗口缓存的重建次数（性能测量用）
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    WindowChrome(QWidget *window, const WindowShadow &shadow);
+    void rebuild();
+    QPixmap shadowTile(int *border) const;
+
+    QWidget *m_window;
+    WindowShadow m_shadow;
+    QMargins m_margins;
+    QPixmap m_cache;
+    bool m_dirty;
+    int m_rebuilds;
+};
+
+#endif // WINDOWCHROME_H
@@ -0,0 +1,275 @@
+#include "windowmanager.h"
+#include "chatroom.h"
+#include "functionmenu.h"
+#include "musicplayer.h"
+#include "audioservice.h"
+#include "dragcontroller.h"
+#include <QApplication>
+#include <QAction>
+#include <QEvent>
+#include <QMenu>
+#include <QSystemTrayIcon>
+#include <QSettings>
+
+/*
+ * WindowManager 构造函数
+ *
+ * 空闲时长默认 5 分钟，可通过配置项 session/idleTimeoutMs 覆盖
+ *
+ * @param anchor：桌宠主窗口
+ * @param drag：所有窗口共用的拖动控制器
+ */
+WindowManager::WindowManager(QWidget *anchor, DragController *drag, QObject *parent)
+    : QObject{parent}
+    , m_anchor(anchor)
+    , m_drag(drag)
+    , m_audio(nullptr)
+    , m_trayIcon(nullptr)
+    , m_hasMusicPos(false)
+    , m_musicDocked(false)
+{
+    QSettings settings;
+    m_idleTimeout = settings.value("session/idleTimeoutMs", 5 * 60 * 1000).toInt();
+}
+
+WindowManager::~WindowManager()
+{
+    // 窗口都以 anchor 为父对象，由 Qt 的父子关系负责销毁；
+    // 播放器窗口引用着播放服务，要在服务（本对象的子对象）之前销毁
+    delete m_musicPlayer;
+    if (m_trayIcon) {
+        m_trayIcon->hide();  // 隐藏托盘图标，避免残留
+    }
+}
+
+void WindowManager::setIdleTimeout(int msec)
+{
+    m_idleTimeout = msec;
+    for (Session &session : m_sessions) {
+        if (m_idleTimeout > 0) {
+            session.idleTimer->setInterval(m_idleTimeout);
+        } else {
+            session.idleTimer->stop();
+        }
+    }
+}
+
+int WindowManager::idleTimeout() const
+{
+    return m_idleTimeout;
+}
+
+chatroom *WindowManager::chatWindow()
+{
+    if (!m_chat) {
+        m_chat = new chatroom(m_anchor);
+        track(m_chat, true);
+        // 猫猫说话时压低音乐音量（还没用过音乐时忽略）
+        connect(m_chat, &chatroom::speakingChanged, this, [this](bool speaking) {
+            if (m_audio) {
+                m_audio->setDucked(speaking);
+            }
+        });
+        emit chatCreated(m_chat);
+    }
+    return m_chat;
+}
+
+functionMenu *WindowManager::functionWindow()
+{
+    if (!m_functionMenu) {
+        m_functionMenu = new functionMenu(m_anchor);
+        track(m_functionMenu, false);
+        // "音乐"按钮交给会话管理器打开，保证全局只有一个播放器
+        connect(m_functionMenu, &functionMenu::functionClicked, this, [this](const QString &name) {
+            if (name == "音乐") {
+                showMusicPlayer();
+            }
+        });
+    }
+    return m_functionMenu;
+}
+
+MusicPlayer *WindowManager::musicWindow()
+{
+    if (!m_musicPlayer) {
+        m_musicPlayer = new MusicPlayer(audioService(), m_anchor);
+        track(m_musicPlayer, true);
+        if (m_hasMusicPos) {
+            // 重建的窗口：回到销毁前的位置，停靠着的继续停靠
+            Session &session = m_sessions[m_musicPlayer];
+            if (m_musicDocked) {
+                m_musicPlayer->move(m_anchor->pos() + m_musicPos);
+                m_drag->dock(m_musicPlayer, m_anchor);
+            } else {
+                session.lastPos = m_musicPos;
+            }
+            session.hasLastPos = true;
+        }
+        connect(m_musicPlayer, &MusicPlayer::minimizedToTray, this, [this]() {
+            if (m_trayIcon) {
+                m_trayIcon->showMessage("猫猫音乐播放器", "播放器已最小化到系统托盘", QSystemTrayIcon::Information, 2000);
+            }
+        });
+    }
+    return m_musicPlayer;
+}
+
+AudioService *WindowManager::audioService()
+{
+    if (!m_audio) {
+        m_audio = new AudioService(this);
+        createTrayIcon();
+        emit audioServiceCreated(m_audio);
+    }
+    return m_audio;
+}
+
+void WindowManager::createTrayIcon()
+{
+    // 创建托盘图标
+    m_trayIcon = new QSystemTrayIcon(this);
+    m_trayIcon->setIcon(QIcon(":/image/icon.png")); // 请替换为实际图标路径
+    m_trayIcon->setToolTip("猫猫音乐");
+
+    // 创建托盘菜单
+    QMenu *trayMenu = new QMenu(m_anchor);
+    QAction *restoreAction = trayMenu->addAction("恢复窗口");
+    QAction *quitAction = trayMenu->addAction("退出");
+    connect(restoreAction, &QAction::triggered, this, &WindowManager::showMusicPlayer);
+    connect(quitAction, &QAction::triggered, qApp, &QApplication::quit);
+    m_trayIcon->setContextMenu(trayMenu);
+
+    // 双击托盘图标：显示或隐藏播放器，窗口已经销毁时重新创建
+    connect(m_trayIcon, &QSystemTrayIcon::activated, this, [this](QSystemTrayIcon::ActivationReason reason) {
+        if (reason != QSystemTrayIcon::DoubleClick) {
+            return;
+        }
+        if (m_musicPlayer && !m_musicPlayer->isHidden()) {
+            m_musicPlayer->hide();
+        } else {
+            showMusicPlayer();
+        }
+    });
+
+    m_trayIcon->show();
+}
+
+void WindowManager::showChat()
+{
+    chatroom *chat = chatWindow();
+    present(chat, m_anchor->mapToGlobal(QPoint(0, m_anchor->height())));//默认在桌宠下方
+}
+
+void WindowManager::showFunctionMenu()
+{
+    functionMenu *menu = functionWindow();
+    // 功能菜单是弹出式窗口，每次都贴着桌宠左侧弹出，不恢复旧位置
+    m_sessions[menu].hasLastPos = false;
+    present(menu, m_anchor->mapToGlobal(QPoint(-menu->width() - 10, 0)));
+}
+
+void WindowManager::showMusicPlayer()
+{
+    MusicPlayer *player = musicWindow();
+    present(player, m_anchor->mapToGlobal(QPoint(m_anchor->width(), 0)));//默认在桌宠右侧
+}
+
+void WindowManager::releaseIdleResources()
+{
+    for (auto it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+        if (it.value().window && it.value().window->isHidden()) {
+            releaseResources(it.value().window);
+        }
+    }
+}
+
+void WindowManager::track(QWidget *window, bool dockable)
+{
+    m_drag->attach(window);
+    if (dockable) {
+        m_drag->setDockTarget(window, m_anchor);
+    }
+
+    Session session;
+    session.window = window;
+    session.dockable = dockable;
+    session.idleTimer = new QTimer(this);
+    session.idleTimer->setSingleShot(true);
+    if (m_idleTimeout > 0) {
+        session.idleTimer->setInterval(m_idleTimeout);
+    }
+    connect(session.idleTimer, &QTimer::timeout, this, [this, window]() {
+        releaseResources(window);
+    });
+    m_sessions.insert(window, session);
+
+    window->installEventFilter(this);
+    connect(window, &QObject::destroyed, this, [this, window]() {
+        Session session = m_sessions.take(window);
+        if (session.idleTimer) {
+            session.idleTimer->deleteLater();
+        }
+    });
+}
+
+void WindowManager::present(QWidget *window, const QPoint &defaultPos)
+{
+    const Session &session = m_sessions[window];
+    // 停靠着的窗口隐藏期间也跟着桌宠移动，位置已经是对的
+    if (!m_drag->isDocked(window)) {
+        window->move(session.hasLastPos ? session.lastPos : defaultPos);
+        if (!session.hasLastPos && session.dockable) {
+            m_drag->dock(window, m_anchor);//第一次在桌宠旁边打开时停靠
+        }
+    }
+    if (window->isMinimized()) {
+        window->showNormal();
+    } else {
+        window->show();
+    }
+    window->raise();
+    window->activateWindow();
+}
+
+void WindowManager::releaseResources(QWidget *window)
+{
+    // 只释放仍处于隐藏状态的窗口，期间被重新打开的窗口不受影响
+    if (!window || !window->isHidden()) {
+        return;
+    }
+    if (window == m_chat) {
+        m_chat->releaseResources();
+    } else if (window == m_musicPlayer) {
+        // 音乐在服务中继续，播放器窗口整个销毁，下次打开时重建
+        m_musicDocked = m_drag->isDocked(window);
+        m_musicPos = m_musicDocked ? window->pos() - m_anchor->pos() : m_sessions.value(window).lastPos;
+        m_hasMusicPos = true;
+        m_audio->releaseResources();
+        m_musicPlayer->deleteLater();
+        m_musicPlayer = nullptr;
+    }
+}
+
+/*
+ * 监听功能窗口的显示/隐藏
+ *
+ * 隐藏时记录位置并启动空闲计时，重新显示时取消计时
+ */
+bool WindowManager::eventFilter(QObject *watched, QEvent *event)
+{
+    auto it = m_sessions.find(static_cast<QWidget*>(watched));
+    if (it != m_sessions.end()) {
+        Session &session = it.value();
+        if (event->type() == QEvent::Hide) {
+            session.lastPos = session.window->pos();
+            session.hasLastPos = true;
+            if (m_idleTimeout > 0) {
+                session.idleTimer->start();
+            }
+        } else if (event->type() == QEvent::Show) {
+            session.idleTimer->stop();
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
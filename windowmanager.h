@@ -0,0 +1,89 @@
+#ifndef WINDOWMANAGER_H
+#define WINDOWMANAGER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QPointer>
+#include <QPoint>
+#include <QTimer>
+#include <QHash>
+
+class chatroom;
+class functionMenu;
+class MusicPlayer;
+class AudioService;
+class DragController;
+class QSystemTrayIcon;
+
+/*
+ * WindowManager：功能窗口会话管理器
+ *
+ * 每种功能窗口（聊天、功能菜单、音乐播放器）只保留一个实例：
+ * 再次打开时直接显示/置顶已有窗口，并恢复上次关闭时的位置。
+ * 窗口隐藏超过空闲时长后，释放其中的重量级资源（已解码的媒体、AI网络连接），
+ * 聊天记录、歌曲列表、播放进度等轻量状态保留，下次打开时按需重新加载。
+ * 音乐由没有界面的 AudioService 播放：播放器窗口空闲时整个销毁，音乐和托盘图标不受影响，
+ * 再次打开时重新创建窗口，位置和停靠状态保持不变。
+ * 聊天窗口和音乐播放器第一次在桌宠旁边打开时停靠到桌宠上，随桌宠一起移动，拖开后独立。
+ */
+class WindowManager : public QObject
+{
+    Q_OBJECT
+public:
+    WindowManager(QWidget *anchor, DragController *drag, QObject *parent = nullptr);//anchor：桌宠主窗口，作为各功能窗口的父窗口和定位参照
+    ~WindowManager();
+
+    void setIdleTimeout(int msec);//设置隐藏后释放资源的空闲时长（毫秒），<=0 表示不释放
+    int idleTimeout() const;
+
+    // 按需创建，始终返回同一个实例
+    chatroom *chatWindow();
+    functionMenu *functionWindow();
+    MusicPlayer *musicWindow();
+    AudioService *audioService();//第一次用到音乐时创建，之后一直存在
+
+public slots:
+    void showChat();
+    void showFunctionMenu();
+    void showMusicPlayer();
+    void releaseIdleResources();//立即释放所有隐藏窗口的重量级资源
+
+signals:
+    void chatCreated(chatroom *chat);
+    void audioServiceCreated(AudioService *audio);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    // 每个功能窗口对应一个会话槽位
+    struct Session
+    {
+        QPointer<QWidget> window;
+        QTimer *idleTimer = nullptr;
+        QPoint lastPos;//上次隐藏时的位置
+        bool hasLastPos = false;
+        bool dockable = false;
+    };
+
+    void track(QWidget *window, bool dockable);//登记窗口并监听显示/隐藏事件，dockable：可以停靠到桌宠
+    void present(QWidget *window, const QPoint &defaultPos);//显示/置顶并恢复位置
+    void releaseResources(QWidget *window);
+    void createTrayIcon();
+
+    QWidget *m_anchor;
+    DragController *m_drag;
+    int m_idleTimeout;
+    QPointer<chatroom> m_chat;
+    QPointer<functionMenu> m_functionMenu;
+    QPointer<MusicPlayer> m_musicPlayer;
+    AudioService *m_audio;
+    QSystemTrayIcon *m_trayIcon;//音乐的托盘图标，播放器窗口销毁后仍在
+    // 播放器窗口销毁时记下的位置，重建后恢复
+    QPoint m_musicPos;
+    bool m_hasMusicPos;
+    bool m_musicDocked;//停靠时记的是相对桌宠的偏移
+    QHash<QWidget*, Session> m_sessions;
+};
+
+#endif // WINDOWMANAGER_H